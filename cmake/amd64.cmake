@@ -2,9 +2,16 @@ set(CMAKE_SYSTEM_PROCESSOR amd64)
 
 if(CMAKE_HOST_SYSTEM_NAME STREQUAL Linux)
     set(CMAKE_SYSTEM_NAME Linux)
-    set(CMAKE_ASM_COMPILER gcc)
-    set(CMAKE_C_COMPILER gcc)
-    set(CMAKE_CXX_COMPILER g++)
+    if(BUILD_FUZZ_TESTS)
+        # libFuzzer is shipped with Clang only
+        set(CMAKE_ASM_COMPILER clang)
+        set(CMAKE_C_COMPILER clang)
+        set(CMAKE_CXX_COMPILER clang++)
+    else()
+        set(CMAKE_ASM_COMPILER gcc)
+        set(CMAKE_C_COMPILER gcc)
+        set(CMAKE_CXX_COMPILER g++)
+    endif()
 elseif(CMAKE_HOST_SYSTEM_NAME STREQUAL FreeBSD)
     set(CMAKE_SYSTEM_NAME FreeBSD)
     set(CMAKE_ASM_COMPILER clang)
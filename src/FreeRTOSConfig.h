@@ -69,7 +69,7 @@ extern uint32_t SystemCoreClock;
 // Sync
 #define configUSE_TASK_NOTIFICATIONS      1
 #define configUSE_MUTEXES                 1
-#define configUSE_RECURSIVE_MUTEXES       0
+#define configUSE_RECURSIVE_MUTEXES       1
 #define configUSE_COUNTING_SEMAPHORES     0
 #define configUSE_QUEUE_SETS              1
 #define configMESSAGE_BUFFER_LENGTH_TYPE  size_t
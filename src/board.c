@@ -6,6 +6,7 @@
 #include "board.h"
 
 #include <limits.h>
+#include <string.h>
 #include <assert.h>
 
 #include "stm32f4xx_hal.h"
@@ -15,6 +16,7 @@
 #include "semphr.h"
 #include "timers.h"
 
+#include "board.config.h"
 #include "board.type.h"
 #include "board.uart_2.h"
 #include "board.spi_1.h"
@@ -26,16 +28,24 @@
 #include "board.exti_2.h"
 #include "board.timer_2.h"
 #include "board.timer_3.h"
+#include "board.rtc_backup.h"
+#include "board.crc.h"
+#include "board.storage.h"
+#include "board.sensor_log.h"
+#include "board.firmware.h"
 #include "board_factory.h"
 
 #include "devices/mcp23017_expander.h"
 #include "devices/vs1838_control.h"
 
 #include "storage.h"
+#include "retained_state.h"
+#include "spi_transfer.h"
 #include "node.h"
 #include "node/node.list.h"
 #include "tcp_client.h"
 #include "tcp_client.type.h"
+#include "latency.h"
 
 #include "version.h"
 
@@ -51,10 +61,12 @@
 #define REMOTE_BUTTON_NOTIFICATION  (1 << 0)
 #define STATUS_LED_NOTIFICATION     (1 << 1)
 #define PHOTORESISTOR_NOTIFICATION  (1 << 2)
+#define FIRMWARE_NOTIFICATION       (1 << 3)
+#define HISTORY_NOTIFICATION        (1 << 4)
 
-#define UART_TIMEOUT_MS (1U * 1000U)    // 1 sec
-#define SPI_TIMEOUT_MS  (1U * 1000U)    // 1 sec
-#define I2C_TIMEOUT_MS  (1U * 1000U)    // 1 sec
+#define UART_TIMEOUT_MS     (1U * 1000U)    // 1 sec
+#define SPI_TIMEOUT_MS      (1U * 1000U)    // 1 sec
+#define I2C_TIMEOUT_MS      (1U * 1000U)    // 1 sec
 
 #define PHOTORESISTOR_MEAUSEREMENT_COUNT    5U
 #define PHOTORESISTOR_DEFAULT_PERIOD_MS     (2U * 60U * 1000U) // 2 min
@@ -70,6 +82,7 @@ static SemaphoreHandle_t status_led_mutex;
 static SemaphoreHandle_t remote_button_mutex;
 static TimerHandle_t photoresistor_timer;
 static SemaphoreHandle_t spi_1_mutex;
+static SemaphoreHandle_t spi_1_dma_semaphore;
 static SemaphoreHandle_t i2c_1_mutex;
 
 static board_config_t config;
@@ -77,11 +90,11 @@ static board_setup_t setup;
 
 static board_led_color_t status_led_color;
 static mcp23017_expander_t mcp23017_expander;
-static storage_t storage;
+static spi_transfer_t spi_1_transfer;
 static vs1838_control_t vs1838_control;
 static board_remote_button_t latest_remote_button;
-static storage_file_t firmware_file;
 static bool is_updating;
+static retained_state_t retained_state __attribute__((section(".noinit")));   // Neither the startup code nor the bootloader touch it
 
 
 static int board_malloc (std_error_t * const error);
@@ -95,11 +108,20 @@ static void board_remote_control_ISR (uint32_t captured_value);
 
 static int board_receive_tcp_msg (tcp_msg_t const * const recv_msg, std_error_t * const error);
 static void board_receive_node_msg (node_msg_t const * const msg);
+static void board_tcp_client_connected ();
+static void board_tcp_client_poll ();
+static void board_check_firmware (node_msg_t const * const request_msg);
+static void board_finish_firmware_update ();
 
 static void board_init_logger ();
+#ifdef LATENCY_TRACE
+static void board_init_latency ();
+#endif // LATENCY_TRACE
 static void board_init_status_led ();
 static void board_init_expander ();
 static void board_init_storage ();
+static void board_init_sensor_log ();
+static void board_init_firmware_update ();
 static void board_init_node ();
 static void board_init_extension ();
 static void board_init_tcp_client ();
@@ -110,6 +132,19 @@ static void board_i2c_1_lock ();
 static void board_i2c_1_unlock ();
 static void board_spi_1_lock ();
 static void board_spi_1_unlock ();
+static int board_spi_1_transfer (uint8_t *tx_data, uint8_t *rx_data, uint16_t size, uint32_t timeout_ms, std_error_t * const error);
+static int board_spi_1_transfer_read (uint8_t *data, uint16_t size, uint32_t timeout_ms, std_error_t * const error);
+static int board_spi_1_transfer_write (uint8_t *data, uint16_t size, uint32_t timeout_ms, std_error_t * const error);
+static void board_spi_1_dma_ISR (bool is_success);
+static bool board_spi_1_wait_dma (uint32_t timeout_ms);
+static void board_spi_1_notify_dma_ISR ();
+static void board_spi_1_stop_dma ();
+static void board_yield ();
+static uint32_t board_get_cycles ();
+#ifdef LATENCY_TRACE
+static void board_latency_lock ();
+static void board_latency_unlock ();
+#endif // LATENCY_TRACE
 
 int board_init (board_config_t const * const init_config, std_error_t * const error)
 {
@@ -141,9 +176,14 @@ void board_task (void *parameters)
 
     LOG("Board : firmware version = %s.%s.%s\r\n", VERSION_MAJOR, VERSION_MINOR, VERSION_PATCH);
 
+#ifdef LATENCY_TRACE
+    board_init_latency();
+#endif // LATENCY_TRACE
     board_init_status_led();
     board_init_expander();
     board_init_storage();
+    board_init_sensor_log();
+    board_init_firmware_update();
     board_init_node();
     board_init_extension();
     board_init_tcp_client();
@@ -156,11 +196,15 @@ void board_task (void *parameters)
 
     xTimerChangePeriod(photoresistor_timer, pdMS_TO_TICKS(PHOTORESISTOR_DEFAULT_PERIOD_MS), RTOS_TIMER_TICKS_TO_WAIT);
 
+    TickType_t longest_loop_ticks = 0U;
+
     while (true)
     {
         uint32_t notification;
         xTaskNotifyWait(0U, ULONG_MAX, &notification, config.watchdog_timeout_ms);
 
+        const TickType_t loop_start_tick_count = xTaskGetTickCount();
+
         if ((notification & REMOTE_BUTTON_NOTIFICATION) != 0U)
         {
             xSemaphoreTake(remote_button_mutex, portMAX_DELAY);
@@ -194,6 +238,26 @@ void board_task (void *parameters)
             board_read_photoresistor(&is_photoresistor_reading, &error);
         }
 
+        if ((notification & FIRMWARE_NOTIFICATION) != 0U)
+        {
+            board_finish_firmware_update();
+        }
+
+        if ((notification & HISTORY_NOTIFICATION) != 0U)
+        {
+            board_sensor_log_send_history(setup.node_id);
+        }
+
+        // What the watchdog margin has to cover, a firmware download included
+        const TickType_t loop_ticks = xTaskGetTickCount() - loop_start_tick_count;
+
+        if (loop_ticks > longest_loop_ticks)
+        {
+            longest_loop_ticks = loop_ticks;
+
+            LOG("Board [watchdog] : longest loop = %lu ms\r\n", (unsigned long)(loop_ticks * portTICK_PERIOD_MS));
+        }
+
         LOG("Board [watchdog] : feed\r\n");
 
         config.refresh_watchdog_callback();
@@ -450,30 +514,17 @@ int board_receive_tcp_msg (tcp_msg_t const * const recv_msg, std_error_t * const
 {
     if (is_updating == true)
     {
-        if (recv_msg->size != ARRAY_SIZE(recv_msg->data))
-        {
-            tcp_client_stop();
-
-            storage_write_file(&storage, &firmware_file, recv_msg->data, recv_msg->size, error);
-
-            size_t firmware_size;
-            storage_get_file_size(&storage, &firmware_file, &firmware_size, error);
-
-            LOG("Board [storage] : firmware size = %u bytes\r\n", firmware_size);
-
-            storage_close_file(&storage, &firmware_file, error);
+        bool is_complete;
 
-            storage_unmount_filesystem(&storage, error);
-            storage_disable_power(&storage, error);
+        const int exit_code = board_firmware_process((const uint8_t*)(recv_msg->data), recv_msg->size, &is_complete, error);
 
-            vTaskDelay(pdMS_TO_TICKS(5U * 1000U));
-
-            HAL_NVIC_SystemReset();
-        }
-        else
+        // Reset from the board task, so this one can still send the result to the server
+        if (is_complete == true)
         {
-            storage_write_file(&storage, &firmware_file, recv_msg->data, recv_msg->size, error);
+            xTaskNotify(task, FIRMWARE_NOTIFICATION, eSetBits);
         }
+
+        return exit_code;
     }
     else
     {
@@ -491,12 +542,12 @@ void board_receive_node_msg (node_msg_t const * const msg)
         std_error_t error;
         std_error_init(&error);
 
-        storage_enable_power(&storage, &error);
-        storage_mount_filesystem(&storage, &error);
-
-        const char file_name[64] = "firmware\0";
-        storage_create_file(&storage, &firmware_file, file_name, &error);
+        if (board_storage_mount(&error) != STD_SUCCESS)
+        {
+            LOG("Board [storage] : %s\r\n", error.text);
+        }
 
+        // The image goes to littlefs from the TCP client task, the sensor log goes on next to it
         is_updating = true;
 
         tcp_client_endpoint_t server;
@@ -510,14 +561,135 @@ void board_receive_node_msg (node_msg_t const * const msg)
 
         tcp_client_restart(&server);
     }
+    else if (msg->cmd_id == REQUEST_FIRMWARE_CHECK)
+    {
+        board_check_firmware(msg);
+    }
+    else if (msg->cmd_id == REQUEST_HISTORY)
+    {
+        // Streamed from the board task, the node task has to drain the messages meanwhile
+        board_sensor_log_request_history(msg);
+
+        xTaskNotify(task, HISTORY_NOTIFICATION, eSetBits);
+    }
     else
     {
         setup.process_msg_callback(msg);
+
+#ifdef LATENCY_TRACE
+        latency_trace_t trace = msg->trace;
+        latency_stamp(&trace, BOARD_PROCESS_HOP);
+        latency_record(&trace);
+#endif // LATENCY_TRACE
     }
 
     return;
 }
 
+void board_tcp_client_connected ()
+{
+    board_firmware_confirm();
+
+    if (is_updating == true)
+    {
+        board_firmware_resume();
+
+        return;
+    }
+
+    if (setup.process_msg_callback == NULL)
+    {
+        return;
+    }
+
+    // Let the server catch up with the whole state right away instead of waiting for periodic updates
+    node_msg_t msg;
+
+    size_t i = 0U;
+
+    msg.header.source = NODE_B01;
+    msg.header.dest_array[i] = setup.node_id;
+    ++i;
+    msg.header.dest_array_size = i;
+
+    msg.cmd_id  = REQUEST_STATE;
+    msg.value_0 = 0;
+    msg.value_1 = 0;
+    msg.value_2 = 0.0F;
+
+    LATENCY_CLEAR(&msg.trace);
+
+    setup.process_msg_callback(&msg);
+
+    return;
+}
+
+void board_tcp_client_poll ()
+{
+    if (is_updating == true)
+    {
+        board_firmware_poll();
+    }
+
+    return;
+}
+
+void board_check_firmware (node_msg_t const * const request_msg)
+{
+    std_error_t error;
+    std_error_init(&error);
+
+    uint32_t image_size;
+
+    const int exit_code = board_firmware_verify(&image_size, &error);
+
+    if (exit_code != STD_SUCCESS)
+    {
+        LOG("Board [firmware] : %s\r\n", error.text);
+    }
+
+    node_msg_t msg;
+
+    size_t i = 0U;
+
+    msg.header.source = setup.node_id;
+    msg.header.dest_array[i] = request_msg->header.source;
+    ++i;
+    msg.header.dest_array_size = i;
+
+    msg.cmd_id  = RESPONSE_FIRMWARE_CHECK;
+    msg.value_0 = (exit_code == STD_SUCCESS) ? 1 : 0;
+    msg.value_1 = (int32_t)(image_size);
+    msg.value_2 = 0.0F;
+
+    LATENCY_CLEAR(&msg.trace);
+
+    if (node_send_msg(&msg, &error) != STD_SUCCESS)
+    {
+        LOG("Board [node] : %s\r\n", error.text);
+    }
+
+    return;
+}
+
+void board_finish_firmware_update ()
+{
+    // Let the result frame leave before the link goes down
+    vTaskDelay(pdMS_TO_TICKS(1U * 1000U));
+
+    tcp_client_stop();
+
+    // The buffered readings would not survive the reset
+    board_sensor_log_stop();
+    board_storage_unmount();
+
+    vTaskDelay(pdMS_TO_TICKS(5U * 1000U));
+
+    HAL_NVIC_SystemReset();
+
+    return;
+}
+
 
 
 void board_init_logger ()
@@ -537,6 +709,28 @@ void board_init_logger ()
     return;
 }
 
+#ifdef LATENCY_TRACE
+void board_init_latency ()
+{
+    LOG("Board [latency] : init (DWT)\r\n");
+
+    // Enable the cycle counter
+    CoreDebug->DEMCR    |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT         = 0U;
+    DWT->CTRL           |= DWT_CTRL_CYCCNTENA_Msk;
+
+    latency_config_t config;
+    config.get_cycles_callback  = board_get_cycles;
+    config.lock_callback        = board_latency_lock;
+    config.unlock_callback      = board_latency_unlock;
+    config.cycles_per_us        = SystemCoreClock / 1000000U;
+
+    latency_init(&config);
+
+    return;
+}
+#endif // LATENCY_TRACE
+
 void board_init_status_led ()
 {
     std_error_t error;
@@ -641,18 +835,39 @@ void board_init_storage ()
         LOG("Board [SPI_1] : %s\r\n", error.text);
     }
 
-    LOG("Board [storage] : init\r\n");
+    // The W25Q pages and the W5500 socket buffers go by DMA, the task sleeps meanwhile
+    spi_transfer_config_t spi_config;
+    spi_config.poll_callback        = board_spi_1_read_write_fast;
+    spi_config.start_callback       = board_spi_1_start_dma;
+    spi_config.wait_callback        = board_spi_1_wait_dma;
+    spi_config.notify_ISR_callback  = board_spi_1_notify_dma_ISR;
+    spi_config.abort_callback       = board_spi_1_stop_dma;
+    spi_config.dma_threshold        = SPI_TRANSFER_DMA_THRESHOLD;
 
-    storage_config_t config;
-    config.spi_lock_callback        = board_spi_1_lock;
-    config.spi_unlock_callback      = board_spi_1_unlock;
-    config.spi_select_callback      = board_gpio_a_pin_4_reset;
-    config.spi_unselect_callback    = board_gpio_a_pin_4_set;
-    config.spi_tx_rx_callback       = board_spi_1_read_write;
-    config.spi_timeout_ms           = SPI_TIMEOUT_MS;
-    config.delay_callback           = vTaskDelay;
+    LOG("Board [SPI_1] : DMA init\r\n");
 
-    if (storage_init(&storage, &config, &error) != STD_SUCCESS)
+    if (board_spi_1_init_dma(board_spi_1_dma_ISR, &error) != STD_SUCCESS)
+    {
+        LOG("Board [SPI_1] : %s\r\n", error.text);
+
+        spi_config.dma_threshold = UINT16_MAX;
+    }
+
+    spi_transfer_init(&spi_1_transfer, &spi_config);
+
+    LOG("Board [storage] : init\r\n");
+
+    board_storage_config_t storage_config;
+    storage_config.spi_lock_callback        = board_spi_1_lock;
+    storage_config.spi_unlock_callback      = board_spi_1_unlock;
+    storage_config.spi_select_callback      = board_gpio_a_pin_4_reset;
+    storage_config.spi_unselect_callback    = board_gpio_a_pin_4_set;
+    storage_config.spi_tx_rx_callback       = board_spi_1_transfer;
+    storage_config.spi_timeout_ms           = SPI_TIMEOUT_MS;
+    storage_config.yield_callback           = board_yield;
+    storage_config.get_cycles_callback      = board_get_cycles;
+
+    if (board_storage_init(&storage_config, &error) != STD_SUCCESS)
     {
         LOG("Board [storage] : %s\r\n", error.text);
     }
@@ -660,6 +875,38 @@ void board_init_storage ()
     return;
 }
 
+void board_init_sensor_log ()
+{
+    std_error_t error;
+    std_error_init(&error);
+
+    LOG("Board [sensor_log] : init\r\n");
+
+    if (board_sensor_log_init(&error) != STD_SUCCESS)
+    {
+        LOG("Board [sensor_log] : %s\r\n", error.text);
+    }
+
+    return;
+}
+
+void board_init_firmware_update ()
+{
+    LOG("Board [rtc_backup] : init\r\n");
+
+    board_rtc_backup_init();
+
+    LOG("Board [CRC] : init\r\n");
+
+    board_crc_init();
+
+    LOG("Board [firmware] : init\r\n");
+
+    board_firmware_init();
+
+    return;
+}
+
 void board_init_extension ()
 {
     std_error_t error;
@@ -667,13 +914,24 @@ void board_init_extension ()
 
     LOG("Board [extension] : init\r\n");
 
+    // A power-on leaves random bytes there, the record check would most likely catch them anyway
+    if ((__HAL_RCC_GET_FLAG(RCC_FLAG_PORRST) != RESET) || (__HAL_RCC_GET_FLAG(RCC_FLAG_BORRST) != RESET))
+    {
+        LOG("Board [extension] : power-on reset\r\n");
+
+        retained_state_clear(&retained_state);
+    }
+    __HAL_RCC_CLEAR_RESET_FLAGS();
+
     board_extension_config_t config;
     config.mcp23017_expander            = &mcp23017_expander;
-    config.storage                      = &storage;
+    config.storage                      = board_storage_get();
+    config.retained_state               = &retained_state;
     config.lock_i2c_1_callback          = board_i2c_1_lock;
     config.unlock_i2c_1_callback        = board_i2c_1_unlock;
     config.update_status_led_callback   = board_update_status_led;
     config.send_node_msg_callback       = node_send_msg;
+    config.log_reading_callback         = board_sensor_log_append;
 
     if (setup.init_extension_callback(&config, &error) != STD_SUCCESS)
     {
@@ -724,13 +982,15 @@ void board_init_tcp_client ()
     tcp_client_config_t config = { 0 };
 
     config.process_msg_callback = board_receive_tcp_msg;
+    config.connect_callback     = board_tcp_client_connected;
+    config.poll_callback        = board_tcp_client_poll;
 
     config.spi_lock_callback        = board_spi_1_lock;
     config.spi_unlock_callback      = board_spi_1_unlock;
     config.spi_select_callback      = board_gpio_c_pin_13_reset;
     config.spi_unselect_callback    = board_gpio_c_pin_13_set;
-    config.spi_read_callback        = board_spi_1_read;
-    config.spi_write_callback       = board_spi_1_write;
+    config.spi_read_callback        = board_spi_1_transfer_read;
+    config.spi_write_callback       = board_spi_1_transfer_write;
     config.spi_timeout_ms           = SPI_TIMEOUT_MS;
 
     config.mac[0] = 0xEA;
@@ -802,10 +1062,11 @@ int board_malloc (std_error_t * const error)
     status_led_mutex    = xSemaphoreCreateMutex();
     remote_button_mutex = xSemaphoreCreateMutex();
     spi_1_mutex         = xSemaphoreCreateMutex();
+    spi_1_dma_semaphore = xSemaphoreCreateBinary();
     i2c_1_mutex         = xSemaphoreCreateMutex();
 
     const bool are_semaphores_allocated = (status_led_mutex != NULL) && (remote_button_mutex != NULL) &&
-                                            (spi_1_mutex != NULL) && (i2c_1_mutex != NULL);
+                                            (spi_1_mutex != NULL) && (spi_1_dma_semaphore != NULL) && (i2c_1_mutex != NULL);
 
     photoresistor_timer = xTimerCreate("photoresistor", pdMS_TO_TICKS(PHOTORESISTOR_DEFAULT_PERIOD_MS), pdFALSE, NULL, board_photoresistor_timer);
 
@@ -816,6 +1077,7 @@ int board_malloc (std_error_t * const error)
         vSemaphoreDelete(status_led_mutex);
         vSemaphoreDelete(remote_button_mutex);
         vSemaphoreDelete(spi_1_mutex);
+        vSemaphoreDelete(spi_1_dma_semaphore);
         vSemaphoreDelete(i2c_1_mutex);
         xTimerDelete(photoresistor_timer, RTOS_TIMER_TICKS_TO_WAIT);
 
@@ -871,3 +1133,80 @@ void board_spi_1_unlock ()
 
     return;
 }
+
+int board_spi_1_transfer (uint8_t *tx_data, uint8_t *rx_data, uint16_t size, uint32_t timeout_ms, std_error_t * const error)
+{
+    return spi_transfer_read_write(&spi_1_transfer, tx_data, rx_data, size, timeout_ms, error);
+}
+
+int board_spi_1_transfer_read (uint8_t *data, uint16_t size, uint32_t timeout_ms, std_error_t * const error)
+{
+    return spi_transfer_read_write(&spi_1_transfer, NULL, data, size, timeout_ms, error);
+}
+
+int board_spi_1_transfer_write (uint8_t *data, uint16_t size, uint32_t timeout_ms, std_error_t * const error)
+{
+    return spi_transfer_read_write(&spi_1_transfer, data, NULL, size, timeout_ms, error);
+}
+
+void board_spi_1_dma_ISR (bool is_success)
+{
+    spi_transfer_complete_ISR(&spi_1_transfer, is_success);
+
+    return;
+}
+
+bool board_spi_1_wait_dma (uint32_t timeout_ms)
+{
+    // Not a task notification: the board task uses its bits for events and does SPI too
+    return (xSemaphoreTake(spi_1_dma_semaphore, pdMS_TO_TICKS(timeout_ms)) == pdTRUE);
+}
+
+void board_spi_1_notify_dma_ISR ()
+{
+    BaseType_t is_higher_priority_task_woken = pdFALSE;
+
+    xSemaphoreGiveFromISR(spi_1_dma_semaphore, &is_higher_priority_task_woken);
+
+    portYIELD_FROM_ISR(is_higher_priority_task_woken);
+
+    return;
+}
+
+void board_spi_1_stop_dma ()
+{
+    board_spi_1_abort_dma();
+
+    // A completion that raced the timeout must not end the next wait early
+    xSemaphoreTake(spi_1_dma_semaphore, 0U);
+
+    return;
+}
+
+void board_yield ()
+{
+    taskYIELD();
+
+    return;
+}
+
+uint32_t board_get_cycles ()
+{
+    return DWT->CYCCNT;
+}
+
+#ifdef LATENCY_TRACE
+void board_latency_lock ()
+{
+    taskENTER_CRITICAL();
+
+    return;
+}
+
+void board_latency_unlock ()
+{
+    taskEXIT_CRITICAL();
+
+    return;
+}
+#endif // LATENCY_TRACE
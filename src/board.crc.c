@@ -0,0 +1,30 @@
+/************************************************************
+ *   Author : German Mundinger
+ *   Date   : 2024
+ ************************************************************/
+
+#include "board.crc.h"
+
+#include "stm32f4xx_hal.h"
+
+
+static CRC_HandleTypeDef crc_handler;
+
+
+void board_crc_init ()
+{
+    __HAL_RCC_CRC_CLK_ENABLE();
+
+    // No configuration at all on STM32F4: fixed polynomial, initial value and word input
+    crc_handler.Instance = CRC;
+
+    HAL_CRC_Init(&crc_handler);
+
+    return;
+}
+
+uint32_t board_crc_calculate (uint32_t const * const words, size_t count)
+{
+    // One word per AHB cycle, the whole gold image takes a few milliseconds
+    return HAL_CRC_Calculate(&crc_handler, (uint32_t*)(words), (uint32_t)(count));
+}
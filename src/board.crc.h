@@ -0,0 +1,17 @@
+/************************************************************
+ *   Author : German Mundinger
+ *   Date   : 2024
+ ************************************************************/
+
+#ifndef BOARD_CRC_H
+#define BOARD_CRC_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+void board_crc_init ();
+
+// CRC-32/MPEG-2 of whole words from the initial value, see crc32_calculate_words()
+uint32_t board_crc_calculate (uint32_t const * const words, size_t count);
+
+#endif // BOARD_CRC_H
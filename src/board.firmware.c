@@ -0,0 +1,531 @@
+/************************************************************
+ *   Author : German Mundinger
+ *   Date   : 2024
+ ************************************************************/
+
+#include "board.firmware.h"
+
+#include <string.h>
+#include <assert.h>
+
+#include "stm32f4xx_hal.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "board.config.h"
+#include "board.rtc_backup.h"
+#include "board.crc.h"
+#include "board.storage.h"
+
+#include "storage.h"
+#include "firmware_update.h"
+#include "patcher.h"
+#include "bootloader/boot.h"
+#include "bootloader/decompressor.h"
+#include "bootloader/image.h"
+#include "crc32.h"
+#include "tcp_client.h"
+#include "tcp_client.type.h"
+#include "latency.h"
+
+#include "logger.h"
+#include "std_error/std_error.h"
+
+
+#define FIRMWARE_MAX_SIZE           ((uint32_t)(FLASH_MEMORY_SIZE) - (64U * 1024U)) // Everything past the bootloader sectors 0 - 3
+#define FIRMWARE_FILE_NAME          "firmware"      // Its presence makes the bootloader flash it
+#define FIRMWARE_PART_FILE_NAME     "firmware.part"
+#define FIRMWARE_NEW_FILE_NAME      "firmware.new"  // Built from the running image and a patch
+#define FIRMWARE_START_ADDRESS      0x08010000U     // Sector 4
+
+#define FIRMWARE_ERROR_TEXT "Board firmware verification error"
+
+#define ARRAY_SIZE(array) (sizeof(array) / sizeof((array)[0]))
+
+
+static storage_stream_t firmware_stream;
+static firmware_update_t firmware_update;
+static patcher_t firmware_patcher;
+static decompressor_t firmware_decompressor;
+static image_checker_t firmware_checker;
+static bool is_firmware_stream_open;
+
+
+static int board_firmware_start (firmware_update_header_t const * const header, std_error_t * const error);
+static int board_firmware_write (uint8_t const * const data, size_t size, std_error_t * const error);
+static int board_firmware_commit (firmware_update_header_t const * const header, std_error_t * const error);
+static void board_firmware_discard ();
+static void board_firmware_send_frame (uint8_t const * const frame, size_t size);
+static uint32_t board_firmware_get_time ();
+static int board_firmware_apply_patch (std_error_t * const error);
+static int board_firmware_process_patch (uint8_t const * const data, size_t size, std_error_t * const error);
+static int board_firmware_read_running (uint32_t offset, uint8_t * const data, size_t size, std_error_t * const error);
+static int board_firmware_check_image (char const * const file_name, std_error_t * const error);
+static int board_firmware_check_chunk (uint8_t const * const data, size_t size, std_error_t * const error);
+
+void board_firmware_init ()
+{
+    is_firmware_stream_open = false;
+
+    firmware_update_config_t config;
+    config.start_callback   = board_firmware_start;
+    config.write_callback   = board_firmware_write;
+    config.commit_callback  = board_firmware_commit;
+    config.discard_callback = board_firmware_discard;
+    config.send_callback    = board_firmware_send_frame;
+    config.time_callback    = board_firmware_get_time;
+    config.max_image_size   = FIRMWARE_MAX_SIZE;
+
+    firmware_update_init(&firmware_update, &config);
+
+    return;
+}
+
+int board_firmware_process (uint8_t const * const data, size_t size, bool * const is_complete, std_error_t * const error)
+{
+    const int exit_code = firmware_update_process(&firmware_update, data, size, error);
+
+    firmware_update_state_t state;
+    firmware_update_get_state(&firmware_update, &state);
+
+    *is_complete = (state == COMPLETE_STATE);
+
+    return exit_code;
+}
+
+void board_firmware_resume ()
+{
+    firmware_update_resume(&firmware_update);
+
+    return;
+}
+
+void board_firmware_poll ()
+{
+    firmware_update_poll(&firmware_update);
+
+    return;
+}
+
+void board_firmware_confirm ()
+{
+    // Reaching the server proves the image good enough, the bootloader stops counting its boots
+    if (boot_is_confirmed(board_rtc_backup_read(BOOT_STATE_REGISTER)) != true)
+    {
+        LOG("Board [boot] : confirm firmware\r\n");
+
+        board_rtc_backup_write(BOOT_STATE_REGISTER, BOOT_CONFIRMED_STATE);
+    }
+
+    return;
+}
+
+int board_firmware_verify (uint32_t * const image_size, std_error_t * const error)
+{
+    image_config_t config;
+    config.crc_callback = board_crc_calculate;
+    config.image        = (uint32_t const*)(FIRMWARE_START_ADDRESS);
+    config.max_size     = FIRMWARE_MAX_SIZE;
+
+    image_info_t info;
+
+    const int exit_code = image_verify(&config, &info, error);
+
+    *image_size = info.size;
+
+    return exit_code;
+}
+
+
+
+int board_firmware_start (firmware_update_header_t const * const header, std_error_t * const error)
+{
+    LOG("Board [firmware] : start, size = %lu bytes\r\n", (unsigned long)(header->image_size));
+
+    const char file_name[64] = FIRMWARE_PART_FILE_NAME "\0";
+
+    if (storage_create_stream(board_storage_get(), &firmware_stream, file_name, STORAGE_STREAM_CHECKPOINT_SIZE, error) != STD_SUCCESS)
+    {
+        return STD_FAILURE;
+    }
+    is_firmware_stream_open = true;
+
+    return STD_SUCCESS;
+}
+
+int board_firmware_write (uint8_t const * const data, size_t size, std_error_t * const error)
+{
+    return storage_write_stream(board_storage_get(), &firmware_stream, data, size, error);
+}
+
+int board_firmware_commit (firmware_update_header_t const * const header, std_error_t * const error)
+{
+    const char part_file_name[64]   = FIRMWARE_PART_FILE_NAME "\0";
+    const char file_name[64]        = FIRMWARE_FILE_NAME "\0";
+
+    size_t firmware_size;
+
+    is_firmware_stream_open = false;
+
+    if (storage_close_stream(board_storage_get(), &firmware_stream, &firmware_size, error) != STD_SUCCESS)
+    {
+        return STD_FAILURE;
+    }
+
+    // Check what the flash holds, not what was sent to it
+    storage_file_t file;
+
+    if (storage_open_file(board_storage_get(), &file, part_file_name, error) != STD_SUCCESS)
+    {
+        return STD_FAILURE;
+    }
+
+    uint32_t crc = CRC32_INITIAL_VALUE;
+    size_t read_size = 0U;
+
+    while (true)
+    {
+        char data[STORAGE_CACHE_SIZE_MAX];
+        size_t size;
+
+        if (storage_read_file(board_storage_get(), &file, data, &size, ARRAY_SIZE(data), error) != STD_SUCCESS)
+        {
+            storage_close_file(board_storage_get(), &file, error);
+
+            return STD_FAILURE;
+        }
+
+        if (size == 0U)
+        {
+            break;
+        }
+
+        crc = crc32_update(crc, (const uint8_t*)(data), size);
+        read_size += size;
+    }
+
+    if (storage_close_file(board_storage_get(), &file, error) != STD_SUCCESS)
+    {
+        return STD_FAILURE;
+    }
+
+    LOG("Board [firmware] : size = %u bytes, crc32 = %08lx\r\n", (unsigned int)(read_size), (unsigned long)(crc));
+
+    if ((read_size != (size_t)(header->image_size)) || (crc != header->image_crc32))
+    {
+        std_error_catch_custom(error, STD_FAILURE, FIRMWARE_ERROR_TEXT, __FILE__, __LINE__);
+
+        return STD_FAILURE;
+    }
+
+    int exit_code;
+
+    if (header->image_type == PATCH_IMAGE_TYPE)
+    {
+        exit_code = board_firmware_apply_patch(error);
+    }
+    else
+    {
+        // The bootloader erases the application before it can tell the image is unusable
+        exit_code = board_firmware_check_image(part_file_name, error);
+
+        // The bootloader takes the file only now, when it is known to be whole
+        if (exit_code == STD_SUCCESS)
+        {
+            exit_code = storage_rename_file(board_storage_get(), part_file_name, file_name, error);
+        }
+    }
+
+    if (exit_code != STD_SUCCESS)
+    {
+        return STD_FAILURE;
+    }
+
+    // Without the flag the bootloader does not even mount littlefs
+    board_rtc_backup_write(BOOT_PENDING_REGISTER, BOOT_PENDING_FLAG);
+
+    return STD_SUCCESS;
+}
+
+void board_firmware_discard ()
+{
+    std_error_t error;
+    std_error_init(&error);
+
+    const char file_name[64] = FIRMWARE_PART_FILE_NAME "\0";
+
+    LOG("Board [firmware] : discard\r\n");
+
+    if (is_firmware_stream_open == true)
+    {
+        size_t firmware_size;
+        storage_close_stream(board_storage_get(), &firmware_stream, &firmware_size, &error);
+
+        is_firmware_stream_open = false;
+    }
+
+    storage_remove_file(board_storage_get(), file_name, &error);
+
+    return;
+}
+
+void board_firmware_send_frame (uint8_t const * const frame, size_t size)
+{
+    tcp_msg_t msg;
+
+    assert(size <= ARRAY_SIZE(msg.data));
+
+    memcpy((void*)(msg.data), (const void*)(frame), size);
+    msg.size = size;
+
+    LATENCY_CLEAR(&msg.trace);
+
+    tcp_client_send_message(&msg);
+
+    return;
+}
+
+uint32_t board_firmware_get_time ()
+{
+    return (uint32_t)(xTaskGetTickCount() * portTICK_PERIOD_MS);
+}
+
+int board_firmware_apply_patch (std_error_t * const error)
+{
+    const char part_file_name[64]   = FIRMWARE_PART_FILE_NAME "\0";
+    const char new_file_name[64]    = FIRMWARE_NEW_FILE_NAME "\0";
+    const char file_name[64]        = FIRMWARE_FILE_NAME "\0";
+
+    LOG("Board [firmware] : apply patch\r\n");
+
+    patcher_config_t patcher_config;
+    patcher_config.read_callback    = board_firmware_read_running;
+    patcher_config.write_callback   = board_firmware_write;
+    patcher_config.max_old_size     = FIRMWARE_MAX_SIZE;
+    patcher_config.max_new_size     = FIRMWARE_MAX_SIZE;
+
+    patcher_init(&firmware_patcher, &patcher_config);
+
+    storage_file_t file;
+
+    if (storage_open_file(board_storage_get(), &file, part_file_name, error) != STD_SUCCESS)
+    {
+        return STD_FAILURE;
+    }
+
+    if (storage_create_stream(board_storage_get(), &firmware_stream, new_file_name, STORAGE_STREAM_CHECKPOINT_SIZE, error) != STD_SUCCESS)
+    {
+        storage_close_file(board_storage_get(), &file, NULL);
+
+        return STD_FAILURE;
+    }
+
+    // A patch is mostly zero differences, so it may come compressed like a full image
+    bool is_compressed  = false;
+    bool is_first_chunk = true;
+    int exit_code       = STD_SUCCESS;
+
+    while (exit_code == STD_SUCCESS)
+    {
+        uint8_t data[STORAGE_CACHE_SIZE_MAX];
+        size_t size;
+
+        exit_code = storage_read_file(board_storage_get(), &file, (char*)(data), &size, ARRAY_SIZE(data), error);
+
+        if ((exit_code != STD_SUCCESS) || (size == 0U))
+        {
+            break;
+        }
+
+        size_t offset = 0U;
+
+        if (is_first_chunk == true)
+        {
+            decompressor_header_t header;
+
+            is_first_chunk  = false;
+            is_compressed   = (size >= DECOMPRESSOR_HEADER_SIZE) && (decompressor_parse_header(data, &header) == true);
+
+            if (is_compressed == true)
+            {
+                decompressor_config_t decompressor_config;
+                decompressor_config.write_callback = board_firmware_process_patch;
+
+                exit_code   = decompressor_init(&firmware_decompressor, &decompressor_config, &header, error);
+                offset      = DECOMPRESSOR_HEADER_SIZE;
+            }
+        }
+
+        if (exit_code == STD_SUCCESS)
+        {
+            if (is_compressed == true)
+            {
+                exit_code = decompressor_process(&firmware_decompressor, &data[offset], size - offset, error);
+            }
+            else
+            {
+                exit_code = board_firmware_process_patch(data, size, error);
+            }
+        }
+    }
+
+    if ((exit_code == STD_SUCCESS) && (is_compressed == true))
+    {
+        exit_code = decompressor_finish(&firmware_decompressor, error);
+    }
+
+    if (exit_code == STD_SUCCESS)
+    {
+        exit_code = patcher_finish(&firmware_patcher, error);
+    }
+
+    size_t firmware_size;
+
+    if (exit_code == STD_SUCCESS)
+    {
+        exit_code = storage_close_stream(board_storage_get(), &firmware_stream, &firmware_size, error);
+    }
+    else
+    {
+        storage_close_stream(board_storage_get(), &firmware_stream, &firmware_size, NULL);
+    }
+
+    storage_close_file(board_storage_get(), &file, NULL);
+
+    if (exit_code != STD_SUCCESS)
+    {
+        storage_remove_file(board_storage_get(), new_file_name, NULL);
+
+        return STD_FAILURE;
+    }
+
+    LOG("Board [firmware] : patched size = %u bytes\r\n", (unsigned int)(firmware_size));
+
+    // The new crc32 of the patch covers what was written, not what the W25Q holds nor the trailer
+    if (board_firmware_check_image(new_file_name, error) != STD_SUCCESS)
+    {
+        storage_remove_file(board_storage_get(), new_file_name, NULL);
+
+        return STD_FAILURE;
+    }
+
+    // The patched image has been checked as the bootloader will check it, the patch is not needed anymore
+    if (storage_rename_file(board_storage_get(), new_file_name, file_name, error) != STD_SUCCESS)
+    {
+        return STD_FAILURE;
+    }
+
+    return storage_remove_file(board_storage_get(), part_file_name, error);
+}
+
+int board_firmware_process_patch (uint8_t const * const data, size_t size, std_error_t * const error)
+{
+    return patcher_process(&firmware_patcher, data, size, error);
+}
+
+int board_firmware_read_running (uint32_t offset, uint8_t * const data, size_t size, std_error_t * const error)
+{
+    UNUSED(error);
+
+    memcpy((void*)(data), (const void*)(FIRMWARE_START_ADDRESS + offset), size);
+
+    return STD_SUCCESS;
+}
+
+int board_firmware_check_image (char const * const file_name, std_error_t * const error)
+{
+    LOG("Board [firmware] : check image\r\n");
+
+    image_checker_init(&firmware_checker, crc32_update, FIRMWARE_MAX_SIZE);
+
+    storage_file_t file;
+
+    if (storage_open_file(board_storage_get(), &file, file_name, error) != STD_SUCCESS)
+    {
+        return STD_FAILURE;
+    }
+
+    bool is_compressed  = false;
+    bool is_first_chunk = true;
+    int exit_code       = STD_SUCCESS;
+
+    while (exit_code == STD_SUCCESS)
+    {
+        uint8_t data[STORAGE_CACHE_SIZE_MAX];
+        size_t size;
+
+        exit_code = storage_read_file(board_storage_get(), &file, (char*)(data), &size, ARRAY_SIZE(data), error);
+
+        if ((exit_code != STD_SUCCESS) || (size == 0U))
+        {
+            break;
+        }
+
+        size_t offset = 0U;
+
+        if (is_first_chunk == true)
+        {
+            decompressor_header_t header;
+
+            is_first_chunk  = false;
+            is_compressed   = (size >= DECOMPRESSOR_HEADER_SIZE) && (decompressor_parse_header(data, &header) == true);
+
+            // The bootloader erases as much flash as the header announces
+            if ((is_compressed == true) && (header.image_size > FIRMWARE_MAX_SIZE))
+            {
+                std_error_catch_custom(error, STD_FAILURE, FIRMWARE_ERROR_TEXT, __FILE__, __LINE__);
+
+                exit_code = STD_FAILURE;
+                break;
+            }
+
+            if (is_compressed == true)
+            {
+                decompressor_config_t decompressor_config;
+                decompressor_config.write_callback = board_firmware_check_chunk;
+
+                exit_code   = decompressor_init(&firmware_decompressor, &decompressor_config, &header, error);
+                offset      = DECOMPRESSOR_HEADER_SIZE;
+            }
+        }
+
+        if (exit_code == STD_SUCCESS)
+        {
+            if (is_compressed == true)
+            {
+                exit_code = decompressor_process(&firmware_decompressor, &data[offset], size - offset, error);
+            }
+            else
+            {
+                exit_code = board_firmware_check_chunk(data, size, error);
+            }
+        }
+    }
+
+    if ((exit_code == STD_SUCCESS) && (is_compressed == true))
+    {
+        exit_code = decompressor_finish(&firmware_decompressor, error);
+    }
+
+    storage_close_file(board_storage_get(), &file, NULL);
+
+    if (exit_code != STD_SUCCESS)
+    {
+        return STD_FAILURE;
+    }
+
+    // The magic, the size and the trailer crc32 the bootloader checks once the image is flashed
+    image_info_t info;
+
+    return image_checker_finish(&firmware_checker, &info, error);
+}
+
+int board_firmware_check_chunk (uint8_t const * const data, size_t size, std_error_t * const error)
+{
+    UNUSED(error);
+
+    image_checker_process(&firmware_checker, data, size);
+
+    return STD_SUCCESS;
+}
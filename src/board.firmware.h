@@ -0,0 +1,30 @@
+/************************************************************
+ *   Author : German Mundinger
+ *   Date   : 2024
+ ************************************************************/
+
+#ifndef BOARD_FIRMWARE_H
+#define BOARD_FIRMWARE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+typedef struct std_error std_error_t;
+
+// The RTC backup registers and the CRC unit go first, the image goes to the storage of board.storage.h
+void board_firmware_init ();
+
+// The frames of firmware_update.h from the TCP client task, the result frames go back by it too.
+// Complete - the image is committed and the bootloader flashes it after a reset.
+int board_firmware_process (uint8_t const * const data, size_t size, bool * const is_complete, std_error_t * const error);
+void board_firmware_resume ();
+void board_firmware_poll ();   // From the TCP client task as well, a lost RESUME is sent again
+
+// Reaching the server proves the image good enough, the bootloader stops counting its boots
+void board_firmware_confirm ();
+
+// The same check the bootloader does before the jump, a few ms of the CRC unit
+int board_firmware_verify (uint32_t * const image_size, std_error_t * const error);
+
+#endif // BOARD_FIRMWARE_H
@@ -0,0 +1,43 @@
+/************************************************************
+ *   Author : German Mundinger
+ *   Date   : 2024
+ ************************************************************/
+
+#include "board.rtc_backup.h"
+
+#include <assert.h>
+
+#include "stm32f4xx_hal.h"
+
+
+#define RTC_BACKUP_REGISTER_COUNT 20U
+
+
+void board_rtc_backup_init ()
+{
+    // The backup domain is write protected after reset
+    __HAL_RCC_PWR_CLK_ENABLE();
+    HAL_PWR_EnableBkUpAccess();
+
+    return;
+}
+
+uint32_t board_rtc_backup_read (uint32_t register_number)
+{
+    assert(register_number < RTC_BACKUP_REGISTER_COUNT);
+
+    volatile uint32_t const * const backup_registers = &(RTC->BKP0R);
+
+    return backup_registers[register_number];
+}
+
+void board_rtc_backup_write (uint32_t register_number, uint32_t value)
+{
+    assert(register_number < RTC_BACKUP_REGISTER_COUNT);
+
+    volatile uint32_t * const backup_registers = &(RTC->BKP0R);
+
+    backup_registers[register_number] = value;
+
+    return;
+}
@@ -0,0 +1,17 @@
+/************************************************************
+ *   Author : German Mundinger
+ *   Date   : 2024
+ ************************************************************/
+
+#ifndef BOARD_RTC_BACKUP_H
+#define BOARD_RTC_BACKUP_H
+
+#include <stdint.h>
+
+// Survive any reset but a backup domain one (power loss without VBAT)
+void board_rtc_backup_init ();
+
+uint32_t board_rtc_backup_read (uint32_t register_number);
+void board_rtc_backup_write (uint32_t register_number, uint32_t value);
+
+#endif // BOARD_RTC_BACKUP_H
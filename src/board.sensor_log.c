@@ -0,0 +1,290 @@
+/************************************************************
+ *   Author : German Mundinger
+ *   Date   : 2024
+ ************************************************************/
+
+#include "board.sensor_log.h"
+
+#include <stdbool.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+
+#include "board.storage.h"
+#include "storage_service.h"
+#include "sensor_log.h"
+#include "node.h"
+#include "latency.h"
+
+#include "logger.h"
+#include "std_error/std_error.h"
+
+
+#define SENSOR_LOG_QUEUE_TIMEOUT_MS (2U * 1000U)    // 2 sec, the worst W25Q 64 KB block erase
+
+#define DEFAULT_ERROR_TEXT  "Board sensor log error"
+#define MALLOC_ERROR_TEXT   "Board sensor log memory allocation error"
+
+
+static SemaphoreHandle_t sensor_log_mutex;
+
+static sensor_log_t sensor_log;
+static bool is_sensor_log_ready;
+static node_msg_t history_request;
+static uint32_t log_time_s;
+static uint32_t log_time_remainder_ms;
+static TickType_t log_time_tick_count;
+
+
+static int board_sensor_log_malloc (std_error_t * const error);
+
+static int board_sensor_log_queue_request (storage_request_t const * const request, std_error_t * const error);
+static uint32_t board_sensor_log_get_time ();
+
+int board_sensor_log_init (std_error_t * const error)
+{
+    is_sensor_log_ready = false;
+
+    // Goes on from the latest record, the time of the log never goes back
+    log_time_s              = 0U;
+    log_time_remainder_ms   = 0U;
+    log_time_tick_count     = xTaskGetTickCount();
+
+    if (board_sensor_log_malloc(error) != STD_SUCCESS)
+    {
+        return STD_FAILURE;
+    }
+
+    if (board_storage_is_mounted() != true)
+    {
+        std_error_catch_custom(error, STD_FAILURE, DEFAULT_ERROR_TEXT, __FILE__, __LINE__);
+
+        return STD_FAILURE;
+    }
+
+    sensor_log_config_t config;
+    config.storage          = board_storage_get();
+    config.request_callback = (board_storage_is_service_ready() == true) ? board_sensor_log_queue_request : NULL;
+
+    if (sensor_log_init(&sensor_log, &config, error) != STD_SUCCESS)
+    {
+        return STD_FAILURE;
+    }
+    is_sensor_log_ready = true;
+
+    if (sensor_log_get_last_time(&sensor_log, &log_time_s) == true)
+    {
+        ++log_time_s;
+    }
+
+    return STD_SUCCESS;
+}
+
+void board_sensor_log_append (uint8_t sensor_id, float value)
+{
+    std_error_t error;
+    std_error_init(&error);
+
+    // Set once by the init, before the other tasks start
+    if (sensor_log_mutex == NULL)
+    {
+        return;
+    }
+
+    xSemaphoreTake(sensor_log_mutex, portMAX_DELAY);
+
+    if (is_sensor_log_ready == true)
+    {
+        if (sensor_log_append(&sensor_log, board_sensor_log_get_time(), sensor_id, value, &error) != STD_SUCCESS)
+        {
+            LOG("Board [sensor_log] : %s\r\n", error.text);
+        }
+    }
+
+    xSemaphoreGive(sensor_log_mutex);
+
+    return;
+}
+
+void board_sensor_log_stop ()
+{
+    std_error_t error;
+    std_error_init(&error);
+
+    if (sensor_log_mutex == NULL)
+    {
+        return;
+    }
+
+    xSemaphoreTake(sensor_log_mutex, portMAX_DELAY);
+
+    if (is_sensor_log_ready == true)
+    {
+        sensor_log_flush(&sensor_log, &error);
+    }
+    is_sensor_log_ready = false;
+
+    board_storage_drain();
+
+    xSemaphoreGive(sensor_log_mutex);
+
+    return;
+}
+
+void board_sensor_log_request_history (node_msg_t const * const msg)
+{
+    if (sensor_log_mutex == NULL)
+    {
+        return;
+    }
+
+    xSemaphoreTake(sensor_log_mutex, portMAX_DELAY);
+    history_request = *msg;
+    xSemaphoreGive(sensor_log_mutex);
+
+    return;
+}
+
+void board_sensor_log_send_history (node_id_t node_id)
+{
+    std_error_t error;
+    std_error_init(&error);
+
+    if (sensor_log_mutex == NULL)
+    {
+        return;
+    }
+
+    sensor_log_cursor_t cursor;
+    bool is_record_valid = false;
+
+    xSemaphoreTake(sensor_log_mutex, portMAX_DELAY);
+
+    const node_msg_t request_msg = history_request;
+
+    if (is_sensor_log_ready == true)
+    {
+        LOG("Board [sensor_log] : history from %ld to %ld s\r\n", (long)(request_msg.value_0), (long)(request_msg.value_1));
+
+        // The queued writes first, the query reads the W25Q
+        sensor_log_flush(&sensor_log, &error);
+        board_storage_drain();
+
+        // Negative bounds come from a broken request, they select nothing
+        is_record_valid = (request_msg.value_0 >= 0) && (request_msg.value_1 >= 0);
+
+        if ((is_record_valid == true) &&
+            (sensor_log_find(&sensor_log, &cursor, (uint32_t)(request_msg.value_0), (uint32_t)(request_msg.value_1), &error) != STD_SUCCESS))
+        {
+            LOG("Board [sensor_log] : %s\r\n", error.text);
+
+            is_record_valid = false;
+        }
+    }
+
+    xSemaphoreGive(sensor_log_mutex);
+
+    node_msg_t msg;
+
+    size_t i = 0U;
+
+    msg.header.source = node_id;
+    msg.header.dest_array[i] = request_msg.header.source;
+    ++i;
+    msg.header.dest_array_size = i;
+
+    LATENCY_CLEAR(&msg.trace);
+
+    uint32_t record_count = 0U;
+
+    while ((is_record_valid == true) && (record_count < NODE_HISTORY_MAX_RECORD_COUNT))
+    {
+        sensor_log_record_t record;
+
+        // Released between the records, the readings go on meanwhile
+        xSemaphoreTake(sensor_log_mutex, portMAX_DELAY);
+        const int exit_code = sensor_log_read_next(&sensor_log, &cursor, &record, &is_record_valid, &error);
+        xSemaphoreGive(sensor_log_mutex);
+
+        if (exit_code != STD_SUCCESS)
+        {
+            LOG("Board [sensor_log] : %s\r\n", error.text);
+
+            break;
+        }
+
+        if (is_record_valid != true)
+        {
+            break;
+        }
+
+        msg.cmd_id  = RESPONSE_HISTORY;
+        msg.value_0 = (int32_t)(record.time_s);
+        msg.value_1 = (int32_t)(record.sensor_id);
+        msg.value_2 = sensor_log_get_value(&record);
+
+        if (node_send_msg(&msg, &error) != STD_SUCCESS)
+        {
+            LOG("Board [node] : %s\r\n", error.text);
+
+            break;
+        }
+
+        ++record_count;
+    }
+
+    xSemaphoreTake(sensor_log_mutex, portMAX_DELAY);
+    const uint32_t time_s = board_sensor_log_get_time();
+    xSemaphoreGive(sensor_log_mutex);
+
+    // Lets the server map the log time to its clock and see whether to ask for more
+    msg.cmd_id  = RESPONSE_HISTORY_END;
+    msg.value_0 = (int32_t)(time_s);
+    msg.value_1 = (int32_t)(record_count);
+    msg.value_2 = 0.0F;
+
+    if (node_send_msg(&msg, &error) != STD_SUCCESS)
+    {
+        LOG("Board [node] : %s\r\n", error.text);
+    }
+
+    return;
+}
+
+int board_sensor_log_malloc (std_error_t * const error)
+{
+    sensor_log_mutex = xSemaphoreCreateMutex();
+
+    if (sensor_log_mutex == NULL)
+    {
+        std_error_catch_custom(error, STD_FAILURE, MALLOC_ERROR_TEXT, __FILE__, __LINE__);
+
+        return STD_FAILURE;
+    }
+    return STD_SUCCESS;
+}
+
+
+
+int board_sensor_log_queue_request (storage_request_t const * const request, std_error_t * const error)
+{
+    // Off the calling task, a W25Q erase stalls the storage task only. A slot frees up within a write or two,
+    // a flush is not dropped unless the storage task is stuck.
+    return storage_service_submit(request, STORAGE_SERVICE_LOW_PRIORITY, SENSOR_LOG_QUEUE_TIMEOUT_MS, NULL, NULL, error);
+}
+
+uint32_t board_sensor_log_get_time ()
+{
+    // No wall clock on the board: uptime seconds, carried over from boot to boot by the latest record.
+    // Called at least every reading period, well before the tick count wraps.
+    const TickType_t tick_count = xTaskGetTickCount();
+
+    const uint32_t elapsed_ms = ((uint32_t)(tick_count - log_time_tick_count) * portTICK_PERIOD_MS) + log_time_remainder_ms;
+
+    log_time_s              += elapsed_ms / 1000U;
+    log_time_remainder_ms   = elapsed_ms % 1000U;
+    log_time_tick_count     = tick_count;
+
+    return log_time_s;
+}
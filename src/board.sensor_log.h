@@ -0,0 +1,28 @@
+/************************************************************
+ *   Author : German Mundinger
+ *   Date   : 2024
+ ************************************************************/
+
+#ifndef BOARD_SENSOR_LOG_H
+#define BOARD_SENSOR_LOG_H
+
+#include <stdint.h>
+
+#include "node.type.h"
+
+typedef struct std_error std_error_t;
+
+// On the storage of board.storage.h, written by the storage task if there is one, in place otherwise
+int board_sensor_log_init (std_error_t * const error);
+
+// Any task, the time comes from the log clock: uptime seconds carried over from boot to boot
+void board_sensor_log_append (uint8_t sensor_id, float value);
+
+// Before a reset: the buffered readings go to the W25Q, nothing is logged after
+void board_sensor_log_stop ();
+
+// The latest request wins, streamed later by board_sensor_log_send_history()
+void board_sensor_log_request_history (node_msg_t const * const msg);
+void board_sensor_log_send_history (node_id_t node_id);
+
+#endif // BOARD_SENSOR_LOG_H
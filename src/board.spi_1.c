@@ -5,8 +5,12 @@
 
 #include "board.spi_1.h"
 
+#include <assert.h>
+
 #include "stm32f4xx_hal.h"
 
+#include "spi_fast.h"
+
 #include "std_error/std_error.h"
 
 
@@ -14,10 +18,15 @@
 
 
 static SPI_HandleTypeDef spi_1_handler;
+static DMA_HandleTypeDef spi_1_rx_dma_handler;
+static DMA_HandleTypeDef spi_1_tx_dma_handler;
+static board_spi_1_dma_callback_t spi_1_dma_callback;
 
 
 static void board_spi_1_msp_init (SPI_HandleTypeDef *spi_handler);
 static void board_spi_1_msp_deinit (SPI_HandleTypeDef *spi_handler);
+static void board_spi_1_dma_complete (SPI_HandleTypeDef *spi_handler);
+static void board_spi_1_dma_error (SPI_HandleTypeDef *spi_handler);
 
 int board_spi_1_init (std_error_t * const error)
 {
@@ -107,6 +116,16 @@ int board_spi_1_read_write (uint8_t *tx_data,
                             uint32_t timeout_ms,
                             std_error_t * const error)
 {
+    if (tx_data == NULL)
+    {
+        return board_spi_1_read(rx_data, size, timeout_ms, error);
+    }
+
+    if (rx_data == NULL)
+    {
+        return board_spi_1_write(tx_data, size, timeout_ms, error);
+    }
+
     const HAL_StatusTypeDef status = HAL_SPI_TransmitReceive(&spi_1_handler, tx_data, rx_data, size, timeout_ms);
 
     if (status != HAL_OK)
@@ -118,6 +137,168 @@ int board_spi_1_read_write (uint8_t *tx_data,
     return STD_SUCCESS;
 }
 
+int board_spi_1_read_write_fast (uint8_t *tx_data,
+                                uint8_t *rx_data,
+                                uint16_t size,
+                                uint32_t timeout_ms,
+                                std_error_t * const error)
+{
+    UNUSED(timeout_ms);
+
+    if (spi_fast_read_write(spi_1_handler.Instance, tx_data, rx_data, size) != true)
+    {
+        std_error_catch_custom(error, (int)(HAL_TIMEOUT), DEFAULT_ERROR_TEXT, __FILE__, __LINE__);
+
+        return STD_FAILURE;
+    }
+    return STD_SUCCESS;
+}
+
+int board_spi_1_init_dma (board_spi_1_dma_callback_t dma_callback, std_error_t * const error)
+{
+    assert(dma_callback != NULL);
+
+    spi_1_dma_callback = dma_callback;
+
+    // DMA controller clock enable
+    __HAL_RCC_DMA2_CLK_ENABLE();
+
+    // SPI1_RX - DMA2 stream 2 channel 3, stream 0 is left to ADC1
+    spi_1_rx_dma_handler.Instance                   = DMA2_Stream2;
+    spi_1_rx_dma_handler.Init.Channel               = DMA_CHANNEL_3;
+    spi_1_rx_dma_handler.Init.Direction             = DMA_PERIPH_TO_MEMORY;
+    spi_1_rx_dma_handler.Init.PeriphInc             = DMA_PINC_DISABLE;
+    spi_1_rx_dma_handler.Init.MemInc                = DMA_MINC_ENABLE;
+    spi_1_rx_dma_handler.Init.PeriphDataAlignment   = DMA_PDATAALIGN_BYTE;
+    spi_1_rx_dma_handler.Init.MemDataAlignment      = DMA_MDATAALIGN_BYTE;
+    spi_1_rx_dma_handler.Init.Mode                  = DMA_NORMAL;
+    spi_1_rx_dma_handler.Init.Priority              = DMA_PRIORITY_HIGH;   // An overrun loses data, a late TX only stretches the clock
+    spi_1_rx_dma_handler.Init.FIFOMode              = DMA_FIFOMODE_DISABLE;
+
+    HAL_StatusTypeDef status = HAL_DMA_Init(&spi_1_rx_dma_handler);
+
+    if (status != HAL_OK)
+    {
+        std_error_catch_custom(error, (int)status, DEFAULT_ERROR_TEXT, __FILE__, __LINE__);
+
+        return STD_FAILURE;
+    }
+    __HAL_LINKDMA(&spi_1_handler, hdmarx, spi_1_rx_dma_handler);
+
+    // SPI1_TX - DMA2 stream 3 channel 3
+    spi_1_tx_dma_handler.Instance                   = DMA2_Stream3;
+    spi_1_tx_dma_handler.Init.Channel               = DMA_CHANNEL_3;
+    spi_1_tx_dma_handler.Init.Direction             = DMA_MEMORY_TO_PERIPH;
+    spi_1_tx_dma_handler.Init.PeriphInc             = DMA_PINC_DISABLE;
+    spi_1_tx_dma_handler.Init.MemInc                = DMA_MINC_ENABLE;
+    spi_1_tx_dma_handler.Init.PeriphDataAlignment   = DMA_PDATAALIGN_BYTE;
+    spi_1_tx_dma_handler.Init.MemDataAlignment      = DMA_MDATAALIGN_BYTE;
+    spi_1_tx_dma_handler.Init.Mode                  = DMA_NORMAL;
+    spi_1_tx_dma_handler.Init.Priority              = DMA_PRIORITY_MEDIUM;
+    spi_1_tx_dma_handler.Init.FIFOMode              = DMA_FIFOMODE_DISABLE;
+
+    status = HAL_DMA_Init(&spi_1_tx_dma_handler);
+
+    if (status != HAL_OK)
+    {
+        std_error_catch_custom(error, (int)status, DEFAULT_ERROR_TEXT, __FILE__, __LINE__);
+
+        return STD_FAILURE;
+    }
+    __HAL_LINKDMA(&spi_1_handler, hdmatx, spi_1_tx_dma_handler);
+
+    // A receive only transfer still clocks the TX stream, so all three ends go to the same place
+    HAL_SPI_RegisterCallback(&spi_1_handler, HAL_SPI_TX_COMPLETE_CB_ID,     board_spi_1_dma_complete);
+    HAL_SPI_RegisterCallback(&spi_1_handler, HAL_SPI_RX_COMPLETE_CB_ID,     board_spi_1_dma_complete);
+    HAL_SPI_RegisterCallback(&spi_1_handler, HAL_SPI_TX_RX_COMPLETE_CB_ID,  board_spi_1_dma_complete);
+    HAL_SPI_RegisterCallback(&spi_1_handler, HAL_SPI_ERROR_CB_ID,           board_spi_1_dma_error);
+
+    // DMA and SPI interrupt init, within the FreeRTOS syscall range
+    HAL_NVIC_SetPriority(DMA2_Stream2_IRQn, 6U, 0U);
+    HAL_NVIC_EnableIRQ(DMA2_Stream2_IRQn);
+    HAL_NVIC_SetPriority(DMA2_Stream3_IRQn, 6U, 0U);
+    HAL_NVIC_EnableIRQ(DMA2_Stream3_IRQn);
+    HAL_NVIC_SetPriority(SPI1_IRQn, 6U, 0U);
+    HAL_NVIC_EnableIRQ(SPI1_IRQn);
+
+    return STD_SUCCESS;
+}
+
+int board_spi_1_start_dma ( uint8_t *tx_data,
+                            uint8_t *rx_data,
+                            uint16_t size,
+                            std_error_t * const error)
+{
+    HAL_StatusTypeDef status;
+
+    if (tx_data == NULL)
+    {
+        status = HAL_SPI_Receive_DMA(&spi_1_handler, rx_data, size);
+    }
+    else if (rx_data == NULL)
+    {
+        status = HAL_SPI_Transmit_DMA(&spi_1_handler, tx_data, size);
+    }
+    else
+    {
+        status = HAL_SPI_TransmitReceive_DMA(&spi_1_handler, tx_data, rx_data, size);
+    }
+
+    if (status != HAL_OK)
+    {
+        std_error_catch_custom(error, (int)status, DEFAULT_ERROR_TEXT, __FILE__, __LINE__);
+
+        return STD_FAILURE;
+    }
+    return STD_SUCCESS;
+}
+
+void board_spi_1_abort_dma ()
+{
+    HAL_SPI_Abort(&spi_1_handler);
+
+    return;
+}
+
+void DMA2_Stream2_IRQHandler ()
+{
+    HAL_DMA_IRQHandler(&spi_1_rx_dma_handler);
+
+    return;
+}
+
+void DMA2_Stream3_IRQHandler ()
+{
+    HAL_DMA_IRQHandler(&spi_1_tx_dma_handler);
+
+    return;
+}
+
+void SPI1_IRQHandler ()
+{
+    HAL_SPI_IRQHandler(&spi_1_handler);
+
+    return;
+}
+
+
+void board_spi_1_dma_complete (SPI_HandleTypeDef *spi_handler)
+{
+    UNUSED(spi_handler);
+
+    spi_1_dma_callback(true);
+
+    return;
+}
+
+void board_spi_1_dma_error (SPI_HandleTypeDef *spi_handler)
+{
+    UNUSED(spi_handler);
+
+    spi_1_dma_callback(false);
+
+    return;
+}
 
 void board_spi_1_msp_init (SPI_HandleTypeDef *spi_handler)
 {
@@ -7,9 +7,12 @@
 #define BOARD_SPI_1_H
 
 #include <stdint.h>
+#include <stdbool.h>
 
 typedef struct std_error std_error_t;
 
+typedef void (*board_spi_1_dma_callback_t) (bool is_success);
+
 int board_spi_1_init (std_error_t * const error);
 void board_spi_1_deinit ();
 
@@ -26,10 +29,28 @@ int board_spi_1_write (uint8_t *data,
                         uint32_t timeout_ms,
                         std_error_t * const error);
 
+// Either data pointer may be NULL for a one-way transfer
 int board_spi_1_read_write (uint8_t *tx_data,
                             uint8_t *rx_data,
                             uint16_t size,
                             uint32_t timeout_ms,
                             std_error_t * const error);
 
+// Register level, for the polled few byte transfers; the timeout is a spin limit instead
+int board_spi_1_read_write_fast (uint8_t *tx_data,
+                                uint8_t *rx_data,
+                                uint16_t size,
+                                uint32_t timeout_ms,
+                                std_error_t * const error);
+
+// DMA2 stream 2 (RX) and stream 3 (TX), the callback comes from their interrupts
+int board_spi_1_init_dma (board_spi_1_dma_callback_t dma_callback, std_error_t * const error);
+
+int board_spi_1_start_dma ( uint8_t *tx_data,
+                            uint8_t *rx_data,
+                            uint16_t size,
+                            std_error_t * const error);
+
+void board_spi_1_abort_dma ();
+
 #endif // BOARD_SPI_1_H
@@ -0,0 +1,206 @@
+/************************************************************
+ *   Author : German Mundinger
+ *   Date   : 2024
+ ************************************************************/
+
+#include "board.storage.h"
+
+#include "stm32f4xx_hal.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+
+#include "board.config.h"
+#include "storage_service.h"
+
+#include "logger.h"
+#include "std_error/std_error.h"
+
+
+#define STORAGE_TIMEOUT_MS          (5U * 1000U)    // 5 sec, a full queue of sensor log writes
+#define STORAGE_PRE_ERASE_PERIOD_MS (1U * 1000U)    // 1 sec, a block of the free space is erased per idle second
+
+#define DEFAULT_ERROR_TEXT  "Board storage error"
+#define MALLOC_ERROR_TEXT   "Board storage memory allocation error"
+
+
+static SemaphoreHandle_t storage_mutex;
+
+static storage_t storage;
+static bool is_storage_initialized;
+static bool is_storage_mounted;
+static bool is_storage_service_ready;
+
+
+static int board_storage_malloc (std_error_t * const error);
+
+static void board_storage_lock ();
+static void board_storage_unlock ();
+
+int board_storage_init (board_storage_config_t const * const init_config, std_error_t * const error)
+{
+    is_storage_initialized      = false;
+    is_storage_mounted          = false;
+    is_storage_service_ready    = false;
+
+    if (board_storage_malloc(error) != STD_SUCCESS)
+    {
+        return STD_FAILURE;
+    }
+
+    // The W25Q busy polling spins on the cycle counter through a page program
+    CoreDebug->DEMCR    |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL           |= DWT_CTRL_CYCCNTENA_Msk;
+
+    storage_config_t config;
+    config.lock_callback            = board_storage_lock;
+    config.unlock_callback          = board_storage_unlock;
+    config.spi_lock_callback        = init_config->spi_lock_callback;
+    config.spi_unlock_callback      = init_config->spi_unlock_callback;
+    config.spi_select_callback      = init_config->spi_select_callback;
+    config.spi_unselect_callback    = init_config->spi_unselect_callback;
+    config.spi_tx_rx_callback       = init_config->spi_tx_rx_callback;
+    config.spi_timeout_ms           = init_config->spi_timeout_ms;
+    config.delay_callback           = vTaskDelay;
+    config.yield_callback           = init_config->yield_callback;
+    config.get_cycles_callback      = init_config->get_cycles_callback;
+    config.cycles_per_us            = SystemCoreClock / 1000000U;
+
+    config.geometry.read_size       = CONFIG_STORAGE_READ_SIZE;
+    config.geometry.prog_size       = CONFIG_STORAGE_PROG_SIZE;
+    config.geometry.cache_size      = CONFIG_STORAGE_CACHE_SIZE;
+    config.geometry.lookahead_size  = CONFIG_STORAGE_LOOKAHEAD_SIZE;
+    config.geometry.block_cycles    = CONFIG_STORAGE_BLOCK_CYCLES;
+
+    if (storage_init(&storage, &config, error) != STD_SUCCESS)
+    {
+        return STD_FAILURE;
+    }
+    is_storage_initialized = true;
+
+    if (board_storage_mount(error) != STD_SUCCESS)
+    {
+        return STD_FAILURE;
+    }
+
+    LOG("Board [storage] : service init\r\n");
+
+    storage_service_config_t service_config;
+    service_config.storage              = &storage;
+    service_config.pre_erase_period_ms  = STORAGE_PRE_ERASE_PERIOD_MS;
+
+    std_error_t service_error;
+    std_error_init(&service_error);
+
+    // The sensor log is written in place without it
+    is_storage_service_ready = (storage_service_init(&service_config, &service_error) == STD_SUCCESS);
+
+    if (is_storage_service_ready != true)
+    {
+        LOG("Board [storage] : %s\r\n", service_error.text);
+    }
+
+    return STD_SUCCESS;
+}
+
+storage_t* board_storage_get ()
+{
+    return &storage;
+}
+
+bool board_storage_is_mounted ()
+{
+    return is_storage_mounted;
+}
+
+bool board_storage_is_service_ready ()
+{
+    return is_storage_service_ready;
+}
+
+int board_storage_mount (std_error_t * const error)
+{
+    if (is_storage_initialized != true)
+    {
+        std_error_catch_custom(error, STD_FAILURE, DEFAULT_ERROR_TEXT, __FILE__, __LINE__);
+
+        return STD_FAILURE;
+    }
+
+    if (is_storage_mounted != true)
+    {
+        if (storage_enable_power(&storage, error) == STD_SUCCESS)
+        {
+            is_storage_mounted = (storage_mount_filesystem(&storage, error) == STD_SUCCESS);
+        }
+    }
+
+    return (is_storage_mounted == true) ? STD_SUCCESS : STD_FAILURE;
+}
+
+void board_storage_unmount ()
+{
+    std_error_t error;
+    std_error_init(&error);
+
+    if (is_storage_initialized != true)
+    {
+        return;
+    }
+
+    is_storage_mounted = false;
+
+    storage_unmount_filesystem(&storage, &error);
+    storage_disable_power(&storage, &error);
+
+    return;
+}
+
+void board_storage_drain ()
+{
+    std_error_t error;
+    std_error_init(&error);
+
+    if (is_storage_service_ready != true)
+    {
+        return;
+    }
+
+    if (storage_service_flush(STORAGE_TIMEOUT_MS, &error) != STD_SUCCESS)
+    {
+        LOG("Board [storage] : %s\r\n", error.text);
+    }
+
+    return;
+}
+
+int board_storage_malloc (std_error_t * const error)
+{
+    storage_mutex = xSemaphoreCreateRecursiveMutex();
+
+    if (storage_mutex == NULL)
+    {
+        std_error_catch_custom(error, STD_FAILURE, MALLOC_ERROR_TEXT, __FILE__, __LINE__);
+
+        return STD_FAILURE;
+    }
+    return STD_SUCCESS;
+}
+
+
+
+void board_storage_lock ()
+{
+    // Taken again by littlefs inside a pre-erase
+    xSemaphoreTakeRecursive(storage_mutex, portMAX_DELAY);
+
+    return;
+}
+
+void board_storage_unlock ()
+{
+    xSemaphoreGiveRecursive(storage_mutex);
+
+    return;
+}
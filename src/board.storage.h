@@ -0,0 +1,42 @@
+/************************************************************
+ *   Author : German Mundinger
+ *   Date   : 2024
+ ************************************************************/
+
+#ifndef BOARD_STORAGE_H
+#define BOARD_STORAGE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "storage.h"
+
+typedef struct board_storage_config
+{
+    storage_spi_lock_callback_t spi_lock_callback;  // SPI1 is shared with the W5500
+    storage_spi_lock_callback_t spi_unlock_callback;
+    storage_spi_select_callback_t spi_select_callback;
+    storage_spi_select_callback_t spi_unselect_callback;
+    storage_spi_tx_rx_callback_t spi_tx_rx_callback;
+    uint32_t spi_timeout_ms;
+
+    storage_yield_callback_t yield_callback;
+    storage_get_cycles_callback_t get_cycles_callback;
+
+} board_storage_config_t;
+
+// The W25Q on SPI1, kept mounted for the sensor log. The storage task takes the queued writes once it is up.
+int board_storage_init (board_storage_config_t const * const config, std_error_t * const error);
+
+storage_t* board_storage_get ();
+bool board_storage_is_mounted ();
+bool board_storage_is_service_ready ();
+
+// Tries again if the mount failed at init
+int board_storage_mount (std_error_t * const error);
+void board_storage_unmount ();
+
+// Waits for the storage task to carry out everything queued so far
+void board_storage_drain ();
+
+#endif // BOARD_STORAGE_H
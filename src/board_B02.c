@@ -24,6 +24,9 @@
 #include "devices/ssd1306_display.h"
 
 #include "node_B02.h"
+#include "retained_state.h"
+#include "format.h"
+#include "latency.h"
 
 #include "logger.h"
 #include "std_error/std_error.h"
@@ -78,11 +81,20 @@ static TimerHandle_t buzzer_timer;
 static board_extension_config_t config;
 
 static node_B02_t *node;
+static uint32_t node_time_offset_ms;   // Of the node time from the tick count, not 0 after a warm restart
+
+#ifdef LATENCY_TRACE
+static volatile uint32_t pir_isr_cycles;
+#endif // LATENCY_TRACE
 
 
 static int board_B02_malloc (std_error_t * const error);
 static void board_B02_task (void *parameters);
 
+static void board_B02_restore_node ();
+static void board_B02_save_node ();
+static uint32_t board_B02_get_node_time ();
+
 static void board_B02_lightning_block_timer (TimerHandle_t timer);
 static void board_B02_veranda_light_timer (TimerHandle_t timer);
 static void board_B02_front_light_timer (TimerHandle_t timer);
@@ -130,8 +142,10 @@ int board_B02_init (board_extension_config_t const * const init_config, std_erro
     assert(init_config                              != NULL);
     assert(init_config->mcp23017_expander           != NULL);
     assert(init_config->storage                     != NULL);
+    assert(init_config->retained_state              != NULL);
     assert(init_config->update_status_led_callback  != NULL);
     assert(init_config->send_node_msg_callback      != NULL);
+    assert(init_config->log_reading_callback        != NULL);
 
     config = *init_config;
 
@@ -150,6 +164,7 @@ void board_B02_task (void *parameters)
     UNUSED(parameters);
 
     node_B02_init(node);
+    board_B02_restore_node();
     board_B02_init_temperature_sensor();
 
     std_error_t error;
@@ -174,14 +189,25 @@ void board_B02_task (void *parameters)
         uint32_t notification;
         xTaskNotifyWait(0U, ULONG_MAX, &notification, portMAX_DELAY);
 
-        const uint32_t tick_count_ms = xTaskGetTickCount();
+        const uint32_t node_time_ms = board_B02_get_node_time();
+
+#ifdef LATENCY_TRACE
+        latency_trace_t trace;
+        latency_clear_trace(&trace);
+
+        if ((notification & (DOOR_PIR_NOTIFICATION | FRONT_PIR_NOTIFICATION | VERANDA_PIR_NOTIFICATION)) != 0U)
+        {
+            latency_stamp_cycles(&trace, ISR_HOP, pir_isr_cycles);
+            latency_stamp(&trace, BOARD_TASK_HOP);
+        }
+#endif // LATENCY_TRACE
 
         if ((notification & DOOR_PIR_NOTIFICATION) != 0U)
         {
             LOG("Board B02 [door_pir] : movement\r\n");
 
             xSemaphoreTake(node_mutex, portMAX_DELAY);
-            node_B02_process_door_movement(node, tick_count_ms);
+            node_B02_process_door_movement(node, node_time_ms);
             xSemaphoreGive(node_mutex);
         }
 
@@ -204,7 +230,7 @@ void board_B02_task (void *parameters)
                 LOG("Board B02 [front_pir] : movement\r\n");
 
                 xSemaphoreTake(node_mutex, portMAX_DELAY);
-                node_B02_process_front_movement(node, tick_count_ms);
+                node_B02_process_front_movement(node, node_time_ms);
                 xSemaphoreGive(node_mutex);
             }
         }
@@ -214,7 +240,7 @@ void board_B02_task (void *parameters)
             LOG("Board B02 [veranda_pir] : movement\r\n");
 
             xSemaphoreTake(node_mutex, portMAX_DELAY);
-            node_B02_process_veranda_movement(node, tick_count_ms);
+            node_B02_process_veranda_movement(node, node_time_ms);
             xSemaphoreGive(node_mutex);
         }
 
@@ -444,7 +470,7 @@ void board_B02_task (void *parameters)
             node_B02_state_t node_state;
 
             xSemaphoreTake(node_mutex, portMAX_DELAY);
-            node_B02_get_state(node, &node_state, tick_count_ms);
+            node_B02_get_state(node, &node_state, node_time_ms);
             xSemaphoreGive(node_mutex);
 
             // Send messages
@@ -464,6 +490,10 @@ void board_B02_task (void *parameters)
                         break;
                     }
 
+#ifdef LATENCY_TRACE
+                    send_msg.trace = trace;
+#endif // LATENCY_TRACE
+
                     if (config.send_node_msg_callback(&send_msg, &error) != STD_SUCCESS)
                     {
                         LOG("Board B02 [node] : %s\r\n", error.text);
@@ -563,12 +593,61 @@ void board_B02_task (void *parameters)
             }
         }
 
+        board_B02_save_node();
+
         LOG("Board B02 : loop\r\n");
     }
 
     return;
 }
 
+void board_B02_restore_node ()
+{
+    node_time_offset_ms = 0U;
+
+    node_B02_snapshot_t snapshot;
+
+    if (retained_state_load(config.retained_state, (uint32_t)(NODE_B02), &snapshot, sizeof(node_B02_snapshot_t)) != true)
+    {
+        LOG("Board B02 [node] : cold start\r\n");
+
+        return;
+    }
+
+    // The node time goes on from the snapshot, the reset itself takes a few milliseconds
+    node_time_offset_ms = snapshot.time_ms - (uint32_t)(xTaskGetTickCount());
+
+    xSemaphoreTake(node_mutex, portMAX_DELAY);
+    node_B02_restore(node, &snapshot);
+    xSemaphoreGive(node_mutex);
+
+    LOG("Board B02 [node] : warm start, mode = %u\r\n", (unsigned int)(snapshot.mode));
+
+    // The outputs follow the restored state at the first loop
+    xTaskNotify(task, UPDATE_STATE_NOTIFICATION, eSetBits);
+
+    return;
+}
+
+void board_B02_save_node ()
+{
+    // Every change of the node goes through the loop, a copy and a CRC of a few dozen bytes after each one keeps the record fresh
+    node_B02_snapshot_t snapshot;
+
+    xSemaphoreTake(node_mutex, portMAX_DELAY);
+    node_B02_get_snapshot(node, &snapshot, board_B02_get_node_time());
+    xSemaphoreGive(node_mutex);
+
+    retained_state_save(config.retained_state, (uint32_t)(NODE_B02), &snapshot, sizeof(node_B02_snapshot_t));
+
+    return;
+}
+
+uint32_t board_B02_get_node_time ()
+{
+    return (uint32_t)(xTaskGetTickCount()) + node_time_offset_ms;
+}
+
 void board_B02_process_remote_button (board_remote_button_t remote_button)
 {
     xSemaphoreTake(node_mutex, portMAX_DELAY);
@@ -609,10 +688,10 @@ void board_B02_process_node_msg (node_msg_t const * const rcv_msg)
 {
     assert(rcv_msg != NULL);
 
-    const uint32_t tick_count_ms = xTaskGetTickCount();
+    const uint32_t node_time_ms = board_B02_get_node_time();
 
     xSemaphoreTake(node_mutex, portMAX_DELAY);
-    node_B02_process_msg(node, rcv_msg, tick_count_ms);
+    node_B02_process_msg(node, rcv_msg, node_time_ms);
     xSemaphoreGive(node_mutex);
 
     xTaskNotify(task, UPDATE_STATE_NOTIFICATION, eSetBits);
@@ -767,7 +846,8 @@ void board_B02_draw_blue_display (node_B02_temperature_t const * const data, std
     const uint8_t error_text[] = {  0xCE, 0xF8, 0xE8, 0xE1, 0xEA, 0xE0 };
 
     char temp_value[16] = { '\0' };
-    sprintf(temp_value, "%+.1f C", data->temperature_C);
+    const size_t temp_length = format_float(temp_value, data->temperature_C, FORMAT_DECI, true);
+    format_text(temp_value + temp_length, " C");
 
     const uint8_t x_text_min = 2U, y_text_min = 6U;
     const uint8_t x_text_max = 10U, y_text_max = 20U;
@@ -863,6 +943,9 @@ void board_B02_read_temperature_data (std_error_t * const error)
 
         LOG("Board B02 [bmp280] : temperature = %.2f C\r\n", data.temperature_C);
         LOG("Board B02 [bmp280] : pressure = %.1f hPa\r\n", data.pressure_hPa);
+
+        config.log_reading_callback(NODE_HISTORY_TEMPERATURE_SENSOR, data.temperature_C);
+        config.log_reading_callback(NODE_HISTORY_PRESSURE_SENSOR, data.pressure_hPa);
     }
     else
     {
@@ -1159,6 +1242,10 @@ void board_B02_door_pir_ISR ()
 
         if (is_high == true)
         {
+#ifdef LATENCY_TRACE
+            pir_isr_cycles = latency_get_cycles();
+#endif // LATENCY_TRACE
+
             BaseType_t is_higher_priority_task_woken;
             xTaskNotifyFromISR(task, DOOR_PIR_NOTIFICATION, eSetBits, &is_higher_priority_task_woken);
 
@@ -1179,6 +1266,10 @@ void board_B02_front_pir_ISR ()
     {
         last_tick_count_ms = tick_count_ms;
 
+#ifdef LATENCY_TRACE
+        pir_isr_cycles = latency_get_cycles();
+#endif // LATENCY_TRACE
+
         BaseType_t is_higher_priority_task_woken;
         xTaskNotifyFromISR(task, FRONT_PIR_NOTIFICATION, eSetBits, &is_higher_priority_task_woken);
 
@@ -1198,6 +1289,10 @@ void board_B02_veranda_pir_ISR ()
     {
         last_tick_count_ms = tick_count_ms;
 
+#ifdef LATENCY_TRACE
+        pir_isr_cycles = latency_get_cycles();
+#endif // LATENCY_TRACE
+
         BaseType_t is_higher_priority_task_woken;
         xTaskNotifyFromISR(task, VERANDA_PIR_NOTIFICATION, eSetBits, &is_higher_priority_task_woken);
 
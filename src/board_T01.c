@@ -23,6 +23,9 @@
 #include "devices/ssd1306_display.h"
 
 #include "node_T01.h"
+#include "retained_state.h"
+#include "format.h"
+#include "latency.h"
 
 #include "logger.h"
 #include "std_error/std_error.h"
@@ -66,11 +69,16 @@ static TimerHandle_t warning_led_timer;
 static board_extension_config_t config;
 
 static node_T01_t *node;
+static uint32_t node_time_offset_ms;   // Of the node time from the tick count, not 0 after a warm restart
 
 
 static int board_T01_malloc (std_error_t * const error);
 static void board_T01_task (void *parameters);
 
+static void board_T01_restore_node ();
+static void board_T01_save_node ();
+static uint32_t board_T01_get_node_time ();
+
 static void board_T01_lightning_block_timer (TimerHandle_t timer);
 static void board_T01_light_timer (TimerHandle_t timer);
 static void board_T01_warning_led_timer (TimerHandle_t timer);
@@ -107,8 +115,10 @@ int board_T01_init (board_extension_config_t const * const init_config, std_erro
     assert(init_config                              != NULL);
     assert(init_config->mcp23017_expander           != NULL);
     assert(init_config->storage                     != NULL);
+    assert(init_config->retained_state              != NULL);
     assert(init_config->update_status_led_callback  != NULL);
     assert(init_config->send_node_msg_callback      != NULL);
+    assert(init_config->log_reading_callback        != NULL);
 
     config = *init_config;
 
@@ -127,6 +137,7 @@ void board_T01_task (void *parameters)
     UNUSED(parameters);
 
     node_T01_init(node);
+    board_T01_restore_node();
     board_T01_init_humidity_sensor();
 
     std_error_t error;
@@ -147,14 +158,14 @@ void board_T01_task (void *parameters)
         uint32_t notification;
         xTaskNotifyWait(0U, ULONG_MAX, &notification, portMAX_DELAY);
 
-        const uint32_t tick_count_ms = xTaskGetTickCount();
+        const uint32_t node_time_ms = board_T01_get_node_time();
 
         if ((notification & PIR_NOTIFICATION) != 0U)
         {
             LOG("Board T01 [pir] : movement\r\n");
 
             xSemaphoreTake(node_mutex, portMAX_DELAY);
-            node_T01_process_movement(node, tick_count_ms);
+            node_T01_process_movement(node, node_time_ms);
             xSemaphoreGive(node_mutex);
         }
 
@@ -246,7 +257,7 @@ void board_T01_task (void *parameters)
             node_T01_state_t node_state;
 
             xSemaphoreTake(node_mutex, portMAX_DELAY);
-            node_T01_get_state(node, &node_state, tick_count_ms);
+            node_T01_get_state(node, &node_state, node_time_ms);
             xSemaphoreGive(node_mutex);
 
             // Send messages
@@ -266,6 +277,8 @@ void board_T01_task (void *parameters)
                         break;
                     }
 
+                    LATENCY_CLEAR(&send_msg.trace);
+
                     if (config.send_node_msg_callback(&send_msg, &error) != STD_SUCCESS)
                     {
                         LOG("Board T01 [node] : %s\r\n", error.text);
@@ -313,12 +326,61 @@ void board_T01_task (void *parameters)
             }
         }
 
+        board_T01_save_node();
+
         LOG("Board T01 : loop\r\n");
     }
 
     return;
 }
 
+void board_T01_restore_node ()
+{
+    node_time_offset_ms = 0U;
+
+    node_T01_snapshot_t snapshot;
+
+    if (retained_state_load(config.retained_state, (uint32_t)(NODE_T01), &snapshot, sizeof(node_T01_snapshot_t)) != true)
+    {
+        LOG("Board T01 [node] : cold start\r\n");
+
+        return;
+    }
+
+    // The node time goes on from the snapshot, the reset itself takes a few milliseconds
+    node_time_offset_ms = snapshot.time_ms - (uint32_t)(xTaskGetTickCount());
+
+    xSemaphoreTake(node_mutex, portMAX_DELAY);
+    node_T01_restore(node, &snapshot);
+    xSemaphoreGive(node_mutex);
+
+    LOG("Board T01 [node] : warm start, mode = %u\r\n", (unsigned int)(snapshot.mode));
+
+    // The outputs follow the restored state at the first loop
+    xTaskNotify(task, UPDATE_STATE_NOTIFICATION, eSetBits);
+
+    return;
+}
+
+void board_T01_save_node ()
+{
+    // Every change of the node goes through the loop, a copy and a CRC of a few dozen bytes after each one keeps the record fresh
+    node_T01_snapshot_t snapshot;
+
+    xSemaphoreTake(node_mutex, portMAX_DELAY);
+    node_T01_get_snapshot(node, &snapshot, board_T01_get_node_time());
+    xSemaphoreGive(node_mutex);
+
+    retained_state_save(config.retained_state, (uint32_t)(NODE_T01), &snapshot, sizeof(node_T01_snapshot_t));
+
+    return;
+}
+
+uint32_t board_T01_get_node_time ()
+{
+    return (uint32_t)(xTaskGetTickCount()) + node_time_offset_ms;
+}
+
 
 void board_T01_process_remote_button (board_remote_button_t remote_button)
 {
@@ -360,10 +422,10 @@ void board_T01_process_node_msg (node_msg_t const * const rcv_msg)
 {
     assert(rcv_msg != NULL);
 
-    const uint32_t tick_count_ms = xTaskGetTickCount();
+    const uint32_t node_time_ms = board_T01_get_node_time();
 
     xSemaphoreTake(node_mutex, portMAX_DELAY);
-    node_T01_process_msg(node, rcv_msg, tick_count_ms);
+    node_T01_process_msg(node, rcv_msg, node_time_ms);
     xSemaphoreGive(node_mutex);
 
     xTaskNotify(task, UPDATE_STATE_NOTIFICATION, eSetBits);
@@ -501,7 +563,8 @@ void board_T01_draw_blue_display (node_T01_humidity_t const * const data, std_er
     const uint8_t error_text[] = {  0xCE, 0xF8, 0xE8, 0xE1, 0xEA, 0xE0 };
 
     char temp_value[16] = { '\0' };
-    sprintf(temp_value, "%+.1f C", data->temperature_C);
+    const size_t temp_length = format_float(temp_value, data->temperature_C, FORMAT_DECI, true);
+    format_text(temp_value + temp_length, " C");
 
     const uint8_t x_text_min = 2U, y_text_min = 6U;
     const uint8_t x_text_max = 10U, y_text_max = 20U;
@@ -584,10 +647,12 @@ void board_T01_draw_yellow_display (node_T01_humidity_t const * const data, std_
     const uint8_t error_text[] = {  0xCE, 0xF8, 0xE8, 0xE1, 0xEA, 0xE0 };
 
     char hum_value[16] = { '\0' };
-    sprintf(hum_value, "%.1f %%", data->humidity_pct);
+    const size_t hum_length = format_float(hum_value, data->humidity_pct, FORMAT_DECI, false);
+    format_text(hum_value + hum_length, " %");
 
     char press_value[16] = { '\0' };
-    sprintf(press_value, "%.0f MM", pressureMM);
+    const size_t press_length = format_float(press_value, pressureMM, 0U, false);
+    format_text(press_value + press_length, " MM");
 
     const uint8_t x_hum_min = 2U, y_hum_min = 8U;
     const uint8_t x_hum_max = 32U, y_hum_max = 16U;
@@ -685,6 +750,10 @@ void board_T01_read_humidity_data (std_error_t * const error)
         LOG("Board T01 [bme280] : humidity = %.1f %%\r\n", data.humidity_pct);
         LOG("Board T01 [bme280] : temperature = %.2f C\r\n", data.temperature_C);
         LOG("Board T01 [bme280] : pressure = %.1f hPa\r\n", data.pressure_hPa);
+
+        config.log_reading_callback(NODE_HISTORY_TEMPERATURE_SENSOR, data.temperature_C);
+        config.log_reading_callback(NODE_HISTORY_HUMIDITY_SENSOR, data.humidity_pct);
+        config.log_reading_callback(NODE_HISTORY_PRESSURE_SENSOR, data.pressure_hPa);
     }
     else
     {
@@ -6,6 +6,7 @@
 #ifndef BOARD_FACTORY_TYPE_H
 #define BOARD_FACTORY_TYPE_H
 
+#include <stdint.h>
 #include <stdbool.h>
 
 #include "board.type.h"
@@ -13,22 +14,26 @@
 
 typedef struct mcp23017_expander mcp23017_expander_t;
 typedef struct storage storage_t;
+typedef struct retained_state retained_state_t;
 typedef struct std_error std_error_t;
 
 typedef void (*board_extension_lock_i2c_1_callback_t) ();
 typedef void (*board_extension_update_status_led_callback_t) (board_led_color_t led_color);
 typedef int (*board_extension_send_node_msg_callback_t) (node_msg_t const * const send_msg, std_error_t * const error);
+typedef void (*board_extension_log_reading_callback_t) (uint8_t sensor_id, float value);
 
 typedef struct board_extension_config
 {
     mcp23017_expander_t *mcp23017_expander;
     storage_t *storage;
+    retained_state_t *retained_state;   // In the no-init RAM, the node snapshot for a warm restart
 
     board_extension_lock_i2c_1_callback_t lock_i2c_1_callback;
     board_extension_lock_i2c_1_callback_t unlock_i2c_1_callback;
 
     board_extension_update_status_led_callback_t update_status_led_callback;
     board_extension_send_node_msg_callback_t send_node_msg_callback;
+    board_extension_log_reading_callback_t log_reading_callback;  // NODE_HISTORY_*_SENSOR, to the sensor log on the W25Q
 
 } board_extension_config_t;
 
@@ -0,0 +1,188 @@
+/************************************************************
+ *   Author : German Mundinger
+ *   Date   : 2024
+ ************************************************************/
+
+#include "boot.h"
+
+#include <assert.h>
+
+#include "logger.h"
+#include "std_error/std_error.h"
+
+
+static int boot_install_staged (boot_config_t const * const config, uint32_t state, std_error_t * const error);
+static int boot_restore_fallback (boot_config_t const * const config, boot_action_t * const action, std_error_t * const error);
+
+
+int boot_prepare (boot_config_t const * const config, boot_action_t * const action, std_error_t * const error)
+{
+    assert(config                               != NULL);
+    assert(config->read_state_callback          != NULL);
+    assert(config->write_state_callback         != NULL);
+    assert(config->read_pending_callback        != NULL);
+    assert(config->write_pending_callback       != NULL);
+    assert(config->is_image_present_callback    != NULL);
+    assert(config->install_image_callback       != NULL);
+    assert(config->move_image_callback          != NULL);
+    assert(action                               != NULL);
+
+    *action = JUMP_BOOT_ACTION;
+
+    const uint32_t state = config->read_state_callback();
+
+    if (boot_is_pending(config->read_pending_callback()) == true)
+    {
+        bool is_staged;
+
+        // Not tried again after a failure, the next start goes on without the W25Q
+        if (config->is_image_present_callback(STAGED_IMAGE, &is_staged, error) != STD_SUCCESS)
+        {
+            config->write_pending_callback(BOOT_NO_PENDING_FLAG);
+
+            return STD_FAILURE;
+        }
+
+        if (is_staged == true)
+        {
+            *action = INSTALL_BOOT_ACTION;
+
+            // A broken stream or a flash error leaves a part of the staged image in the internal flash
+            if (boot_install_staged(config, state, error) != STD_SUCCESS)
+            {
+                LOG("Boot : install failed\r\n");
+
+                config->write_pending_callback(BOOT_NO_PENDING_FLAG);
+
+                return boot_restore_fallback(config, action, error);
+            }
+        }
+
+        // Cleared last, a power loss before it only costs one more look at the W25Q
+        config->write_pending_callback(BOOT_NO_PENDING_FLAG);
+
+        if (is_staged == true)
+        {
+            return STD_SUCCESS;
+        }
+    }
+
+    if (boot_is_confirmed(state) == true)
+    {
+        return STD_SUCCESS;
+    }
+
+    const uint32_t attempts = state & BOOT_ATTEMPT_MASK;
+
+    LOG("Boot : trial attempt = %lu\r\n", (unsigned long)(attempts + 1U));
+
+    if (attempts < config->max_attempts)
+    {
+        config->write_state_callback(BOOT_TRIAL_STATE | (attempts + 1U));
+
+        return STD_SUCCESS;
+    }
+
+    return boot_restore_fallback(config, action, error);
+}
+
+int boot_repair (boot_config_t const * const config, boot_action_t * const action, std_error_t * const error)
+{
+    assert(config   != NULL);
+    assert(action   != NULL);
+
+    // The copy of a trial image is just as bad, it came from the same download
+    if (boot_is_confirmed(config->read_state_callback()) != true)
+    {
+        return boot_restore_fallback(config, action, error);
+    }
+
+    LOG("Boot : reinstall active image\r\n");
+
+    *action = REPAIR_BOOT_ACTION;
+
+    return config->install_image_callback(ACTIVE_IMAGE, error);
+}
+
+bool boot_is_confirmed (uint32_t state)
+{
+    // Anything but a trial, garbage after a backup domain reset included
+    return ((state & BOOT_TRIAL_MASK) != BOOT_TRIAL_STATE);
+}
+
+bool boot_is_pending (uint32_t pending)
+{
+    // Backup registers read 0 after a backup domain reset, so a lost flag means no update
+    return (pending == BOOT_PENDING_FLAG);
+}
+
+
+int boot_install_staged (boot_config_t const * const config, uint32_t state, std_error_t * const error)
+{
+    // Only a confirmed image is worth falling back to, an unconfirmed one is just replaced
+    if (boot_is_confirmed(state) == true)
+    {
+        bool is_active;
+
+        if (config->is_image_present_callback(ACTIVE_IMAGE, &is_active, error) != STD_SUCCESS)
+        {
+            return STD_FAILURE;
+        }
+
+        if (is_active == true)
+        {
+            if (config->move_image_callback(ACTIVE_IMAGE, FALLBACK_IMAGE, error) != STD_SUCCESS)
+            {
+                return STD_FAILURE;
+            }
+        }
+    }
+
+    LOG("Boot : install staged image\r\n");
+
+    if (config->install_image_callback(STAGED_IMAGE, error) != STD_SUCCESS)
+    {
+        return STD_FAILURE;
+    }
+
+    // Counting starts before the staged image disappears, a power loss in between installs it once more
+    config->write_state_callback(BOOT_TRIAL_STATE | 1U);
+
+    return config->move_image_callback(STAGED_IMAGE, ACTIVE_IMAGE, error);
+}
+
+int boot_restore_fallback (boot_config_t const * const config, boot_action_t * const action, std_error_t * const error)
+{
+    bool is_fallback;
+
+    if (config->is_image_present_callback(FALLBACK_IMAGE, &is_fallback, error) != STD_SUCCESS)
+    {
+        return STD_FAILURE;
+    }
+
+    if (is_fallback == true)
+    {
+        LOG("Boot : restore fallback image\r\n");
+
+        *action = RESTORE_BOOT_ACTION;
+
+        if (config->install_image_callback(FALLBACK_IMAGE, error) != STD_SUCCESS)
+        {
+            return STD_FAILURE;
+        }
+
+        if (config->move_image_callback(FALLBACK_IMAGE, ACTIVE_IMAGE, error) != STD_SUCCESS)
+        {
+            return STD_FAILURE;
+        }
+    }
+    else
+    {
+        LOG("Boot : no fallback image\r\n");
+    }
+
+    // The fallback was confirmed once, and without one there is nothing better to run anyway
+    config->write_state_callback(BOOT_CONFIRMED_STATE);
+
+    return STD_SUCCESS;
+}
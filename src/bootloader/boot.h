@@ -0,0 +1,85 @@
+/************************************************************
+ *   Author : German Mundinger
+ *   Date   : 2024
+ ************************************************************/
+
+#ifndef BOOT_H
+#define BOOT_H
+
+// Boot state in an RTC backup register: 0 - the running image is confirmed, BOOT_TRIAL_STATE | n - n boots of a new image so far
+#define BOOT_STATE_REGISTER         0U
+#define BOOT_CONFIRMED_STATE        0x00000000U
+#define BOOT_TRIAL_STATE            0xB0070000U
+#define BOOT_TRIAL_MASK             0xFFFF0000U
+#define BOOT_ATTEMPT_MASK           0x0000FFFFU
+#define BOOT_MAX_ATTEMPTS           3U
+
+// Set by the application once an image is staged, the bootloader touches the W25Q only then or for a rollback
+#define BOOT_PENDING_REGISTER       1U
+#define BOOT_PENDING_FLAG           0x55504454U // "UPDT"
+#define BOOT_NO_PENDING_FLAG        0x00000000U
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct std_error std_error_t;
+
+typedef enum boot_image
+{
+    STAGED_IMAGE = 0,   // Downloaded, not installed yet
+    ACTIVE_IMAGE,       // The copy of what the internal flash holds
+    FALLBACK_IMAGE      // The one installed before, known to be good
+
+} boot_image_t;
+
+typedef enum boot_action
+{
+    JUMP_BOOT_ACTION = 0,
+    INSTALL_BOOT_ACTION,
+    RESTORE_BOOT_ACTION,
+    REPAIR_BOOT_ACTION
+
+} boot_action_t;
+
+typedef uint32_t (*boot_read_state_callback_t) ();
+typedef void (*boot_write_state_callback_t) (uint32_t state);
+typedef uint32_t (*boot_read_pending_callback_t) ();
+typedef void (*boot_write_pending_callback_t) (uint32_t pending);
+typedef int (*boot_is_image_present_callback_t) (boot_image_t image, bool * const is_present, std_error_t * const error);
+typedef int (*boot_install_image_callback_t) (boot_image_t image, std_error_t * const error);
+typedef int (*boot_move_image_callback_t) (boot_image_t from_image, boot_image_t to_image, std_error_t * const error);
+
+typedef struct boot_config
+{
+    boot_read_state_callback_t read_state_callback;
+    boot_write_state_callback_t write_state_callback;
+    boot_read_pending_callback_t read_pending_callback;
+    boot_write_pending_callback_t write_pending_callback;
+    boot_is_image_present_callback_t is_image_present_callback;
+    boot_install_image_callback_t install_image_callback;   // Into the internal flash
+    boot_move_image_callback_t move_image_callback;         // Replaces the target image
+
+    uint32_t max_attempts;
+
+} boot_config_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Every step is safe to repeat after a power loss; the image callbacks are called only for an update or a rollback
+// A staged image that fails to install is not tried again, the fallback is restored instead
+int boot_prepare (boot_config_t const * const config, boot_action_t * const action, std_error_t * const error);
+
+// The internal flash failed its check. A trial image is the one that failed, the fallback comes back;
+// a confirmed one is installed again from its copy.
+int boot_repair (boot_config_t const * const config, boot_action_t * const action, std_error_t * const error);
+
+bool boot_is_confirmed (uint32_t state);
+bool boot_is_pending (uint32_t pending);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BOOT_H
@@ -0,0 +1,244 @@
+/************************************************************
+ *   Author : German Mundinger
+ *   Date   : 2024
+ ************************************************************/
+
+#include "decompressor.h"
+
+#include <string.h>
+#include <assert.h>
+
+#include "std_error/std_error.h"
+
+
+#define FORMAT_ERROR_TEXT   "Decompressor image format error"
+#define SIZE_ERROR_TEXT     "Decompressor image size error"
+
+
+static int decompressor_decode (decompressor_t * const self, std_error_t * const error);
+static bool decompressor_take_bits (decompressor_t * const self, uint32_t count, uint32_t * const value);
+static int decompressor_copy (decompressor_t * const self, uint32_t offset, uint32_t count, std_error_t * const error);
+static int decompressor_push (decompressor_t * const self, uint8_t byte, std_error_t * const error);
+
+
+bool decompressor_parse_header (uint8_t const data[DECOMPRESSOR_HEADER_SIZE], decompressor_header_t * const header)
+{
+    assert(data     != NULL);
+    assert(header   != NULL);
+
+    if ((data[0] != DECOMPRESSOR_MAGIC_0) || (data[1] != DECOMPRESSOR_MAGIC_1))
+    {
+        return false;
+    }
+
+    header->window_bits     = data[2];
+    header->lookahead_bits  = data[3];
+    header->image_size      = (uint32_t)(data[4]) | ((uint32_t)(data[5]) << 8U) | ((uint32_t)(data[6]) << 16U) | ((uint32_t)(data[7]) << 24U);
+
+    return true;
+}
+
+int decompressor_init (decompressor_t * const self, decompressor_config_t const * const config, decompressor_header_t const * const header, std_error_t * const error)
+{
+    assert(self                     != NULL);
+    assert(config                   != NULL);
+    assert(config->write_callback   != NULL);
+    assert(header                   != NULL);
+
+    if ((header->window_bits < DECOMPRESSOR_MIN_WINDOW_BITS) || (header->window_bits > DECOMPRESSOR_MAX_WINDOW_BITS) ||
+        (header->lookahead_bits < DECOMPRESSOR_MIN_LOOKAHEAD_BITS) || (header->lookahead_bits >= header->window_bits))
+    {
+        std_error_catch_custom(error, STD_FAILURE, FORMAT_ERROR_TEXT, __FILE__, __LINE__);
+
+        return STD_FAILURE;
+    }
+
+    self->config    = *config;
+    self->header    = *header;
+
+    self->state     = TAG_DECOMPRESSOR_STATE;
+    self->bits      = 0U;
+    self->bit_count = 0U;
+    self->index     = 0U;
+
+    // Heatshrink refers to zeros before the first byte
+    memset((void*)(self->window), 0, sizeof(self->window));
+    self->window_head = 0U;
+
+    self->output_size   = 0U;
+    self->image_size    = 0U;
+
+    return STD_SUCCESS;
+}
+
+int decompressor_process (decompressor_t * const self, uint8_t const * const data, size_t size, std_error_t * const error)
+{
+    assert(self != NULL);
+    assert(data != NULL);
+
+    for (size_t i = 0U; i < size; ++i)
+    {
+        // Fields are up to 10 bits, so fewer than 10 bits stay between bytes
+        self->bits      = (self->bits << 8U) | (uint32_t)(data[i]);
+        self->bit_count += 8U;
+
+        if (decompressor_decode(self, error) != STD_SUCCESS)
+        {
+            return STD_FAILURE;
+        }
+    }
+
+    return STD_SUCCESS;
+}
+
+int decompressor_finish (decompressor_t * const self, std_error_t * const error)
+{
+    assert(self != NULL);
+
+    // The padding bits of the last byte never make up a whole literal or back-reference
+    if (self->image_size != self->header.image_size)
+    {
+        std_error_catch_custom(error, STD_FAILURE, SIZE_ERROR_TEXT, __FILE__, __LINE__);
+
+        return STD_FAILURE;
+    }
+
+    if (self->output_size != 0U)
+    {
+        if (self->config.write_callback(self->output, self->output_size, error) != STD_SUCCESS)
+        {
+            return STD_FAILURE;
+        }
+        self->output_size = 0U;
+    }
+
+    return STD_SUCCESS;
+}
+
+
+int decompressor_decode (decompressor_t * const self, std_error_t * const error)
+{
+    uint32_t value;
+
+    while (true)
+    {
+        switch (self->state)
+        {
+            case TAG_DECOMPRESSOR_STATE:
+            {
+                if (decompressor_take_bits(self, 1U, &value) != true)
+                {
+                    return STD_SUCCESS;
+                }
+                self->state = (value != 0U) ? LITERAL_DECOMPRESSOR_STATE : INDEX_DECOMPRESSOR_STATE;
+
+                break;
+            }
+
+            case LITERAL_DECOMPRESSOR_STATE:
+            {
+                if (decompressor_take_bits(self, 8U, &value) != true)
+                {
+                    return STD_SUCCESS;
+                }
+                self->state = TAG_DECOMPRESSOR_STATE;
+
+                if (decompressor_push(self, (uint8_t)(value), error) != STD_SUCCESS)
+                {
+                    return STD_FAILURE;
+                }
+                break;
+            }
+
+            case INDEX_DECOMPRESSOR_STATE:
+            {
+                if (decompressor_take_bits(self, self->header.window_bits, &self->index) != true)
+                {
+                    return STD_SUCCESS;
+                }
+                self->state = COUNT_DECOMPRESSOR_STATE;
+
+                break;
+            }
+
+            case COUNT_DECOMPRESSOR_STATE:
+            {
+                if (decompressor_take_bits(self, self->header.lookahead_bits, &value) != true)
+                {
+                    return STD_SUCCESS;
+                }
+                self->state = TAG_DECOMPRESSOR_STATE;
+
+                // Both are stored minus one
+                if (decompressor_copy(self, self->index + 1U, value + 1U, error) != STD_SUCCESS)
+                {
+                    return STD_FAILURE;
+                }
+                break;
+            }
+
+            default:
+            {
+                return STD_SUCCESS;
+            }
+        }
+    }
+}
+
+bool decompressor_take_bits (decompressor_t * const self, uint32_t count, uint32_t * const value)
+{
+    if (self->bit_count < count)
+    {
+        return false;
+    }
+
+    self->bit_count -= count;
+    *value = (self->bits >> self->bit_count) & ((1U << count) - 1U);
+
+    return true;
+}
+
+int decompressor_copy (decompressor_t * const self, uint32_t offset, uint32_t count, std_error_t * const error)
+{
+    const uint32_t mask = (1U << self->header.window_bits) - 1U;
+
+    for (uint32_t i = 0U; i < count; ++i)
+    {
+        const uint8_t byte = self->window[(self->window_head - offset) & mask];
+
+        if (decompressor_push(self, byte, error) != STD_SUCCESS)
+        {
+            return STD_FAILURE;
+        }
+    }
+
+    return STD_SUCCESS;
+}
+
+int decompressor_push (decompressor_t * const self, uint8_t byte, std_error_t * const error)
+{
+    if (self->image_size >= self->header.image_size)
+    {
+        std_error_catch_custom(error, STD_FAILURE, SIZE_ERROR_TEXT, __FILE__, __LINE__);
+
+        return STD_FAILURE;
+    }
+
+    const uint32_t mask = (1U << self->header.window_bits) - 1U;
+
+    self->window[self->window_head & mask] = byte;
+    ++self->window_head;
+    ++self->image_size;
+
+    self->output[self->output_size] = byte;
+    ++self->output_size;
+
+    if (self->output_size == DECOMPRESSOR_OUTPUT_SIZE)
+    {
+        self->output_size = 0U;
+
+        return self->config.write_callback(self->output, DECOMPRESSOR_OUTPUT_SIZE, error);
+    }
+
+    return STD_SUCCESS;
+}
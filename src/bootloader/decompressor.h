@@ -0,0 +1,92 @@
+/************************************************************
+ *   Author : German Mundinger
+ *   Date   : 2024
+ ************************************************************/
+
+#ifndef DECOMPRESSOR_H
+#define DECOMPRESSOR_H
+
+// Image: magic (2) | window bits (1) | lookahead bits (1) | image size (4), little endian | heatshrink stream
+#define DECOMPRESSOR_MAGIC_0            0x48U   // 'H'
+#define DECOMPRESSOR_MAGIC_1            0x53U   // 'S'
+#define DECOMPRESSOR_HEADER_SIZE        8U
+#define DECOMPRESSOR_MIN_WINDOW_BITS    4U
+#define DECOMPRESSOR_MAX_WINDOW_BITS    10U     // 1 kB of RAM
+#define DECOMPRESSOR_MIN_LOOKAHEAD_BITS 3U
+#define DECOMPRESSOR_OUTPUT_SIZE        256U    // Word multiple, see flasher_program()
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+typedef struct std_error std_error_t;
+
+typedef int (*decompressor_write_callback_t) (uint8_t const * const data, size_t size, std_error_t * const error);
+
+typedef struct decompressor_header
+{
+    uint8_t window_bits;
+    uint8_t lookahead_bits;
+    uint32_t image_size;    // Decompressed
+
+} decompressor_header_t;
+
+typedef struct decompressor_config
+{
+    decompressor_write_callback_t write_callback;   // Full output chunks, a shorter one only at the end
+
+} decompressor_config_t;
+
+typedef struct decompressor decompressor_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// A raw image starts with its stack pointer (0x2000xxxx) and never with the magic
+bool decompressor_parse_header (uint8_t const data[DECOMPRESSOR_HEADER_SIZE], decompressor_header_t * const header);
+
+int decompressor_init (decompressor_t * const self, decompressor_config_t const * const config, decompressor_header_t const * const header, std_error_t * const error);
+
+// The stream without the header, split at any point
+int decompressor_process (decompressor_t * const self, uint8_t const * const data, size_t size, std_error_t * const error);
+
+// Writes the tail and checks the image size
+int decompressor_finish (decompressor_t * const self, std_error_t * const error);
+
+#ifdef __cplusplus
+}
+#endif
+
+
+
+// Private
+typedef enum decompressor_state
+{
+    TAG_DECOMPRESSOR_STATE = 0,
+    LITERAL_DECOMPRESSOR_STATE,
+    INDEX_DECOMPRESSOR_STATE,
+    COUNT_DECOMPRESSOR_STATE
+
+} decompressor_state_t;
+
+typedef struct decompressor
+{
+    decompressor_config_t config;
+    decompressor_header_t header;
+
+    decompressor_state_t state;
+    uint32_t bits;
+    uint32_t bit_count;
+    uint32_t index;
+
+    uint8_t window[1U << DECOMPRESSOR_MAX_WINDOW_BITS];
+    uint32_t window_head;
+
+    uint8_t output[DECOMPRESSOR_OUTPUT_SIZE];
+    size_t output_size;
+    uint32_t image_size;
+
+} decompressor_t;
+
+#endif // DECOMPRESSOR_H
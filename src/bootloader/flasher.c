@@ -0,0 +1,128 @@
+/************************************************************
+ *   Author : German Mundinger
+ *   Date   : 2024
+ ************************************************************/
+
+#include "flasher.h"
+
+#include <string.h>
+#include <assert.h>
+
+#include "logger.h"
+#include "std_error/std_error.h"
+
+
+#define SIZE_ERROR_TEXT     "Flasher image size error"
+#define ADDRESS_ERROR_TEXT  "Flasher address error"
+
+#define ARRAY_SIZE(array) (sizeof(array) / sizeof((array)[0]))
+
+
+// STM32F401xC ends after sector 5, STM32F411xE - after sector 7
+static const flasher_sector_t sector_table[] =
+{
+    { 0x08000000U, 16U * 1024U },
+    { 0x08004000U, 16U * 1024U },
+    { 0x08008000U, 16U * 1024U },
+    { 0x0800C000U, 16U * 1024U },
+    { 0x08010000U, 64U * 1024U },
+    { 0x08020000U, 128U * 1024U },
+    { 0x08040000U, 128U * 1024U },
+    { 0x08060000U, 128U * 1024U }
+};
+
+
+void flasher_init (flasher_t * const self, flasher_config_t const * const config)
+{
+    assert(self                             != NULL);
+    assert(config                           != NULL);
+    assert(config->erase_sector_callback    != NULL);
+    assert(config->program_word_callback    != NULL);
+    assert(config->start_address            < config->end_address);
+
+    self->config    = *config;
+    self->address   = config->start_address;
+
+    return;
+}
+
+int flasher_erase (flasher_t * const self, size_t image_size, std_error_t * const error)
+{
+    assert(self != NULL);
+
+    if ((image_size == 0U) || (image_size > (size_t)(self->config.end_address - self->config.start_address)))
+    {
+        std_error_catch_custom(error, STD_FAILURE, SIZE_ERROR_TEXT, __FILE__, __LINE__);
+
+        return STD_FAILURE;
+    }
+
+    const uint32_t image_end_address = self->config.start_address + (uint32_t)(image_size);
+
+    for (size_t i = 0U; i < ARRAY_SIZE(sector_table); ++i)
+    {
+        const uint32_t sector_start_address = sector_table[i].address;
+        const uint32_t sector_end_address   = sector_table[i].address + sector_table[i].size;
+
+        if ((sector_end_address <= self->config.start_address) || (sector_start_address >= image_end_address))
+        {
+            continue;
+        }
+
+        LOG("Flasher : erase sector %u\r\n", (unsigned int)(i));
+
+        if (self->config.erase_sector_callback((uint32_t)(i), error) != STD_SUCCESS)
+        {
+            return STD_FAILURE;
+        }
+    }
+
+    self->address = self->config.start_address;
+
+    return STD_SUCCESS;
+}
+
+int flasher_program (flasher_t * const self, uint8_t const * const data, size_t size, std_error_t * const error)
+{
+    assert(self != NULL);
+    assert(data != NULL);
+
+    if (((self->address % FLASHER_WORD_SIZE) != 0U) || (size > (size_t)(self->config.end_address - self->address)))
+    {
+        std_error_catch_custom(error, STD_FAILURE, ADDRESS_ERROR_TEXT, __FILE__, __LINE__);
+
+        return STD_FAILURE;
+    }
+
+    for (size_t i = 0U; i < size; i += FLASHER_WORD_SIZE)
+    {
+        // Erased flash reads as 0xFF, so the padding programs nothing
+        uint8_t bytes[FLASHER_WORD_SIZE] = { 0xFFU, 0xFFU, 0xFFU, 0xFFU };
+
+        const size_t word_size = ((size - i) < FLASHER_WORD_SIZE) ? (size - i) : FLASHER_WORD_SIZE;
+        memcpy((void*)(bytes), (const void*)(&data[i]), word_size);
+
+        const uint32_t word = (uint32_t)(bytes[0]) | ((uint32_t)(bytes[1]) << 8U) | ((uint32_t)(bytes[2]) << 16U) | ((uint32_t)(bytes[3]) << 24U);
+
+        if (self->config.program_word_callback(self->address, word, error) != STD_SUCCESS)
+        {
+            return STD_FAILURE;
+        }
+
+        // An unaligned tail ends the image, the alignment check above refuses anything after it
+        self->address += (uint32_t)(word_size);
+    }
+
+    return STD_SUCCESS;
+}
+
+void flasher_get_sector_table (flasher_sector_t const **table, size_t * const size)
+{
+    assert(table    != NULL);
+    assert(size     != NULL);
+
+    *table  = sector_table;
+    *size   = ARRAY_SIZE(sector_table);
+
+    return;
+}
@@ -0,0 +1,67 @@
+/************************************************************
+ *   Author : German Mundinger
+ *   Date   : 2024
+ ************************************************************/
+
+#ifndef FLASHER_H
+#define FLASHER_H
+
+#define FLASHER_WORD_SIZE   4U  // FLASH_TYPEPROGRAM_WORD, x32 parallelism needs 2.7 V - 3.6 V
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef struct std_error std_error_t;
+
+typedef int (*flasher_erase_sector_callback_t) (uint32_t sector_number, std_error_t * const error);
+typedef int (*flasher_program_word_callback_t) (uint32_t address, uint32_t word, std_error_t * const error);
+
+typedef struct flasher_sector
+{
+    uint32_t address;
+    uint32_t size;
+
+} flasher_sector_t;
+
+typedef struct flasher_config
+{
+    flasher_erase_sector_callback_t erase_sector_callback;
+    flasher_program_word_callback_t program_word_callback;
+
+    uint32_t start_address; // The first byte of the application, must start a sector
+    uint32_t end_address;   // The first byte past the internal flash
+
+} flasher_config_t;
+
+typedef struct flasher flasher_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void flasher_init (flasher_t * const self, flasher_config_t const * const config);
+
+// Erases only the sectors the image touches
+int flasher_erase (flasher_t * const self, size_t image_size, std_error_t * const error);
+
+// Chunks go in order and all of them but the last one are word multiples, the tail is padded with 0xFF
+int flasher_program (flasher_t * const self, uint8_t const * const data, size_t size, std_error_t * const error);
+
+void flasher_get_sector_table (flasher_sector_t const **table, size_t * const size);
+
+#ifdef __cplusplus
+}
+#endif
+
+
+
+// Private
+typedef struct flasher
+{
+    flasher_config_t config;
+
+    uint32_t address;
+
+} flasher_t;
+
+#endif // FLASHER_H
@@ -0,0 +1,194 @@
+/************************************************************
+ *   Author : German Mundinger
+ *   Date   : 2024
+ ************************************************************/
+
+#include "image.h"
+
+#include <assert.h>
+
+#include "logger.h"
+#include "std_error/std_error.h"
+
+
+#define FORMAT_ERROR_TEXT   "Image format error"
+#define CRC_ERROR_TEXT      "Image crc error"
+
+#define WORD_SIZE   4U
+#define STACK_ALIGN 8U  // AAPCS
+
+#define CRC_INITIAL_VALUE   0xFFFFFFFFU // As the STM32 CRC unit after a reset
+
+
+static bool image_is_info_block_valid (uint32_t const info_block[2], uint32_t max_size);
+static void image_checker_process_word (image_checker_t * const self, uint32_t offset);
+
+int image_verify (image_config_t const * const config, image_info_t * const info, std_error_t * const error)
+{
+    assert(config               != NULL);
+    assert(config->crc_callback != NULL);
+    assert(config->image        != NULL);
+    assert(info                 != NULL);
+
+    info->size  = 0U;
+    info->crc32 = 0U;
+
+    uint32_t const * const info_block = &config->image[IMAGE_INFO_OFFSET / WORD_SIZE];
+
+    // Erased flash, an image built before the trailer or a size pointing anywhere
+    if (image_is_info_block_valid(info_block, config->max_size) != true)
+    {
+        std_error_catch_custom(error, STD_FAILURE, FORMAT_ERROR_TEXT, __FILE__, __LINE__);
+
+        return STD_FAILURE;
+    }
+
+    const uint32_t size = info_block[1];
+
+    uint32_t const * const trailer = &config->image[size / WORD_SIZE];
+
+    if (trailer[0] != size)
+    {
+        std_error_catch_custom(error, STD_FAILURE, FORMAT_ERROR_TEXT, __FILE__, __LINE__);
+
+        return STD_FAILURE;
+    }
+
+    info->size  = size;
+    info->crc32 = config->crc_callback(config->image, (size_t)(size / WORD_SIZE));
+
+    LOG("Image : size = %lu bytes, crc32 = %08lx\r\n", (unsigned long)(info->size), (unsigned long)(info->crc32));
+
+    if (info->crc32 != trailer[1])
+    {
+        std_error_catch_custom(error, STD_FAILURE, CRC_ERROR_TEXT, __FILE__, __LINE__);
+
+        return STD_FAILURE;
+    }
+
+    return STD_SUCCESS;
+}
+
+bool image_is_stack_pointer_valid (uint32_t stack_pointer, uint32_t ram_base, uint32_t ram_size)
+{
+    return (stack_pointer > ram_base) && (stack_pointer <= (ram_base + ram_size)) && ((stack_pointer % STACK_ALIGN) == 0U);
+}
+
+void image_checker_init (image_checker_t * const self, image_crc_update_callback_t crc_callback, uint32_t max_size)
+{
+    assert(self         != NULL);
+    assert(crc_callback != NULL);
+
+    self->crc_callback  = crc_callback;
+    self->max_size      = max_size;
+
+    self->size  = 0U;
+    self->crc32 = CRC_INITIAL_VALUE;
+
+    self->info_block[0] = 0U;
+    self->info_block[1] = 0U;
+    self->trailer[0]    = 0U;
+    self->trailer[1]    = 0U;
+
+    return;
+}
+
+void image_checker_process (image_checker_t * const self, uint8_t const * const data, size_t size)
+{
+    assert(self != NULL);
+    assert((data != NULL) || (size == 0U));
+
+    for (size_t i = 0U; i < size; ++i)
+    {
+        // Anything past the trailer fails image_checker_finish(), only the size is counted
+        if (self->size < self->max_size)
+        {
+            self->word[self->size % WORD_SIZE] = data[i];
+
+            if ((self->size % WORD_SIZE) == (WORD_SIZE - 1U))
+            {
+                image_checker_process_word(self, self->size - (WORD_SIZE - 1U));
+            }
+        }
+        ++self->size;
+    }
+
+    return;
+}
+
+int image_checker_finish (image_checker_t const * const self, image_info_t * const info, std_error_t * const error)
+{
+    assert(self != NULL);
+    assert(info != NULL);
+
+    info->size  = 0U;
+    info->crc32 = 0U;
+
+    const uint32_t size = self->info_block[1];
+
+    // A truncated file, a file with a tail or a size pointing anywhere
+    if ((image_is_info_block_valid(self->info_block, self->max_size) != true) ||
+        (self->size != (size + IMAGE_TRAILER_SIZE)) || (self->trailer[0] != size))
+    {
+        std_error_catch_custom(error, STD_FAILURE, FORMAT_ERROR_TEXT, __FILE__, __LINE__);
+
+        return STD_FAILURE;
+    }
+
+    info->size  = size;
+    info->crc32 = self->crc32;
+
+    LOG("Image : size = %lu bytes, crc32 = %08lx\r\n", (unsigned long)(info->size), (unsigned long)(info->crc32));
+
+    if (info->crc32 != self->trailer[1])
+    {
+        std_error_catch_custom(error, STD_FAILURE, CRC_ERROR_TEXT, __FILE__, __LINE__);
+
+        return STD_FAILURE;
+    }
+
+    return STD_SUCCESS;
+}
+
+
+
+bool image_is_info_block_valid (uint32_t const info_block[2], uint32_t max_size)
+{
+    return (info_block[0] == IMAGE_INFO_MAGIC) && ((info_block[1] % WORD_SIZE) == 0U) &&
+           (info_block[1] >= (IMAGE_INFO_OFFSET + 8U)) && (info_block[1] <= (max_size - IMAGE_TRAILER_SIZE));
+}
+
+void image_checker_process_word (image_checker_t * const self, uint32_t offset)
+{
+    const uint32_t value = (uint32_t)(self->word[0]) | ((uint32_t)(self->word[1]) << 8U) |
+                           ((uint32_t)(self->word[2]) << 16U) | ((uint32_t)(self->word[3]) << 24U);
+
+    const uint32_t size = self->info_block[1];
+
+    // The info block lies inside any image, so the size is known before the words it bounds
+    if (offset == IMAGE_INFO_OFFSET)
+    {
+        self->info_block[0] = value;
+    }
+    else if (offset == (IMAGE_INFO_OFFSET + WORD_SIZE))
+    {
+        self->info_block[1] = value;
+    }
+
+    if ((offset <= (IMAGE_INFO_OFFSET + WORD_SIZE)) || (offset < size))
+    {
+        const uint8_t bytes[WORD_SIZE] = { self->word[3], self->word[2], self->word[1], self->word[0] };
+
+        self->crc32 = self->crc_callback(self->crc32, bytes, WORD_SIZE);
+    }
+    else if (offset == size)
+    {
+        self->trailer[0] = value;
+    }
+    else if (offset == (size + WORD_SIZE))
+    {
+        self->trailer[1] = value;
+    }
+
+    return;
+}
@@ -0,0 +1,80 @@
+/************************************************************
+ *   Author : German Mundinger
+ *   Date   : 2024
+ ************************************************************/
+
+#ifndef IMAGE_H
+#define IMAGE_H
+
+// Info block, filled by the linker: magic (4) | image size (4) - the trailer offset
+#define IMAGE_INFO_OFFSET   0x200U          // Past the vector table of both STM32F401 and STM32F411
+#define IMAGE_INFO_MAGIC    0x4F464E49U     // "INFO"
+
+// Trailer, appended at packaging: image size (4) | crc32 of the image words (4)
+#define IMAGE_TRAILER_SIZE  8U
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+typedef struct std_error std_error_t;
+
+typedef uint32_t (*image_crc_callback_t) (uint32_t const * const words, size_t count);
+typedef uint32_t (*image_crc_update_callback_t) (uint32_t crc, uint8_t const * const data, size_t size);
+
+typedef struct image_config
+{
+    image_crc_callback_t crc_callback;  // The STM32 CRC unit or crc32_calculate_words()
+
+    uint32_t const *image;              // Word aligned
+    uint32_t max_size;                  // With the trailer
+
+} image_config_t;
+
+typedef struct image_info
+{
+    uint32_t size;  // Without the trailer
+    uint32_t crc32;
+
+} image_info_t;
+
+typedef struct image_checker image_checker_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int image_verify (image_config_t const * const config, image_info_t * const info, std_error_t * const error);
+
+// The initial stack pointer, the first vector word: the applications keep the top of RAM for .noinit
+// and start their stack below it, while an image built before that starts it at the very end
+bool image_is_stack_pointer_valid (uint32_t stack_pointer, uint32_t ram_base, uint32_t ram_size);
+
+// The same checks over an image still in a file, fed in chunks split at any point:
+// crc32_update() of each word taken most significant byte first gives the crc of image_verify()
+void image_checker_init (image_checker_t * const self, image_crc_update_callback_t crc_callback, uint32_t max_size);
+void image_checker_process (image_checker_t * const self, uint8_t const * const data, size_t size);
+int image_checker_finish (image_checker_t const * const self, image_info_t * const info, std_error_t * const error);
+
+#ifdef __cplusplus
+}
+#endif
+
+
+
+// Private
+typedef struct image_checker
+{
+    image_crc_update_callback_t crc_callback;
+    uint32_t max_size;
+
+    uint32_t size;
+    uint32_t crc32;
+    uint8_t word[4];
+
+    uint32_t info_block[2];
+    uint32_t trailer[2];
+
+} image_checker_t;
+
+#endif // IMAGE_H
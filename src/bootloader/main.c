@@ -9,29 +9,68 @@
 #include "stm32f4xx_hal_flash_ex.h"
 
 #include "storage.h"
+#include "bootloader/boot.h"
+#include "bootloader/flasher.h"
+#include "bootloader/decompressor.h"
+#include "bootloader/image.h"
 
 #include "board.config.h"
 #include "board.uart_2.h"
 #include "board.spi_1.h"
 #include "board.gpio_a.h"
+#include "board.rtc_backup.h"
+#include "board.crc.h"
 
 #include "logger.h"
 #include "std_error/std_error.h"
 
 
 #define APPLICATION_START_ADDRESS   0x08010000  // Sector 4
-#define SRAM_END    (SRAM_BASE + SRAM_SIZE)
+#define FLASH_END_ADDRESS   (FLASH_BASE + FLASH_MEMORY_SIZE)
+
+#define FIRMWARE_CHUNK_SIZE 4096U   // One W25Q sector, littlefs reads it past its cache
 
 #define UART_TIMEOUT_MS (1U * 1000U)    // 1 sec
 #define SPI_TIMEOUT_MS  (1U * 1000U)    // 1 sec
 
+#define FLASH_ERROR_TEXT    "Bootloader flash error"
+
 #define ARRAY_SIZE(array) (sizeof(array) / sizeof((array)[0]))
 
 
 static void bootloader_loop ();
+static void bootloader_reset ();
 static void board_print_uart_2 (const uint8_t *data, uint16_t data_size);
 static void spi_1_lock ();
+static void yield ();
+static uint32_t get_cycles ();
 static void freeze_loop ();
+static int flash_erase_sector (uint32_t sector_number, std_error_t * const error);
+static int flash_program_word (uint32_t address, uint32_t word, std_error_t * const error);
+
+static int mount_storage (std_error_t * const error);
+static uint32_t read_boot_state ();
+static void write_boot_state (uint32_t state);
+static uint32_t read_pending_flag ();
+static void write_pending_flag (uint32_t pending);
+static int is_image_present (boot_image_t image, bool * const is_present, std_error_t * const error);
+static int install_image (boot_image_t image, std_error_t * const error);
+static int move_image (boot_image_t from_image, boot_image_t to_image, std_error_t * const error);
+static int program_image (uint8_t const * const data, size_t size, std_error_t * const error);
+static int verify_application (std_error_t * const error);
+
+static const char image_file_name_table[][64] =
+{
+    [STAGED_IMAGE]      = "firmware\0",
+    [ACTIVE_IMAGE]      = "firmware.active\0",
+    [FALLBACK_IMAGE]    = "firmware.backup\0"
+};
+
+static storage_t storage;
+static bool is_storage_mounted;
+static flasher_t flasher;
+static decompressor_t decompressor;
+static uint8_t firmware_data[FIRMWARE_CHUNK_SIZE];
 
 int main ()
 {
@@ -55,115 +94,70 @@ int main ()
     std_error_t error;
     std_error_init(&error);
 
-    LOG("Bootloader [GPIO_A] : init\r\n");
+    is_storage_mounted = false;
 
-    board_gpio_a_init();
+    LOG("Bootloader [rtc_backup] : init\r\n");
 
-    LOG("Bootloader [SPI_1] : init\r\n");
+    board_rtc_backup_init();
 
-    if (board_spi_1_init(&error) != STD_SUCCESS)
-    {
-        LOG("Bootloader [SPI_1] : %s\r\n", error.text);
+    boot_config_t boot_config;
+    boot_config.read_state_callback         = read_boot_state;
+    boot_config.write_state_callback        = write_boot_state;
+    boot_config.read_pending_callback       = read_pending_flag;
+    boot_config.write_pending_callback      = write_pending_flag;
+    boot_config.is_image_present_callback   = is_image_present;
+    boot_config.install_image_callback      = install_image;
+    boot_config.move_image_callback         = move_image;
+    boot_config.max_attempts                = BOOT_MAX_ATTEMPTS;
 
-        bootloader_loop();
-    }
-
-    LOG("Bootloader [storage] : init\r\n");
+    boot_action_t boot_action;
 
-    storage_config_t config;
-    config.spi_lock_callback        = spi_1_lock;
-    config.spi_unlock_callback      = spi_1_lock;
-    config.spi_select_callback      = board_gpio_a_pin_4_reset;
-    config.spi_unselect_callback    = board_gpio_a_pin_4_set;
-    config.spi_tx_rx_callback       = board_spi_1_read_write;
-    config.spi_timeout_ms           = SPI_TIMEOUT_MS;
-    config.delay_callback           = HAL_Delay;
-
-    storage_t storage;
-
-    if (storage_init(&storage, &config, &error) != STD_SUCCESS)
+    if (boot_prepare(&boot_config, &boot_action, &error) != STD_SUCCESS)
     {
-        LOG("Bootloader [storage] : %s\r\n", error.text);
+        LOG("Bootloader [boot] : %s\r\n", error.text);
 
-        bootloader_loop();
+        // An update is not tried again, its pending flag is cleared by now
+        bootloader_reset();
     }
 
-    if (storage_enable_power(&storage, &error) != STD_SUCCESS)
-    {
-        LOG("Bootloader [storage] : %s\r\n", error.text);
+    LOG("Bootloader [boot] : action = %d, state = %08lx\r\n", boot_action, read_boot_state());
 
-        bootloader_loop();
-    }
+    LOG("Bootloader [CRC] : init\r\n");
 
-    if (storage_mount_filesystem(&storage, &error) != STD_SUCCESS)
-    {
-        LOG("Bootloader [storage] : %s\r\n", error.text);
+    board_crc_init();
 
-        bootloader_loop();
-    }
-
-    const char firmware_file_name[64] = "firmware\0";
-    storage_file_t firmware_file;
-
-    if (storage_open_file(&storage, &firmware_file, firmware_file_name, &error) == STD_SUCCESS)
+    // A half programmed sector or a worn flash bit must not be jumped into
+    if (verify_application(&error) != STD_SUCCESS)
     {
-        HAL_FLASH_Unlock();
-
-        LOG("Bootloader [flash] : earse firmware\r\n");
-        
-        FLASH_EraseInitTypeDef erase_init;
-        erase_init.Sector       = FLASH_SECTOR_4;
-        erase_init.NbSectors    = 2;
-        erase_init.TypeErase    = FLASH_TYPEERASE_SECTORS;
-        erase_init.VoltageRange = VOLTAGE_RANGE_3;
-
-        uint32_t sector_error;
-
-        if (HAL_FLASHEx_Erase(&erase_init, &sector_error) != HAL_OK)
-        {
-            LOG("Bootloader [flash] : earse sector error = %lu\r\n", sector_error);
-        }
+        LOG("Bootloader [image] : %s\r\n", error.text);
 
-        char firmware_data[LFS_CACHE_SIZE];
-
-        uint32_t flash_address = APPLICATION_START_ADDRESS;
-
-        while (true)
+        if ((boot_repair(&boot_config, &boot_action, &error) != STD_SUCCESS) || (verify_application(&error) != STD_SUCCESS))
         {
-            size_t size;
+            LOG("Bootloader [image] : %s\r\n", error.text);
 
-            if (storage_read_file(&storage, &firmware_file, firmware_data, &size, ARRAY_SIZE(firmware_data), &error) != STD_SUCCESS)
+            // A trial image has its boots counted, the rollback comes once they run out
+            if (boot_is_confirmed(read_boot_state()) != true)
             {
-                LOG("Bootloader [storage] : %s\r\n", error.text);
-
-                bootloader_loop();
+                bootloader_reset();
             }
 
-            if (size == 0U)
-            {
-                break;
-            }
-
-            LOG("Bootloader [flash] : program bytes = %u\r\n", size);
-
-            for (size_t i = 0U; i < size; ++i)
-            {
-                HAL_FLASH_Program(FLASH_TYPEPROGRAM_BYTE, flash_address, (uint64_t)firmware_data[i]);
-
-                ++flash_address;
-            }
+            // Nothing left to install, a reset would only erase the flash once more
+            bootloader_loop();
         }
 
-        HAL_FLASH_Lock();
+        LOG("Bootloader [boot] : action = %d\r\n", boot_action);
+    }
 
-        if (storage_close_file(&storage, &firmware_file, &error) != STD_SUCCESS)
+    if (is_storage_mounted == true)
+    {
+        if (storage_unmount_filesystem(&storage, &error) != STD_SUCCESS)
         {
             LOG("Bootloader [storage] : %s\r\n", error.text);
 
             bootloader_loop();
         }
 
-        if (storage_remove_file(&storage, firmware_file_name, &error) != STD_SUCCESS)
+        if (storage_disable_power(&storage, &error) != STD_SUCCESS)
         {
             LOG("Bootloader [storage] : %s\r\n", error.text);
 
@@ -171,23 +165,9 @@ int main ()
         }
     }
 
-    if (storage_unmount_filesystem(&storage, &error) != STD_SUCCESS)
-    {
-        LOG("Bootloader [storage] : %s\r\n", error.text);
-
-        bootloader_loop();
-    }
-
-    if (storage_disable_power(&storage, &error) != STD_SUCCESS)
-    {
-        LOG("Bootloader [storage] : %s\r\n", error.text);
-
-        bootloader_loop();
-    }
-
 
     // Jump to the application
-    if (*((uint32_t*) APPLICATION_START_ADDRESS) != SRAM_END)
+    if (image_is_stack_pointer_valid(*((uint32_t*) APPLICATION_START_ADDRESS), SRAM_BASE, SRAM_SIZE) != true)
     {
         LOG("Bootloader : no application found\r\n");
 
@@ -235,6 +215,18 @@ void bootloader_loop ()
     return;
 }
 
+void bootloader_reset ()
+{
+    LOG("Bootloader : reset\r\n");
+
+    // Lets the log out, a flash that keeps failing is not erased over and over at full speed either
+    HAL_Delay(5U * 1000U);
+
+    HAL_NVIC_SystemReset();
+
+    return;
+}
+
 void board_print_uart_2 (const uint8_t *data, uint16_t data_size)
 {
     board_uart_2_write(data, data_size, UART_TIMEOUT_MS, NULL);
@@ -249,6 +241,18 @@ void spi_1_lock ()
     return;
 }
 
+void yield ()
+{
+    // Nothing else to run
+
+    return;
+}
+
+uint32_t get_cycles ()
+{
+    return DWT->CYCCNT;
+}
+
 void freeze_loop ()
 {
     __disable_irq();
@@ -258,3 +262,286 @@ void freeze_loop ()
     }
     return;
 }
+
+int flash_erase_sector (uint32_t sector_number, std_error_t * const error)
+{
+    FLASH_EraseInitTypeDef erase_init;
+    erase_init.Sector       = sector_number;
+    erase_init.NbSectors    = 1U;
+    erase_init.TypeErase    = FLASH_TYPEERASE_SECTORS;
+    erase_init.VoltageRange = VOLTAGE_RANGE_3;
+
+    uint32_t sector_error;
+
+    const HAL_StatusTypeDef status = HAL_FLASHEx_Erase(&erase_init, &sector_error);
+
+    if (status != HAL_OK)
+    {
+        LOG("Bootloader [flash] : earse sector error = %lu\r\n", sector_error);
+
+        std_error_catch_custom(error, (int)(status), FLASH_ERROR_TEXT, __FILE__, __LINE__);
+
+        return STD_FAILURE;
+    }
+    return STD_SUCCESS;
+}
+
+int flash_program_word (uint32_t address, uint32_t word, std_error_t * const error)
+{
+    const HAL_StatusTypeDef status = HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, address, (uint64_t)(word));
+
+    if (status != HAL_OK)
+    {
+        std_error_catch_custom(error, (int)(status), FLASH_ERROR_TEXT, __FILE__, __LINE__);
+
+        return STD_FAILURE;
+    }
+    return STD_SUCCESS;
+}
+
+int mount_storage (std_error_t * const error)
+{
+    // Only an update or a rollback gets here, a plain reset jumps without the W25Q
+    if (is_storage_mounted == true)
+    {
+        return STD_SUCCESS;
+    }
+
+    LOG("Bootloader [GPIO_A] : init\r\n");
+
+    board_gpio_a_init();
+
+    LOG("Bootloader [SPI_1] : init\r\n");
+
+    if (board_spi_1_init(error) != STD_SUCCESS)
+    {
+        return STD_FAILURE;
+    }
+
+    LOG("Bootloader [storage] : init\r\n");
+
+    CoreDebug->DEMCR    |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL           |= DWT_CTRL_CYCCNTENA_Msk;
+
+    storage_config_t config;
+    config.lock_callback            = spi_1_lock;
+    config.unlock_callback          = spi_1_lock;
+    config.spi_lock_callback        = spi_1_lock;
+    config.spi_unlock_callback      = spi_1_lock;
+    config.spi_select_callback      = board_gpio_a_pin_4_reset;
+    config.spi_unselect_callback    = board_gpio_a_pin_4_set;
+    config.spi_tx_rx_callback       = board_spi_1_read_write;
+    config.spi_timeout_ms           = SPI_TIMEOUT_MS;
+    config.delay_callback           = HAL_Delay;
+    config.yield_callback           = yield;
+    config.get_cycles_callback      = get_cycles;
+    config.cycles_per_us            = SystemCoreClock / 1000000U;
+
+    config.geometry.read_size       = CONFIG_STORAGE_READ_SIZE;
+    config.geometry.prog_size       = CONFIG_STORAGE_PROG_SIZE;
+    config.geometry.cache_size      = CONFIG_STORAGE_CACHE_SIZE;
+    config.geometry.lookahead_size  = CONFIG_STORAGE_LOOKAHEAD_SIZE;
+    config.geometry.block_cycles    = CONFIG_STORAGE_BLOCK_CYCLES;
+
+    if (storage_init(&storage, &config, error) != STD_SUCCESS)
+    {
+        return STD_FAILURE;
+    }
+
+    if (storage_enable_power(&storage, error) != STD_SUCCESS)
+    {
+        return STD_FAILURE;
+    }
+
+    if (storage_mount_filesystem(&storage, error) != STD_SUCCESS)
+    {
+        return STD_FAILURE;
+    }
+    is_storage_mounted = true;
+
+    return STD_SUCCESS;
+}
+
+uint32_t read_boot_state ()
+{
+    return board_rtc_backup_read(BOOT_STATE_REGISTER);
+}
+
+void write_boot_state (uint32_t state)
+{
+    board_rtc_backup_write(BOOT_STATE_REGISTER, state);
+
+    return;
+}
+
+uint32_t read_pending_flag ()
+{
+    return board_rtc_backup_read(BOOT_PENDING_REGISTER);
+}
+
+void write_pending_flag (uint32_t pending)
+{
+    board_rtc_backup_write(BOOT_PENDING_REGISTER, pending);
+
+    return;
+}
+
+int is_image_present (boot_image_t image, bool * const is_present, std_error_t * const error)
+{
+    if (mount_storage(error) != STD_SUCCESS)
+    {
+        return STD_FAILURE;
+    }
+
+    storage_file_t file;
+
+    // A missing file is the only expected failure, a broken one fails at install anyway
+    std_error_t open_error;
+    std_error_init(&open_error);
+
+    *is_present = false;
+
+    if (storage_open_file(&storage, &file, image_file_name_table[image], &open_error) == STD_SUCCESS)
+    {
+        *is_present = true;
+
+        return storage_close_file(&storage, &file, error);
+    }
+    return STD_SUCCESS;
+}
+
+int install_image (boot_image_t image, std_error_t * const error)
+{
+    if (mount_storage(error) != STD_SUCCESS)
+    {
+        return STD_FAILURE;
+    }
+
+    storage_file_t file;
+
+    if (storage_open_file(&storage, &file, image_file_name_table[image], error) != STD_SUCCESS)
+    {
+        return STD_FAILURE;
+    }
+
+    size_t firmware_size;
+
+    if (storage_get_file_size(&storage, &file, &firmware_size, error) != STD_SUCCESS)
+    {
+        storage_close_file(&storage, &file, error);
+
+        return STD_FAILURE;
+    }
+
+    size_t size;
+
+    if (storage_read_file(&storage, &file, (char*)(firmware_data), &size, ARRAY_SIZE(firmware_data), error) != STD_SUCCESS)
+    {
+        storage_close_file(&storage, &file, error);
+
+        return STD_FAILURE;
+    }
+
+    // A compressed image goes through a small window, the flash gets the decompressed one
+    decompressor_header_t header;
+    bool is_compressed  = false;
+    size_t offset       = 0U;
+    int exit_code       = STD_SUCCESS;
+
+    if (size >= DECOMPRESSOR_HEADER_SIZE)
+    {
+        is_compressed = decompressor_parse_header(firmware_data, &header);
+    }
+
+    if (is_compressed == true)
+    {
+        LOG("Bootloader [flash] : compressed image, window bits = %u\r\n", header.window_bits);
+
+        decompressor_config_t decompressor_config;
+        decompressor_config.write_callback = program_image;
+
+        firmware_size   = (size_t)(header.image_size);
+        offset          = DECOMPRESSOR_HEADER_SIZE;
+        exit_code       = decompressor_init(&decompressor, &decompressor_config, &header, error);
+    }
+
+    flasher_config_t flasher_config;
+    flasher_config.erase_sector_callback    = flash_erase_sector;
+    flasher_config.program_word_callback    = flash_program_word;
+    flasher_config.start_address            = APPLICATION_START_ADDRESS;
+    flasher_config.end_address              = FLASH_END_ADDRESS;
+
+    flasher_init(&flasher, &flasher_config);
+
+    HAL_FLASH_Unlock();
+
+    LOG("Bootloader [flash] : earse firmware, size = %u bytes\r\n", firmware_size);
+
+    if (exit_code == STD_SUCCESS)
+    {
+        exit_code = flasher_erase(&flasher, firmware_size, error);
+    }
+
+    while ((exit_code == STD_SUCCESS) && (size != 0U))
+    {
+        LOG("Bootloader [flash] : program bytes = %u\r\n", size);
+
+        if (is_compressed == true)
+        {
+            exit_code = decompressor_process(&decompressor, &firmware_data[offset], size - offset, error);
+        }
+        else
+        {
+            exit_code = program_image(&firmware_data[offset], size - offset, error);
+        }
+        offset = 0U;
+
+        if (exit_code == STD_SUCCESS)
+        {
+            exit_code = storage_read_file(&storage, &file, (char*)(firmware_data), &size, ARRAY_SIZE(firmware_data), error);
+        }
+    }
+
+    if ((exit_code == STD_SUCCESS) && (is_compressed == true))
+    {
+        exit_code = decompressor_finish(&decompressor, error);
+    }
+
+    HAL_FLASH_Lock();
+
+    if (exit_code != STD_SUCCESS)
+    {
+        storage_close_file(&storage, &file, NULL);
+
+        return STD_FAILURE;
+    }
+
+    return storage_close_file(&storage, &file, error);
+}
+
+int move_image (boot_image_t from_image, boot_image_t to_image, std_error_t * const error)
+{
+    if (mount_storage(error) != STD_SUCCESS)
+    {
+        return STD_FAILURE;
+    }
+
+    return storage_rename_file(&storage, image_file_name_table[from_image], image_file_name_table[to_image], error);
+}
+
+int program_image (uint8_t const * const data, size_t size, std_error_t * const error)
+{
+    return flasher_program(&flasher, data, size, error);
+}
+
+int verify_application (std_error_t * const error)
+{
+    image_config_t config;
+    config.crc_callback = board_crc_calculate;
+    config.image        = (uint32_t const*)(APPLICATION_START_ADDRESS);
+    config.max_size     = (uint32_t)(FLASH_END_ADDRESS - APPLICATION_START_ADDRESS);
+
+    image_info_t info;
+
+    return image_verify(&config, &info, error);
+}
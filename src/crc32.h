@@ -0,0 +1,29 @@
+/************************************************************
+ *   Author : German Mundinger
+ *   Date   : 2024
+ ************************************************************/
+
+#ifndef CRC32_H
+#define CRC32_H
+
+#define CRC32_INITIAL_VALUE 0xFFFFFFFFU
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// CRC-32/MPEG-2 (polynomial 0x04C11DB7, no reflection, no final XOR) - the one of the STM32 CRC unit
+uint32_t crc32_update (uint32_t crc, uint8_t const * const data, size_t size);
+uint32_t crc32_calculate (uint8_t const * const data, size_t size);
+
+// The STM32 CRC unit takes whole words, most significant byte first - its software equivalent
+uint32_t crc32_calculate_words (uint32_t const * const words, size_t count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CRC32_H
@@ -13,18 +13,82 @@
 
 
 #define READ_JEDEC_ID           0x9F
+#define READ_SFDP               0x5A
 #define READ_DATA               0x03
 #define FAST_READ               0x0B
 #define WRITE_ENABLE            0x06
 #define PAGE_PROGRAMM           0x02
 #define SECTOR_ERASE            0x20
+#define HALF_BLOCK_ERASE        0x52
 #define BLOCK_ERASE             0xD8
 #define CHIP_ERASE              0xC7
 #define READ_STATUS_REGISTER_1  0x05
+#define READ_STATUS_REGISTER_2  0x35
+#define ERASE_SUSPEND           0x75
+#define ERASE_RESUME            0x7A
 #define POWER_DOWN              0xB9
 #define RELEASE_POWER_DOWN      0xAB
+#define ENTER_4_BYTE_ADDRESS    0xB7
 
 #define DUMMY_BYTE              0xA5
+#define BUSY_BIT                0x01
+#define SUSPEND_BIT             0x80    // Of the status register 2
+
+#define SFDP_SIGNATURE          0x50444653U     // "SFDP"
+#define SFDP_BASIC_TABLE_ID     0x00U
+#define SFDP_TABLE_SIZE_MAX     11U             // DWORDs, up to the page size
+
+#define READ_CHUNK_SIZE         4096U   // Of a receive, as littlefs reads a sector, well within the SPI timeout
+
+#define W25Q32BV_SIZE           (4U * 1024U * 1024U)
+#define W25Q_SIZE_MAX           (64U * 1024U * 1024U)   // The W25Q512, the chip erase timeout stays in 32 bits
+#define W25Q_3_BYTE_SIZE_MAX    (16U * 1024U * 1024U)
+
+#define TIMEOUT_ERROR_TEXT      "W25Q busy timeout"
+#define PART_ERROR_TEXT         "W25Q unknown part"
+
+
+typedef struct w25q32bv_flash_wait
+{
+    uint32_t spin_us;       // Back to back polls until
+    uint32_t yield_us;      // Polls with a yield in between until
+    uint32_t sleep_ms;      // Afterwards polls with a sleep in between
+    uint32_t timeout_ms;
+
+} w25q32bv_flash_wait_t;
+
+// Of the JEDEC basic flash parameter table
+typedef struct w25q32bv_flash_sfdp
+{
+    bool is_found;                      // Early parts have none
+    uint32_t flash_size;
+    uint32_t page_size;
+    bool is_4_byte_address_supported;
+    bool is_erase_layout_valid;         // 4, 32 and 64 KB erases, the ones the driver sends
+
+} w25q32bv_flash_sfdp_t;
+
+// Datasheet, typical / max: page program 0.7 / 3 ms, sector erase 30 / 200 ms, 32 KB block erase 120 / 800 ms,
+// block erase 150 / 1000 ms, chip erase 10 / 50 s, erase suspend - / 20 us
+static const w25q32bv_flash_wait_t wait_array[W25Q32BV_OPERATION_SIZE] =
+{
+    { 1000U,    3000U,  1U,     10U     },  // PAGE_PROGRAM_W25Q32BV_OPERATION
+    { 0U,       0U,     1U,     400U    },  // SECTOR_ERASE_W25Q32BV_OPERATION
+    { 0U,       0U,     10U,    1600U   },  // HALF_BLOCK_ERASE_W25Q32BV_OPERATION
+    { 0U,       0U,     10U,    2000U   },  // BLOCK_ERASE_W25Q32BV_OPERATION
+    { 0U,       0U,     100U,   100000U },  // CHIP_ERASE_W25Q32BV_OPERATION
+    { 1000U,    1000U,  1U,     1U      }   // ERASE_SUSPEND_W25Q32BV_OPERATION
+};
+
+
+static int w25q32bv_flash_read (w25q32bv_flash_t const * const self, uint8_t command, uint8_t *data, uint32_t size, uint32_t address, std_error_t * const error);
+static int w25q32bv_flash_read_suspended (w25q32bv_flash_t const * const self, bool * const is_suspended, std_error_t * const error);
+static int w25q32bv_flash_send_command (w25q32bv_flash_t const * const self, uint8_t command, std_error_t * const error);
+static uint16_t w25q32bv_flash_set_address_command (w25q32bv_flash_t const * const self, uint8_t * const tx_data, uint8_t command, uint32_t address);
+static int w25q32bv_flash_read_sfdp (w25q32bv_flash_t const * const self, uint8_t *data, uint16_t size, uint32_t address, std_error_t * const error);
+static int w25q32bv_flash_parse_sfdp (w25q32bv_flash_t const * const self, w25q32bv_flash_sfdp_t * const sfdp, std_error_t * const error);
+static uint32_t w25q32bv_flash_get_dword (uint8_t const * const data, uint32_t dword_number);
+static void w25q32bv_flash_set_array (w25q32bv_flash_t * const self, uint32_t flash_size, uint32_t page_size);
 
 
 void w25q32bv_flash_init (w25q32bv_flash_t * const self,
@@ -38,19 +102,73 @@ void w25q32bv_flash_init (w25q32bv_flash_t * const self,
     assert(config->spi_unselect_callback    != NULL);
     assert(config->spi_tx_rx_callback       != NULL);
     assert(config->delay_callback           != NULL);
+    assert(config->yield_callback           != NULL);
+    assert(config->get_cycles_callback      != NULL);
+    assert(config->cycles_per_us            != 0U);
 
     self->config = *config;
 
-    self->array.block_count     = 64U;
-    self->array.page_size       = 256U;
-    self->array.sector_size     = 4096U;
-    self->array.sector_count    = self->array.block_count * 16U;
-    self->array.page_count      = (self->array.sector_count * self->array.sector_size) / self->array.page_size;
-    self->array.block_size      = self->array.sector_size * 16U;
+    // Till a detect
+    self->address_size = 3U;
+    w25q32bv_flash_set_array(self, W25Q32BV_SIZE, 256U);
 
     return;
 }
 
+int w25q32bv_flash_detect (w25q32bv_flash_t * const self, std_error_t * const error)
+{
+    assert(self != NULL);
+
+    w25q32bv_flash_info_t info;
+
+    if (w25q32bv_flash_read_info(self, &info, error) != STD_SUCCESS)
+    {
+        return STD_FAILURE;
+    }
+
+    w25q32bv_flash_sfdp_t sfdp;
+
+    if (w25q32bv_flash_parse_sfdp(self, &sfdp, error) != STD_SUCCESS)
+    {
+        return STD_FAILURE;
+    }
+
+    if (sfdp.is_found != true)
+    {
+        // The capacity code of the JEDEC ID is log2 of the size, the W25Q erases and pages
+        const uint32_t capacity_code = info.jedec_id & 0xFFU;
+
+        sfdp.flash_size                     = ((capacity_code >= 0x10U) && (capacity_code < 0x20U)) ? (1U << capacity_code) : 0U;
+        sfdp.page_size                      = 256U;
+        sfdp.is_4_byte_address_supported    = true;
+        sfdp.is_erase_layout_valid          = true;
+    }
+
+    const bool is_4_byte_address = (sfdp.flash_size > W25Q_3_BYTE_SIZE_MAX);
+
+    if ((sfdp.flash_size < W25Q32BV_SIZE) || (sfdp.flash_size > W25Q_SIZE_MAX) ||
+        (sfdp.is_erase_layout_valid != true) || ((is_4_byte_address == true) && (sfdp.is_4_byte_address_supported != true)))
+    {
+        std_error_catch_custom(error, STD_FAILURE, PART_ERROR_TEXT, __FILE__, __LINE__);
+
+        return STD_FAILURE;
+    }
+
+    // Till a power cycle, a warm reset finds it there and sends it again
+    if (is_4_byte_address == true)
+    {
+        if (w25q32bv_flash_send_command(self, ENTER_4_BYTE_ADDRESS, error) != STD_SUCCESS)
+        {
+            return STD_FAILURE;
+        }
+    }
+
+    self->address_size = (is_4_byte_address == true) ? 4U : 3U;
+    w25q32bv_flash_set_array(self, sfdp.flash_size, sfdp.page_size);
+
+    return STD_SUCCESS;
+}
+
 void w25q32bv_flash_get_array (w25q32bv_flash_t const * const self,
                                 w25q32bv_flash_array_t * const array)
 {
@@ -102,29 +220,7 @@ int w25q32bv_flash_read_data (  w25q32bv_flash_t const * const self,
 
     const uint32_t address = (sector_number * self->array.sector_size) + sector_offset;
 
-    const uint16_t data_size = 4U;
-    uint8_t tx_data[data_size], rx_data[data_size];
-
-    tx_data[0] = READ_DATA;
-    tx_data[1] = (address >> 16) & 0xFF;
-    tx_data[2] = (address >> 8) & 0xFF;
-    tx_data[3] = (address >> 0) & 0xFF;
-
-    self->config.spi_lock_callback();
-    self->config.spi_select_callback();
-
-    int exit_code = self->config.spi_tx_rx_callback(tx_data, rx_data, data_size, self->config.spi_timeout_ms, error);
-
-    if (exit_code != STD_FAILURE)
-    {
-        uint8_t dummy_data[size];
-
-        exit_code = self->config.spi_tx_rx_callback(dummy_data, data, size, self->config.spi_timeout_ms, error);
-    }
-    self->config.spi_unselect_callback();
-    self->config.spi_unlock_callback();
-
-    return exit_code;
+    return w25q32bv_flash_read(self, READ_DATA, data, size, address, error);
 }
 
 int w25q32bv_flash_read_data_fast (w25q32bv_flash_t const * const self,
@@ -139,30 +235,43 @@ int w25q32bv_flash_read_data_fast (w25q32bv_flash_t const * const self,
 
     const uint32_t address = (sector_number * self->array.sector_size) + sector_offset;
 
-    const uint16_t data_size = 5U;
-    uint8_t tx_data[data_size], rx_data[data_size];
-
-    tx_data[0] = FAST_READ;
-    tx_data[1] = (address >> 16) & 0xFF;
-    tx_data[2] = (address >> 8) & 0xFF;
-    tx_data[3] = (address >> 0) & 0xFF;
-    tx_data[4] = 0U;
+    return w25q32bv_flash_read(self, FAST_READ, data, size, address, error);
+}
 
-    self->config.spi_lock_callback();
-    self->config.spi_select_callback();
+int w25q32bv_flash_read_data_stream (w25q32bv_flash_t const * const self,
+                                        uint8_t *buffer,
+                                        uint32_t buffer_size,
+                                        uint32_t size,
+                                        uint32_t sector_number,
+                                        uint32_t sector_offset,
+                                        w25q32bv_flash_read_callback_t read_callback,
+                                        void *context,
+                                        std_error_t * const error)
+{
+    assert(self             != NULL);
+    assert(buffer           != NULL);
+    assert(buffer_size      != 0U);
+    assert(read_callback    != NULL);
 
-    int exit_code = self->config.spi_tx_rx_callback(tx_data, rx_data, data_size, self->config.spi_timeout_ms, error);
+    const uint32_t address = (sector_number * self->array.sector_size) + sector_offset;
 
-    if (exit_code != STD_FAILURE)
+    for (uint32_t offset = 0U; offset < size; offset += buffer_size)
     {
-        uint8_t dummy_data[size];
+        const uint32_t chunk_size = ((size - offset) < buffer_size) ? (size - offset) : buffer_size;
+
+        if (w25q32bv_flash_read(self, FAST_READ, buffer, chunk_size, address + offset, error) != STD_SUCCESS)
+        {
+            return STD_FAILURE;
+        }
 
-        exit_code = self->config.spi_tx_rx_callback(dummy_data, data, size, self->config.spi_timeout_ms, error);
+        // The bus is given back meanwhile, the W5500 keeps working through a long copy
+        if (read_callback(buffer, chunk_size, context, error) != STD_SUCCESS)
+        {
+            return STD_FAILURE;
+        }
     }
-    self->config.spi_unselect_callback();
-    self->config.spi_unlock_callback();
 
-    return exit_code;
+    return STD_SUCCESS;
 }
 
 int w25q32bv_flash_enable_erasing_or_writing (w25q32bv_flash_t const * const self, std_error_t * const error)
@@ -189,17 +298,34 @@ int w25q32bv_flash_erase_sector (w25q32bv_flash_t const * const self, uint32_t s
 
     const uint32_t address = sector_number * self->array.sector_size;
 
-    const uint16_t data_size = 4U;
+    const uint16_t data_size = 5U;
     uint8_t tx_data[data_size], rx_data[data_size];
 
-    tx_data[0] = SECTOR_ERASE;
-    tx_data[1] = (address >> 16) & 0xFF;
-    tx_data[2] = (address >> 8) & 0xFF;
-    tx_data[3] = (address >> 0) & 0xFF;
+    const uint16_t command_size = w25q32bv_flash_set_address_command(self, tx_data, SECTOR_ERASE, address);
 
     self->config.spi_lock_callback();
     self->config.spi_select_callback();
-    const int exit_code = self->config.spi_tx_rx_callback(tx_data, rx_data, data_size, self->config.spi_timeout_ms, error);
+    const int exit_code = self->config.spi_tx_rx_callback(tx_data, rx_data, command_size, self->config.spi_timeout_ms, error);
+    self->config.spi_unselect_callback();
+    self->config.spi_unlock_callback();
+
+    return exit_code;
+}
+
+int w25q32bv_flash_erase_half_block (w25q32bv_flash_t const * const self, uint32_t half_block_number, std_error_t * const error)
+{
+    assert(self != NULL);
+
+    const uint32_t address = half_block_number * (self->array.block_size / 2U);
+
+    const uint16_t data_size = 5U;
+    uint8_t tx_data[data_size], rx_data[data_size];
+
+    const uint16_t command_size = w25q32bv_flash_set_address_command(self, tx_data, HALF_BLOCK_ERASE, address);
+
+    self->config.spi_lock_callback();
+    self->config.spi_select_callback();
+    const int exit_code = self->config.spi_tx_rx_callback(tx_data, rx_data, command_size, self->config.spi_timeout_ms, error);
     self->config.spi_unselect_callback();
     self->config.spi_unlock_callback();
 
@@ -212,17 +338,14 @@ int w25q32bv_flash_erase_block (w25q32bv_flash_t const * const self, uint32_t bl
 
     const uint32_t address = block_number * self->array.block_size;
 
-    const uint16_t data_size = 4U;
+    const uint16_t data_size = 5U;
     uint8_t tx_data[data_size], rx_data[data_size];
 
-    tx_data[0] = BLOCK_ERASE;
-    tx_data[1] = (address >> 16) & 0xFF;
-    tx_data[2] = (address >> 8) & 0xFF;
-    tx_data[3] = (address >> 0) & 0xFF;
+    const uint16_t command_size = w25q32bv_flash_set_address_command(self, tx_data, BLOCK_ERASE, address);
 
     self->config.spi_lock_callback();
     self->config.spi_select_callback();
-    const int exit_code = self->config.spi_tx_rx_callback(tx_data, rx_data, data_size, self->config.spi_timeout_ms, error);
+    const int exit_code = self->config.spi_tx_rx_callback(tx_data, rx_data, command_size, self->config.spi_timeout_ms, error);
     self->config.spi_unselect_callback();
     self->config.spi_unlock_callback();
 
@@ -266,24 +389,19 @@ int w25q32bv_flash_write_page (w25q32bv_flash_t const * const self,
 
     const uint32_t address = (page_number * self->array.page_size) + page_offset;
 
-    const uint16_t data_size = 4U;
+    const uint16_t data_size = 5U;
     uint8_t tx_data[data_size], rx_data[data_size];
 
-    tx_data[0] = PAGE_PROGRAMM;
-    tx_data[1] = (address >> 16) & 0xFF;
-    tx_data[2] = (address >> 8) & 0xFF;
-    tx_data[3] = (address >> 0) & 0xFF;
+    const uint16_t command_size = w25q32bv_flash_set_address_command(self, tx_data, PAGE_PROGRAMM, address);
 
     self->config.spi_lock_callback();
     self->config.spi_select_callback();
 
-    int exit_code = self->config.spi_tx_rx_callback(tx_data, rx_data, data_size, self->config.spi_timeout_ms, error);
+    int exit_code = self->config.spi_tx_rx_callback(tx_data, rx_data, command_size, self->config.spi_timeout_ms, error);
 
     if (exit_code != STD_FAILURE)
     {
-        uint8_t dummy_data[size];
-
-        exit_code = self->config.spi_tx_rx_callback(data, dummy_data, size, self->config.spi_timeout_ms, error);
+        exit_code = self->config.spi_tx_rx_callback(data, NULL, size, self->config.spi_timeout_ms, error);
     }
     self->config.spi_unselect_callback();
     self->config.spi_unlock_callback();
@@ -291,47 +409,98 @@ int w25q32bv_flash_write_page (w25q32bv_flash_t const * const self,
     return exit_code;
 }
 
-int w25q32bv_flash_wait_erasing_or_writing (w25q32bv_flash_t const * const self, std_error_t * const error)
+int w25q32bv_flash_wait_erasing_or_writing (w25q32bv_flash_t const * const self,
+                                            w25q32bv_flash_operation_t operation,
+                                            std_error_t * const error)
 {
-    assert(self != NULL);
+    assert(self         != NULL);
+    assert(operation    < W25Q32BV_OPERATION_SIZE);
 
-    const uint16_t data_size = 1U;
-    uint8_t tx_data[data_size], rx_data[data_size];
+    const w25q32bv_flash_wait_t *wait = &wait_array[operation];
 
-    tx_data[0] = READ_STATUS_REGISTER_1;
+    uint32_t timeout_us = wait->timeout_ms * 1000U;
 
-    self->config.spi_lock_callback();
-    self->config.spi_select_callback();
+    // Of the W25Q32BV, a larger part takes as many times longer
+    if (operation == CHIP_ERASE_W25Q32BV_OPERATION)
+    {
+        timeout_us *= (self->array.sector_count * self->array.sector_size) / W25Q32BV_SIZE;
+    }
 
-    int exit_code = self->config.spi_tx_rx_callback(tx_data, rx_data, data_size, self->config.spi_timeout_ms, error);
+    uint32_t elapsed_us     = 0U;
+    uint32_t last_cycles    = self->config.get_cycles_callback();
 
-    if (exit_code != STD_FAILURE)
+    while (true)
     {
-        const uint32_t delay_ms = 1U;
-        
-        tx_data[0] = DUMMY_BYTE;
+        bool is_busy;
+
+        if (w25q32bv_flash_read_busy(self, &is_busy, error) != STD_SUCCESS)
+        {
+            return STD_FAILURE;
+        }
+
+        if (is_busy != true)
+        {
+            return STD_SUCCESS;
+        }
+
+        if (elapsed_us >= timeout_us)
+        {
+            std_error_catch_custom(error, STD_FAILURE, TIMEOUT_ERROR_TEXT, __FILE__, __LINE__);
+
+            return STD_FAILURE;
+        }
 
-        while (true)
+        if (elapsed_us >= wait->yield_us)
         {
-            exit_code = self->config.spi_tx_rx_callback(tx_data, rx_data, data_size, self->config.spi_timeout_ms, error);
+            self->config.delay_callback(wait->sleep_ms);
 
-            if (exit_code != STD_SUCCESS)
-            {
-                break;
-            }
+            // The core clock stops in the tickless idle, so a sleep counts as its own length
+            elapsed_us  += wait->sleep_ms * 1000U;
+            last_cycles = self->config.get_cycles_callback();
 
-            if ((rx_data[0] & 1U) == 0U)
-            {
-                break;
-            }
+            continue;
+        }
 
-            self->config.delay_callback(delay_ms);
+        if (elapsed_us >= wait->spin_us)
+        {
+            self->config.yield_callback();
         }
+
+        const uint32_t cycles   = self->config.get_cycles_callback();
+        const uint32_t delta_us = (cycles - last_cycles) / self->config.cycles_per_us;
+
+        elapsed_us  += delta_us;
+        last_cycles += delta_us * self->config.cycles_per_us;
     }
-    self->config.spi_unselect_callback();
-    self->config.spi_unlock_callback();
-    
-    return exit_code;
+}
+
+int w25q32bv_flash_suspend_erasing (w25q32bv_flash_t const * const self, bool * const is_suspended, std_error_t * const error)
+{
+    assert(self         != NULL);
+    assert(is_suspended != NULL);
+
+    *is_suspended = false;
+
+    if (w25q32bv_flash_send_command(self, ERASE_SUSPEND, error) != STD_SUCCESS)
+    {
+        return STD_FAILURE;
+    }
+
+    // Busy until the array is readable, a chip erase is never suspended and times out here
+    if (w25q32bv_flash_wait_erasing_or_writing(self, ERASE_SUSPEND_W25Q32BV_OPERATION, error) != STD_SUCCESS)
+    {
+        return STD_FAILURE;
+    }
+
+    // Not if the erase was over before the command
+    return w25q32bv_flash_read_suspended(self, is_suspended, error);
+}
+
+int w25q32bv_flash_resume_erasing (w25q32bv_flash_t const * const self, std_error_t * const error)
+{
+    assert(self != NULL);
+
+    return w25q32bv_flash_send_command(self, ERASE_RESUME, error);
 }
 
 int w25q32bv_flash_power_down (w25q32bv_flash_t const * const self, std_error_t * const error)
@@ -369,3 +538,220 @@ int w25q32bv_flash_release_power_down (w25q32bv_flash_t const * const self, std_
 
     return exit_code;
 }
+
+
+int w25q32bv_flash_read (w25q32bv_flash_t const * const self, uint8_t command, uint8_t *data, uint32_t size, uint32_t address, std_error_t * const error)
+{
+    const uint16_t data_size = 6U;
+    uint8_t tx_data[data_size], rx_data[data_size];
+
+    uint16_t command_size = w25q32bv_flash_set_address_command(self, tx_data, command, address);
+
+    // And a dummy byte
+    if (command == FAST_READ)
+    {
+        tx_data[command_size] = 0U;
+        ++command_size;
+    }
+
+    self->config.spi_lock_callback();
+    self->config.spi_select_callback();
+
+    int exit_code = self->config.spi_tx_rx_callback(tx_data, rx_data, command_size, self->config.spi_timeout_ms, error);
+
+    // Receive only, straight into the data, the array streams on across the chunks
+    for (uint32_t offset = 0U; (offset < size) && (exit_code != STD_FAILURE); offset += READ_CHUNK_SIZE)
+    {
+        const uint32_t chunk_size = ((size - offset) < READ_CHUNK_SIZE) ? (size - offset) : READ_CHUNK_SIZE;
+
+        exit_code = self->config.spi_tx_rx_callback(NULL, &data[offset], (uint16_t)(chunk_size), self->config.spi_timeout_ms, error);
+    }
+    self->config.spi_unselect_callback();
+    self->config.spi_unlock_callback();
+
+    return exit_code;
+}
+
+int w25q32bv_flash_read_busy (w25q32bv_flash_t const * const self, bool * const is_busy, std_error_t * const error)
+{
+    const uint16_t data_size = 2U;
+    uint8_t tx_data[data_size], rx_data[data_size];
+
+    tx_data[0] = READ_STATUS_REGISTER_1;
+    tx_data[1] = DUMMY_BYTE;
+
+    // The bus is given back between polls, the W5500 keeps working through an erase
+    self->config.spi_lock_callback();
+    self->config.spi_select_callback();
+    const int exit_code = self->config.spi_tx_rx_callback(tx_data, rx_data, data_size, self->config.spi_timeout_ms, error);
+    self->config.spi_unselect_callback();
+    self->config.spi_unlock_callback();
+
+    *is_busy = ((rx_data[1] & BUSY_BIT) != 0U);
+
+    return exit_code;
+}
+
+int w25q32bv_flash_read_suspended (w25q32bv_flash_t const * const self, bool * const is_suspended, std_error_t * const error)
+{
+    const uint16_t data_size = 2U;
+    uint8_t tx_data[data_size], rx_data[data_size];
+
+    tx_data[0] = READ_STATUS_REGISTER_2;
+    tx_data[1] = DUMMY_BYTE;
+
+    self->config.spi_lock_callback();
+    self->config.spi_select_callback();
+    const int exit_code = self->config.spi_tx_rx_callback(tx_data, rx_data, data_size, self->config.spi_timeout_ms, error);
+    self->config.spi_unselect_callback();
+    self->config.spi_unlock_callback();
+
+    *is_suspended = ((rx_data[1] & SUSPEND_BIT) != 0U);
+
+    return exit_code;
+}
+
+int w25q32bv_flash_send_command (w25q32bv_flash_t const * const self, uint8_t command, std_error_t * const error)
+{
+    const uint16_t data_size = 1U;
+    uint8_t tx_data[data_size], rx_data[data_size];
+
+    tx_data[0] = command;
+
+    self->config.spi_lock_callback();
+    self->config.spi_select_callback();
+    const int exit_code = self->config.spi_tx_rx_callback(tx_data, rx_data, data_size, self->config.spi_timeout_ms, error);
+    self->config.spi_unselect_callback();
+    self->config.spi_unlock_callback();
+
+    return exit_code;
+}
+
+uint16_t w25q32bv_flash_set_address_command (w25q32bv_flash_t const * const self, uint8_t * const tx_data, uint8_t command, uint32_t address)
+{
+    tx_data[0] = command;
+
+    // MSB first, 3 or 4 bytes as detected
+    for (uint32_t i = 0U; i < self->address_size; ++i)
+    {
+        tx_data[1U + i] = (address >> (8U * (self->address_size - 1U - i))) & 0xFF;
+    }
+
+    return (uint16_t)(1U + self->address_size);
+}
+
+int w25q32bv_flash_read_sfdp (w25q32bv_flash_t const * const self, uint8_t *data, uint16_t size, uint32_t address, std_error_t * const error)
+{
+    const uint16_t data_size = 5U;
+    uint8_t tx_data[data_size], rx_data[data_size];
+
+    // A 3 byte address in any addressing mode, then a dummy byte
+    tx_data[0] = READ_SFDP;
+    tx_data[1] = (address >> 16) & 0xFF;
+    tx_data[2] = (address >> 8) & 0xFF;
+    tx_data[3] = (address >> 0) & 0xFF;
+    tx_data[4] = DUMMY_BYTE;
+
+    self->config.spi_lock_callback();
+    self->config.spi_select_callback();
+
+    int exit_code = self->config.spi_tx_rx_callback(tx_data, rx_data, data_size, self->config.spi_timeout_ms, error);
+
+    if (exit_code != STD_FAILURE)
+    {
+        exit_code = self->config.spi_tx_rx_callback(NULL, data, size, self->config.spi_timeout_ms, error);
+    }
+    self->config.spi_unselect_callback();
+    self->config.spi_unlock_callback();
+
+    return exit_code;
+}
+
+int w25q32bv_flash_parse_sfdp (w25q32bv_flash_t const * const self, w25q32bv_flash_sfdp_t * const sfdp, std_error_t * const error)
+{
+    sfdp->is_found = false;
+
+    // The SFDP header, then the first parameter header, the one of the basic table
+    uint8_t header[16];
+
+    if (w25q32bv_flash_read_sfdp(self, header, sizeof(header), 0U, error) != STD_SUCCESS)
+    {
+        return STD_FAILURE;
+    }
+
+    const uint32_t table_size       = header[11];   // DWORDs
+    const uint32_t table_address    = w25q32bv_flash_get_dword(header, 3U) & 0xFFFFFFU;
+
+    if ((w25q32bv_flash_get_dword(header, 0U) != SFDP_SIGNATURE) || (header[8] != SFDP_BASIC_TABLE_ID) || (table_size < 9U))
+    {
+        return STD_SUCCESS;
+    }
+
+    uint8_t table[SFDP_TABLE_SIZE_MAX * 4U];
+
+    const uint32_t read_size = (table_size < SFDP_TABLE_SIZE_MAX) ? table_size : SFDP_TABLE_SIZE_MAX;
+
+    if (w25q32bv_flash_read_sfdp(self, table, (uint16_t)(read_size * 4U), table_address, error) != STD_SUCCESS)
+    {
+        return STD_FAILURE;
+    }
+
+    sfdp->is_found = true;
+
+    // DWORD 1: 3 byte only, 3 or 4 byte, 4 byte only
+    sfdp->is_4_byte_address_supported = (((w25q32bv_flash_get_dword(table, 0U) >> 17) & 0x03U) != 0U);
+
+    // DWORD 2: the size in bits, or its log2 with the top bit set
+    const uint32_t density = w25q32bv_flash_get_dword(table, 1U);
+
+    if ((density & 0x80000000U) != 0U)
+    {
+        const uint32_t exponent = density & 0x7FFFFFFFU;
+
+        sfdp->flash_size = ((exponent >= 3U) && (exponent < 35U)) ? (1U << (exponent - 3U)) : 0U;
+    }
+    else
+    {
+        sfdp->flash_size = (density / 8U) + 1U;
+    }
+
+    // DWORDs 8 and 9: four erase types, the log2 of the size and the command of each
+    bool is_sector_erase        = false;
+    bool is_half_block_erase    = false;
+    bool is_block_erase         = false;
+
+    for (uint32_t i = 0U; i < 4U; ++i)
+    {
+        const uint8_t exponent  = table[28U + (2U * i)];
+        const uint8_t command   = table[29U + (2U * i)];
+
+        is_sector_erase     = is_sector_erase       || ((exponent == 12U) && (command == SECTOR_ERASE));
+        is_half_block_erase = is_half_block_erase   || ((exponent == 15U) && (command == HALF_BLOCK_ERASE));
+        is_block_erase      = is_block_erase        || ((exponent == 16U) && (command == BLOCK_ERASE));
+    }
+    sfdp->is_erase_layout_valid = (is_sector_erase == true) && (is_half_block_erase == true) && (is_block_erase == true);
+
+    // DWORD 11 since JESD216A, the log2 of the page size
+    sfdp->page_size = (read_size >= 11U) ? (1U << ((w25q32bv_flash_get_dword(table, 10U) >> 4) & 0x0FU)) : 256U;
+
+    return STD_SUCCESS;
+}
+
+uint32_t w25q32bv_flash_get_dword (uint8_t const * const data, uint32_t dword_number)
+{
+    uint8_t const * const dword = &data[dword_number * 4U];
+
+    return ((uint32_t)(dword[3]) << 24) | ((uint32_t)(dword[2]) << 16) | ((uint32_t)(dword[1]) << 8) | ((uint32_t)(dword[0]) << 0);
+}
+
+void w25q32bv_flash_set_array (w25q32bv_flash_t * const self, uint32_t flash_size, uint32_t page_size)
+{
+    self->array.page_size       = page_size;
+    self->array.page_count      = flash_size / page_size;
+    self->array.sector_size     = 4096U;
+    self->array.sector_count    = flash_size / self->array.sector_size;
+    self->array.block_size      = 65536U;
+    self->array.block_count     = flash_size / self->array.block_size;
+
+    return;
+}
@@ -7,14 +7,32 @@
 #define W25Q32BV_FLASH_H
 
 #include <stdint.h>
+#include <stdbool.h>
 
 typedef struct std_error std_error_t;
 
+typedef enum w25q32bv_flash_operation
+{
+    PAGE_PROGRAM_W25Q32BV_OPERATION = 0,
+    SECTOR_ERASE_W25Q32BV_OPERATION,
+    HALF_BLOCK_ERASE_W25Q32BV_OPERATION,
+    BLOCK_ERASE_W25Q32BV_OPERATION,
+    CHIP_ERASE_W25Q32BV_OPERATION,
+    ERASE_SUSPEND_W25Q32BV_OPERATION,
+    W25Q32BV_OPERATION_SIZE
+
+} w25q32bv_flash_operation_t;
+
 typedef void (*w25q32bv_flash_spi_lock_callback_t) ();
 typedef void (*w25q32bv_flash_spi_select_callback_t) ();
+// tx_data or rx_data is NULL for the one-way data phases
 typedef int (*w25q32bv_flash_spi_tx_rx_callback_t) (uint8_t *tx_data, uint8_t *rx_data, uint16_t size,
                                                     uint32_t timeout_ms, std_error_t * const error);
 typedef void (*w25q32bv_flash_delay_callback_t) (uint32_t delay_ms);
+typedef void (*w25q32bv_flash_yield_callback_t) ();
+typedef uint32_t (*w25q32bv_flash_get_cycles_callback_t) ();
+// A chunk of a streamed read, anything but STD_SUCCESS stops it
+typedef int (*w25q32bv_flash_read_callback_t) (uint8_t const * const data, uint32_t size, void *context, std_error_t * const error);
 
 typedef struct w25q32bv_flash_config
 {
@@ -26,6 +44,9 @@ typedef struct w25q32bv_flash_config
     uint32_t spi_timeout_ms;
 
     w25q32bv_flash_delay_callback_t delay_callback;
+    w25q32bv_flash_yield_callback_t yield_callback;
+    w25q32bv_flash_get_cycles_callback_t get_cycles_callback;   // Free running, must not stop while polling
+    uint32_t cycles_per_us;
 
 } w25q32bv_flash_config_t;
 
@@ -49,9 +70,19 @@ typedef struct w25q32bv_flash_array
 
 typedef struct w25q32bv_flash w25q32bv_flash_t;
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The W25Q32BV array till a detect
 void w25q32bv_flash_init (  w25q32bv_flash_t * const self,
                             w25q32bv_flash_config_t const * const config);
 
+// Out of the power down only. The size and the erases come from the SFDP tables, or from the JEDEC ID of a part without them.
+// Past 16 MB the part is switched to 4 byte addresses (W25Q256), a part with another erase layout is refused.
+int w25q32bv_flash_detect ( w25q32bv_flash_t * const self,
+                            std_error_t * const error);
+
 void w25q32bv_flash_get_array ( w25q32bv_flash_t const * const self,
                                 w25q32bv_flash_array_t * const array);
 
@@ -73,6 +104,17 @@ int w25q32bv_flash_read_data_fast ( w25q32bv_flash_t const * const self,
                                     uint32_t sector_offset,
                                     std_error_t * const error);
 
+// Of any size through a buffer of the caller, read_callback gets it a buffer at a time with the SPI bus free
+int w25q32bv_flash_read_data_stream (   w25q32bv_flash_t const * const self,
+                                        uint8_t *buffer,
+                                        uint32_t buffer_size,
+                                        uint32_t size,
+                                        uint32_t sector_number,
+                                        uint32_t sector_offset,
+                                        w25q32bv_flash_read_callback_t read_callback,
+                                        void *context,
+                                        std_error_t * const error);
+
 int w25q32bv_flash_enable_erasing_or_writing (  w25q32bv_flash_t const * const self,
                                                 std_error_t * const error);
 
@@ -84,14 +126,31 @@ int w25q32bv_flash_write_page ( w25q32bv_flash_t const * const self,
                                 std_error_t * const error);
 
 int w25q32bv_flash_erase_sector (w25q32bv_flash_t const * const self, uint32_t sector_number, std_error_t * const error);
+int w25q32bv_flash_erase_half_block (w25q32bv_flash_t const * const self, uint32_t half_block_number, std_error_t * const error);  // 32 KB
 int w25q32bv_flash_erase_block (w25q32bv_flash_t const * const self, uint32_t block_number, std_error_t * const error);
 int w25q32bv_flash_erase_chip (w25q32bv_flash_t const * const self, std_error_t * const error);
 
-int w25q32bv_flash_wait_erasing_or_writing (w25q32bv_flash_t const * const self, std_error_t * const error);
+// Spins through a page program, backs off to yields and sleeps for the erases, fails after the worst case
+int w25q32bv_flash_wait_erasing_or_writing (w25q32bv_flash_t const * const self,
+                                            w25q32bv_flash_operation_t operation,
+                                            std_error_t * const error);
+
+// A single status poll, nothing waits for it
+int w25q32bv_flash_read_busy (w25q32bv_flash_t const * const self, bool * const is_busy, std_error_t * const error);
+
+// A sector or block erase only, returns once the array is readable again, but the sectors being erased.
+// Programs outside of them are allowed, erases are not.
+int w25q32bv_flash_suspend_erasing (w25q32bv_flash_t const * const self, bool * const is_suspended, std_error_t * const error);
+// Busy again for the rest of the erase, wait for it as usual
+int w25q32bv_flash_resume_erasing (w25q32bv_flash_t const * const self, std_error_t * const error);
 
 int w25q32bv_flash_power_down (w25q32bv_flash_t const * const self, std_error_t * const error);
 int w25q32bv_flash_release_power_down (w25q32bv_flash_t const * const self, std_error_t * const error);
 
+#ifdef __cplusplus
+}
+#endif
+
 
 
 // Private
@@ -100,6 +159,7 @@ typedef struct w25q32bv_flash
     w25q32bv_flash_config_t config;
 
     w25q32bv_flash_array_t array;
+    uint32_t address_size;  // 3 or 4 bytes
 
 } w25q32bv_flash_t;
 
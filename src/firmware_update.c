@@ -0,0 +1,485 @@
+/************************************************************
+ *   Author : German Mundinger
+ *   Date   : 2024
+ ************************************************************/
+
+#include "firmware_update.h"
+
+#include <string.h>
+#include <assert.h>
+
+#include "crc32.h"
+
+#include "logger.h"
+#include "std_error/std_error.h"
+
+
+#define DEFAULT_ERROR_TEXT  "Firmware update error"
+#define SIZE_ERROR_TEXT     "Firmware update image size error"
+#define CRC_ERROR_TEXT      "Firmware update image crc error"
+
+
+static int firmware_update_process_frame (firmware_update_t * const self, std_error_t * const error);
+static int firmware_update_process_header (firmware_update_t * const self, uint8_t const * const payload, size_t payload_size, std_error_t * const error);
+static int firmware_update_process_chunk (firmware_update_t * const self, uint32_t offset, uint8_t const * const payload, size_t payload_size, std_error_t * const error);
+static int firmware_update_finish (firmware_update_t * const self, std_error_t * const error);
+static void firmware_update_drop_byte (firmware_update_t * const self);
+static void firmware_update_request_resume (firmware_update_t * const self);
+static void firmware_update_send_result (firmware_update_t * const self, firmware_update_result_t result);
+
+static void firmware_update_write_u16 (uint8_t * const data, uint16_t value);
+static void firmware_update_write_u32 (uint8_t * const data, uint32_t value);
+static uint16_t firmware_update_read_u16 (uint8_t const * const data);
+static uint32_t firmware_update_read_u32 (uint8_t const * const data);
+
+
+void firmware_update_init (firmware_update_t * const self, firmware_update_config_t const * const config)
+{
+    assert(self                         != NULL);
+    assert(config                       != NULL);
+    assert(config->start_callback       != NULL);
+    assert(config->write_callback       != NULL);
+    assert(config->commit_callback      != NULL);
+    assert(config->discard_callback     != NULL);
+    assert(config->send_callback        != NULL);
+    assert(config->time_callback        != NULL);
+
+    self->config = *config;
+
+    self->state                 = WAITING_HEADER_STATE;
+    self->offset                = 0U;
+    self->image_crc32           = CRC32_INITIAL_VALUE;
+    self->requested_offset      = 0U;
+    self->resume_time_ms        = 0U;
+    self->is_resume_requested   = false;
+    self->frame_size            = 0U;
+
+    memset((void*)(&self->header), 0, sizeof(self->header));
+
+    return;
+}
+
+void firmware_update_resume (firmware_update_t * const self)
+{
+    assert(self != NULL);
+
+    // A frame cut by the disconnect is never completed
+    self->frame_size            = 0U;
+    self->is_resume_requested   = false;
+
+    if (self->state == COMPLETE_STATE)
+    {
+        firmware_update_send_result(self, IMAGE_ACCEPTED);
+    }
+    else
+    {
+        firmware_update_request_resume(self);
+    }
+
+    return;
+}
+
+void firmware_update_poll (firmware_update_t * const self)
+{
+    assert(self != NULL);
+
+    // The server waits for a RESUME the node has lost, nothing is going to arrive otherwise
+    if ((self->state != COMPLETE_STATE) && (self->is_resume_requested == true))
+    {
+        firmware_update_request_resume(self);
+    }
+
+    return;
+}
+
+int firmware_update_process (firmware_update_t * const self, uint8_t const * const data, size_t size, std_error_t * const error)
+{
+    assert(self != NULL);
+    assert(data != NULL);
+
+    int exit_code = STD_SUCCESS;
+
+    size_t i = 0U;
+
+    while (i < size)
+    {
+        size_t frame_size = FIRMWARE_UPDATE_FRAME_HEAD_SIZE;
+
+        if (self->frame_size >= FIRMWARE_UPDATE_FRAME_HEAD_SIZE)
+        {
+            frame_size += (size_t)(firmware_update_read_u16(&self->frame[8])) + FIRMWARE_UPDATE_FRAME_CRC_SIZE;
+        }
+
+        size_t copy_size = frame_size - self->frame_size;
+
+        if (copy_size > (size - i))
+        {
+            copy_size = size - i;
+        }
+
+        memcpy((void*)(&self->frame[self->frame_size]), (const void*)(&data[i]), copy_size);
+        self->frame_size    += copy_size;
+        i                   += copy_size;
+
+        // Hunt for the magic byte by byte, the buffer never holds more than one head here
+        while ((self->frame_size != 0U) && (self->frame[0] != FIRMWARE_UPDATE_MAGIC_0))
+        {
+            firmware_update_drop_byte(self);
+        }
+
+        if (self->frame_size == FIRMWARE_UPDATE_FRAME_HEAD_SIZE)
+        {
+            const bool is_head_valid = (self->frame[1] == FIRMWARE_UPDATE_MAGIC_1) &&
+                                        (firmware_update_read_u16(&self->frame[8]) <= FIRMWARE_UPDATE_CHUNK_SIZE);
+
+            if (is_head_valid != true)
+            {
+                firmware_update_drop_byte(self);
+            }
+        }
+        else if (self->frame_size == frame_size)
+        {
+            const size_t crc_offset = frame_size - FIRMWARE_UPDATE_FRAME_CRC_SIZE;
+
+            if (crc32_calculate(self->frame, crc_offset) != firmware_update_read_u32(&self->frame[crc_offset]))
+            {
+                LOG("Firmware update : frame crc error\r\n");
+
+                // Lost data, unlike a gap, is never healed by the chunks in flight
+                self->frame_size            = 0U;
+                self->is_resume_requested   = false;
+
+                firmware_update_request_resume(self);
+            }
+            else
+            {
+                if (firmware_update_process_frame(self, error) != STD_SUCCESS)
+                {
+                    exit_code = STD_FAILURE;
+                }
+                self->frame_size = 0U;
+            }
+        }
+    }
+
+    return exit_code;
+}
+
+void firmware_update_get_state (firmware_update_t const * const self, firmware_update_state_t * const state)
+{
+    assert(self     != NULL);
+    assert(state    != NULL);
+
+    *state = self->state;
+
+    return;
+}
+
+void firmware_update_get_offset (firmware_update_t const * const self, uint32_t * const offset)
+{
+    assert(self     != NULL);
+    assert(offset   != NULL);
+
+    *offset = self->offset;
+
+    return;
+}
+
+size_t firmware_update_pack_frame (firmware_update_frame_type_t type, uint32_t offset, uint8_t const * const payload, size_t payload_size,
+                                    uint8_t * const frame)
+{
+    assert(frame        != NULL);
+    assert(payload_size <= FIRMWARE_UPDATE_CHUNK_SIZE);
+    assert((payload != NULL) || (payload_size == 0U));
+
+    frame[0] = FIRMWARE_UPDATE_MAGIC_0;
+    frame[1] = FIRMWARE_UPDATE_MAGIC_1;
+    frame[2] = (uint8_t)(type);
+    frame[3] = 0U;
+
+    firmware_update_write_u32(&frame[4], offset);
+    firmware_update_write_u16(&frame[8], (uint16_t)(payload_size));
+
+    if (payload_size != 0U)
+    {
+        memcpy((void*)(&frame[FIRMWARE_UPDATE_FRAME_HEAD_SIZE]), (const void*)(payload), payload_size);
+    }
+
+    const size_t crc_offset = FIRMWARE_UPDATE_FRAME_HEAD_SIZE + payload_size;
+
+    firmware_update_write_u32(&frame[crc_offset], crc32_calculate(frame, crc_offset));
+
+    return crc_offset + FIRMWARE_UPDATE_FRAME_CRC_SIZE;
+}
+
+void firmware_update_pack_header (firmware_update_header_t const * const header, uint8_t payload[FIRMWARE_UPDATE_HEADER_SIZE])
+{
+    assert(header   != NULL);
+    assert(payload  != NULL);
+
+    firmware_update_write_u32(&payload[0], header->image_size);
+    firmware_update_write_u32(&payload[4], header->image_crc32);
+
+    payload[8]  = header->version_major;
+    payload[9]  = header->version_minor;
+    payload[10] = header->version_patch;
+    payload[11] = (uint8_t)(header->image_type);
+
+    return;
+}
+
+
+int firmware_update_process_frame (firmware_update_t * const self, std_error_t * const error)
+{
+    const firmware_update_frame_type_t type = (firmware_update_frame_type_t)(self->frame[2]);
+    const uint32_t offset                   = firmware_update_read_u32(&self->frame[4]);
+    const size_t payload_size               = (size_t)(firmware_update_read_u16(&self->frame[8]));
+    uint8_t const * const payload           = &self->frame[FIRMWARE_UPDATE_FRAME_HEAD_SIZE];
+
+    int exit_code = STD_SUCCESS;
+
+    if (type == IMAGE_HEADER_FRAME)
+    {
+        exit_code = firmware_update_process_header(self, payload, payload_size, error);
+    }
+    else if (type == IMAGE_CHUNK_FRAME)
+    {
+        exit_code = firmware_update_process_chunk(self, offset, payload, payload_size, error);
+    }
+
+    return exit_code;
+}
+
+int firmware_update_process_header (firmware_update_t * const self, uint8_t const * const payload, size_t payload_size, std_error_t * const error)
+{
+    if (payload_size != FIRMWARE_UPDATE_HEADER_SIZE)
+    {
+        return STD_SUCCESS;
+    }
+
+    firmware_update_header_t header;
+    header.image_size       = firmware_update_read_u32(&payload[0]);
+    header.image_crc32      = firmware_update_read_u32(&payload[4]);
+    header.version_major    = payload[8];
+    header.version_minor    = payload[9];
+    header.version_patch    = payload[10];
+    header.image_type       = (firmware_update_image_type_t)(payload[11]);
+
+    const bool is_same_image = (self->state != WAITING_HEADER_STATE) &&
+                                (header.image_size      == self->header.image_size) &&
+                                (header.image_crc32     == self->header.image_crc32) &&
+                                (header.version_major   == self->header.version_major) &&
+                                (header.version_minor   == self->header.version_minor) &&
+                                (header.version_patch   == self->header.version_patch) &&
+                                (header.image_type      == self->header.image_type);
+
+    if (is_same_image == true)
+    {
+        if (self->state == COMPLETE_STATE)
+        {
+            firmware_update_send_result(self, IMAGE_ACCEPTED);
+        }
+        return STD_SUCCESS;
+    }
+
+    LOG("Firmware update : image = %u.%u.%u, size = %lu bytes\r\n",
+        header.version_major, header.version_minor, header.version_patch, (unsigned long)(header.image_size));
+
+    if ((header.image_size == 0U) || (header.image_size > self->config.max_image_size))
+    {
+        self->state = WAITING_HEADER_STATE;
+
+        firmware_update_send_result(self, IMAGE_STORAGE_ERROR);
+
+        std_error_catch_custom(error, STD_FAILURE, SIZE_ERROR_TEXT, __FILE__, __LINE__);
+
+        return STD_FAILURE;
+    }
+
+    if (self->state == RECEIVING_STATE)
+    {
+        self->config.discard_callback();
+    }
+
+    self->state         = WAITING_HEADER_STATE;
+    self->header        = header;
+    self->offset        = 0U;
+    self->image_crc32   = CRC32_INITIAL_VALUE;
+
+    if (self->config.start_callback(&self->header, error) != STD_SUCCESS)
+    {
+        firmware_update_send_result(self, IMAGE_STORAGE_ERROR);
+
+        return STD_FAILURE;
+    }
+
+    self->state = RECEIVING_STATE;
+
+    // The server may be sending a different image from a resumed offset
+    firmware_update_request_resume(self);
+
+    return STD_SUCCESS;
+}
+
+int firmware_update_process_chunk (firmware_update_t * const self, uint32_t offset, uint8_t const * const payload, size_t payload_size, std_error_t * const error)
+{
+    if (self->state != RECEIVING_STATE)
+    {
+        return STD_SUCCESS;
+    }
+
+    // Duplicates are dropped silently, gaps ask for the missing part once
+    if (offset != self->offset)
+    {
+        if (offset > self->offset)
+        {
+            firmware_update_request_resume(self);
+        }
+        return STD_SUCCESS;
+    }
+
+    if (payload_size > (self->header.image_size - self->offset))
+    {
+        self->config.discard_callback();
+        self->state = WAITING_HEADER_STATE;
+
+        firmware_update_send_result(self, IMAGE_STORAGE_ERROR);
+
+        std_error_catch_custom(error, STD_FAILURE, SIZE_ERROR_TEXT, __FILE__, __LINE__);
+
+        return STD_FAILURE;
+    }
+
+    if (self->config.write_callback(payload, payload_size, error) != STD_SUCCESS)
+    {
+        self->config.discard_callback();
+        self->state = WAITING_HEADER_STATE;
+
+        firmware_update_send_result(self, IMAGE_STORAGE_ERROR);
+
+        return STD_FAILURE;
+    }
+
+    self->image_crc32           = crc32_update(self->image_crc32, payload, payload_size);
+    self->offset                += (uint32_t)(payload_size);
+    self->is_resume_requested   = false;
+
+    if (self->offset == self->header.image_size)
+    {
+        return firmware_update_finish(self, error);
+    }
+
+    return STD_SUCCESS;
+}
+
+int firmware_update_finish (firmware_update_t * const self, std_error_t * const error)
+{
+    if (self->image_crc32 != self->header.image_crc32)
+    {
+        LOG("Firmware update : image crc = %08lx, expected = %08lx\r\n",
+            (unsigned long)(self->image_crc32), (unsigned long)(self->header.image_crc32));
+
+        self->config.discard_callback();
+        self->state = WAITING_HEADER_STATE;
+
+        firmware_update_send_result(self, IMAGE_CRC_MISMATCH);
+
+        std_error_catch_custom(error, STD_FAILURE, CRC_ERROR_TEXT, __FILE__, __LINE__);
+
+        return STD_FAILURE;
+    }
+
+    if (self->config.commit_callback(&self->header, error) != STD_SUCCESS)
+    {
+        self->config.discard_callback();
+        self->state = WAITING_HEADER_STATE;
+
+        firmware_update_send_result(self, IMAGE_STORAGE_ERROR);
+
+        return STD_FAILURE;
+    }
+
+    LOG("Firmware update : image accepted\r\n");
+
+    self->state = COMPLETE_STATE;
+
+    firmware_update_send_result(self, IMAGE_ACCEPTED);
+
+    return STD_SUCCESS;
+}
+
+void firmware_update_drop_byte (firmware_update_t * const self)
+{
+    --self->frame_size;
+    memmove((void*)(&self->frame[0]), (const void*)(&self->frame[1]), self->frame_size);
+
+    return;
+}
+
+void firmware_update_request_resume (firmware_update_t * const self)
+{
+    const uint32_t offset   = (self->state == RECEIVING_STATE) ? self->offset : 0U;
+    const uint32_t time_ms  = self->config.time_callback();
+
+    // One request per offset, the chunks already in flight would trigger it again otherwise;
+    // the send buffer may have dropped it though, so it goes out again once it times out
+    if ((self->is_resume_requested == true) && (self->requested_offset == offset) &&
+        ((time_ms - self->resume_time_ms) < FIRMWARE_UPDATE_RESUME_TIMEOUT_MS))
+    {
+        return;
+    }
+
+    LOG("Firmware update : resume from %lu\r\n", (unsigned long)(offset));
+
+    self->requested_offset      = offset;
+    self->resume_time_ms        = time_ms;
+    self->is_resume_requested   = true;
+
+    uint8_t frame[FIRMWARE_UPDATE_FRAME_HEAD_SIZE + FIRMWARE_UPDATE_FRAME_CRC_SIZE];
+    const size_t frame_size = firmware_update_pack_frame(RESUME_FRAME, offset, NULL, 0U, frame);
+
+    self->config.send_callback(frame, frame_size);
+
+    return;
+}
+
+void firmware_update_send_result (firmware_update_t * const self, firmware_update_result_t result)
+{
+    const uint8_t status = (uint8_t)(result);
+
+    uint8_t frame[FIRMWARE_UPDATE_FRAME_HEAD_SIZE + sizeof(status) + FIRMWARE_UPDATE_FRAME_CRC_SIZE];
+    const size_t frame_size = firmware_update_pack_frame(RESULT_FRAME, self->offset, &status, sizeof(status), frame);
+
+    self->config.send_callback(frame, frame_size);
+
+    return;
+}
+
+
+void firmware_update_write_u16 (uint8_t * const data, uint16_t value)
+{
+    data[0] = (uint8_t)(value);
+    data[1] = (uint8_t)(value >> 8U);
+
+    return;
+}
+
+void firmware_update_write_u32 (uint8_t * const data, uint32_t value)
+{
+    data[0] = (uint8_t)(value);
+    data[1] = (uint8_t)(value >> 8U);
+    data[2] = (uint8_t)(value >> 16U);
+    data[3] = (uint8_t)(value >> 24U);
+
+    return;
+}
+
+uint16_t firmware_update_read_u16 (uint8_t const * const data)
+{
+    return (uint16_t)((uint16_t)(data[0]) | ((uint16_t)(data[1]) << 8U));
+}
+
+uint32_t firmware_update_read_u32 (uint8_t const * const data)
+{
+    return (uint32_t)(data[0]) | ((uint32_t)(data[1]) << 8U) | ((uint32_t)(data[2]) << 16U) | ((uint32_t)(data[3]) << 24U);
+}
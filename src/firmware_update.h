@@ -0,0 +1,138 @@
+/************************************************************
+ *   Author : German Mundinger
+ *   Date   : 2024
+ ************************************************************/
+
+#ifndef FIRMWARE_UPDATE_H
+#define FIRMWARE_UPDATE_H
+
+// Frame: magic (2) | type (1) | reserved (1) | offset (4) | payload size (2) | payload | crc32 (4), little endian
+#define FIRMWARE_UPDATE_MAGIC_0         0x46U   // 'F'
+#define FIRMWARE_UPDATE_MAGIC_1         0x57U   // 'W'
+#define FIRMWARE_UPDATE_FRAME_HEAD_SIZE 10U
+#define FIRMWARE_UPDATE_FRAME_CRC_SIZE  4U
+#define FIRMWARE_UPDATE_HEADER_SIZE     12U     // Image size (4) | image crc32 (4) | major (1) | minor (1) | patch (1) | image type (1)
+#define FIRMWARE_UPDATE_CHUNK_SIZE      256U    // Max payload of a chunk frame
+#define FIRMWARE_UPDATE_FRAME_MAX_SIZE  (FIRMWARE_UPDATE_FRAME_HEAD_SIZE + FIRMWARE_UPDATE_CHUNK_SIZE + FIRMWARE_UPDATE_FRAME_CRC_SIZE)
+
+#define FIRMWARE_UPDATE_RESUME_TIMEOUT_MS   (5U * 1000U)    // Before the same RESUME goes out again
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+typedef struct std_error std_error_t;
+
+typedef enum firmware_update_frame_type
+{
+    IMAGE_HEADER_FRAME = 1,     // Server -> node
+    IMAGE_CHUNK_FRAME,          // Server -> node, offset tagged
+    RESUME_FRAME,               // Node -> server, "send the header and the chunks from the offset"
+    RESULT_FRAME                // Node -> server, one status byte
+
+} firmware_update_frame_type_t;
+
+typedef enum firmware_update_result
+{
+    IMAGE_ACCEPTED = 0,
+    IMAGE_CRC_MISMATCH,
+    IMAGE_STORAGE_ERROR
+
+} firmware_update_result_t;
+
+typedef enum firmware_update_state
+{
+    WAITING_HEADER_STATE = 0,
+    RECEIVING_STATE,
+    COMPLETE_STATE
+
+} firmware_update_state_t;
+
+typedef enum firmware_update_image_type
+{
+    FULL_IMAGE_TYPE = 0,    // The application itself, maybe compressed
+    PATCH_IMAGE_TYPE        // A patch against the running application
+
+} firmware_update_image_type_t;
+
+typedef struct firmware_update_header
+{
+    uint32_t image_size;
+    uint32_t image_crc32;
+    uint8_t version_major;
+    uint8_t version_minor;
+    uint8_t version_patch;
+    firmware_update_image_type_t image_type;
+
+} firmware_update_header_t;
+
+typedef int (*firmware_update_start_callback_t) (firmware_update_header_t const * const header, std_error_t * const error);
+typedef int (*firmware_update_write_callback_t) (uint8_t const * const data, size_t size, std_error_t * const error);
+typedef int (*firmware_update_commit_callback_t) (firmware_update_header_t const * const header, std_error_t * const error);
+typedef void (*firmware_update_discard_callback_t) ();
+typedef void (*firmware_update_send_callback_t) (uint8_t const * const frame, size_t size);
+typedef uint32_t (*firmware_update_time_callback_t) ();
+
+typedef struct firmware_update_config
+{
+    firmware_update_start_callback_t start_callback;        // Drop any partial image and start a new one
+    firmware_update_write_callback_t write_callback;        // Append in order, offsets are already checked
+    firmware_update_commit_callback_t commit_callback;      // The whole image arrived and its crc32 matches
+    firmware_update_discard_callback_t discard_callback;    // The image is broken, drop it
+    firmware_update_send_callback_t send_callback;         // May lose the frame, a RESUME is sent again when it times out
+    firmware_update_time_callback_t time_callback;         // Milliseconds
+
+    uint32_t max_image_size;
+
+} firmware_update_config_t;
+
+typedef struct firmware_update firmware_update_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void firmware_update_init (firmware_update_t * const self, firmware_update_config_t const * const config);
+
+// Call after every (re)connect: asks the server to go on from the last accepted byte
+void firmware_update_resume (firmware_update_t * const self);
+
+// Call periodically, also when nothing arrives: sends a RESUME again once it times out
+void firmware_update_poll (firmware_update_t * const self);
+
+// Raw stream bytes, split at any point
+int firmware_update_process (firmware_update_t * const self, uint8_t const * const data, size_t size, std_error_t * const error);
+
+void firmware_update_get_state (firmware_update_t const * const self, firmware_update_state_t * const state);
+void firmware_update_get_offset (firmware_update_t const * const self, uint32_t * const offset);
+
+size_t firmware_update_pack_frame (firmware_update_frame_type_t type, uint32_t offset, uint8_t const * const payload, size_t payload_size,
+                                    uint8_t * const frame);  // Up to FIRMWARE_UPDATE_FRAME_MAX_SIZE bytes
+void firmware_update_pack_header (firmware_update_header_t const * const header, uint8_t payload[FIRMWARE_UPDATE_HEADER_SIZE]);
+
+#ifdef __cplusplus
+}
+#endif
+
+
+
+// Private
+typedef struct firmware_update
+{
+    firmware_update_config_t config;
+
+    firmware_update_state_t state;
+    firmware_update_header_t header;
+
+    uint32_t offset;
+    uint32_t image_crc32;
+    uint32_t requested_offset;
+    uint32_t resume_time_ms;
+    bool is_resume_requested;
+
+    uint8_t frame[FIRMWARE_UPDATE_FRAME_MAX_SIZE];
+    size_t frame_size;
+
+} firmware_update_t;
+
+#endif // FIRMWARE_UPDATE_H
@@ -0,0 +1,231 @@
+/************************************************************
+ *   Author : German Mundinger
+ *   Date   : 2024
+ ************************************************************/
+
+#include "format.h"
+
+#include <assert.h>
+#include <math.h>
+
+
+#define ARRAY_SIZE(array) (sizeof(array) / sizeof((array)[0]))
+
+#define FIXED_MAX_VALUE     2147483520.0F   // The largest float below INT32_MAX
+#define INTEGER_MAX_VALUE   4294967040.0F   // The largest float below UINT32_MAX
+
+
+static const uint32_t power_10_array[] = { 1U, 10U, 100U, 1000U, 10000U, 100000U, 1000000U, 10000000U, 100000000U, 1000000000U };
+
+static size_t format_digits (char *buffer, uint32_t value, size_t min_digits);
+
+
+size_t format_text (char *buffer, const char *text)
+{
+    assert(buffer   != NULL);
+    assert(text     != NULL);
+
+    size_t length = 0U;
+
+    while (text[length] != '\0')
+    {
+        buffer[length] = text[length];
+        ++length;
+    }
+    buffer[length] = '\0';
+
+    return length;
+}
+
+size_t format_int (char *buffer, int32_t value)
+{
+    return format_fixed(buffer, value, 0U, false);
+}
+
+size_t format_uint (char *buffer, uint32_t value)
+{
+    assert(buffer != NULL);
+
+    return format_digits(buffer, value, 1U);
+}
+
+size_t format_hex (char *buffer, uint32_t value, size_t min_digits, bool is_upper_case)
+{
+    assert(buffer       != NULL);
+    assert(min_digits   <= 8U);
+
+    const char *digits = (is_upper_case == true) ? "0123456789ABCDEF" : "0123456789abcdef";
+
+    char reversed[8];
+    size_t length = 0U;
+
+    do
+    {
+        reversed[length] = digits[value & 0xFU];
+        value >>= 4U;
+        ++length;
+    }
+    while (value != 0U);
+
+    for (; length < min_digits; ++length)
+    {
+        reversed[length] = '0';
+    }
+
+    for (size_t i = 0U; i < length; ++i)
+    {
+        buffer[i] = reversed[length - 1U - i];
+    }
+    buffer[length] = '\0';
+
+    return length;
+}
+
+size_t format_fixed (char *buffer, int32_t value, size_t fraction_digits, bool is_sign_forced)
+{
+    assert(buffer           != NULL);
+    assert(fraction_digits  < ARRAY_SIZE(power_10_array));
+
+    size_t length = 0U;
+
+    // Negate in unsigned arithmetic to cover INT32_MIN
+    uint32_t magnitude = (uint32_t)(value);
+
+    if (value < 0)
+    {
+        magnitude = 0U - magnitude;
+
+        buffer[length] = '-';
+        ++length;
+    }
+    else if (is_sign_forced == true)
+    {
+        buffer[length] = '+';
+        ++length;
+    }
+
+    const uint32_t divider = power_10_array[fraction_digits];
+
+    length += format_digits(buffer + length, magnitude / divider, 1U);
+
+    if (fraction_digits != 0U)
+    {
+        buffer[length] = '.';
+        ++length;
+
+        length += format_digits(buffer + length, magnitude % divider, fraction_digits);
+    }
+
+    return length;
+}
+
+int32_t format_float_to_fixed (float value, size_t fraction_digits)
+{
+    assert(fraction_digits < ARRAY_SIZE(power_10_array));
+
+    float scaled_value = value * (float)(power_10_array[fraction_digits]);
+
+    if (scaled_value != scaled_value)
+    {
+        // NaN
+        return 0;
+    }
+
+    scaled_value = (scaled_value < 0.0F) ? (scaled_value - 0.5F) : (scaled_value + 0.5F);
+
+    if (scaled_value > FIXED_MAX_VALUE)
+    {
+        return INT32_MAX;
+    }
+
+    if (scaled_value < (-FIXED_MAX_VALUE))
+    {
+        return (-INT32_MAX);
+    }
+
+    return (int32_t)(scaled_value);
+}
+
+size_t format_float (char *buffer, float value, size_t fraction_digits, bool is_sign_forced)
+{
+    assert(buffer           != NULL);
+    assert(fraction_digits  <= FORMAT_FRACTION_DIGITS_MAX);
+
+    size_t length = 0U;
+
+    if (value != value)
+    {
+        // NaN
+        value = 0.0F;
+    }
+
+    // Taken before rounding, so -0.001 is "-0.00" and not "0.00"
+    if (signbit(value) != 0)
+    {
+        value = -value;
+
+        buffer[length] = '-';
+        ++length;
+    }
+    else if (is_sign_forced == true)
+    {
+        buffer[length] = '+';
+        ++length;
+    }
+
+    if (value > INTEGER_MAX_VALUE)
+    {
+        value = INTEGER_MAX_VALUE;
+    }
+
+    // The integer and the fraction apart, so a long fraction does not overflow the fixed-point range
+    const uint32_t divider = power_10_array[fraction_digits];
+
+    uint32_t integer    = (uint32_t)(value);
+    uint32_t fraction   = (uint32_t)(((value - (float)(integer)) * (float)(divider)) + 0.5F);
+
+    if (fraction >= divider)
+    {
+        fraction -= divider;
+        ++integer;
+    }
+
+    length += format_digits(buffer + length, integer, 1U);
+
+    if (fraction_digits != 0U)
+    {
+        buffer[length] = '.';
+        ++length;
+
+        length += format_digits(buffer + length, fraction, fraction_digits);
+    }
+
+    return length;
+}
+
+size_t format_digits (char *buffer, uint32_t value, size_t min_digits)
+{
+    char reversed[10];
+    size_t length = 0U;
+
+    do
+    {
+        reversed[length] = (char)('0' + (value % 10U));
+        value /= 10U;
+        ++length;
+    }
+    while (value != 0U);
+
+    for (; length < min_digits; ++length)
+    {
+        reversed[length] = '0';
+    }
+
+    for (size_t i = 0U; i < length; ++i)
+    {
+        buffer[i] = reversed[length - 1U - i];
+    }
+    buffer[length] = '\0';
+
+    return length;
+}
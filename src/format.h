@@ -0,0 +1,42 @@
+/************************************************************
+ *   Author : German Mundinger
+ *   Date   : 2024
+ ************************************************************/
+
+#ifndef FORMAT_H
+#define FORMAT_H
+
+#define FORMAT_NUMBER_SIZE  24U // Enough for any 32-bit number with sign, point, the longest fraction and null
+
+#define FORMAT_DECI                 1U  // 0.1
+#define FORMAT_CENTI                2U  // 0.01
+#define FORMAT_FRACTION_DIGITS_MAX  9U
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// All the functions write a null-terminated string and return its length (without null)
+size_t format_text (char *buffer, const char *text);
+size_t format_int (char *buffer, int32_t value);
+size_t format_uint (char *buffer, uint32_t value);
+size_t format_hex (char *buffer, uint32_t value, size_t min_digits, bool is_upper_case);
+
+// The value is already scaled: 'value = 235, fraction_digits = 1' -> "23.5"
+size_t format_fixed (char *buffer, int32_t value, size_t fraction_digits, bool is_sign_forced);
+
+// Round half away from zero and saturate to the int32_t range
+int32_t format_float_to_fixed (float value, size_t fraction_digits);
+
+// Round half away from zero and saturate to the uint32_t range; a negative value rounded to zero keeps its sign, as with printf()
+size_t format_float (char *buffer, float value, size_t fraction_digits, bool is_sign_forced);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FORMAT_H
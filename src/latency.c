@@ -0,0 +1,146 @@
+/************************************************************
+ *   Author : German Mundinger
+ *   Date   : 2024
+ ************************************************************/
+
+#include "latency.h"
+
+#include <stdbool.h>
+#include <string.h>
+#include <assert.h>
+
+
+static latency_config_t config;
+static uint16_t histogram_array[LATENCY_HOP_SIZE][LATENCY_BUCKET_COUNT];
+
+static size_t latency_get_bucket (uint32_t cycles);
+
+
+void latency_init (latency_config_t const * const init_config)
+{
+    assert(init_config                      != NULL);
+    assert(init_config->get_cycles_callback != NULL);
+    assert(init_config->lock_callback       != NULL);
+    assert(init_config->unlock_callback     != NULL);
+    assert(init_config->cycles_per_us       != 0U);
+
+    config = *init_config;
+
+    latency_reset();
+
+    return;
+}
+
+void latency_reset ()
+{
+    config.lock_callback();
+    memset((void*)(histogram_array), 0, sizeof(histogram_array));
+    config.unlock_callback();
+
+    return;
+}
+
+uint32_t latency_get_cycles ()
+{
+    return config.get_cycles_callback();
+}
+
+void latency_clear_trace (latency_trace_t * const trace)
+{
+    assert(trace != NULL);
+
+    trace->size = 0U;
+
+    return;
+}
+
+void latency_stamp (latency_trace_t * const trace, latency_hop_t hop)
+{
+    latency_stamp_cycles(trace, hop, config.get_cycles_callback());
+
+    return;
+}
+
+void latency_stamp_cycles (latency_trace_t * const trace, latency_hop_t hop, uint32_t cycles)
+{
+    assert(trace    != NULL);
+    assert(hop      < LATENCY_HOP_SIZE);
+
+    if (trace->size < LATENCY_HOP_SIZE)
+    {
+        trace->cycles_array[trace->size]    = cycles;
+        trace->hop_array[trace->size]       = hop;
+        ++trace->size;
+    }
+
+    return;
+}
+
+void latency_record (latency_trace_t const * const trace)
+{
+    assert(trace != NULL);
+
+    if (trace->size > LATENCY_HOP_SIZE)
+    {
+        return;
+    }
+
+    config.lock_callback();
+
+    for (size_t i = 1U; i < trace->size; ++i)
+    {
+        // Unsigned subtraction survives the counter wrap
+        const uint32_t cycles = trace->cycles_array[i] - trace->cycles_array[i - 1U];
+        const latency_hop_t hop = trace->hop_array[i];
+
+        if (hop >= LATENCY_HOP_SIZE)
+        {
+            continue;
+        }
+
+        uint16_t *histogram = histogram_array[hop];
+        const size_t bucket = latency_get_bucket(cycles);
+
+        ++histogram[bucket];
+
+        // Keep the shape, forget the old samples
+        if (histogram[bucket] >= LATENCY_COUNT_MAX)
+        {
+            for (size_t j = 0U; j < LATENCY_BUCKET_COUNT; ++j)
+            {
+                histogram[j] /= 2U;
+            }
+        }
+    }
+
+    config.unlock_callback();
+
+    return;
+}
+
+void latency_get_histogram (latency_hop_t hop, uint16_t histogram[LATENCY_BUCKET_COUNT])
+{
+    assert(hop          < LATENCY_HOP_SIZE);
+    assert(histogram    != NULL);
+
+    config.lock_callback();
+    memcpy((void*)(histogram), (const void*)(histogram_array[hop]), sizeof(histogram_array[hop]));
+    config.unlock_callback();
+
+    return;
+}
+
+size_t latency_get_bucket (uint32_t cycles)
+{
+    uint32_t time_us = cycles / config.cycles_per_us;
+
+    size_t bucket = 0U;
+
+    while ((time_us > 1U) && (bucket < (LATENCY_BUCKET_COUNT - 1U)))
+    {
+        time_us >>= 1U;
+        ++bucket;
+    }
+
+    return bucket;
+}
@@ -0,0 +1,82 @@
+/************************************************************
+ *   Author : German Mundinger
+ *   Date   : 2024
+ ************************************************************/
+
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#define LATENCY_BUCKET_COUNT    14U     // log2 buckets: [0, 2) us, [2, 4) us, ... [8192, inf) us
+#define LATENCY_COUNT_MAX       999U    // All the buckets of a hop are halved when one reaches it
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef enum latency_hop
+{
+    ISR_HOP = 0,
+    BOARD_TASK_HOP,
+    NODE_SEND_HOP,
+    NODE_TASK_HOP,
+    TCP_SEND_HOP,
+    TCP_RECV_HOP,
+    NODE_RECV_HOP,
+    BOARD_PROCESS_HOP,
+    LATENCY_HOP_SIZE
+
+} latency_hop_t;
+
+typedef struct latency_trace
+{
+    uint32_t cycles_array[LATENCY_HOP_SIZE];
+    latency_hop_t hop_array[LATENCY_HOP_SIZE];
+    size_t size;
+
+} latency_trace_t;
+
+typedef uint32_t (*latency_get_cycles_callback_t) ();
+typedef void (*latency_lock_callback_t) ();
+typedef void (*latency_unlock_callback_t) ();
+
+typedef struct latency_config
+{
+    latency_get_cycles_callback_t get_cycles_callback;
+    latency_lock_callback_t lock_callback;
+    latency_unlock_callback_t unlock_callback;
+    uint32_t cycles_per_us;
+
+} latency_config_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void latency_init (latency_config_t const * const init_config);
+void latency_reset ();
+
+uint32_t latency_get_cycles ();
+
+void latency_clear_trace (latency_trace_t * const trace);
+void latency_stamp (latency_trace_t * const trace, latency_hop_t hop);
+void latency_stamp_cycles (latency_trace_t * const trace, latency_hop_t hop, uint32_t cycles);
+
+// Every stamp adds the time passed since the previous stamp to the histogram of its hop
+void latency_record (latency_trace_t const * const trace);
+
+void latency_get_histogram (latency_hop_t hop, uint16_t histogram[LATENCY_BUCKET_COUNT]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#ifdef LATENCY_TRACE
+#define LATENCY_CLEAR(trace)        latency_clear_trace(trace)
+#define LATENCY_STAMP(trace, hop)   latency_stamp((trace), (hop))
+#define LATENCY_RECORD(trace)       latency_record(trace)
+#else
+#define LATENCY_CLEAR(trace)        ((void)0U)
+#define LATENCY_STAMP(trace, hop)   ((void)0U)
+#define LATENCY_RECORD(trace)       ((void)0U)
+#endif // LATENCY_TRACE
+
+#endif // LATENCY_H
@@ -5,12 +5,31 @@
 
 #include "logger.h"
 
+#include <stdbool.h>
+#include <stdarg.h>
+#include <string.h>
+
+#include "format.h"
+
 
 #define UNUSED(x) (void)(x)
 
+#define LOGGER_BUFFER_SIZE  64U
+
+
+typedef struct logger_buffer
+{
+    char data[LOGGER_BUFFER_SIZE];
+    size_t size;
+
+} logger_buffer_t;
 
 static logger_config_t config;
 
+static void logger_put_text (logger_buffer_t * const buffer, const char *text, size_t length);
+static void logger_put_padding (logger_buffer_t * const buffer, char symbol, size_t length);
+static void logger_flush (logger_buffer_t * const buffer);
+
 
 void logger_init (logger_config_t const * const init_config)
 {
@@ -19,6 +38,230 @@ void logger_init (logger_config_t const * const init_config)
     return;
 }
 
+void logger_print (const char *format, ...)
+{
+    logger_buffer_t buffer;
+    buffer.size = 0U;
+
+    va_list args;
+    va_start(args, format);
+
+    while (*format != '\0')
+    {
+        if (*format != '%')
+        {
+            logger_put_text(&buffer, format, 1U);
+            ++format;
+
+            continue;
+        }
+        const char *specification = format;
+        ++format;
+
+        bool is_sign_forced = false;
+        bool is_zero_padded = false;
+
+        while ((*format == '+') || (*format == '0'))
+        {
+            if (*format == '+')
+            {
+                is_sign_forced = true;
+            }
+            else
+            {
+                is_zero_padded = true;
+            }
+            ++format;
+        }
+
+        size_t width = 0U;
+
+        while ((*format >= '0') && (*format <= '9'))
+        {
+            width = (width * 10U) + (size_t)(*format - '0');
+            ++format;
+        }
+
+        size_t precision = 6U;
+
+        if (*format == '.')
+        {
+            ++format;
+
+            precision = 0U;
+
+            while ((*format >= '0') && (*format <= '9'))
+            {
+                precision = (precision * 10U) + (size_t)(*format - '0');
+                ++format;
+            }
+        }
+
+        bool is_long = false;
+
+        if (*format == 'l')
+        {
+            is_long = true;
+            ++format;
+        }
+
+        char number[FORMAT_NUMBER_SIZE];
+        const char *text = number;
+        size_t length = 0U;
+
+        switch (*format)
+        {
+            case 'd':
+            case 'i':
+            {
+                const int32_t value = (is_long == true) ? (int32_t)(va_arg(args, long)) : (int32_t)(va_arg(args, int));
+                length = format_fixed(number, value, 0U, is_sign_forced);
+                break;
+            }
+
+            case 'u':
+            {
+                const uint32_t value = (is_long == true) ? (uint32_t)(va_arg(args, unsigned long)) : (uint32_t)(va_arg(args, unsigned int));
+                length = format_uint(number, value);
+                break;
+            }
+
+            case 'x':
+            case 'X':
+            {
+                const uint32_t value = (is_long == true) ? (uint32_t)(va_arg(args, unsigned long)) : (uint32_t)(va_arg(args, unsigned int));
+                length = format_hex(number, value, 1U, (*format == 'X'));
+                break;
+            }
+
+            case 'f':
+            {
+                const float value = (float)(va_arg(args, double));
+
+                // Printed as is rather than as a shorter number than asked for
+                if (precision > FORMAT_FRACTION_DIGITS_MAX)
+                {
+                    text    = specification;
+                    length  = (size_t)(format - specification) + 1U;
+                }
+                else
+                {
+                    length = format_float(number, value, precision, is_sign_forced);
+                }
+                break;
+            }
+
+            case 's':
+            {
+                text = va_arg(args, const char*);
+
+                if (text == NULL)
+                {
+                    text = "(null)";
+                }
+                length = strlen(text);
+                break;
+            }
+
+            case 'c':
+            {
+                number[0] = (char)(va_arg(args, int));
+                length = 1U;
+                break;
+            }
+
+            case '\0':
+            {
+                // Broken format tail
+                --format;
+                break;
+            }
+
+            default:
+            {
+                number[0] = *format;
+                length = 1U;
+                break;
+            }
+        }
+        ++format;
+
+        if (width > length)
+        {
+            if ((is_zero_padded == true) && (text == number))
+            {
+                // Zeros go between the sign and the digits
+                const bool is_signed = (number[0] == '-') || (number[0] == '+');
+
+                if (is_signed == true)
+                {
+                    logger_put_text(&buffer, text, 1U);
+                    ++text;
+                    --length;
+                    --width;
+                }
+                logger_put_padding(&buffer, '0', width - length);
+            }
+            else
+            {
+                logger_put_padding(&buffer, ' ', width - length);
+            }
+        }
+        logger_put_text(&buffer, text, length);
+    }
+    va_end(args);
+
+    logger_flush(&buffer);
+
+    return;
+}
+
+void logger_put_text (logger_buffer_t * const buffer, const char *text, size_t length)
+{
+    while (length != 0U)
+    {
+        if (buffer->size == LOGGER_BUFFER_SIZE)
+        {
+            logger_flush(buffer);
+        }
+
+        size_t chunk_size = LOGGER_BUFFER_SIZE - buffer->size;
+
+        if (chunk_size > length)
+        {
+            chunk_size = length;
+        }
+        memcpy((void*)(buffer->data + buffer->size), (const void*)(text), chunk_size);
+
+        buffer->size    += chunk_size;
+        text            += chunk_size;
+        length          -= chunk_size;
+    }
+
+    return;
+}
+
+void logger_put_padding (logger_buffer_t * const buffer, char symbol, size_t length)
+{
+    for (size_t i = 0U; i < length; ++i)
+    {
+        logger_put_text(buffer, &symbol, 1U);
+    }
+
+    return;
+}
+
+void logger_flush (logger_buffer_t * const buffer)
+{
+    if ((buffer->size != 0U) && (config.write_array_callback != NULL))
+    {
+        config.write_array_callback((const uint8_t*)(buffer->data), (uint16_t)(buffer->size));
+    }
+    buffer->size = 0U;
+
+    return;
+}
+
 // Redefine
 //#ifndef NDEBUG
 
@@ -33,4 +276,4 @@ int _write(int fd, char *ptr, int len)
     return len;
 }
 
-//#endif // NDEBUG
\ No newline at end of file
+//#endif // NDEBUG
@@ -6,7 +6,6 @@
 #ifndef LOGGER_H
 #define LOGGER_H
 
-#include <stdio.h>
 #include <stdint.h>
 
 typedef void (*write_array_callback_t) (const uint8_t *data, uint16_t data_size);
@@ -17,12 +16,23 @@ typedef struct logger_config
 
 } logger_config_t;
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 void logger_init (logger_config_t const * const init_config);
 
+// Supports %d %i %u %x %X %s %c %f with '+', '0', width, precision and 'l' modifiers
+void logger_print (const char *format, ...) __attribute__((format(printf, 1, 2)));
+
+#ifdef __cplusplus
+}
+#endif
+
 //#ifdef NDEBUG
 //#define LOG(...) ((void)0U)
 //#else
-#define LOG(...) printf(__VA_ARGS__)
+#define LOG(...) logger_print(__VA_ARGS__)
 //#endif // NDEBUG
 
 #endif // LOGGER_H
@@ -1,19 +0,0 @@
-/************************************************************
- *   Author : German Mundinger
- *   Date   : 2023
- ************************************************************/
-
-#ifndef LWJSON_HDR_OPTS_H
-#define LWJSON_HDR_OPTS_H
-
-#include <stdint.h>
-
-#define LWJSON_CFG_REAL_TYPE                float
-#define LWJSON_CFG_INT_TYPE                 int32_t
-#define LWJSON_CFG_COMMENTS                 0
-#define LWJSON_CFG_STREAM_KEY_MAX_LEN       8
-#define LWJSON_CFG_STREAM_STACK_SIZE        4
-#define LWJSON_CFG_STREAM_STRING_MAX_LEN    2
-#define LWJSON_CFG_STREAM_PRIMITIVE_MAX_LEN 6
-
-#endif // LWJSON_HDR_OPTS_H
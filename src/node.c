@@ -16,6 +16,7 @@
 #include "queue.h"
 
 #include "tcp_client.type.h"
+#include "latency.h"
 
 #include "logger.h"
 #include "std_error/std_error.h"
@@ -55,6 +56,10 @@ static tcp_msg_t *tcp_msg_buffer;
 static int node_malloc (std_error_t * const error);
 static void node_task (void *parameters);
 
+#ifdef LATENCY_TRACE
+static void node_send_latency (node_msg_t const * const request_msg);
+#endif // LATENCY_TRACE
+
 int node_init (node_config_t const * const init_config, std_error_t * const error)
 {
     assert(init_config                          != NULL);
@@ -79,6 +84,8 @@ int node_send_msg (node_msg_t const * const send_msg, std_error_t * const error)
 
     memcpy((void*)(free_msg), (const void*)(send_msg), sizeof(node_msg_t));
 
+    LATENCY_STAMP(&free_msg->trace, NODE_SEND_HOP);
+
     xQueueSend(work_msg_queue, (const void*)&free_msg, RTOS_QUEUE_TICKS_TO_WAIT);
 
     return STD_SUCCESS;
@@ -142,8 +149,13 @@ void node_task (void *parameters)
 
                 node_msg_t node_msg;
 
-                if (node_mapper_deserialize_message(work_tcp_msg->data, &node_msg, &error) == STD_SUCCESS)
+                if (node_mapper_deserialize_message(work_tcp_msg->data, work_tcp_msg->size, &node_msg, &error) == STD_SUCCESS)
                 {
+#ifdef LATENCY_TRACE
+                    node_msg.trace = work_tcp_msg->trace;
+                    latency_stamp(&node_msg.trace, NODE_RECV_HOP);
+#endif // LATENCY_TRACE
+
                     node_msg_t *free_msg;
 
                     if (xQueueReceive(free_msg_queue, (void*)&free_msg, RTOS_QUEUE_TICKS_TO_WAIT) == pdPASS)
@@ -174,6 +186,11 @@ void node_task (void *parameters)
 
                     node_mapper_serialize_message(work_msg, send_tcp_msg.data, &send_tcp_msg.size);
 
+#ifdef LATENCY_TRACE
+                    send_tcp_msg.trace = work_msg->trace;
+                    latency_stamp(&send_tcp_msg.trace, NODE_TASK_HOP);
+#endif // LATENCY_TRACE
+
                     LOG("Node [tcp] : output msg = %s\r\n", send_tcp_msg.data);
 
                     config.send_tcp_msg_callback(&send_tcp_msg);
@@ -197,11 +214,19 @@ void node_task (void *parameters)
 
                         node_mapper_serialize_message(&out_msg, send_tcp_msg.data, &send_tcp_msg.size);
 
+                        LATENCY_CLEAR(&send_tcp_msg.trace);
+
                         LOG("Node [tcp] : output msg = %s\r\n", send_tcp_msg.data);
 
                         config.send_tcp_msg_callback(&send_tcp_msg);
                     }
-                    else if (work_msg->cmd_id == UPDATE_FIRMWARE)
+#ifdef LATENCY_TRACE
+                    else if (work_msg->cmd_id == REQUEST_LATENCY)
+                    {
+                        node_send_latency(work_msg);
+                    }
+#endif // LATENCY_TRACE
+                    else if ((work_msg->cmd_id == UPDATE_FIRMWARE) || (work_msg->cmd_id == REQUEST_FIRMWARE_CHECK) || (work_msg->cmd_id == REQUEST_HISTORY))
                     {
                         for (size_t i = 0U; i < work_msg->header.dest_array_size; ++i)
                         {
@@ -227,6 +252,61 @@ void node_task (void *parameters)
     return;
 }
 
+#ifdef LATENCY_TRACE
+void node_send_latency (node_msg_t const * const request_msg)
+{
+    const bool is_hop_valid = (request_msg->value_0 >= 0) && (request_msg->value_0 < (int32_t)(LATENCY_HOP_SIZE));
+
+    if (is_hop_valid != true)
+    {
+        LOG("Node [latency] : unknown hop = %ld\r\n", request_msg->value_0);
+
+        return;
+    }
+
+    bool is_addressed = false;
+
+    for (size_t i = 0U; i < request_msg->header.dest_array_size; ++i)
+    {
+        if (request_msg->header.dest_array[i] == config.id)
+        {
+            is_addressed = true;
+
+            break;
+        }
+    }
+
+    if (is_addressed != true)
+    {
+        return;
+    }
+
+    uint16_t histogram[LATENCY_BUCKET_COUNT];
+    latency_get_histogram((latency_hop_t)(request_msg->value_0), histogram);
+
+    node_msg_t out_msg;
+
+    out_msg.header.source           = config.id;
+    out_msg.header.dest_array[0]    = request_msg->header.source;
+    out_msg.header.dest_array_size  = 1U;
+
+    out_msg.cmd_id  = RESPONSE_LATENCY;
+    out_msg.value_0 = request_msg->value_0;
+
+    tcp_msg_t send_tcp_msg;
+
+    node_mapper_serialize_latency(&out_msg, histogram, ARRAY_SIZE(histogram), send_tcp_msg.data, &send_tcp_msg.size);
+
+    latency_clear_trace(&send_tcp_msg.trace);
+
+    LOG("Node [tcp] : output msg = %s\r\n", send_tcp_msg.data);
+
+    config.send_tcp_msg_callback(&send_tcp_msg);
+
+    return;
+}
+#endif // LATENCY_TRACE
+
 
 int node_malloc (std_error_t * const error)
 {
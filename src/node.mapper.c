@@ -7,17 +7,46 @@
 #include "node.type.h"
 
 #include <stdbool.h>
-#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
 #include <assert.h>
 
-#include "lwjson/lwjson.h"
-
+#include "format.h"
 #include "version.h"
 
 #include "std_error/std_error.h"
 
 
+#define ARRAY_SIZE(array) (sizeof(array) / sizeof((array)[0]))
+
 #define DEFAULT_ERROR_TEXT  "Mapper error"
+#define DEST_ERROR_TEXT     "Mapper destination error"
+
+#define PARSER_MAX_DEPTH    8U
+#define PARSER_KEY_SIZE     16U
+
+
+typedef struct node_mapper_parser
+{
+    const char *data;
+    size_t size;
+    size_t position;
+    bool is_dest_overflow;
+
+} node_mapper_parser_t;
+
+static size_t node_mapper_serialize_header (node_msg_header_t const * const header, char *raw_data);
+
+static bool node_mapper_parse_message (node_mapper_parser_t * const parser, node_msg_t * const msg);
+static bool node_mapper_parse_dest_array (node_mapper_parser_t * const parser, node_msg_header_t * const header);
+static bool node_mapper_parse_data (node_mapper_parser_t * const parser, node_msg_t * const msg);
+static bool node_mapper_parse_key (node_mapper_parser_t * const parser, char * const key);
+static bool node_mapper_parse_string (node_mapper_parser_t * const parser, char * const string, size_t string_size);
+static bool node_mapper_parse_number (node_mapper_parser_t * const parser, int32_t * const value, bool * const is_integer);
+static bool node_mapper_skip_value (node_mapper_parser_t * const parser, size_t depth);
+static bool node_mapper_skip_literal (node_mapper_parser_t * const parser, const char *literal);
+static void node_mapper_skip_spaces (node_mapper_parser_t * const parser);
+static char node_mapper_peek (node_mapper_parser_t const * const parser);
 
 
 void node_mapper_serialize_message (node_msg_t const * const msg, char *raw_data, size_t * const raw_data_size)
@@ -27,129 +56,734 @@ void node_mapper_serialize_message (node_msg_t const * const msg, char *raw_data
     assert(raw_data_size    != NULL);
     assert(msg->header.dest_array_size != 0U);
 
-    char dest_array[16] = { '\0' };
-
-    sprintf(dest_array, "%d", msg->header.dest_array[0]);
+    char *data = raw_data;
 
-    for (size_t i = 1U; i < msg->header.dest_array_size; ++i)
-    {
-        sprintf(dest_array + strlen(dest_array), ",%d", msg->header.dest_array[i]);
-    }
-
-    int data_size = (-1);
+    data += node_mapper_serialize_header(&msg->header, data);
 
     if (msg->cmd_id == RESPONSE_VERSION)
     {
-        data_size = sprintf(raw_data, "{\"src_id\":%d,\"dst_id\":[%s],\"cmd_id\":%d,\"data\":{\"major\":%s,\"minor\":%s,\"patch\":%s}}\n", msg->header.source, dest_array, msg->cmd_id, VERSION_MAJOR, VERSION_MINOR, VERSION_PATCH);
+        data += format_int(data, (int32_t)(msg->cmd_id));
+        data += format_text(data, ",\"data\":{\"major\":" VERSION_MAJOR ",\"minor\":" VERSION_MINOR ",\"patch\":" VERSION_PATCH "}");
     }
     else if ((msg->cmd_id == SET_LIGHT) || (msg->cmd_id == SET_INTRUSION))
     {
-        data_size = sprintf(raw_data, "{\"src_id\":%d,\"dst_id\":[%s],\"cmd_id\":%d,\"data\":{\"value_id\":%ld}}\n", msg->header.source, dest_array, msg->cmd_id, msg->value_0);
+        data += format_int(data, (int32_t)(msg->cmd_id));
+        data += format_text(data, ",\"data\":{\"value_id\":");
+        data += format_int(data, msg->value_0);
+        data += format_text(data, "}");
     }
     else if (msg->cmd_id == UPDATE_HUMIDITY)
     {
-        data_size = sprintf(raw_data, "{\"src_id\":%d,\"dst_id\":[%s],\"cmd_id\":%d,\"data\":{\"pres_hpa\":%ld,\"hum_pct\":%ld,\"temp_c\":%.1f}}\n", msg->header.source, dest_array, msg->cmd_id, msg->value_0, msg->value_1, msg->value_2);
+        data += format_int(data, (int32_t)(msg->cmd_id));
+        data += format_text(data, ",\"data\":{\"pres_hpa\":");
+        data += format_int(data, msg->value_0);
+        data += format_text(data, ",\"hum_pct\":");
+        data += format_int(data, msg->value_1);
+        data += format_text(data, ",\"temp_c\":");
+        data += format_float(data, msg->value_2, FORMAT_DECI, false);
+        data += format_text(data, "}");
     }
     else if (msg->cmd_id == UPDATE_TEMPERATURE)
     {
-        data_size = sprintf(raw_data, "{\"src_id\":%d,\"dst_id\":[%s],\"cmd_id\":%d,\"data\":{\"pres_hpa\":%ld,\"temp_c\":%.1f}}\n", msg->header.source, dest_array, msg->cmd_id, msg->value_0, msg->value_2);
+        data += format_int(data, (int32_t)(msg->cmd_id));
+        data += format_text(data, ",\"data\":{\"pres_hpa\":");
+        data += format_int(data, msg->value_0);
+        data += format_text(data, ",\"temp_c\":");
+        data += format_float(data, msg->value_2, FORMAT_DECI, false);
+        data += format_text(data, "}");
     }
     else if (msg->cmd_id == UPDATE_DOOR_STATE)
     {
-        data_size = sprintf(raw_data, "{\"src_id\":%d,\"dst_id\":[%s],\"cmd_id\":%d,\"data\":{\"door_state\":%ld}}\n", msg->header.source, dest_array, msg->cmd_id, msg->value_0);
+        data += format_int(data, (int32_t)(msg->cmd_id));
+        data += format_text(data, ",\"data\":{\"door_state\":");
+        data += format_int(data, msg->value_0);
+        data += format_text(data, "}");
+    }
+    else if (msg->cmd_id == RESPONSE_STATE)
+    {
+        const uint32_t state = (uint32_t)(msg->value_0);
+
+        data += format_int(data, (int32_t)(msg->cmd_id));
+        data += format_text(data, ",\"data\":{\"mode\":");
+        data += format_uint(data, state & NODE_STATE_MODE_MASK);
+        data += format_text(data, ",\"flags\":");
+        data += format_uint(data, state & NODE_STATE_FLAGS_MASK);
+        data += format_text(data, ",\"pres_hpa\":");
+        data += format_int(data, msg->value_1);
+        data += format_text(data, ",\"hum_pct\":");
+        data += format_uint(data, (state >> NODE_STATE_HUMIDITY_SHIFT) & NODE_STATE_HUMIDITY_MASK);
+        data += format_text(data, ",\"temp_c\":");
+        data += format_float(data, msg->value_2, FORMAT_DECI, false);
+        data += format_text(data, "}");
+    }
+    else if (msg->cmd_id == RESPONSE_FIRMWARE_CHECK)
+    {
+        data += format_int(data, (int32_t)(msg->cmd_id));
+        data += format_text(data, ",\"data\":{\"valid\":");
+        data += format_int(data, msg->value_0);
+        data += format_text(data, ",\"size\":");
+        data += format_int(data, msg->value_1);
+        data += format_text(data, "}");
+    }
+    else if (msg->cmd_id == RESPONSE_HISTORY)
+    {
+        data += format_int(data, (int32_t)(msg->cmd_id));
+        data += format_text(data, ",\"data\":{\"time_s\":");
+        data += format_int(data, msg->value_0);
+        data += format_text(data, ",\"sensor\":");
+        data += format_int(data, msg->value_1);
+        data += format_text(data, ",\"value\":");
+        data += format_float(data, msg->value_2, FORMAT_DECI, false);
+        data += format_text(data, "}");
+    }
+    else if (msg->cmd_id == RESPONSE_HISTORY_END)
+    {
+        data += format_int(data, (int32_t)(msg->cmd_id));
+        data += format_text(data, ",\"data\":{\"time_s\":");
+        data += format_int(data, msg->value_0);
+        data += format_text(data, ",\"count\":");
+        data += format_int(data, msg->value_1);
+        data += format_text(data, "}");
     }
     else
     {
-        data_size = sprintf(raw_data, "{\"src_id\":%d,\"dst_id\":[%s],\"cmd_id\":%d}\n", msg->header.source, dest_array, DO_NOTHING);
+        data += format_int(data, (int32_t)(DO_NOTHING));
     }
 
-    *raw_data_size = 0U;
+    data += format_text(data, "}\n");
+
+    *raw_data_size = (size_t)(data - raw_data);
+
+    return;
+}
 
-    if (data_size > 0)
+void node_mapper_serialize_latency (node_msg_t const * const msg,
+                                    uint16_t const * const histogram,
+                                    size_t histogram_size,
+                                    char *raw_data,
+                                    size_t * const raw_data_size)
+{
+    assert(raw_data         != NULL);
+    assert(msg              != NULL);
+    assert(histogram        != NULL);
+    assert(raw_data_size    != NULL);
+    assert(msg->header.dest_array_size != 0U);
+
+    char *data = raw_data;
+
+    data += node_mapper_serialize_header(&msg->header, data);
+    data += format_int(data, (int32_t)(RESPONSE_LATENCY));
+    data += format_text(data, ",\"data\":{\"hop\":");
+    data += format_int(data, msg->value_0);
+    data += format_text(data, ",\"hist\":[");
+
+    for (size_t i = 0U; i < histogram_size; ++i)
     {
-        *raw_data_size = (size_t)(data_size);
+        if (i != 0U)
+        {
+            data += format_text(data, ",");
+        }
+        data += format_uint(data, (uint32_t)(histogram[i]));
     }
 
+    data += format_text(data, "]}}\n");
+
+    *raw_data_size = (size_t)(data - raw_data);
+
     return;
 }
 
-int node_mapper_deserialize_message (const char *raw_data, node_msg_t * const msg, std_error_t * const error)
+int node_mapper_deserialize_message (const char *raw_data, size_t raw_data_size, node_msg_t * const msg, std_error_t * const error)
 {
     assert(raw_data != NULL);
     assert(msg      != NULL);
 
+    msg->header.source          = NODE_BROADCAST;
     msg->header.dest_array_size = 0U;
+    msg->cmd_id                 = DO_NOTHING;
+    msg->value_0                = 0;
+    msg->value_1                = 0;
+    msg->value_2                = 0.0F;
+
+    // All the parser state lives on the caller stack, so the decoder is reentrant
+    node_mapper_parser_t parser;
+    parser.data             = raw_data;
+    parser.size             = raw_data_size;
+    parser.position         = 0U;
+    parser.is_dest_overflow = false;
+
+    if (node_mapper_parse_message(&parser, msg) != true)
+    {
+        if (parser.is_dest_overflow == true)
+        {
+            std_error_catch_custom(error, STD_FAILURE, DEST_ERROR_TEXT, __FILE__, __LINE__);
+        }
+        else
+        {
+            // The offset is a diagnostic, not a code: a failure at the very first byte must still be a failure
+            char text[sizeof(DEFAULT_ERROR_TEXT " at ") + FORMAT_NUMBER_SIZE];
+
+            char *data = text;
+            data += format_text(data, DEFAULT_ERROR_TEXT " at ");
+            data += format_uint(data, (uint32_t)(parser.position));
+
+            std_error_catch_custom(error, STD_FAILURE, text, __FILE__, __LINE__);
+        }
+        msg->header.dest_array_size = 0U;
+
+        return STD_FAILURE;
+    }
+
+    return STD_SUCCESS;
+}
+
+size_t node_mapper_serialize_header (node_msg_header_t const * const header, char *raw_data)
+{
+    char *data = raw_data;
+
+    data += format_text(data, "{\"src_id\":");
+    data += format_int(data, (int32_t)(header->source));
+    data += format_text(data, ",\"dst_id\":[");
+    data += format_int(data, (int32_t)(header->dest_array[0]));
+
+    for (size_t i = 1U; i < header->dest_array_size; ++i)
+    {
+        data += format_text(data, ",");
+        data += format_int(data, (int32_t)(header->dest_array[i]));
+    }
+
+    data += format_text(data, "],\"cmd_id\":");
+
+    return (size_t)(data - raw_data);
+}
 
-    int exit_code = STD_SUCCESS;
+bool node_mapper_parse_message (node_mapper_parser_t * const parser, node_msg_t * const msg)
+{
+    node_mapper_skip_spaces(parser);
 
-    static lwjson_t lwjson;
-    static lwjson_token_t tokens[8];
+    if (node_mapper_peek(parser) != '{')
+    {
+        return false;
+    }
+    ++parser->position;
 
-    lwjson_init(&lwjson, tokens, LWJSON_ARRAYSIZE(tokens));
+    node_mapper_skip_spaces(parser);
 
-    lwjsonr_t parser_code = lwjson_parse(&lwjson, raw_data);
+    bool is_object_end = (node_mapper_peek(parser) == '}');
 
-    if (parser_code == lwjsonOK)
+    while (is_object_end == false)
     {
-        const lwjson_token_t *token;
+        char key[PARSER_KEY_SIZE];
+
+        if (node_mapper_parse_key(parser, key) != true)
+        {
+            return false;
+        }
+
+        bool is_value_parsed = false;
+
+        if (strcmp(key, "src_id") == 0)
+        {
+            int32_t value;
+            bool is_integer;
+
+            is_value_parsed = node_mapper_parse_number(parser, &value, &is_integer);
+
+            if ((is_value_parsed == true) && (is_integer == true))
+            {
+                msg->header.source = (node_id_t)value;
+            }
+        }
+        else if ((strcmp(key, "dst_id") == 0) && (node_mapper_peek(parser) == '['))
+        {
+            is_value_parsed = node_mapper_parse_dest_array(parser, &msg->header);
+        }
+        else if (strcmp(key, "cmd_id") == 0)
+        {
+            int32_t value;
+            bool is_integer;
+
+            is_value_parsed = node_mapper_parse_number(parser, &value, &is_integer);
+
+            if ((is_value_parsed == true) && (is_integer == true))
+            {
+                msg->cmd_id = (node_command_id_t)value;
+            }
+        }
+        else if ((strcmp(key, "data") == 0) && (node_mapper_peek(parser) == '{'))
+        {
+            is_value_parsed = node_mapper_parse_data(parser, msg);
+        }
+        else
+        {
+            is_value_parsed = node_mapper_skip_value(parser, 1U);
+        }
+
+        if (is_value_parsed != true)
+        {
+            return false;
+        }
+        node_mapper_skip_spaces(parser);
 
-        bool is_token_parsed = ((token = lwjson_find(&lwjson, "src_id")) != NULL) && (token->type == LWJSON_TYPE_NUM_INT);
+        const char symbol = node_mapper_peek(parser);
 
-        if (is_token_parsed == true)
+        if (symbol == ',')
+        {
+            ++parser->position;
+            node_mapper_skip_spaces(parser);
+        }
+        else if (symbol == '}')
+        {
+            is_object_end = true;
+        }
+        else
         {
-            msg->header.source = (node_id_t)token->u.num_int;
+            return false;
         }
+    }
+    ++parser->position;
 
-        is_token_parsed = ((token = lwjson_find(&lwjson, "dst_id")) != NULL) && (token->type == LWJSON_TYPE_ARRAY);
+    // Only whitespaces may follow the message
+    node_mapper_skip_spaces(parser);
 
-        if (is_token_parsed == true)
+    return (node_mapper_peek(parser) == '\0');
+}
+
+bool node_mapper_parse_dest_array (node_mapper_parser_t * const parser, node_msg_header_t * const header)
+{
+    ++parser->position;
+
+    node_mapper_skip_spaces(parser);
+
+    bool is_array_end = (node_mapper_peek(parser) == ']');
+
+    while (is_array_end == false)
+    {
+        int32_t value;
+        bool is_integer;
+
+        if ((node_mapper_parse_number(parser, &value, &is_integer) != true) || (is_integer != true))
         {
-            for (const lwjson_token_t *tkn = lwjson_get_first_child(token); tkn != NULL; tkn = tkn->next)
+            return false;
+        }
+
+        // Repeated destinations do not take space in the array
+        bool is_duplicate = false;
+
+        for (size_t i = 0U; i < header->dest_array_size; ++i)
+        {
+            if (header->dest_array[i] == (node_id_t)value)
             {
-                msg->header.dest_array[msg->header.dest_array_size] = (node_id_t)tkn->u.num_int;
-                ++msg->header.dest_array_size;
+                is_duplicate = true;
+                break;
             }
         }
 
-        is_token_parsed = ((token = lwjson_find(&lwjson, "cmd_id")) != NULL) && (token->type == LWJSON_TYPE_NUM_INT);
+        if (is_duplicate == false)
+        {
+            if (header->dest_array_size >= ARRAY_SIZE(header->dest_array))
+            {
+                parser->is_dest_overflow = true;
+
+                return false;
+            }
+            header->dest_array[header->dest_array_size] = (node_id_t)value;
+            ++header->dest_array_size;
+        }
+        node_mapper_skip_spaces(parser);
+
+        const char symbol = node_mapper_peek(parser);
 
-        if (is_token_parsed == true)
+        if (symbol == ',')
         {
-            msg->cmd_id = (node_command_id_t)token->u.num_int;
+            ++parser->position;
+            node_mapper_skip_spaces(parser);
+        }
+        else if (symbol == ']')
+        {
+            is_array_end = true;
         }
         else
         {
-            msg->cmd_id = DO_NOTHING;
+            return false;
         }
+    }
+    ++parser->position;
 
-        if ((msg->cmd_id == REQUEST_VERSION) || (msg->cmd_id == UPDATE_FIRMWARE))
+    return true;
+}
+
+bool node_mapper_parse_data (node_mapper_parser_t * const parser, node_msg_t * const msg)
+{
+    ++parser->position;
+
+    node_mapper_skip_spaces(parser);
+
+    bool is_object_end = (node_mapper_peek(parser) == '}');
+
+    while (is_object_end == false)
+    {
+        char key[PARSER_KEY_SIZE];
+
+        if (node_mapper_parse_key(parser, key) != true)
         {
-            // Do nothing
+            return false;
         }
-        else if ((msg->cmd_id == SET_MODE) || (msg->cmd_id == SET_LIGHT) || (msg->cmd_id == SET_INTRUSION) || (msg->cmd_id == SET_WARNING))
+
+        bool is_value_parsed = false;
+
+        if ((strcmp(key, "value_id") == 0) || (strcmp(key, "from_s") == 0))
         {
-            is_token_parsed = ((token = lwjson_find(&lwjson, "data")) != NULL) && (token->type == LWJSON_TYPE_OBJECT);
+            int32_t value;
+            bool is_integer;
+
+            is_value_parsed = node_mapper_parse_number(parser, &value, &is_integer);
 
-            if (is_token_parsed == true)
+            if ((is_value_parsed == true) && (is_integer == true))
             {
-                const lwjson_token_t *tkn = lwjson_find_ex(&lwjson, token, "value_id");
+                msg->value_0 = value;
+            }
+        }
+        else if (strcmp(key, "to_s") == 0)
+        {
+            int32_t value;
+            bool is_integer;
 
-                is_token_parsed = (tkn!= NULL) && (tkn->type == LWJSON_TYPE_NUM_INT);
+            is_value_parsed = node_mapper_parse_number(parser, &value, &is_integer);
 
-                if (is_token_parsed == true)
-                {
-                    msg->value_0 = (int32_t)(tkn->u.num_int);
-                }
+            if ((is_value_parsed == true) && (is_integer == true))
+            {
+                msg->value_1 = value;
             }
         }
+        else
+        {
+            is_value_parsed = node_mapper_skip_value(parser, 2U);
+        }
+
+        if (is_value_parsed != true)
+        {
+            return false;
+        }
+        node_mapper_skip_spaces(parser);
+
+        const char symbol = node_mapper_peek(parser);
+
+        if (symbol == ',')
+        {
+            ++parser->position;
+            node_mapper_skip_spaces(parser);
+        }
+        else if (symbol == '}')
+        {
+            is_object_end = true;
+        }
+        else
+        {
+            return false;
+        }
     }
-    else
+    ++parser->position;
+
+    return true;
+}
+
+bool node_mapper_parse_key (node_mapper_parser_t * const parser, char * const key)
+{
+    if (node_mapper_parse_string(parser, key, PARSER_KEY_SIZE) != true)
     {
-        std_error_catch_custom(error, (int)(parser_code), DEFAULT_ERROR_TEXT, __FILE__, __LINE__);
+        return false;
+    }
+    node_mapper_skip_spaces(parser);
+
+    if (node_mapper_peek(parser) != ':')
+    {
+        return false;
+    }
+    ++parser->position;
 
-        exit_code = STD_FAILURE;
+    node_mapper_skip_spaces(parser);
+
+    return true;
+}
+
+bool node_mapper_parse_string (node_mapper_parser_t * const parser, char * const string, size_t string_size)
+{
+    if (node_mapper_peek(parser) != '"')
+    {
+        return false;
+    }
+    ++parser->position;
+
+    size_t length = 0U;
+    bool is_truncated = false;
+
+    while (true)
+    {
+        const char symbol = node_mapper_peek(parser);
+
+        if (((unsigned char)(symbol) < 0x20U))
+        {
+            // Unexpected end of data or raw control character
+            return false;
+        }
+        ++parser->position;
+
+        if (symbol == '"')
+        {
+            break;
+        }
+
+        if (symbol == '\\')
+        {
+            // Escaped symbols are never a part of the known keys
+            if (node_mapper_peek(parser) == '\0')
+            {
+                return false;
+            }
+            ++parser->position;
+
+            is_truncated = true;
+        }
+        else if (length + 1U < string_size)
+        {
+            string[length] = symbol;
+            ++length;
+        }
+        else
+        {
+            is_truncated = true;
+        }
+    }
+
+    if (string_size != 0U)
+    {
+        // Unknown (too long) strings never match the known keys
+        string[(is_truncated == true) ? 0U : length] = '\0';
+    }
+
+    return true;
+}
+
+bool node_mapper_parse_number (node_mapper_parser_t * const parser, int32_t * const value, bool * const is_integer)
+{
+    bool is_negative = false;
+
+    if (node_mapper_peek(parser) == '-')
+    {
+        is_negative = true;
+        ++parser->position;
+    }
+
+    const size_t digit_start = parser->position;
+    int64_t number = 0;
+
+    *is_integer = true;
+
+    while ((node_mapper_peek(parser) >= '0') && (node_mapper_peek(parser) <= '9'))
+    {
+        if (number <= (int64_t)(INT32_MAX))
+        {
+            number = (number * 10) + (int64_t)(node_mapper_peek(parser) - '0');
+        }
+        ++parser->position;
+    }
+
+    if (parser->position == digit_start)
+    {
+        return false;
+    }
+
+    if (node_mapper_peek(parser) == '.')
+    {
+        ++parser->position;
+
+        const size_t fraction_start = parser->position;
+
+        while ((node_mapper_peek(parser) >= '0') && (node_mapper_peek(parser) <= '9'))
+        {
+            ++parser->position;
+        }
+
+        if (parser->position == fraction_start)
+        {
+            return false;
+        }
+        *is_integer = false;
+    }
+
+    if ((node_mapper_peek(parser) == 'e') || (node_mapper_peek(parser) == 'E'))
+    {
+        ++parser->position;
+
+        if ((node_mapper_peek(parser) == '+') || (node_mapper_peek(parser) == '-'))
+        {
+            ++parser->position;
+        }
+
+        const size_t exponent_start = parser->position;
+
+        while ((node_mapper_peek(parser) >= '0') && (node_mapper_peek(parser) <= '9'))
+        {
+            ++parser->position;
+        }
+
+        if (parser->position == exponent_start)
+        {
+            return false;
+        }
+        *is_integer = false;
+    }
+
+    if (is_negative == true)
+    {
+        number = -number;
+    }
+
+    if ((number > (int64_t)(INT32_MAX)) || (number < (int64_t)(INT32_MIN)))
+    {
+        *is_integer = false;
+    }
+
+    if (*is_integer == true)
+    {
+        *value = (int32_t)(number);
+    }
+
+    return true;
+}
+
+bool node_mapper_skip_value (node_mapper_parser_t * const parser, size_t depth)
+{
+    const char symbol = node_mapper_peek(parser);
+
+    if (symbol == '"')
+    {
+        return node_mapper_parse_string(parser, NULL, 0U);
+    }
+
+    if ((symbol == '-') || ((symbol >= '0') && (symbol <= '9')))
+    {
+        int32_t value;
+        bool is_integer;
+
+        return node_mapper_parse_number(parser, &value, &is_integer);
+    }
+
+    if (symbol == 't')
+    {
+        return node_mapper_skip_literal(parser, "true");
+    }
+
+    if (symbol == 'f')
+    {
+        return node_mapper_skip_literal(parser, "false");
+    }
+
+    if (symbol == 'n')
+    {
+        return node_mapper_skip_literal(parser, "null");
+    }
+
+    if ((symbol != '{') && (symbol != '['))
+    {
+        return false;
+    }
+
+    // Nesting is bounded to keep the stack usage constant
+    if (depth >= PARSER_MAX_DEPTH)
+    {
+        return false;
+    }
+    ++parser->position;
+
+    const bool is_object = (symbol == '{');
+    const char end_symbol = (is_object == true) ? '}' : ']';
+
+    node_mapper_skip_spaces(parser);
+
+    bool is_container_end = (node_mapper_peek(parser) == end_symbol);
+
+    while (is_container_end == false)
+    {
+        if (is_object == true)
+        {
+            if (node_mapper_parse_string(parser, NULL, 0U) != true)
+            {
+                return false;
+            }
+            node_mapper_skip_spaces(parser);
+
+            if (node_mapper_peek(parser) != ':')
+            {
+                return false;
+            }
+            ++parser->position;
+
+            node_mapper_skip_spaces(parser);
+        }
+
+        if (node_mapper_skip_value(parser, depth + 1U) != true)
+        {
+            return false;
+        }
+        node_mapper_skip_spaces(parser);
+
+        const char next_symbol = node_mapper_peek(parser);
+
+        if (next_symbol == ',')
+        {
+            ++parser->position;
+            node_mapper_skip_spaces(parser);
+        }
+        else if (next_symbol == end_symbol)
+        {
+            is_container_end = true;
+        }
+        else
+        {
+            return false;
+        }
+    }
+    ++parser->position;
+
+    return true;
+}
+
+bool node_mapper_skip_literal (node_mapper_parser_t * const parser, const char *literal)
+{
+    for (; *literal != '\0'; ++literal)
+    {
+        if (node_mapper_peek(parser) != *literal)
+        {
+            return false;
+        }
+        ++parser->position;
+    }
+
+    return true;
+}
+
+void node_mapper_skip_spaces (node_mapper_parser_t * const parser)
+{
+    char symbol = node_mapper_peek(parser);
+
+    while ((symbol == ' ') || (symbol == '\t') || (symbol == '\r') || (symbol == '\n'))
+    {
+        ++parser->position;
+
+        symbol = node_mapper_peek(parser);
+    }
+
+    return;
+}
+
+char node_mapper_peek (node_mapper_parser_t const * const parser)
+{
+    if (parser->position >= parser->size)
+    {
+        return '\0';
     }
-    lwjson_free(&lwjson);
 
-    return exit_code;
+    return parser->data[parser->position];
 }
@@ -6,12 +6,26 @@
 #ifndef NODE_MAPPER_H
 #define NODE_MAPPER_H
 
+#include <stdint.h>
 #include <stddef.h>
 
 typedef struct node_msg node_msg_t;
 typedef struct std_error std_error_t;
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 void node_mapper_serialize_message (node_msg_t const * const msg, char *raw_data, size_t * const raw_data_size);
-int node_mapper_deserialize_message (const char *raw_data, node_msg_t * const msg, std_error_t * const error);
+void node_mapper_serialize_latency (node_msg_t const * const msg,
+                                    uint16_t const * const histogram,
+                                    size_t histogram_size,
+                                    char *raw_data,
+                                    size_t * const raw_data_size);
+int node_mapper_deserialize_message (const char *raw_data, size_t raw_data_size, node_msg_t * const msg, std_error_t * const error);
+
+#ifdef __cplusplus
+}
+#endif
 
 #endif // NODE_MAPPER_H
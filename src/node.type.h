@@ -11,6 +11,42 @@
 #include "node/node.list.h"
 #include "node/node.command.h"
 
+#ifdef LATENCY_TRACE
+#include "latency.h"
+#endif // LATENCY_TRACE
+
+// Commands handled by the node itself, not yet listed in node.command.h
+#define REQUEST_LATENCY         ((node_command_id_t)(100))
+#define RESPONSE_LATENCY        ((node_command_id_t)(101))
+#define REQUEST_STATE           ((node_command_id_t)(102))
+#define RESPONSE_STATE          ((node_command_id_t)(103))
+#define REQUEST_FIRMWARE_CHECK  ((node_command_id_t)(104))
+#define RESPONSE_FIRMWARE_CHECK ((node_command_id_t)(105))
+#define REQUEST_HISTORY         ((node_command_id_t)(106))
+#define RESPONSE_HISTORY        ((node_command_id_t)(107))
+#define RESPONSE_HISTORY_END    ((node_command_id_t)(108))
+
+// RESPONSE_STATE payload: value_0 - mode, flags and humidity, value_1 - pressure, value_2 - temperature
+#define NODE_STATE_MODE_MASK            0xFFU
+#define NODE_STATE_LIGHT_FLAG           (1U << 8U)
+#define NODE_STATE_DISPLAY_FLAG         (1U << 9U)
+#define NODE_STATE_DOOR_OPEN_FLAG       (1U << 10U)
+#define NODE_STATE_INTRUSION_FLAG       (1U << 11U)
+#define NODE_STATE_WARNING_FLAG         (1U << 12U)
+#define NODE_STATE_DARK_FLAG            (1U << 13U)
+#define NODE_STATE_SENSOR_VALID_FLAG    (1U << 14U)
+#define NODE_STATE_FLAGS_MASK           0xFF00U
+#define NODE_STATE_HUMIDITY_SHIFT       16U
+#define NODE_STATE_HUMIDITY_MASK        0xFFU
+
+// REQUEST_HISTORY: value_0 - from, value_1 - to (log seconds, both included)
+// RESPONSE_HISTORY: value_0 - time, value_1 - sensor, value_2 - reading
+// RESPONSE_HISTORY_END: value_0 - the current log time, value_1 - records sent
+#define NODE_HISTORY_TEMPERATURE_SENSOR 1U
+#define NODE_HISTORY_HUMIDITY_SENSOR    2U
+#define NODE_HISTORY_PRESSURE_SENSOR    3U
+#define NODE_HISTORY_MAX_RECORD_COUNT   256U    // Per request, the server asks again from the last time sent
+
 typedef struct node_msg_header
 {
     node_id_t source;
@@ -29,6 +65,10 @@ typedef struct node_msg
     int32_t value_1;
     float value_2;
 
+#ifdef LATENCY_TRACE
+    latency_trace_t trace;
+#endif // LATENCY_TRACE
+
 } node_msg_t;
 
 #endif // NODE_TYPE_H
@@ -14,6 +14,7 @@
 
 static void node_B02_update_time (node_B02_t * const self, uint32_t time_ms);
 static void node_B02_update_state (node_B02_t * const self, uint32_t time_ms);
+static void node_B02_push_state (node_B02_t * const self, node_id_t dest_id, uint32_t time_ms);
 
 void node_B02_init (node_B02_t * const self)
 {
@@ -494,6 +495,70 @@ void node_B02_process_msg ( node_B02_t * const self,
         }
     }
 
+    else if (rcv_msg->cmd_id == REQUEST_STATE)
+    {
+        node_B02_push_state(self, rcv_msg->header.source, time_ms);
+    }
+
+    return;
+}
+
+void node_B02_push_state (node_B02_t * const self, node_id_t dest_id, uint32_t time_ms)
+{
+    if (self->send_msg_buffer_size == ARRAY_SIZE(self->send_msg_buffer))
+    {
+        return;
+    }
+
+    node_B02_update_state(self, time_ms);
+    const uint32_t intrusion_duration_ms = time_ms - self->intrusion_start_time_ms;
+
+    uint32_t state = (uint32_t)(self->mode) & NODE_STATE_MODE_MASK;
+
+    if ((self->state.light_strip.is_white_on == true) || (self->state.is_veranda_light_on == true) || (self->state.is_front_light_on == true))
+    {
+        state |= NODE_STATE_LIGHT_FLAG;
+    }
+
+    if (self->state.is_display_on == true)
+    {
+        state |= NODE_STATE_DISPLAY_FLAG;
+    }
+
+    if ((self->mode == ALARM_MODE) || ((self->mode == GUARD_MODE) && (intrusion_duration_ms <= NODE_B02_INTRUSION_DURATION_MS)))
+    {
+        state |= NODE_STATE_INTRUSION_FLAG;
+    }
+
+    if (self->is_dark == true)
+    {
+        state |= NODE_STATE_DARK_FLAG;
+    }
+
+    const size_t i = self->send_msg_buffer_size;
+    size_t j = 0U;
+
+    self->send_msg_buffer[i].header.source = self->id;
+    self->send_msg_buffer[i].header.dest_array[j] = dest_id;
+    ++j;
+    self->send_msg_buffer[i].header.dest_array_size = j;
+
+    self->send_msg_buffer[i].cmd_id = RESPONSE_STATE;
+    self->send_msg_buffer[i].value_1 = 0;
+    self->send_msg_buffer[i].value_2 = 0.0F;
+
+    if (self->temperature.is_valid == true)
+    {
+        state |= NODE_STATE_SENSOR_VALID_FLAG;
+
+        self->send_msg_buffer[i].value_1 = (int32_t)(self->temperature.pressure_hPa);
+        self->send_msg_buffer[i].value_2 = self->temperature.temperature_C;
+    }
+
+    self->send_msg_buffer[i].value_0 = (int32_t)(state);
+
+    ++self->send_msg_buffer_size;
+
     return;
 }
 
@@ -530,3 +595,37 @@ void node_B02_get_msg ( node_B02_t * const self,
 
     return;
 }
+
+void node_B02_get_snapshot (node_B02_t const * const self,
+                            node_B02_snapshot_t * const snapshot,
+                            uint32_t time_ms)
+{
+    assert(self     != NULL);
+    assert(snapshot != NULL);
+
+    snapshot->mode                    = self->mode;
+    snapshot->is_dark                 = self->is_dark;
+    snapshot->light_start_time_ms     = self->light_start_time_ms;
+    snapshot->display_start_time_ms   = self->display_start_time_ms;
+    snapshot->intrusion_start_time_ms = self->intrusion_start_time_ms;
+    snapshot->temperature             = self->temperature;
+
+    snapshot->time_ms = time_ms;
+
+    return;
+}
+
+void node_B02_restore (node_B02_t * const self, node_B02_snapshot_t const * const snapshot)
+{
+    assert(self     != NULL);
+    assert(snapshot != NULL);
+
+    self->mode                    = snapshot->mode;
+    self->is_dark                 = snapshot->is_dark;
+    self->light_start_time_ms     = snapshot->light_start_time_ms;
+    self->display_start_time_ms   = snapshot->display_start_time_ms;
+    self->intrusion_start_time_ms = snapshot->intrusion_start_time_ms;
+    self->temperature             = snapshot->temperature;
+
+    return;
+}
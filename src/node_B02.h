@@ -61,6 +61,21 @@ typedef struct node_B02_temperature
 
 } node_B02_temperature_t;
 
+typedef struct node_B02_snapshot
+{
+    node_mode_id_t mode;
+    bool is_dark;
+
+    uint32_t light_start_time_ms;
+    uint32_t display_start_time_ms;
+    uint32_t intrusion_start_time_ms;
+
+    node_B02_temperature_t temperature;
+
+    uint32_t time_ms;   // Of the node when taken, its time goes on from here after a restore
+
+} node_B02_snapshot_t;
+
 
 #ifdef __cplusplus
 extern "C" {
@@ -104,6 +119,14 @@ void node_B02_get_msg ( node_B02_t * const self,
                         node_msg_t *msg,
                         bool * const is_msg_valid);
 
+// What a reset must not lose, the messages still to send aside
+void node_B02_get_snapshot (node_B02_t const * const self,
+                            node_B02_snapshot_t * const snapshot,
+                            uint32_t time_ms);
+
+// Over a freshly initialized node, the times passed to it next must go on from snapshot->time_ms
+void node_B02_restore (node_B02_t * const self, node_B02_snapshot_t const * const snapshot);
+
 #ifdef __cplusplus
 }
 #endif
@@ -15,6 +15,7 @@
 
 static void node_T01_update_time (node_T01_t * const self, uint32_t time_ms);
 static void node_T01_update_state (node_T01_t * const self, uint32_t time_ms);
+static void node_T01_push_state (node_T01_t * const self, node_id_t dest_id, uint32_t time_ms);
 
 void node_T01_init (node_T01_t * const self)
 {
@@ -491,6 +492,83 @@ void node_T01_process_msg (node_T01_t * const self,
         }
     }
 
+    else if (rcv_msg->cmd_id == REQUEST_STATE)
+    {
+        node_T01_push_state(self, rcv_msg->header.source, time_ms);
+    }
+
+    return;
+}
+
+void node_T01_push_state (node_T01_t * const self, node_id_t dest_id, uint32_t time_ms)
+{
+    if (self->send_msg_buffer_size == ARRAY_SIZE(self->send_msg_buffer))
+    {
+        return;
+    }
+
+    node_T01_update_state(self, time_ms);
+    const uint32_t intrusion_duration_ms = time_ms - self->intrusion_start_time_ms;
+
+    uint32_t state = (uint32_t)(self->mode) & NODE_STATE_MODE_MASK;
+
+    if (self->state.is_light_on == true)
+    {
+        state |= NODE_STATE_LIGHT_FLAG;
+    }
+
+    if (self->state.is_display_on == true)
+    {
+        state |= NODE_STATE_DISPLAY_FLAG;
+    }
+
+    if (self->is_door_open == true)
+    {
+        state |= NODE_STATE_DOOR_OPEN_FLAG;
+    }
+
+    if ((self->mode == ALARM_MODE) || ((self->mode == GUARD_MODE) && (intrusion_duration_ms <= NODE_T01_INTRUSION_DURATION_MS)))
+    {
+        state |= NODE_STATE_INTRUSION_FLAG;
+    }
+
+    if (self->is_warning_enabled == true)
+    {
+        state |= NODE_STATE_WARNING_FLAG;
+    }
+
+    if (self->is_dark == true)
+    {
+        state |= NODE_STATE_DARK_FLAG;
+    }
+
+    const size_t i = self->send_msg_buffer_size;
+    size_t j = 0U;
+
+    self->send_msg_buffer[i].header.source = self->id;
+    self->send_msg_buffer[i].header.dest_array[j] = dest_id;
+    ++j;
+    self->send_msg_buffer[i].header.dest_array_size = j;
+
+    self->send_msg_buffer[i].cmd_id = RESPONSE_STATE;
+    self->send_msg_buffer[i].value_1 = 0;
+    self->send_msg_buffer[i].value_2 = 0.0F;
+
+    if (self->humidity.is_valid == true)
+    {
+        const uint32_t humidity_pct = (self->humidity.humidity_pct > 0.0F) ? (uint32_t)(self->humidity.humidity_pct) : 0U;
+
+        state |= NODE_STATE_SENSOR_VALID_FLAG;
+        state |= (humidity_pct & NODE_STATE_HUMIDITY_MASK) << NODE_STATE_HUMIDITY_SHIFT;
+
+        self->send_msg_buffer[i].value_1 = (int32_t)(self->humidity.pressure_hPa);
+        self->send_msg_buffer[i].value_2 = self->humidity.temperature_C;
+    }
+
+    self->send_msg_buffer[i].value_0 = (int32_t)(state);
+
+    ++self->send_msg_buffer_size;
+
     return;
 }
 
@@ -527,3 +605,41 @@ void node_T01_get_msg ( node_T01_t * const self,
 
     return;
 }
+
+void node_T01_get_snapshot (node_T01_t const * const self,
+                            node_T01_snapshot_t * const snapshot,
+                            uint32_t time_ms)
+{
+    assert(self     != NULL);
+    assert(snapshot != NULL);
+
+    snapshot->mode                    = self->mode;
+    snapshot->is_dark                 = self->is_dark;
+    snapshot->is_door_open            = self->is_door_open;
+    snapshot->is_warning_enabled      = self->is_warning_enabled;
+    snapshot->light_start_time_ms     = self->light_start_time_ms;
+    snapshot->display_start_time_ms   = self->display_start_time_ms;
+    snapshot->intrusion_start_time_ms = self->intrusion_start_time_ms;
+    snapshot->humidity                = self->humidity;
+
+    snapshot->time_ms = time_ms;
+
+    return;
+}
+
+void node_T01_restore (node_T01_t * const self, node_T01_snapshot_t const * const snapshot)
+{
+    assert(self     != NULL);
+    assert(snapshot != NULL);
+
+    self->mode                    = snapshot->mode;
+    self->is_dark                 = snapshot->is_dark;
+    self->is_door_open            = snapshot->is_door_open;
+    self->is_warning_enabled      = snapshot->is_warning_enabled;
+    self->light_start_time_ms     = snapshot->light_start_time_ms;
+    self->display_start_time_ms   = snapshot->display_start_time_ms;
+    self->intrusion_start_time_ms = snapshot->intrusion_start_time_ms;
+    self->humidity                = snapshot->humidity;
+
+    return;
+}
@@ -53,6 +53,23 @@ typedef struct node_T01_humidity
 
 } node_T01_humidity_t;
 
+typedef struct node_T01_snapshot
+{
+    node_mode_id_t mode;
+    bool is_dark;
+    bool is_door_open;
+    bool is_warning_enabled;
+
+    uint32_t light_start_time_ms;
+    uint32_t display_start_time_ms;
+    uint32_t intrusion_start_time_ms;
+
+    node_T01_humidity_t humidity;
+
+    uint32_t time_ms;   // Of the node when taken, its time goes on from here after a restore
+
+} node_T01_snapshot_t;
+
 
 #ifdef __cplusplus
 extern "C" {
@@ -96,6 +113,14 @@ void node_T01_get_msg ( node_T01_t * const self,
                         node_msg_t *msg,
                         bool * const is_msg_valid);
 
+// What a reset must not lose, the messages still to send aside
+void node_T01_get_snapshot (node_T01_t const * const self,
+                            node_T01_snapshot_t * const snapshot,
+                            uint32_t time_ms);
+
+// Over a freshly initialized node, the times passed to it next must go on from snapshot->time_ms
+void node_T01_restore (node_T01_t * const self, node_T01_snapshot_t const * const snapshot);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,313 @@
+/************************************************************
+ *   Author : German Mundinger
+ *   Date   : 2024
+ ************************************************************/
+
+#include "patcher.h"
+
+#include <assert.h>
+
+#include "crc32.h"
+#include "logger.h"
+#include "std_error/std_error.h"
+
+
+#define FORMAT_ERROR_TEXT   "Patcher format error"
+#define SIZE_ERROR_TEXT     "Patcher image size error"
+#define OLD_CRC_ERROR_TEXT  "Patcher old image crc error"
+#define NEW_CRC_ERROR_TEXT  "Patcher new image crc error"
+
+
+static int patcher_process_header (patcher_t * const self, std_error_t * const error);
+static int patcher_process_operation (patcher_t * const self, std_error_t * const error);
+static int patcher_copy (patcher_t * const self, uint32_t old_offset, uint32_t size, uint8_t const * const diff, std_error_t * const error);
+static int patcher_write (patcher_t * const self, uint8_t const * const data, size_t size, std_error_t * const error);
+static bool patcher_is_in_old_image (patcher_t const * const self, uint32_t old_offset, uint32_t size);
+static size_t patcher_get_head_size (patcher_t const * const self);
+static uint32_t patcher_read_u32 (uint8_t const * const data);
+
+
+void patcher_init (patcher_t * const self, patcher_config_t const * const config)
+{
+    assert(self                     != NULL);
+    assert(config                   != NULL);
+    assert(config->read_callback    != NULL);
+    assert(config->write_callback   != NULL);
+
+    self->config = *config;
+
+    self->state         = HEADER_PATCHER_STATE;
+    self->head_size     = 0U;
+
+    self->old_size      = 0U;
+    self->new_size      = 0U;
+    self->new_crc32     = 0U;
+    self->old_offset    = 0U;
+    self->size          = 0U;
+
+    self->image_size    = 0U;
+    self->image_crc32   = CRC32_INITIAL_VALUE;
+
+    return;
+}
+
+int patcher_process (patcher_t * const self, uint8_t const * const data, size_t size, std_error_t * const error)
+{
+    assert(self != NULL);
+    assert(data != NULL);
+
+    size_t i = 0U;
+
+    while (i < size)
+    {
+        if ((self->state == HEADER_PATCHER_STATE) || (self->state == OPERATION_PATCHER_STATE))
+        {
+            self->head[self->head_size] = data[i];
+            ++self->head_size;
+            ++i;
+
+            const size_t head_size = patcher_get_head_size(self);
+
+            if (head_size == 0U)
+            {
+                std_error_catch_custom(error, STD_FAILURE, FORMAT_ERROR_TEXT, __FILE__, __LINE__);
+
+                return STD_FAILURE;
+            }
+
+            if (self->head_size < head_size)
+            {
+                continue;
+            }
+            self->head_size = 0U;
+
+            const int exit_code = (self->state == HEADER_PATCHER_STATE) ? patcher_process_header(self, error) : patcher_process_operation(self, error);
+
+            if (exit_code != STD_SUCCESS)
+            {
+                return STD_FAILURE;
+            }
+            continue;
+        }
+
+        const size_t available  = size - i;
+        const size_t part_size  = (available < (size_t)(self->size)) ? available : (size_t)(self->size);
+
+        if (self->state == ADD_PATCHER_STATE)
+        {
+            if (patcher_copy(self, self->old_offset, (uint32_t)(part_size), &data[i], error) != STD_SUCCESS)
+            {
+                return STD_FAILURE;
+            }
+            self->old_offset += (uint32_t)(part_size);
+        }
+        else
+        {
+            if (patcher_write(self, &data[i], part_size, error) != STD_SUCCESS)
+            {
+                return STD_FAILURE;
+            }
+        }
+
+        i += part_size;
+        self->size -= (uint32_t)(part_size);
+
+        if (self->size == 0U)
+        {
+            self->state = OPERATION_PATCHER_STATE;
+        }
+    }
+
+    return STD_SUCCESS;
+}
+
+int patcher_finish (patcher_t * const self, std_error_t * const error)
+{
+    assert(self != NULL);
+
+    if ((self->state != OPERATION_PATCHER_STATE) || (self->head_size != 0U) || (self->image_size != self->new_size))
+    {
+        std_error_catch_custom(error, STD_FAILURE, SIZE_ERROR_TEXT, __FILE__, __LINE__);
+
+        return STD_FAILURE;
+    }
+
+    LOG("Patcher : new image crc32 = %08lx\r\n", (unsigned long)(self->image_crc32));
+
+    if (self->image_crc32 != self->new_crc32)
+    {
+        std_error_catch_custom(error, STD_FAILURE, NEW_CRC_ERROR_TEXT, __FILE__, __LINE__);
+
+        return STD_FAILURE;
+    }
+
+    return STD_SUCCESS;
+}
+
+
+int patcher_process_header (patcher_t * const self, std_error_t * const error)
+{
+    if ((self->head[0] != PATCHER_MAGIC_0) || (self->head[1] != PATCHER_MAGIC_1))
+    {
+        std_error_catch_custom(error, STD_FAILURE, FORMAT_ERROR_TEXT, __FILE__, __LINE__);
+
+        return STD_FAILURE;
+    }
+
+    self->old_size  = patcher_read_u32(&self->head[4]);
+    self->new_size  = patcher_read_u32(&self->head[12]);
+    self->new_crc32 = patcher_read_u32(&self->head[16]);
+
+    const uint32_t old_crc32 = patcher_read_u32(&self->head[8]);
+
+    LOG("Patcher : old size = %lu bytes, new size = %lu bytes\r\n", (unsigned long)(self->old_size), (unsigned long)(self->new_size));
+
+    if ((self->old_size > self->config.max_old_size) || (self->new_size == 0U) || (self->new_size > self->config.max_new_size))
+    {
+        std_error_catch_custom(error, STD_FAILURE, SIZE_ERROR_TEXT, __FILE__, __LINE__);
+
+        return STD_FAILURE;
+    }
+
+    // A patch made against another build would produce garbage with a matching size
+    uint32_t crc = CRC32_INITIAL_VALUE;
+
+    for (uint32_t offset = 0U; offset < self->old_size; offset += PATCHER_BUFFER_SIZE)
+    {
+        uint8_t buffer[PATCHER_BUFFER_SIZE];
+
+        const uint32_t size = ((self->old_size - offset) < PATCHER_BUFFER_SIZE) ? (self->old_size - offset) : PATCHER_BUFFER_SIZE;
+
+        if (self->config.read_callback(offset, buffer, (size_t)(size), error) != STD_SUCCESS)
+        {
+            return STD_FAILURE;
+        }
+        crc = crc32_update(crc, buffer, (size_t)(size));
+    }
+
+    if (crc != old_crc32)
+    {
+        std_error_catch_custom(error, STD_FAILURE, OLD_CRC_ERROR_TEXT, __FILE__, __LINE__);
+
+        return STD_FAILURE;
+    }
+
+    self->state = OPERATION_PATCHER_STATE;
+
+    return STD_SUCCESS;
+}
+
+int patcher_process_operation (patcher_t * const self, std_error_t * const error)
+{
+    const patcher_operation_t operation = (patcher_operation_t)(self->head[0]);
+
+    if (operation == INSERT_PATCHER_OPERATION)
+    {
+        self->size = patcher_read_u32(&self->head[1]);
+
+        if (self->size != 0U)
+        {
+            self->state = INSERT_PATCHER_STATE;
+        }
+        return STD_SUCCESS;
+    }
+
+    const uint32_t old_offset   = patcher_read_u32(&self->head[1]);
+    const uint32_t size         = patcher_read_u32(&self->head[5]);
+
+    if (patcher_is_in_old_image(self, old_offset, size) != true)
+    {
+        std_error_catch_custom(error, STD_FAILURE, FORMAT_ERROR_TEXT, __FILE__, __LINE__);
+
+        return STD_FAILURE;
+    }
+
+    if (operation == COPY_PATCHER_OPERATION)
+    {
+        return patcher_copy(self, old_offset, size, NULL, error);
+    }
+
+    self->old_offset    = old_offset;
+    self->size          = size;
+
+    if (self->size != 0U)
+    {
+        self->state = ADD_PATCHER_STATE;
+    }
+    return STD_SUCCESS;
+}
+
+int patcher_copy (patcher_t * const self, uint32_t old_offset, uint32_t size, uint8_t const * const diff, std_error_t * const error)
+{
+    for (uint32_t i = 0U; i < size; i += PATCHER_BUFFER_SIZE)
+    {
+        uint8_t buffer[PATCHER_BUFFER_SIZE];
+
+        const uint32_t part_size = ((size - i) < PATCHER_BUFFER_SIZE) ? (size - i) : PATCHER_BUFFER_SIZE;
+
+        if (self->config.read_callback(old_offset + i, buffer, (size_t)(part_size), error) != STD_SUCCESS)
+        {
+            return STD_FAILURE;
+        }
+
+        if (diff != NULL)
+        {
+            for (uint32_t j = 0U; j < part_size; ++j)
+            {
+                buffer[j] = (uint8_t)(buffer[j] + diff[i + j]);
+            }
+        }
+
+        if (patcher_write(self, buffer, (size_t)(part_size), error) != STD_SUCCESS)
+        {
+            return STD_FAILURE;
+        }
+    }
+
+    return STD_SUCCESS;
+}
+
+int patcher_write (patcher_t * const self, uint8_t const * const data, size_t size, std_error_t * const error)
+{
+    if (size > (size_t)(self->new_size - self->image_size))
+    {
+        std_error_catch_custom(error, STD_FAILURE, SIZE_ERROR_TEXT, __FILE__, __LINE__);
+
+        return STD_FAILURE;
+    }
+
+    self->image_size    += (uint32_t)(size);
+    self->image_crc32   = crc32_update(self->image_crc32, data, size);
+
+    return self->config.write_callback(data, size, error);
+}
+
+bool patcher_is_in_old_image (patcher_t const * const self, uint32_t old_offset, uint32_t size)
+{
+    return (old_offset <= self->old_size) && (size <= (self->old_size - old_offset));
+}
+
+size_t patcher_get_head_size (patcher_t const * const self)
+{
+    if (self->state == HEADER_PATCHER_STATE)
+    {
+        return PATCHER_HEADER_SIZE;
+    }
+
+    const patcher_operation_t operation = (patcher_operation_t)(self->head[0]);
+
+    if ((operation == COPY_PATCHER_OPERATION) || (operation == ADD_PATCHER_OPERATION))
+    {
+        return PATCHER_OPERATION_SIZE;
+    }
+    if (operation == INSERT_PATCHER_OPERATION)
+    {
+        return PATCHER_INSERT_SIZE;
+    }
+    return 0U;
+}
+
+uint32_t patcher_read_u32 (uint8_t const * const data)
+{
+    return (uint32_t)(data[0]) | ((uint32_t)(data[1]) << 8U) | ((uint32_t)(data[2]) << 16U) | ((uint32_t)(data[3]) << 24U);
+}
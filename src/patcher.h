@@ -0,0 +1,98 @@
+/************************************************************
+ *   Author : German Mundinger
+ *   Date   : 2024
+ ************************************************************/
+
+#ifndef PATCHER_H
+#define PATCHER_H
+
+// Patch: magic (2) | reserved (2) | old size (4) | old crc32 (4) | new size (4) | new crc32 (4) | operations, little endian
+// Operation: COPY    | old offset (4) | size (4)             - new = old
+//            ADD     | old offset (4) | size (4) | bytes     - new = old + byte, bsdiff style: moved code differs in few bytes
+//            INSERT  | size (4) | bytes                       - new = byte
+#define PATCHER_MAGIC_0         0x44U   // 'D'
+#define PATCHER_MAGIC_1         0x50U   // 'P'
+#define PATCHER_HEADER_SIZE     20U
+#define PATCHER_OPERATION_SIZE  9U      // The COPY and ADD head, the longest one
+#define PATCHER_INSERT_SIZE     5U      // The INSERT head
+#define PATCHER_BUFFER_SIZE     64U     // Old image bytes per read
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+typedef struct std_error std_error_t;
+
+typedef enum patcher_operation
+{
+    COPY_PATCHER_OPERATION = 1,
+    ADD_PATCHER_OPERATION,
+    INSERT_PATCHER_OPERATION
+
+} patcher_operation_t;
+
+typedef int (*patcher_read_callback_t) (uint32_t offset, uint8_t * const data, size_t size, std_error_t * const error);
+typedef int (*patcher_write_callback_t) (uint8_t const * const data, size_t size, std_error_t * const error);
+
+typedef struct patcher_config
+{
+    patcher_read_callback_t read_callback;      // The running image
+    patcher_write_callback_t write_callback;    // The new one, in order
+
+    uint32_t max_old_size;
+    uint32_t max_new_size;
+
+} patcher_config_t;
+
+typedef struct patcher patcher_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void patcher_init (patcher_t * const self, patcher_config_t const * const config);
+
+// The patch, split at any point; the old image is checked against its crc32 as soon as the header is in
+int patcher_process (patcher_t * const self, uint8_t const * const data, size_t size, std_error_t * const error);
+
+// Checks the size and the crc32 of the new image
+int patcher_finish (patcher_t * const self, std_error_t * const error);
+
+#ifdef __cplusplus
+}
+#endif
+
+
+
+// Private
+typedef enum patcher_state
+{
+    HEADER_PATCHER_STATE = 0,
+    OPERATION_PATCHER_STATE,
+    ADD_PATCHER_STATE,
+    INSERT_PATCHER_STATE
+
+} patcher_state_t;
+
+typedef struct patcher
+{
+    patcher_config_t config;
+
+    patcher_state_t state;
+
+    uint8_t head[PATCHER_HEADER_SIZE];
+    size_t head_size;
+
+    uint32_t old_size;
+    uint32_t new_size;
+    uint32_t new_crc32;
+
+    uint32_t old_offset;    // Of the current ADD
+    uint32_t size;          // Left in the current ADD or INSERT
+
+    uint32_t image_size;
+    uint32_t image_crc32;
+
+} patcher_t;
+
+#endif // PATCHER_H
@@ -0,0 +1,70 @@
+/************************************************************
+ *   Author : German Mundinger
+ *   Date   : 2024
+ ************************************************************/
+
+#include "retained_state.h"
+
+#include <string.h>
+#include <assert.h>
+
+#include "crc32.h"
+
+
+static uint32_t retained_state_calculate_crc32 (retained_state_t const * const self);
+
+void retained_state_clear (retained_state_t * const self)
+{
+    assert(self != NULL);
+
+    memset(self, 0, sizeof(retained_state_t));
+
+    return;
+}
+
+void retained_state_save (retained_state_t * const self, uint32_t type, void const * const data, size_t size)
+{
+    assert(self != NULL);
+    assert(data != NULL);
+    assert(size <= RETAINED_STATE_DATA_SIZE);
+
+    // A reset in the middle leaves a record that fails its check
+    self->crc32 = 0U;
+
+    self->magic = RETAINED_STATE_MAGIC;
+    self->type  = type;
+    self->size  = (uint32_t)(size);
+
+    memcpy(self->data, data, size);
+    memset(&self->data[size], 0, RETAINED_STATE_DATA_SIZE - size);
+
+    self->crc32 = retained_state_calculate_crc32(self);
+
+    return;
+}
+
+bool retained_state_load (retained_state_t const * const self, uint32_t type, void * const data, size_t size)
+{
+    assert(self != NULL);
+    assert(data != NULL);
+    assert(size <= RETAINED_STATE_DATA_SIZE);
+
+    if ((self->magic != RETAINED_STATE_MAGIC) || (self->type != type) || (self->size != (uint32_t)(size)))
+    {
+        return false;
+    }
+
+    if (self->crc32 != retained_state_calculate_crc32(self))
+    {
+        return false;
+    }
+
+    memcpy(data, self->data, size);
+
+    return true;
+}
+
+uint32_t retained_state_calculate_crc32 (retained_state_t const * const self)
+{
+    return crc32_calculate((uint8_t const*)(self), offsetof(retained_state_t, crc32));
+}
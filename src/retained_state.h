@@ -0,0 +1,48 @@
+/************************************************************
+ *   Author : German Mundinger
+ *   Date   : 2024
+ ************************************************************/
+
+#ifndef RETAINED_STATE_H
+#define RETAINED_STATE_H
+
+#define RETAINED_STATE_MAGIC        0x31534B57U // "WKS1", a new one whenever a snapshot layout changes
+#define RETAINED_STATE_DATA_SIZE    112U        // The largest snapshot, the whole record fits the 256 bytes of .noinit
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+typedef struct retained_state retained_state_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Lives in the no-init RAM, nothing but a valid record survives a power-on
+void retained_state_clear (retained_state_t * const self);
+
+// type - whose snapshot it is, a node id
+void retained_state_save (retained_state_t * const self, uint32_t type, void const * const data, size_t size);
+
+// false - a cold boot, a corrupted record or a snapshot of another type or size (data is left as it is)
+bool retained_state_load (retained_state_t const * const self, uint32_t type, void * const data, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+
+
+// Private
+typedef struct retained_state
+{
+    uint32_t magic;
+    uint32_t type;
+    uint32_t size;
+    uint8_t data[RETAINED_STATE_DATA_SIZE];
+    uint32_t crc32;     // Over everything before it
+
+} retained_state_t;
+
+#endif // RETAINED_STATE_H
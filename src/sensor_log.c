@@ -0,0 +1,578 @@
+/************************************************************
+ *   Author : German Mundinger
+ *   Date   : 2024
+ ************************************************************/
+
+#include "sensor_log.h"
+
+#include <string.h>
+#include <assert.h>
+
+#include "format.h"
+
+#include "logger.h"
+#include "std_error/std_error.h"
+
+
+#define ORDER_ERROR_TEXT    "Sensor log time order error"
+
+#define INDEX_FILE_NAME             "log.index"
+#define INDEX_TEMPORARY_FILE_NAME   "log.index.tmp"
+#define SEGMENT_FILE_NAME_PREFIX    "log."
+
+
+static int sensor_log_load_index (sensor_log_t * const self, std_error_t * const error);
+static int sensor_log_save_index (sensor_log_t * const self, std_error_t * const error);
+static int sensor_log_load_newest_segment (sensor_log_t * const self, std_error_t * const error);
+static int sensor_log_rotate (sensor_log_t * const self, uint32_t first_time_s, std_error_t * const error);
+static int sensor_log_write (sensor_log_t * const self, sensor_log_record_t const * const records, size_t count, std_error_t * const error);
+static int sensor_log_read (sensor_log_t * const self, uint32_t segment_id, size_t record_number,
+                            sensor_log_record_t * const records, size_t * const count, size_t max_count, std_error_t * const error);
+static int sensor_log_get_segment_size (sensor_log_t * const self, uint32_t segment_id, size_t * const count, std_error_t * const error);
+static int sensor_log_submit (sensor_log_t * const self, std_error_t * const error);
+static void sensor_log_get_file_name (uint32_t segment_id, char file_name[64]);
+
+
+int sensor_log_init (sensor_log_t * const self, sensor_log_config_t const * const config, std_error_t * const error)
+{
+    assert(self             != NULL);
+    assert(config           != NULL);
+    assert(config->storage  != NULL);
+
+    self->config = *config;
+
+    self->segment_array_size    = 0U;
+    self->record_count          = 0U;
+    self->buffer_size           = 0U;
+    self->last_time_s           = 0U;
+    self->is_empty              = true;
+
+    if (sensor_log_load_index(self, error) != STD_SUCCESS)
+    {
+        return STD_FAILURE;
+    }
+
+    return sensor_log_load_newest_segment(self, error);
+}
+
+int sensor_log_append (sensor_log_t * const self, uint32_t time_s, uint8_t sensor_id, float value, std_error_t * const error)
+{
+    assert(self != NULL);
+
+    // The index and the queries rely on the time order
+    if ((self->is_empty != true) && (time_s < self->last_time_s))
+    {
+        std_error_catch_custom(error, STD_FAILURE, ORDER_ERROR_TEXT, __FILE__, __LINE__);
+
+        return STD_FAILURE;
+    }
+
+    int32_t scaled_value = format_float_to_fixed(value, SENSOR_LOG_VALUE_DIGITS);
+
+    if (scaled_value > INT16_MAX)
+    {
+        scaled_value = INT16_MAX;
+    }
+    else if (scaled_value < INT16_MIN)
+    {
+        scaled_value = INT16_MIN;
+    }
+
+    sensor_log_record_t * const record = &self->buffer[self->buffer_size];
+    record->time_s      = time_s;
+    record->sensor_id   = sensor_id;
+    record->reserved    = 0U;
+    record->value       = (int16_t)(scaled_value);
+
+    ++self->buffer_size;
+
+    self->last_time_s   = time_s;
+    self->is_empty      = false;
+
+    if (self->buffer_size == SENSOR_LOG_BUFFER_SIZE)
+    {
+        return sensor_log_flush(self, error);
+    }
+
+    return STD_SUCCESS;
+}
+
+int sensor_log_flush (sensor_log_t * const self, std_error_t * const error)
+{
+    assert(self != NULL);
+
+    int exit_code = STD_SUCCESS;
+
+    size_t position = 0U;
+
+    while (position < self->buffer_size)
+    {
+        if ((self->segment_array_size == 0U) || (self->record_count == SENSOR_LOG_SEGMENT_SIZE))
+        {
+            exit_code = sensor_log_rotate(self, self->buffer[position].time_s, error);
+
+            if (exit_code != STD_SUCCESS)
+            {
+                break;
+            }
+        }
+
+        size_t count = self->buffer_size - position;
+
+        if (count > (SENSOR_LOG_SEGMENT_SIZE - self->record_count))
+        {
+            count = SENSOR_LOG_SEGMENT_SIZE - self->record_count;
+        }
+
+        exit_code = sensor_log_write(self, &self->buffer[position], count, error);
+
+        if (exit_code != STD_SUCCESS)
+        {
+            break;
+        }
+
+        self->record_count  += count;
+        position            += count;
+    }
+
+    // A failed write costs the buffered records, not the records to come
+    self->buffer_size = 0U;
+
+    return exit_code;
+}
+
+bool sensor_log_get_last_time (sensor_log_t const * const self, uint32_t * const time_s)
+{
+    assert(self     != NULL);
+    assert(time_s   != NULL);
+
+    *time_s = self->last_time_s;
+
+    return (self->is_empty != true);
+}
+
+int sensor_log_find (sensor_log_t * const self, sensor_log_cursor_t * const cursor, uint32_t from_s, uint32_t to_s, std_error_t * const error)
+{
+    assert(self     != NULL);
+    assert(cursor   != NULL);
+
+    cursor->segment_id      = 0U;
+    cursor->record_number   = 0U;
+    cursor->to_s            = to_s;
+    cursor->is_end          = true;
+    cursor->chunk_size      = 0U;
+    cursor->chunk_position  = 0U;
+
+    if (self->buffer_size != 0U)
+    {
+        if (sensor_log_flush(self, error) != STD_SUCCESS)
+        {
+            return STD_FAILURE;
+        }
+    }
+
+    if ((self->segment_array_size == 0U) || (from_s > to_s))
+    {
+        return STD_SUCCESS;
+    }
+
+    // The last segment started strictly before from_s, the records of that second may end the previous one
+    size_t segment_index = 0U;
+
+    for (size_t i = 1U; i < self->segment_array_size; ++i)
+    {
+        if (self->segment_array[i].first_time_s < from_s)
+        {
+            segment_index = i;
+        }
+    }
+
+    const uint32_t segment_id = self->segment_array[segment_index].id;
+
+    size_t record_count;
+
+    if (sensor_log_get_segment_size(self, segment_id, &record_count, error) != STD_SUCCESS)
+    {
+        return STD_FAILURE;
+    }
+
+    // The first record with time_s >= from_s
+    size_t low  = 0U;
+    size_t high = record_count;
+
+    while (low < high)
+    {
+        const size_t middle = low + ((high - low) / 2U);
+
+        sensor_log_record_t record;
+        size_t count;
+
+        if (sensor_log_read(self, segment_id, middle, &record, &count, 1U, error) != STD_SUCCESS)
+        {
+            return STD_FAILURE;
+        }
+
+        if ((count != 0U) && (record.time_s < from_s))
+        {
+            low = middle + 1U;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    cursor->segment_id      = segment_id;
+    cursor->record_number   = low;
+    cursor->is_end          = false;
+
+    return STD_SUCCESS;
+}
+
+int sensor_log_read_next (sensor_log_t * const self, sensor_log_cursor_t * const cursor, sensor_log_record_t * const record, bool * const is_record_valid, std_error_t * const error)
+{
+    assert(self             != NULL);
+    assert(cursor           != NULL);
+    assert(record           != NULL);
+    assert(is_record_valid  != NULL);
+
+    *is_record_valid = false;
+
+    while (cursor->is_end != true)
+    {
+        if (cursor->chunk_position < cursor->chunk_size)
+        {
+            *record = cursor->chunk[cursor->chunk_position];
+            ++cursor->chunk_position;
+
+            if (record->time_s > cursor->to_s)
+            {
+                cursor->is_end = true;
+
+                break;
+            }
+
+            *is_record_valid = true;
+
+            break;
+        }
+
+        if (self->segment_array_size == 0U)
+        {
+            cursor->is_end = true;
+
+            break;
+        }
+
+        const uint32_t oldest_id = self->segment_array[0].id;
+        const uint32_t newest_id = self->segment_array[self->segment_array_size - 1U].id;
+
+        // Rotated out since the last call
+        if (cursor->segment_id < oldest_id)
+        {
+            cursor->segment_id      = oldest_id;
+            cursor->record_number   = 0U;
+        }
+
+        if (cursor->segment_id > newest_id)
+        {
+            cursor->is_end = true;
+
+            break;
+        }
+
+        size_t count;
+
+        if (sensor_log_read(self, cursor->segment_id, cursor->record_number, cursor->chunk, &count, SENSOR_LOG_CHUNK_SIZE, error) != STD_SUCCESS)
+        {
+            return STD_FAILURE;
+        }
+
+        cursor->chunk_size      = count;
+        cursor->chunk_position  = 0U;
+        cursor->record_number   += count;
+
+        if (count == 0U)
+        {
+            ++cursor->segment_id;
+            cursor->record_number = 0U;
+        }
+    }
+
+    return STD_SUCCESS;
+}
+
+float sensor_log_get_value (sensor_log_record_t const * const record)
+{
+    assert(record != NULL);
+
+    float value = (float)(record->value);
+
+    for (size_t i = 0U; i < SENSOR_LOG_VALUE_DIGITS; ++i)
+    {
+        value /= 10.0F;
+    }
+
+    return value;
+}
+
+
+int sensor_log_load_index (sensor_log_t * const self, std_error_t * const error)
+{
+    storage_t * const storage = self->config.storage;
+
+    // No index yet - a new log
+    if (storage_open_file(storage, &self->file, INDEX_FILE_NAME, NULL) != STD_SUCCESS)
+    {
+        LOG("Sensor log : no index\r\n");
+
+        return STD_SUCCESS;
+    }
+
+    size_t size;
+
+    int exit_code = storage_read_file(storage, &self->file, (char*)(self->segment_array), &size, sizeof(self->segment_array), error);
+
+    storage_close_file(storage, &self->file, NULL);
+
+    if (exit_code == STD_SUCCESS)
+    {
+        self->segment_array_size = size / sizeof(sensor_log_segment_t);
+    }
+
+    LOG("Sensor log : segment count = %u\r\n", (unsigned int)(self->segment_array_size));
+
+    return exit_code;
+}
+
+int sensor_log_save_index (sensor_log_t * const self, std_error_t * const error)
+{
+    const size_t size = self->segment_array_size * sizeof(sensor_log_segment_t);
+
+    // Atomic: a power loss leaves either the old index or the new one
+    if (storage_request_init(&self->request, STORAGE_WRITE_REQUEST, INDEX_TEMPORARY_FILE_NAME, (const void*)(self->segment_array), size, error) != STD_SUCCESS)
+    {
+        return STD_FAILURE;
+    }
+
+    if (sensor_log_submit(self, error) != STD_SUCCESS)
+    {
+        return STD_FAILURE;
+    }
+
+    if (storage_request_init(&self->request, STORAGE_RENAME_REQUEST, INDEX_TEMPORARY_FILE_NAME, (const void*)(INDEX_FILE_NAME), 0U, error) != STD_SUCCESS)
+    {
+        return STD_FAILURE;
+    }
+
+    return sensor_log_submit(self, error);
+}
+
+int sensor_log_load_newest_segment (sensor_log_t * const self, std_error_t * const error)
+{
+    if (self->segment_array_size == 0U)
+    {
+        return STD_SUCCESS;
+    }
+
+    sensor_log_segment_t const * const segment = &self->segment_array[self->segment_array_size - 1U];
+
+    if (sensor_log_get_segment_size(self, segment->id, &self->record_count, error) != STD_SUCCESS)
+    {
+        return STD_FAILURE;
+    }
+
+    // Indexed but never written: the time is still a bound the next record can't go under
+    self->last_time_s   = segment->first_time_s;
+    self->is_empty      = false;
+
+    if (self->record_count != 0U)
+    {
+        sensor_log_record_t record;
+        size_t count;
+
+        if (sensor_log_read(self, segment->id, self->record_count - 1U, &record, &count, 1U, error) != STD_SUCCESS)
+        {
+            return STD_FAILURE;
+        }
+
+        if (count != 0U)
+        {
+            self->last_time_s = record.time_s;
+        }
+    }
+
+    LOG("Sensor log : segment = %lu, records = %u, last time = %lu s\r\n",
+        (unsigned long)(segment->id), (unsigned int)(self->record_count), (unsigned long)(self->last_time_s));
+
+    return STD_SUCCESS;
+}
+
+int sensor_log_rotate (sensor_log_t * const self, uint32_t first_time_s, std_error_t * const error)
+{
+    uint32_t segment_id = 0U;
+
+    if (self->segment_array_size != 0U)
+    {
+        segment_id = self->segment_array[self->segment_array_size - 1U].id + 1U;
+    }
+
+    // Put back if a request is not queued, the index in RAM never runs ahead of the one on the W25Q
+    const sensor_log_segment_t oldest_segment   = self->segment_array[0];
+    const size_t segment_array_size             = self->segment_array_size;
+    const size_t record_count                   = self->record_count;
+
+    if (self->segment_array_size == SENSOR_LOG_SEGMENT_COUNT)
+    {
+        char file_name[64];
+        sensor_log_get_file_name(self->segment_array[0].id, file_name);
+
+        LOG("Sensor log : drop segment = %lu\r\n", (unsigned long)(self->segment_array[0].id));
+
+        if (storage_request_init(&self->request, STORAGE_DELETE_REQUEST, file_name, NULL, 0U, error) != STD_SUCCESS)
+        {
+            return STD_FAILURE;
+        }
+
+        // A full queue fails the rotation, while a segment missing after a power loss in the middle of one is nothing to drop
+        if (self->config.request_callback != NULL)
+        {
+            if (self->config.request_callback(&self->request, error) != STD_SUCCESS)
+            {
+                return STD_FAILURE;
+            }
+        }
+        else
+        {
+            storage_request_execute(&self->request, self->config.storage, NULL);
+        }
+
+        memmove((void*)(&self->segment_array[0]), (const void*)(&self->segment_array[1]), (SENSOR_LOG_SEGMENT_COUNT - 1U) * sizeof(sensor_log_segment_t));
+
+        --self->segment_array_size;
+    }
+
+    self->segment_array[self->segment_array_size].id            = segment_id;
+    self->segment_array[self->segment_array_size].first_time_s  = first_time_s;
+
+    ++self->segment_array_size;
+
+    self->record_count = 0U;
+
+    // Indexed before written, so a segment file is never lost to the index
+    if (sensor_log_save_index(self, error) != STD_SUCCESS)
+    {
+        // The dropped segment reads as empty if its delete went through
+        if (segment_array_size == SENSOR_LOG_SEGMENT_COUNT)
+        {
+            memmove((void*)(&self->segment_array[1]), (const void*)(&self->segment_array[0]), (SENSOR_LOG_SEGMENT_COUNT - 1U) * sizeof(sensor_log_segment_t));
+
+            self->segment_array[0] = oldest_segment;
+        }
+
+        self->segment_array_size    = segment_array_size;
+        self->record_count          = record_count;
+
+        return STD_FAILURE;
+    }
+
+    return STD_SUCCESS;
+}
+
+int sensor_log_write (sensor_log_t * const self, sensor_log_record_t const * const records, size_t count, std_error_t * const error)
+{
+    char file_name[64];
+    sensor_log_get_file_name(self->segment_array[self->segment_array_size - 1U].id, file_name);
+
+    // One write and one sync for the whole buffer
+    if (storage_request_init(&self->request, STORAGE_APPEND_REQUEST, file_name, (const void*)(records), count * sizeof(sensor_log_record_t), error) != STD_SUCCESS)
+    {
+        return STD_FAILURE;
+    }
+
+    return sensor_log_submit(self, error);
+}
+
+int sensor_log_read (sensor_log_t * const self, uint32_t segment_id, size_t record_number,
+                        sensor_log_record_t * const records, size_t * const count, size_t max_count, std_error_t * const error)
+{
+    storage_t * const storage = self->config.storage;
+
+    *count = 0U;
+
+    char file_name[64];
+    sensor_log_get_file_name(segment_id, file_name);
+
+    // Lost to a power loss in the middle of a rotation - no records
+    if (storage_open_file(storage, &self->file, file_name, NULL) != STD_SUCCESS)
+    {
+        return STD_SUCCESS;
+    }
+
+    int exit_code = storage_seek_file(storage, &self->file, record_number * sizeof(sensor_log_record_t), error);
+
+    if (exit_code == STD_SUCCESS)
+    {
+        size_t size;
+
+        exit_code = storage_read_file(storage, &self->file, (char*)(records), &size, max_count * sizeof(sensor_log_record_t), error);
+
+        if (exit_code == STD_SUCCESS)
+        {
+            *count = size / sizeof(sensor_log_record_t);
+        }
+    }
+
+    storage_close_file(storage, &self->file, NULL);
+
+    return exit_code;
+}
+
+int sensor_log_get_segment_size (sensor_log_t * const self, uint32_t segment_id, size_t * const count, std_error_t * const error)
+{
+    storage_t * const storage = self->config.storage;
+
+    *count = 0U;
+
+    char file_name[64];
+    sensor_log_get_file_name(segment_id, file_name);
+
+    if (storage_open_file(storage, &self->file, file_name, NULL) != STD_SUCCESS)
+    {
+        return STD_SUCCESS;
+    }
+
+    size_t size;
+
+    const int exit_code = storage_get_file_size(storage, &self->file, &size, error);
+
+    storage_close_file(storage, &self->file, NULL);
+
+    if (exit_code == STD_SUCCESS)
+    {
+        *count = size / sizeof(sensor_log_record_t);
+    }
+
+    return exit_code;
+}
+
+int sensor_log_submit (sensor_log_t * const self, std_error_t * const error)
+{
+    // Queued ones are carried out in order, a rotation goes before the appends to its segment
+    if (self->config.request_callback != NULL)
+    {
+        return self->config.request_callback(&self->request, error);
+    }
+
+    return storage_request_execute(&self->request, self->config.storage, error);
+}
+
+void sensor_log_get_file_name (uint32_t segment_id, char file_name[64])
+{
+    char *name = file_name;
+
+    name += format_text(name, SEGMENT_FILE_NAME_PREFIX);
+    name += format_uint(name, segment_id);
+
+    return;
+}
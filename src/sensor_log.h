@@ -0,0 +1,119 @@
+/************************************************************
+ *   Author : German Mundinger
+ *   Date   : 2024
+ ************************************************************/
+
+#ifndef SENSOR_LOG_H
+#define SENSOR_LOG_H
+
+// Record: time (4) | sensor id (1) | reserved (1) | value * 10 (2), little endian as the MCU stores it
+#define SENSOR_LOG_RECORD_SIZE      8U
+#define SENSOR_LOG_VALUE_DIGITS     1U      // Fraction digits kept of a reading
+#define SENSOR_LOG_BUFFER_SIZE      32U     // Records held in RAM between two writes, a W25Q page
+#define SENSOR_LOG_SEGMENT_SIZE     512U    // Records of a segment file, a W25Q sector
+#define SENSOR_LOG_SEGMENT_COUNT    32U     // Segments kept, the oldest goes once a new one is needed
+#define SENSOR_LOG_CHUNK_SIZE       16U     // Records read at once by a query
+#define SENSOR_LOG_REQUEST_BURST    5U      // Queued by a flush at most: an append, a rotation (delete, index write, rename) and an append
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+typedef struct storage storage_t;
+typedef struct std_error std_error_t;
+
+typedef struct sensor_log_record
+{
+    uint32_t time_s;    // Never goes back
+    uint8_t sensor_id;
+    uint8_t reserved;
+    int16_t value;      // Scaled by SENSOR_LOG_VALUE_DIGITS
+
+} sensor_log_record_t;
+
+typedef struct storage_request storage_request_t;
+
+// Queues a write, an append, a rename or a delete to be carried out in order later (e.g. by the storage task).
+// A request that is not queued fails the flush, a rotation it was part of is undone.
+typedef int (*sensor_log_request_callback_t) (storage_request_t const * const request, std_error_t * const error);
+
+typedef struct sensor_log_config
+{
+    storage_t *storage;                             // Mounted, the caller serializes the access
+    sensor_log_request_callback_t request_callback; // NULL - everything is written in place, else the queries wait for the queue to drain
+
+} sensor_log_config_t;
+
+typedef struct sensor_log sensor_log_t;
+typedef struct sensor_log_cursor sensor_log_cursor_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Loads the segment index, an empty log if there is none
+int sensor_log_init (sensor_log_t * const self, sensor_log_config_t const * const config, std_error_t * const error);
+
+// Only copied to RAM, a full buffer goes to the W25Q with a single sync
+int sensor_log_append (sensor_log_t * const self, uint32_t time_s, uint8_t sensor_id, float value, std_error_t * const error);
+int sensor_log_flush (sensor_log_t * const self, std_error_t * const error);
+
+// The time of the latest record, buffered included (false - the log is empty)
+bool sensor_log_get_last_time (sensor_log_t const * const self, uint32_t * const time_s);
+
+// Records with from_s <= time_s <= to_s in time order, the buffered ones are flushed first
+int sensor_log_find (sensor_log_t * const self, sensor_log_cursor_t * const cursor, uint32_t from_s, uint32_t to_s, std_error_t * const error);
+int sensor_log_read_next (sensor_log_t * const self, sensor_log_cursor_t * const cursor, sensor_log_record_t * const record, bool * const is_record_valid, std_error_t * const error);
+
+float sensor_log_get_value (sensor_log_record_t const * const record);
+
+#ifdef __cplusplus
+}
+#endif
+
+
+
+// Private
+#include "storage.h"
+#include "storage_request.h"
+
+typedef struct sensor_log_segment
+{
+    uint32_t id;            // Names the file: "log.<id>"
+    uint32_t first_time_s;  // The sparse time index, one entry per segment
+
+} sensor_log_segment_t;
+
+typedef struct sensor_log
+{
+    sensor_log_config_t config;
+
+    sensor_log_segment_t segment_array[SENSOR_LOG_SEGMENT_COUNT];   // Oldest first
+    size_t segment_array_size;
+    size_t record_count;    // Written to the newest segment
+
+    sensor_log_record_t buffer[SENSOR_LOG_BUFFER_SIZE];
+    size_t buffer_size;
+
+    uint32_t last_time_s;
+    bool is_empty;
+
+    storage_file_t file;
+    storage_request_t request;
+
+} sensor_log_t;
+
+typedef struct sensor_log_cursor
+{
+    uint32_t segment_id;
+    size_t record_number;   // Of the next record in the segment
+    uint32_t to_s;
+    bool is_end;
+
+    sensor_log_record_t chunk[SENSOR_LOG_CHUNK_SIZE];
+    size_t chunk_size;
+    size_t chunk_position;
+
+} sensor_log_cursor_t;
+
+#endif // SENSOR_LOG_H
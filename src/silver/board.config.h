@@ -9,6 +9,7 @@
 // BlackPill-Silver config
 
 #define SRAM_SIZE   (64 * 1024) // 64 kB
+#define FLASH_MEMORY_SIZE   (256 * 1024)    // 256 kB
 
 // SysClock
 #define CONFIG_CLOCK_REGULATOR_SCALE PWR_REGULATOR_VOLTAGE_SCALE2
@@ -18,6 +19,13 @@
 #define CONFIG_CLOCK_PLLQ 7U
 #define CONFIG_CLOCK_FLASH_LATENCY FLASH_LATENCY_2
 
+// Storage (littlefs on the W25Q)
+#define CONFIG_STORAGE_READ_SIZE        16U
+#define CONFIG_STORAGE_PROG_SIZE        256U    // A whole W25Q page
+#define CONFIG_STORAGE_CACHE_SIZE       256U
+#define CONFIG_STORAGE_LOOKAHEAD_SIZE   128U    // All the 1024 sectors
+#define CONFIG_STORAGE_BLOCK_CYCLES     500
+
 // FreeRTOS
 #define CONFIG_RTOS_HEAP_SIZE ((size_t)(50 * 1024)) // 50 Kbytes
 
@@ -0,0 +1,82 @@
+/************************************************************
+ *   Author : German Mundinger
+ *   Date   : 2024
+ ************************************************************/
+
+#ifndef SPI_FAST_H
+#define SPI_FAST_H
+
+// Register level 8 bit full duplex master transfer, for the few bytes of a W5500 register access or a W25Q command:
+// no handle lock, no state machine, no tick reads. SPI_TypeDef and the SPI_SR_* / SPI_CR1_* bits come from
+// the includer - stm32f4xx.h on the target, a register model in the tests
+#define SPI_FAST_DUMMY_BYTE 0xFFU
+#define SPI_FAST_SPIN_LIMIT 10000U  // Per flag, a byte takes 16 CPU cycles at the /2 prescaler
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Either data pointer may be NULL for a one-way transfer
+static inline bool spi_fast_read_write (SPI_TypeDef * const spi, uint8_t const *tx_data, uint8_t *rx_data, uint16_t size)
+{
+    // HAL enables the peripheral on its first transfer and leaves it on, the fast path may come first
+    if ((spi->CR1 & SPI_CR1_SPE) != SPI_CR1_SPE)
+    {
+        spi->CR1 |= SPI_CR1_SPE;
+    }
+
+    // A byte left from a transmit only transfer would shift everything by one
+    if ((spi->SR & SPI_SR_RXNE) == SPI_SR_RXNE)
+    {
+        const uint32_t stale_byte = spi->DR;
+        (void)(stale_byte);
+    }
+
+    for (uint16_t i = 0U; i < size; ++i)
+    {
+        uint32_t spin = 0U;
+
+        while ((spi->SR & SPI_SR_TXE) != SPI_SR_TXE)
+        {
+            if (++spin == SPI_FAST_SPIN_LIMIT)
+            {
+                return false;
+            }
+        }
+
+        spi->DR = (tx_data != NULL) ? tx_data[i] : SPI_FAST_DUMMY_BYTE;
+
+        // One byte in flight: reading it back before the next one never lets RXNE overrun
+        spin = 0U;
+
+        while ((spi->SR & SPI_SR_RXNE) != SPI_SR_RXNE)
+        {
+            if (++spin == SPI_FAST_SPIN_LIMIT)
+            {
+                return false;
+            }
+        }
+
+        const uint8_t byte = (uint8_t)(spi->DR);
+
+        if (rx_data != NULL)
+        {
+            rx_data[i] = byte;
+        }
+    }
+
+    // The last clock edge is out, the chip select may go up
+    uint32_t spin = 0U;
+
+    while ((spi->SR & SPI_SR_BSY) == SPI_SR_BSY)
+    {
+        if (++spin == SPI_FAST_SPIN_LIMIT)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+#endif // SPI_FAST_H
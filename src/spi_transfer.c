@@ -0,0 +1,110 @@
+/************************************************************
+ *   Author : German Mundinger
+ *   Date   : 2024
+ ************************************************************/
+
+#include "spi_transfer.h"
+
+#include <assert.h>
+
+#include "std_error/std_error.h"
+
+
+#define TIMEOUT_ERROR_TEXT  "SPI transfer timeout"
+#define DMA_ERROR_TEXT      "SPI transfer DMA error"
+
+
+void spi_transfer_init (spi_transfer_t * const self, spi_transfer_config_t const * const config)
+{
+    assert(self                         != NULL);
+    assert(config                       != NULL);
+    assert(config->poll_callback        != NULL);
+    assert(config->start_callback       != NULL);
+    assert(config->wait_callback        != NULL);
+    assert(config->notify_ISR_callback  != NULL);
+    assert(config->abort_callback       != NULL);
+
+    self->config = *config;
+
+    self->is_busy       = false;
+    self->is_success    = true;
+
+    return;
+}
+
+int spi_transfer_submit (spi_transfer_t * const self, uint8_t *tx_data, uint8_t *rx_data, uint16_t size, uint32_t timeout_ms, std_error_t * const error)
+{
+    assert(self != NULL);
+    assert((tx_data != NULL) || (rx_data != NULL));
+
+    // One transfer on the bus at a time, in the order they come
+    if (spi_transfer_wait(self, timeout_ms, error) != STD_SUCCESS)
+    {
+        return STD_FAILURE;
+    }
+
+    if (size < self->config.dma_threshold)
+    {
+        return self->config.poll_callback(tx_data, rx_data, size, timeout_ms, error);
+    }
+
+    self->is_success    = false;
+    self->is_busy       = true;
+
+    if (self->config.start_callback(tx_data, rx_data, size, error) != STD_SUCCESS)
+    {
+        self->is_busy = false;
+
+        return STD_FAILURE;
+    }
+    return STD_SUCCESS;
+}
+
+int spi_transfer_wait (spi_transfer_t * const self, uint32_t timeout_ms, std_error_t * const error)
+{
+    assert(self != NULL);
+
+    if (self->is_busy != true)
+    {
+        return STD_SUCCESS;
+    }
+    self->is_busy = false;
+
+    if (self->config.wait_callback(timeout_ms) != true)
+    {
+        self->config.abort_callback();
+
+        std_error_catch_custom(error, STD_FAILURE, TIMEOUT_ERROR_TEXT, __FILE__, __LINE__);
+
+        return STD_FAILURE;
+    }
+
+    if (self->is_success != true)
+    {
+        std_error_catch_custom(error, STD_FAILURE, DMA_ERROR_TEXT, __FILE__, __LINE__);
+
+        return STD_FAILURE;
+    }
+    return STD_SUCCESS;
+}
+
+void spi_transfer_complete_ISR (spi_transfer_t * const self, bool is_success)
+{
+    assert(self != NULL);
+
+    // Only written here and read after the wait, the notification orders the two
+    self->is_success = is_success;
+
+    self->config.notify_ISR_callback();
+
+    return;
+}
+
+int spi_transfer_read_write (spi_transfer_t * const self, uint8_t *tx_data, uint8_t *rx_data, uint16_t size, uint32_t timeout_ms, std_error_t * const error)
+{
+    if (spi_transfer_submit(self, tx_data, rx_data, size, timeout_ms, error) != STD_SUCCESS)
+    {
+        return STD_FAILURE;
+    }
+    return spi_transfer_wait(self, timeout_ms, error);
+}
@@ -0,0 +1,70 @@
+/************************************************************
+ *   Author : German Mundinger
+ *   Date   : 2024
+ ************************************************************/
+
+#ifndef SPI_TRANSFER_H
+#define SPI_TRANSFER_H
+
+// At 42 Mbit/s a byte takes 0.2 us: below it, the DMA setup and the completion interrupt cost more than polling
+#define SPI_TRANSFER_DMA_THRESHOLD  32U
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct std_error std_error_t;
+
+// Either data pointer may be NULL for a one-way transfer
+typedef int (*spi_transfer_poll_callback_t) (uint8_t *tx_data, uint8_t *rx_data, uint16_t size, uint32_t timeout_ms, std_error_t * const error);
+typedef int (*spi_transfer_start_callback_t) (uint8_t *tx_data, uint8_t *rx_data, uint16_t size, std_error_t * const error);
+typedef bool (*spi_transfer_wait_callback_t) (uint32_t timeout_ms);
+typedef void (*spi_transfer_notify_callback_t) ();
+typedef void (*spi_transfer_abort_callback_t) ();
+
+typedef struct spi_transfer_config
+{
+    spi_transfer_poll_callback_t poll_callback;     // Blocking, for the short transfers
+    spi_transfer_start_callback_t start_callback;   // Starts DMA, the end comes to spi_transfer_complete_ISR()
+    spi_transfer_wait_callback_t wait_callback;     // Blocks the calling task until notified or the timeout
+    spi_transfer_notify_callback_t notify_ISR_callback;
+    spi_transfer_abort_callback_t abort_callback;   // Stops DMA after a timeout, a late completion must not wake the next wait
+
+    uint16_t dma_threshold;
+
+} spi_transfer_config_t;
+
+typedef struct spi_transfer spi_transfer_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void spi_transfer_init (spi_transfer_t * const self, spi_transfer_config_t const * const config);
+
+// Returns once DMA is started, a short transfer is polled right away; any transfer in flight is waited for first
+int spi_transfer_submit (spi_transfer_t * const self, uint8_t *tx_data, uint8_t *rx_data, uint16_t size, uint32_t timeout_ms, std_error_t * const error);
+int spi_transfer_wait (spi_transfer_t * const self, uint32_t timeout_ms, std_error_t * const error);
+
+// From the DMA or the SPI error interrupt
+void spi_transfer_complete_ISR (spi_transfer_t * const self, bool is_success);
+
+// Blocking, with the same contract as the poll callback: the chip select may go up right after it
+int spi_transfer_read_write (spi_transfer_t * const self, uint8_t *tx_data, uint8_t *rx_data, uint16_t size, uint32_t timeout_ms, std_error_t * const error);
+
+#ifdef __cplusplus
+}
+#endif
+
+
+
+// Private
+typedef struct spi_transfer
+{
+    spi_transfer_config_t config;
+
+    bool is_busy;
+    volatile bool is_success;
+
+} spi_transfer_t;
+
+#endif // SPI_TRANSFER_H
@@ -5,6 +5,8 @@
 
 #include "storage.h"
 
+#include <stdbool.h>
+#include <string.h>
 #include <assert.h>
 
 #include "logger.h"
@@ -13,29 +15,59 @@
 
 #define DEFAULT_ERROR_TEXT      "Storage error"
 #define DEFAULT_LFS_ERROR_TEXT  "Storage lfs error"
+#define TIMEOUT_ERROR_TEXT      "Storage pre-erase timeout"
+
+#define PRE_ERASE_POLL_PERIOD_MS    10U
+#define PRE_ERASE_TIMEOUT_MS        2000U   // Twice the worst block erase
 
 #define UNUSED(x) (void)(x)
-#define ARRAY_SIZE(array) (sizeof(array) / sizeof((array)[0]))
 
 
 static int storage_lfs_block_device_read (const struct lfs_config *config, lfs_block_t sector_number, lfs_off_t sector_offset, void *raw_data, lfs_size_t size);
 static int storage_lfs_block_device_prog (const struct lfs_config *config, lfs_block_t sector_number, lfs_off_t sector_offset, const void *raw_data, lfs_size_t size);
 static int storage_lfs_block_device_erase (const struct lfs_config *config, lfs_block_t sector_number);
 static int storage_lfs_block_device_sync (const struct lfs_config *config);
+static int storage_lfs_lock (const struct lfs_config *config);
+static int storage_lfs_unlock (const struct lfs_config *config);
+
+static bool storage_is_geometry_valid (storage_geometry_t const * const geometry, w25q32bv_flash_array_t const * const flash_array);
+static int storage_flush_stream (storage_t * const self, storage_stream_t * const stream, uint8_t const * const data, size_t size, std_error_t * const error);
+
+static int storage_mark_used_sector (void *context, lfs_block_t sector_number);
+static bool storage_is_pre_erase_needed (storage_t const * const self, uint32_t first_sector, uint32_t sector_count);
+static int storage_start_pre_erase (storage_t * const self, bool * const is_started, std_error_t * const error);
+static int storage_wait_pre_erase (storage_t * const self, storage_wait_callback_t wait_callback, bool * const is_woken_up, std_error_t * const error);
+static int storage_start_erase (storage_t * const self, uint32_t first_sector, uint32_t sector_count, std_error_t * const error);
+static int storage_suspend_erase (storage_t * const self);
+static int storage_resume_erase (storage_t * const self);
+static int storage_finish_erase (storage_t * const self);
+static void storage_complete_erase (storage_t * const self);
+static bool storage_is_sector_marked (uint8_t const * const sector_map, uint32_t sector_number);
+static void storage_mark_sector (uint8_t * const sector_map, uint32_t sector_number, bool is_marked);
 
 int storage_init (storage_t * const self, storage_config_t const * const config, std_error_t * const error)
 {
     assert(config                           != NULL);
+    assert(config->lock_callback            != NULL);
+    assert(config->unlock_callback          != NULL);
     assert(config->spi_lock_callback        != NULL);
     assert(config->spi_unlock_callback      != NULL);
     assert(config->spi_select_callback      != NULL);
     assert(config->spi_unselect_callback    != NULL);
     assert(config->spi_tx_rx_callback       != NULL);
     assert(config->delay_callback           != NULL);
+    assert(config->yield_callback           != NULL);
+    assert(config->get_cycles_callback      != NULL);
 
     self->config = *config;
 
-    LOG("Storage [w25q] : init (W25Q32BV)\r\n");
+    memset((void*)(self->erased_sector_map), 0, sizeof(self->erased_sector_map));
+    self->is_mounted            = false;
+    self->erasing_sector_count  = 0U;
+    self->is_erase_suspended    = false;
+    self->lock_depth            = 0U;
+
+    LOG("Storage [w25q] : init\r\n");
 
     w25q32bv_flash_config_t flash_config;
     flash_config.spi_lock_callback      = self->config.spi_lock_callback;
@@ -45,6 +77,9 @@ int storage_init (storage_t * const self, storage_config_t const * const config,
     flash_config.spi_tx_rx_callback     = self->config.spi_tx_rx_callback;
     flash_config.spi_timeout_ms         = self->config.spi_timeout_ms;
     flash_config.delay_callback         = self->config.delay_callback;
+    flash_config.yield_callback         = self->config.yield_callback;
+    flash_config.get_cycles_callback    = self->config.get_cycles_callback;
+    flash_config.cycles_per_us          = self->config.cycles_per_us;
 
     w25q32bv_flash_init(&self->w25q32bv_flash, &flash_config);
 
@@ -59,18 +94,39 @@ int storage_init (storage_t * const self, storage_config_t const * const config,
         return exit_code;
     }
 
-    LOG("Storage [w25q] : read info\r\n");
+    LOG("Storage [w25q] : detect\r\n");
+
+    exit_code = w25q32bv_flash_detect(&self->w25q32bv_flash, error);
+
+    if (exit_code != STD_SUCCESS)
+    {
+        LOG("Storage [w25q] : %s\r\n", error->text);
+
+        return exit_code;
+    }
 
+    // littlefs takes the part as it is
     w25q32bv_flash_array_t flash_array;
     w25q32bv_flash_get_array(&self->w25q32bv_flash, &flash_array);
 
+    if (storage_is_geometry_valid(&self->config.geometry, &flash_array) != true)
+    {
+        std_error_catch_invalid_argument(error, __FILE__, __LINE__);
+
+        LOG("Storage [lfs] : %s\r\n", error->text);
+
+        return STD_FAILURE;
+    }
+
+    LOG("Storage [w25q] : read info\r\n");
+
     w25q32bv_flash_info_t flash_info;
     exit_code = w25q32bv_flash_read_info(&self->w25q32bv_flash, &flash_info, error);
 
     if (exit_code != STD_FAILURE)
     {
-        LOG("Storage [w25q] : JEDEC ID = 0x%lX\r\n", flash_info.jedec_id);
-        LOG("Storage [w25q] : capacity = %lu KBytes\r\n", flash_info.capacity_KByte);
+        LOG("Storage [w25q] : JEDEC ID = 0x%lX\r\n", (unsigned long)(flash_info.jedec_id));
+        LOG("Storage [w25q] : capacity = %lu KBytes\r\n", (unsigned long)(flash_info.capacity_KByte));
     }
     else
     {
@@ -88,17 +144,17 @@ int storage_init (storage_t * const self, storage_config_t const * const config,
     self->lfs_config.prog       = storage_lfs_block_device_prog;
     self->lfs_config.erase      = storage_lfs_block_device_erase;
     self->lfs_config.sync       = storage_lfs_block_device_sync;
-    //self->lfs_config.lock       = storage_lfs_block_device_lock;
-    //self->lfs_config.unlock     = storage_lfs_block_device_unlock;
+    self->lfs_config.lock       = storage_lfs_lock;
+    self->lfs_config.unlock     = storage_lfs_unlock;
     self->lfs_config.context    = (void*)self;
     
-    self->lfs_config.read_size      = LFS_MIN_READ_BLOCK_SIZE;
-    self->lfs_config.prog_size      = LFS_MIN_PROG_BLOCK_SIZE;
+    self->lfs_config.read_size      = self->config.geometry.read_size;
+    self->lfs_config.prog_size      = self->config.geometry.prog_size;
     self->lfs_config.block_size     = flash_array.sector_size;
     self->lfs_config.block_count    = flash_array.sector_count;
-    self->lfs_config.cache_size     = LFS_CACHE_SIZE;
-    self->lfs_config.lookahead_size = LFS_LOOKAHEAD_SIZE;
-    self->lfs_config.block_cycles   = LFS_ERASE_CYCLES;
+    self->lfs_config.cache_size     = self->config.geometry.cache_size;
+    self->lfs_config.lookahead_size = self->config.geometry.lookahead_size;
+    self->lfs_config.block_cycles   = self->config.geometry.block_cycles;
 
     self->lfs_config.read_buffer        = self->lfs_read_buffer;
     self->lfs_config.prog_buffer        = self->lfs_prog_buffer;
@@ -137,12 +193,37 @@ int storage_init (storage_t * const self, storage_config_t const * const config,
     return exit_code;
 }
 
+bool storage_is_geometry_valid (storage_geometry_t const * const geometry, w25q32bv_flash_array_t const * const flash_array)
+{
+    if ((geometry->read_size == 0U) || (geometry->prog_size == 0U) || (geometry->cache_size == 0U) || (geometry->lookahead_size == 0U))
+    {
+        return false;
+    }
+
+    if ((geometry->cache_size > STORAGE_CACHE_SIZE_MAX) || (geometry->lookahead_size > STORAGE_LOOKAHEAD_SIZE_MAX) ||
+        (flash_array->sector_count > STORAGE_SECTOR_COUNT_MAX))
+    {
+        return false;
+    }
+
+    if (((geometry->cache_size % geometry->read_size) != 0U) || ((geometry->cache_size % geometry->prog_size) != 0U) ||
+        ((flash_array->sector_size % geometry->cache_size) != 0U) || ((flash_array->page_size % geometry->prog_size) != 0U))
+    {
+        return false;
+    }
+
+    return ((geometry->lookahead_size % 8U) == 0U);
+}
+
 
 int storage_enable_power (storage_t * const self, std_error_t * const error)
 {
     LOG("Storage [w25q] : release power down\r\n");
 
+    // Not in the middle of a littlefs call of another task
+    self->config.lock_callback();
     const int exit_code = w25q32bv_flash_release_power_down(&self->w25q32bv_flash, error);
+    self->config.unlock_callback();
 
     if (exit_code != STD_SUCCESS)
     {
@@ -156,7 +237,11 @@ int storage_disable_power (storage_t * const self, std_error_t * const error)
 {
     LOG("Storage [w25q] : power down\r\n");
 
+    // Not in the middle of a littlefs call of another task, nor of a pre-erase
+    self->config.lock_callback();
+    storage_finish_erase(self);
     const int exit_code = w25q32bv_flash_power_down(&self->w25q32bv_flash, error);
+    self->config.unlock_callback();
 
     if (exit_code != STD_SUCCESS)
     {
@@ -172,8 +257,17 @@ int storage_mount_filesystem (storage_t * const self, std_error_t * const error)
 
     LOG("Storage [lfs] : mount\r\n");
 
+    // Not in the middle of a pre-erase of another task
+    self->lfs_config.lock(&self->lfs_config);
+
     const enum lfs_error lfs_error = (enum lfs_error)lfs_mount(&self->lfs, &self->lfs_config);
 
+    // Nobody knows what was programmed while unmounted
+    memset((void*)(self->erased_sector_map), 0, sizeof(self->erased_sector_map));
+    self->is_mounted = (lfs_error == LFS_ERR_OK);
+
+    self->lfs_config.unlock(&self->lfs_config);
+
     if (lfs_error != LFS_ERR_OK)
     {
         LOG("Storage [lfs] : mount failure = %d\r\n", lfs_error);
@@ -191,7 +285,12 @@ int storage_unmount_filesystem (storage_t * const self, std_error_t * const erro
 
     LOG("Storage [lfs] : unmount\r\n");
 
+    self->lfs_config.lock(&self->lfs_config);
+
     const enum lfs_error lfs_error = (enum lfs_error)lfs_unmount(&self->lfs);
+    self->is_mounted = false;
+
+    self->lfs_config.unlock(&self->lfs_config);
 
     if (lfs_error != LFS_ERR_OK)
     {
@@ -249,6 +348,29 @@ int storage_open_file (storage_t * const self, storage_file_t * const file, cons
     return exit_code;
 }
 
+int storage_open_file_to_append (storage_t * const self, storage_file_t * const file, const char file_name[64], std_error_t * const error)
+{
+    int exit_code = STD_SUCCESS;
+
+    LOG("Storage [lfs] : open file to append\r\n");
+
+    file->config.buffer     = (void*)file->lfs_file_buffer;
+    file->config.attr_count = 0U;
+
+    // Created if missing, never truncated
+    enum lfs_error lfs_error = (enum lfs_error)lfs_file_opencfg(&self->lfs, &file->file, file_name, LFS_O_WRONLY | LFS_O_CREAT | LFS_O_APPEND, &file->config);
+
+    if (lfs_error != LFS_ERR_OK)
+    {
+        LOG("Storage [lfs] : file error = %d\r\n", lfs_error);
+
+        exit_code = STD_FAILURE;
+        std_error_catch_custom(error, (int)(lfs_error), DEFAULT_LFS_ERROR_TEXT, __FILE__, __LINE__);
+    }
+
+    return exit_code;
+}
+
 int storage_close_file (storage_t * const self, storage_file_t * const file, std_error_t * const error)
 {
     int exit_code = STD_SUCCESS;
@@ -287,6 +409,26 @@ int storage_remove_file (storage_t * const self, const char file_name[64], std_e
     return exit_code;
 }
 
+int storage_rename_file (storage_t * const self, const char old_file_name[64], const char new_file_name[64], std_error_t * const error)
+{
+    int exit_code = STD_SUCCESS;
+
+    LOG("Storage [lfs] : rename file\r\n");
+
+    // Atomic: the new name either keeps its old content or gets the whole new one
+    enum lfs_error lfs_error = (enum lfs_error)lfs_rename(&self->lfs, old_file_name, new_file_name);
+
+    if (lfs_error != LFS_ERR_OK)
+    {
+        LOG("Storage [lfs] : file error = %d\r\n", lfs_error);
+
+        exit_code = STD_FAILURE;
+        std_error_catch_custom(error, (int)(lfs_error), DEFAULT_LFS_ERROR_TEXT, __FILE__, __LINE__);
+    }
+
+    return exit_code;
+}
+
 
 int storage_write_file (storage_t * const self, storage_file_t * const file, char const * const data, size_t size, std_error_t * const error)
 {
@@ -296,7 +438,7 @@ int storage_write_file (storage_t * const self, storage_file_t * const file, cha
 
     if (bytes_written < 0)
     {
-        LOG("Storage [lfs] : file error = %ld\r\n", bytes_written);
+        LOG("Storage [lfs] : file error = %ld\r\n", (long)(bytes_written));
 
         std_error_catch_custom(error, (int)(bytes_written), DEFAULT_LFS_ERROR_TEXT, __FILE__, __LINE__);
 
@@ -304,7 +446,7 @@ int storage_write_file (storage_t * const self, storage_file_t * const file, cha
     }
     else
     {
-        LOG("Board [lfs] : bytes written = %ld\r\n", bytes_written);
+        LOG("Board [lfs] : bytes written = %ld\r\n", (long)(bytes_written));
     }
 
     int exit_code = STD_SUCCESS;
@@ -334,14 +476,14 @@ int storage_read_file (storage_t * const self, storage_file_t * const file, char
 
     if (bytes_read < 0)
     {
-        LOG("Storage [lfs] : file error = %ld\r\n", bytes_read);
+        LOG("Storage [lfs] : file error = %ld\r\n", (long)(bytes_read));
 
         exit_code = STD_FAILURE;
         std_error_catch_custom(error, (int)(bytes_read), DEFAULT_LFS_ERROR_TEXT, __FILE__, __LINE__);
     }
     else
     {
-        LOG("Board [lfs] : bytes read = %ld\r\n", bytes_read);
+        LOG("Board [lfs] : bytes read = %ld\r\n", (long)(bytes_read));
 
         *size = (size_t)bytes_read;
     }
@@ -349,6 +491,25 @@ int storage_read_file (storage_t * const self, storage_file_t * const file, char
     return exit_code;
 }
 
+int storage_seek_file (storage_t * const self, storage_file_t * const file, size_t position, std_error_t * const error)
+{
+    int exit_code = STD_SUCCESS;
+
+    LOG("Storage [lfs] : seek file\r\n");
+
+    const lfs_soff_t file_position = lfs_file_seek(&self->lfs, &file->file, (lfs_soff_t)(position), LFS_SEEK_SET);
+
+    if (file_position < 0)
+    {
+        LOG("Storage [lfs] : file error = %ld\r\n", (long)(file_position));
+
+        exit_code = STD_FAILURE;
+        std_error_catch_custom(error, (int)(file_position), DEFAULT_LFS_ERROR_TEXT, __FILE__, __LINE__);
+    }
+
+    return exit_code;
+}
+
 int storage_get_file_size (storage_t * const self, storage_file_t * const file, size_t * const size, std_error_t * const error)
 {
     int exit_code = STD_SUCCESS;
@@ -361,14 +522,14 @@ int storage_get_file_size (storage_t * const self, storage_file_t * const file,
 
     if (file_size < 0)
     {
-        LOG("Storage [lfs] : file error = %ld\r\n", file_size);
+        LOG("Storage [lfs] : file error = %ld\r\n", (long)(file_size));
 
         exit_code = STD_FAILURE;
         std_error_catch_custom(error, (int)(file_size), DEFAULT_LFS_ERROR_TEXT, __FILE__, __LINE__);
     }
     else
     {
-        LOG("Board [lfs] : bytes read = %ld\r\n", file_size);
+        LOG("Board [lfs] : bytes read = %ld\r\n", (long)(file_size));
 
         *size = (size_t)file_size;
     }
@@ -377,6 +538,491 @@ int storage_get_file_size (storage_t * const self, storage_file_t * const file,
 }
 
 
+int storage_create_stream (storage_t * const self, storage_stream_t * const stream, const char file_name[64], size_t checkpoint_size, std_error_t * const error)
+{
+    assert(self         != NULL);
+    assert(stream       != NULL);
+    assert(file_name    != NULL);
+
+    stream->buffer_size     = 0U;
+    stream->checkpoint_size = checkpoint_size;
+    stream->unsynced_size   = 0U;
+    stream->total_size      = 0U;
+
+    return storage_create_file(self, &stream->file, file_name, error);
+}
+
+int storage_write_stream (storage_t * const self, storage_stream_t * const stream, uint8_t const * const data, size_t size, std_error_t * const error)
+{
+    assert(self     != NULL);
+    assert(stream   != NULL);
+    assert(data     != NULL);
+
+    const size_t prog_size = (size_t)(self->lfs_config.prog_size);
+
+    size_t offset = 0U;
+
+    // Top up the partial page first
+    if (stream->buffer_size != 0U)
+    {
+        size_t size_to_copy = prog_size - stream->buffer_size;
+
+        if (size_to_copy > size)
+        {
+            size_to_copy = size;
+        }
+
+        memcpy((void*)(&stream->buffer[stream->buffer_size]), (const void*)(data), size_to_copy);
+        stream->buffer_size += size_to_copy;
+        offset              += size_to_copy;
+
+        if (stream->buffer_size != prog_size)
+        {
+            return STD_SUCCESS;
+        }
+
+        if (storage_flush_stream(self, stream, stream->buffer, stream->buffer_size, error) != STD_SUCCESS)
+        {
+            return STD_FAILURE;
+        }
+        stream->buffer_size = 0U;
+    }
+
+    // Whole pages go to littlefs straight from the caller buffer
+    const size_t page_aligned_size = ((size - offset) / prog_size) * prog_size;
+
+    if (page_aligned_size != 0U)
+    {
+        if (storage_flush_stream(self, stream, &data[offset], page_aligned_size, error) != STD_SUCCESS)
+        {
+            return STD_FAILURE;
+        }
+        offset += page_aligned_size;
+    }
+
+    memcpy((void*)(stream->buffer), (const void*)(&data[offset]), size - offset);
+    stream->buffer_size = size - offset;
+
+    return STD_SUCCESS;
+}
+
+int storage_close_stream (storage_t * const self, storage_stream_t * const stream, size_t * const size, std_error_t * const error)
+{
+    assert(self     != NULL);
+    assert(stream   != NULL);
+    assert(size     != NULL);
+
+    int exit_code = STD_SUCCESS;
+
+    if (stream->buffer_size != 0U)
+    {
+        exit_code = storage_flush_stream(self, stream, stream->buffer, stream->buffer_size, error);
+        stream->buffer_size = 0U;
+    }
+
+    *size = stream->total_size;
+
+    LOG("Storage [lfs] : stream size = %u bytes\r\n", (unsigned int)(stream->total_size));
+
+    // Closing commits the last checkpoint
+    if (storage_close_file(self, &stream->file, error) != STD_SUCCESS)
+    {
+        exit_code = STD_FAILURE;
+    }
+
+    return exit_code;
+}
+
+int storage_pre_erase (storage_t * const self, size_t max_erase_count, storage_wait_callback_t wait_callback,
+                        size_t * const erase_count, std_error_t * const error)
+{
+    assert(self         != NULL);
+    assert(erase_count  != NULL);
+
+    *erase_count = 0U;
+
+    int exit_code = STD_SUCCESS;
+
+    while ((max_erase_count == 0U) || (*erase_count < max_erase_count))
+    {
+        bool is_started;
+        exit_code = storage_start_pre_erase(self, &is_started, error);
+
+        if ((exit_code != STD_SUCCESS) || (is_started != true))
+        {
+            break;
+        }
+        ++(*erase_count);
+
+        // The lock is free meanwhile, littlefs suspends the erase whenever it needs the flash
+        bool is_woken_up;
+        exit_code = storage_wait_pre_erase(self, wait_callback, &is_woken_up, error);
+
+        if ((exit_code != STD_SUCCESS) || (is_woken_up == true))
+        {
+            break;
+        }
+    }
+
+    if (exit_code != STD_SUCCESS)
+    {
+        LOG("Storage [w25q] : pre-erase failure = %s\r\n", error->text);
+    }
+
+    return exit_code;
+}
+
+int storage_flush_stream (storage_t * const self, storage_stream_t * const stream, uint8_t const * const data, size_t size, std_error_t * const error)
+{
+    const lfs_ssize_t bytes_written = lfs_file_write(&self->lfs, &stream->file.file, (const void*)data, (lfs_size_t)size);
+
+    if (bytes_written != (lfs_ssize_t)(size))
+    {
+        LOG("Storage [lfs] : stream error = %ld\r\n", (long)(bytes_written));
+
+        const int lfs_error = (bytes_written < 0) ? (int)(bytes_written) : (int)(LFS_ERR_NOSPC);
+        std_error_catch_custom(error, lfs_error, DEFAULT_LFS_ERROR_TEXT, __FILE__, __LINE__);
+
+        return STD_FAILURE;
+    }
+
+    stream->total_size      += size;
+    stream->unsynced_size   += size;
+
+    if ((stream->checkpoint_size != 0U) && (stream->unsynced_size >= stream->checkpoint_size))
+    {
+        stream->unsynced_size = 0U;
+
+        const enum lfs_error lfs_error = (enum lfs_error)lfs_file_sync(&self->lfs, &stream->file.file);
+
+        if (lfs_error != LFS_ERR_OK)
+        {
+            LOG("Storage [lfs] : stream error = %d\r\n", lfs_error);
+
+            std_error_catch_custom(error, (int)(lfs_error), DEFAULT_LFS_ERROR_TEXT, __FILE__, __LINE__);
+
+            return STD_FAILURE;
+        }
+    }
+
+    return STD_SUCCESS;
+}
+
+
+
+int storage_mark_used_sector (void *context, lfs_block_t sector_number)
+{
+    storage_t *self = (storage_t*)context;
+
+    if ((uint32_t)(sector_number) < self->lfs_config.block_count)
+    {
+        storage_mark_sector(self->used_sector_map, (uint32_t)(sector_number), true);
+    }
+
+    return (int)(LFS_ERR_OK);
+}
+
+bool storage_is_pre_erase_needed (storage_t const * const self, uint32_t first_sector, uint32_t sector_count)
+{
+    bool is_erased = true;
+
+    for (uint32_t sector_number = first_sector; sector_number < (first_sector + sector_count); ++sector_number)
+    {
+        if (storage_is_sector_marked(self->used_sector_map, sector_number) == true)
+        {
+            return false;
+        }
+        is_erased = is_erased && storage_is_sector_marked(self->erased_sector_map, sector_number);
+    }
+
+    return (is_erased != true);
+}
+
+int storage_start_pre_erase (storage_t * const self, bool * const is_started, std_error_t * const error)
+{
+    *is_started = false;
+
+    // littlefs allocates nothing in between the traverse and the erase command
+    self->lfs_config.lock(&self->lfs_config);
+
+    if (self->is_mounted != true)
+    {
+        self->lfs_config.unlock(&self->lfs_config);
+
+        return STD_SUCCESS;
+    }
+
+    // Left going by a woken up wait, not over yet
+    if (self->erasing_sector_count != 0U)
+    {
+        self->lfs_config.unlock(&self->lfs_config);
+
+        *is_started = true;
+
+        return STD_SUCCESS;
+    }
+
+    memset((void*)(self->used_sector_map), 0, sizeof(self->used_sector_map));
+
+    // Every block of the tree and of the open files, the very way the littlefs allocator sees them
+    const enum lfs_error lfs_error = (enum lfs_error)lfs_fs_traverse(&self->lfs, storage_mark_used_sector, (void*)self);
+
+    if (lfs_error != LFS_ERR_OK)
+    {
+        self->lfs_config.unlock(&self->lfs_config);
+
+        LOG("Storage [lfs] : traverse failure = %d\r\n", lfs_error);
+
+        std_error_catch_custom(error, (int)(lfs_error), DEFAULT_LFS_ERROR_TEXT, __FILE__, __LINE__);
+
+        return STD_FAILURE;
+    }
+
+    w25q32bv_flash_array_t flash_array;
+    w25q32bv_flash_get_array(&self->w25q32bv_flash, &flash_array);
+
+    const uint32_t block_sector_count       = flash_array.block_size / flash_array.sector_size;
+    const uint32_t half_block_sector_count  = block_sector_count / 2U;
+
+    uint32_t first_sector = 0U;
+    uint32_t sector_count = 0U;
+
+    for (uint32_t block_number = 0U; (block_number < flash_array.block_count) && (sector_count == 0U); ++block_number)
+    {
+        const uint32_t low_first_sector     = block_number * block_sector_count;
+        const uint32_t high_first_sector    = low_first_sector + half_block_sector_count;
+
+        const bool is_low_half_needed   = storage_is_pre_erase_needed(self, low_first_sector, half_block_sector_count);
+        const bool is_high_half_needed  = storage_is_pre_erase_needed(self, high_first_sector, half_block_sector_count);
+
+        // The whole block for the time of a half one, a half one keeps the wear off its blank neighbour
+        if ((is_low_half_needed == true) && (is_high_half_needed == true))
+        {
+            first_sector = low_first_sector;
+            sector_count = block_sector_count;
+        }
+        else if (is_low_half_needed == true)
+        {
+            first_sector = low_first_sector;
+            sector_count = half_block_sector_count;
+        }
+        else if (is_high_half_needed == true)
+        {
+            first_sector = high_first_sector;
+            sector_count = half_block_sector_count;
+        }
+    }
+
+    int exit_code = STD_SUCCESS;
+
+    if (sector_count != 0U)
+    {
+        exit_code   = storage_start_erase(self, first_sector, sector_count, error);
+        *is_started = (exit_code == STD_SUCCESS);
+    }
+
+    self->lfs_config.unlock(&self->lfs_config);
+
+    return exit_code;
+}
+
+int storage_wait_pre_erase (storage_t * const self, storage_wait_callback_t wait_callback, bool * const is_woken_up, std_error_t * const error)
+{
+    *is_woken_up = false;
+
+    uint32_t elapsed_ms = 0U;
+
+    while (true)
+    {
+        if (wait_callback != NULL)
+        {
+            *is_woken_up = wait_callback(PRE_ERASE_POLL_PERIOD_MS);
+        }
+        else
+        {
+            self->config.delay_callback(PRE_ERASE_POLL_PERIOD_MS);
+        }
+        elapsed_ms += PRE_ERASE_POLL_PERIOD_MS;
+
+        // The caller has a littlefs call to make, it suspends the erase
+        if (*is_woken_up == true)
+        {
+            return STD_SUCCESS;
+        }
+
+        self->lfs_config.lock(&self->lfs_config);
+
+        int exit_code   = STD_SUCCESS;
+        bool is_busy    = false;
+
+        // Finished by littlefs in between otherwise
+        if (self->erasing_sector_count != 0U)
+        {
+            exit_code = w25q32bv_flash_read_busy(&self->w25q32bv_flash, &is_busy, error);
+
+            if ((exit_code == STD_SUCCESS) && (is_busy != true))
+            {
+                storage_complete_erase(self);
+            }
+        }
+
+        if ((exit_code == STD_SUCCESS) && (is_busy == true) && (elapsed_ms >= PRE_ERASE_TIMEOUT_MS))
+        {
+            self->erasing_sector_count = 0U;
+
+            std_error_catch_custom(error, STD_FAILURE, TIMEOUT_ERROR_TEXT, __FILE__, __LINE__);
+            exit_code = STD_FAILURE;
+        }
+
+        self->lfs_config.unlock(&self->lfs_config);
+
+        if ((exit_code != STD_SUCCESS) || (is_busy != true))
+        {
+            return exit_code;
+        }
+    }
+}
+
+int storage_start_erase (storage_t * const self, uint32_t first_sector, uint32_t sector_count, std_error_t * const error)
+{
+    const w25q32bv_flash_t *flash = &self->w25q32bv_flash;
+
+    w25q32bv_flash_array_t flash_array;
+    w25q32bv_flash_get_array(flash, &flash_array);
+
+    const uint32_t address = first_sector * flash_array.sector_size;
+
+    int exit_code = w25q32bv_flash_enable_erasing_or_writing(flash, error);
+
+    if (exit_code != STD_FAILURE)
+    {
+        if ((sector_count * flash_array.sector_size) == flash_array.block_size)
+        {
+            exit_code = w25q32bv_flash_erase_block(flash, address / flash_array.block_size, error);
+        }
+        else
+        {
+            exit_code = w25q32bv_flash_erase_half_block(flash, address / (flash_array.block_size / 2U), error);
+        }
+    }
+
+    if (exit_code != STD_SUCCESS)
+    {
+        return STD_FAILURE;
+    }
+
+    self->erasing_first_sector  = first_sector;
+    self->erasing_sector_count  = sector_count;
+    self->is_erase_suspended    = false;
+
+    return STD_SUCCESS;
+}
+
+int storage_suspend_erase (storage_t * const self)
+{
+    if ((self->erasing_sector_count == 0U) || (self->is_erase_suspended == true))
+    {
+        return STD_SUCCESS;
+    }
+
+    bool is_suspended;
+
+    if (w25q32bv_flash_suspend_erasing(&self->w25q32bv_flash, &is_suspended, NULL) != STD_SUCCESS)
+    {
+        return STD_FAILURE;
+    }
+
+    if (is_suspended == true)
+    {
+        self->is_erase_suspended = true;
+    }
+    else
+    {
+        // Over before the command
+        storage_complete_erase(self);
+    }
+
+    return STD_SUCCESS;
+}
+
+int storage_resume_erase (storage_t * const self)
+{
+    if (self->is_erase_suspended != true)
+    {
+        return STD_SUCCESS;
+    }
+
+    self->is_erase_suspended = false;
+
+    return w25q32bv_flash_resume_erasing(&self->w25q32bv_flash, NULL);
+}
+
+int storage_finish_erase (storage_t * const self)
+{
+    if (self->erasing_sector_count == 0U)
+    {
+        return STD_SUCCESS;
+    }
+
+    w25q32bv_flash_array_t flash_array;
+    w25q32bv_flash_get_array(&self->w25q32bv_flash, &flash_array);
+
+    const bool is_block = ((self->erasing_sector_count * flash_array.sector_size) == flash_array.block_size);
+    const w25q32bv_flash_operation_t operation = (is_block == true) ? BLOCK_ERASE_W25Q32BV_OPERATION : HALF_BLOCK_ERASE_W25Q32BV_OPERATION;
+
+    int exit_code = storage_resume_erase(self);
+
+    if (exit_code != STD_FAILURE)
+    {
+        exit_code = w25q32bv_flash_wait_erasing_or_writing(&self->w25q32bv_flash, operation, NULL);
+    }
+
+    if (exit_code != STD_SUCCESS)
+    {
+        self->erasing_sector_count = 0U;
+
+        return STD_FAILURE;
+    }
+
+    storage_complete_erase(self);
+
+    return STD_SUCCESS;
+}
+
+void storage_complete_erase (storage_t * const self)
+{
+    const uint32_t last_sector = self->erasing_first_sector + self->erasing_sector_count;
+
+    for (uint32_t sector_number = self->erasing_first_sector; sector_number < last_sector; ++sector_number)
+    {
+        storage_mark_sector(self->erased_sector_map, sector_number, true);
+    }
+
+    self->erasing_sector_count  = 0U;
+    self->is_erase_suspended    = false;
+
+    return;
+}
+
+bool storage_is_sector_marked (uint8_t const * const sector_map, uint32_t sector_number)
+{
+    return ((sector_map[sector_number / 8U] & (uint8_t)(1U << (sector_number % 8U))) != 0U);
+}
+
+void storage_mark_sector (uint8_t * const sector_map, uint32_t sector_number, bool is_marked)
+{
+    if (is_marked == true)
+    {
+        sector_map[sector_number / 8U] |= (uint8_t)(1U << (sector_number % 8U));
+    }
+    else
+    {
+        sector_map[sector_number / 8U] &= (uint8_t)(~(1U << (sector_number % 8U)));
+    }
+
+    return;
+}
+
 
 int storage_lfs_block_device_read ( const struct lfs_config *config,
                                     lfs_block_t sector_number,
@@ -384,9 +1030,15 @@ int storage_lfs_block_device_read ( const struct lfs_config *config,
                                     void *raw_data,
                                     lfs_size_t size)
 {
-    const storage_t *storage = (const storage_t*)config->context;
+    storage_t *storage = (storage_t*)config->context;
     const w25q32bv_flash_t *flash = &storage->w25q32bv_flash;
 
+    // Readable again within microseconds, resumed once littlefs lets go of the lock
+    if (storage_suspend_erase(storage) != STD_SUCCESS)
+    {
+        return (int)(LFS_ERR_IO);
+    }
+
     const int exit_code = w25q32bv_flash_read_data_fast(flash, (uint8_t*)raw_data, (uint32_t)size, (uint32_t)sector_number, (uint32_t)sector_offset, NULL);
 
     if (exit_code != STD_SUCCESS)
@@ -402,9 +1054,17 @@ int storage_lfs_block_device_prog ( const struct lfs_config *config,
                                     const void *raw_data,
                                     lfs_size_t size)
 {
-    const storage_t *storage = (const storage_t*)config->context;
+    storage_t *storage = (storage_t*)config->context;
     const w25q32bv_flash_t *flash = &storage->w25q32bv_flash;
 
+    if (storage_suspend_erase(storage) != STD_SUCCESS)
+    {
+        return (int)(LFS_ERR_IO);
+    }
+
+    // Not blank any more, the next erase is a real one
+    storage_mark_sector(storage->erased_sector_map, (uint32_t)(sector_number), false);
+
     int exit_code = STD_FAILURE;
 
     w25q32bv_flash_array_t flash_array;
@@ -434,7 +1094,7 @@ int storage_lfs_block_device_prog ( const struct lfs_config *config,
 
             if (exit_code != STD_FAILURE)
             {
-                exit_code = w25q32bv_flash_wait_erasing_or_writing(flash, NULL);
+                exit_code = w25q32bv_flash_wait_erasing_or_writing(flash, PAGE_PROGRAM_W25Q32BV_OPERATION, NULL);
 
                 if (exit_code != STD_FAILURE)
                 {
@@ -477,9 +1137,21 @@ int storage_lfs_block_device_prog ( const struct lfs_config *config,
 int storage_lfs_block_device_erase (const struct lfs_config *config,
                                     lfs_block_t sector_number)
 {
-    const storage_t *storage = (const storage_t*)config->context;
+    storage_t *storage = (storage_t*)config->context;
     const w25q32bv_flash_t *flash = &storage->w25q32bv_flash;
 
+    // No erase while another one is suspended, the sector may be in there anyway
+    if (storage_finish_erase(storage) != STD_SUCCESS)
+    {
+        return (int)(LFS_ERR_IO);
+    }
+
+    // Still blank since a pre-erase
+    if (storage_is_sector_marked(storage->erased_sector_map, (uint32_t)(sector_number)) == true)
+    {
+        return (int)(LFS_ERR_OK);
+    }
+
     int exit_code = w25q32bv_flash_enable_erasing_or_writing(flash, NULL);
 
     if (exit_code != STD_FAILURE)
@@ -488,7 +1160,7 @@ int storage_lfs_block_device_erase (const struct lfs_config *config,
 
         if (exit_code != STD_FAILURE)
         {
-            exit_code = w25q32bv_flash_wait_erasing_or_writing(flash, NULL);
+            exit_code = w25q32bv_flash_wait_erasing_or_writing(flash, SECTOR_ERASE_W25Q32BV_OPERATION, NULL);
         }
     }
 
@@ -507,20 +1179,29 @@ int storage_lfs_block_device_sync (const struct lfs_config *config)
     return (int)(LFS_ERR_OK);
 }
 
-/*int storage_lfs_block_device_lock (const struct lfs_config *config)
+int storage_lfs_lock (const struct lfs_config *config)
 {
-    const storage_t *storage = (const storage_t*)config->context;
+    storage_t *storage = (storage_t*)config->context;
 
-    storage->config.spi_lock_callback();
+    storage->config.lock_callback();
+    ++storage->lock_depth;
 
     return (int)(LFS_ERR_OK);
 }
 
-int storage_lfs_block_device_unlock (const struct lfs_config *config)
+int storage_lfs_unlock (const struct lfs_config *config)
 {
-    const storage_t *storage = (const storage_t*)config->context;
+    storage_t *storage = (storage_t*)config->context;
 
-    storage->config.spi_unlock_callback();
+    --storage->lock_depth;
+
+    // The pre-erase goes on once littlefs is done with the flash
+    if (storage->lock_depth == 0U)
+    {
+        storage_resume_erase(storage);
+    }
+
+    storage->config.unlock_callback();
 
     return (int)(LFS_ERR_OK);
-}*/
+}
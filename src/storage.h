@@ -6,19 +6,41 @@
 #ifndef STOARGE_H
 #define STOARGE_H
 
+#define STORAGE_STREAM_CHECKPOINT_SIZE  (32U * 1024U)   // Bytes between metadata commits of a stream
+
 #include <stdint.h>
 #include <stddef.h>
+#include <stdbool.h>
 
 typedef struct std_error std_error_t;
 
+typedef void (*storage_lock_callback_t) ();
 typedef void (*storage_spi_lock_callback_t) ();
 typedef void (*storage_spi_select_callback_t) ();
 typedef int (*storage_spi_tx_rx_callback_t) (uint8_t *tx_data, uint8_t *rx_data, uint16_t size,
                                                 uint32_t timeout_ms, std_error_t * const error);
 typedef void (*storage_delay_callback_t) (uint32_t delay_ms);
+typedef void (*storage_yield_callback_t) ();
+typedef uint32_t (*storage_get_cycles_callback_t) ();
+
+// Sleeps up to delay_ms, true - woken up by something else to do
+typedef bool (*storage_wait_callback_t) (uint32_t delay_ms);
+
+typedef struct storage_geometry
+{
+    uint32_t read_size;         // littlefs reads in multiples of it
+    uint32_t prog_size;         // littlefs programs in multiples of it, a divisor of the W25Q page
+    uint32_t cache_size;        // Of the read, the prog and every file cache, a multiple of both above
+    uint32_t lookahead_size;    // Bytes of the free block bitmap, a bit per sector
+    int32_t block_cycles;       // Erases of a metadata pair before it moves (-1 - never)
+
+} storage_geometry_t;
 
 typedef struct storage_config
 {
+    storage_lock_callback_t lock_callback;          // Around every littlefs call and power change, taken before the SPI lock, recursive
+    storage_lock_callback_t unlock_callback;
+
     storage_spi_lock_callback_t spi_lock_callback;
     storage_spi_lock_callback_t spi_unlock_callback;
     storage_spi_select_callback_t spi_select_callback;
@@ -27,11 +49,21 @@ typedef struct storage_config
     uint32_t spi_timeout_ms;
 
     storage_delay_callback_t delay_callback;
+    storage_yield_callback_t yield_callback;
+    storage_get_cycles_callback_t get_cycles_callback;
+    uint32_t cycles_per_us;
+
+    storage_geometry_t geometry;
 
 } storage_config_t;
 
 typedef struct storage storage_t;
 typedef struct storage_file storage_file_t;
+typedef struct storage_stream storage_stream_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
 
 int storage_init (storage_t * const self, storage_config_t const * const config, std_error_t * const error);
 
@@ -43,13 +75,33 @@ int storage_unmount_filesystem (storage_t * const self, std_error_t * const erro
 
 int storage_create_file (storage_t * const self, storage_file_t * const file, const char file_name[64], std_error_t * const error);
 int storage_open_file (storage_t * const self, storage_file_t * const file, const char file_name[64], std_error_t * const error);
+int storage_open_file_to_append (storage_t * const self, storage_file_t * const file, const char file_name[64], std_error_t * const error);
 int storage_close_file (storage_t * const self, storage_file_t * const file, std_error_t * const error);
 int storage_remove_file (storage_t * const self, const char file_name[64], std_error_t * const error);
+int storage_rename_file (storage_t * const self, const char old_file_name[64], const char new_file_name[64], std_error_t * const error);
 
 int storage_write_file (storage_t * const self, storage_file_t * const file, char const * const data, size_t size, std_error_t * const error);
 int storage_read_file (storage_t * const self, storage_file_t * const file, char *data, size_t * const size, size_t max_size, std_error_t * const error);
+int storage_seek_file (storage_t * const self, storage_file_t * const file, size_t position, std_error_t * const error);
 int storage_get_file_size (storage_t * const self, storage_file_t * const file, size_t * const size, std_error_t * const error);
 
+// The stream keeps the file open and commits metadata only every checkpoint_size bytes (0 - on close only)
+int storage_create_stream (storage_t * const self, storage_stream_t * const stream, const char file_name[64], size_t checkpoint_size, std_error_t * const error);
+int storage_write_stream (storage_t * const self, storage_stream_t * const stream, uint8_t const * const data, size_t size, std_error_t * const error);
+int storage_close_stream (storage_t * const self, storage_stream_t * const stream, size_t * const size, std_error_t * const error);
+
+// Erases the free 32 and 64 KB blocks ahead with one command each, littlefs skips the erase of a sector in there later on.
+// Up to max_erase_count commands (0 - no limit). The lock is free while the W25Q erases, a littlefs call of any task
+// suspends the erase for its time. Meant for an idle task, it sleeps in wait_callback until the erase is over
+// (NULL - in delay_callback). Woken up, it returns at once and leaves the erase going: the next littlefs call suspends it,
+// the next pre-erase waits for it first.
+int storage_pre_erase (storage_t * const self, size_t max_erase_count, storage_wait_callback_t wait_callback,
+                        size_t * const erase_count, std_error_t * const error);
+
+#ifdef __cplusplus
+}
+#endif
+
 
 
 // Private
@@ -57,11 +109,11 @@ int storage_get_file_size (storage_t * const self, storage_file_t * const file,
 
 #include "devices/w25q32bv_flash.h"
 
-#define LFS_MIN_READ_BLOCK_SIZE 128U
-#define LFS_MIN_PROG_BLOCK_SIZE 128U
-#define LFS_CACHE_SIZE          128U
-#define LFS_LOOKAHEAD_SIZE      128U
-#define LFS_ERASE_CYCLES        500
+// The buffers fit any geometry up to a W25Q page of cache and the whole W25Q32BV in the lookahead,
+// littlefs scans a larger part a window at a time
+#define STORAGE_CACHE_SIZE_MAX      256U
+#define STORAGE_LOOKAHEAD_SIZE_MAX  128U
+#define STORAGE_SECTOR_COUNT_MAX    8192U   // A bit per sector in the pre-erase maps, up to the W25Q256
 
 typedef struct storage
 {
@@ -72,9 +124,19 @@ typedef struct storage
     struct lfs_config lfs_config;
     lfs_t lfs;
 
-    uint8_t lfs_read_buffer[LFS_CACHE_SIZE];
-    uint8_t lfs_prog_buffer[LFS_CACHE_SIZE];
-    uint8_t lfs_lookahead_buffer[LFS_LOOKAHEAD_SIZE];
+    uint8_t lfs_read_buffer[STORAGE_CACHE_SIZE_MAX];
+    uint8_t lfs_prog_buffer[STORAGE_CACHE_SIZE_MAX];
+    uint8_t lfs_lookahead_buffer[STORAGE_LOOKAHEAD_SIZE_MAX];
+
+    uint8_t used_sector_map[STORAGE_SECTOR_COUNT_MAX / 8U];     // littlefs blocks as of the last pre-erase
+    uint8_t erased_sector_map[STORAGE_SECTOR_COUNT_MAX / 8U];   // Blank since a pre-erase, not programmed yet
+    bool is_mounted;
+
+    // The pre-erase in flight, suspended while littlefs needs the flash
+    uint32_t erasing_first_sector;
+    uint32_t erasing_sector_count;  // 0 - none
+    bool is_erase_suspended;
+    uint32_t lock_depth;
 
 } storage_t;
 
@@ -83,8 +145,21 @@ typedef struct storage_file
     lfs_file_t file;
     struct lfs_file_config config;
 
-    uint8_t lfs_file_buffer[LFS_CACHE_SIZE];
+    uint8_t lfs_file_buffer[STORAGE_CACHE_SIZE_MAX];
 
 } storage_file_t;
 
+typedef struct storage_stream
+{
+    storage_file_t file;
+
+    uint8_t buffer[STORAGE_CACHE_SIZE_MAX];
+    size_t buffer_size;
+
+    size_t checkpoint_size;
+    size_t unsynced_size;
+    size_t total_size;
+
+} storage_stream_t;
+
 #endif // STOARGE_H
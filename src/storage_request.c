@@ -0,0 +1,166 @@
+/************************************************************
+ *   Author : German Mundinger
+ *   Date   : 2024
+ ************************************************************/
+
+#include "storage_request.h"
+
+#include <stdbool.h>
+#include <string.h>
+#include <assert.h>
+
+#include "storage.h"
+
+#include "std_error/std_error.h"
+
+
+#define NAME_ERROR_TEXT "Storage request file name error"
+#define SIZE_ERROR_TEXT "Storage request size error"
+
+
+static int storage_request_copy_name (char name[STORAGE_REQUEST_NAME_SIZE], char const * const source_name, std_error_t * const error);
+static int storage_request_read (storage_request_t * const self, storage_t * const storage, std_error_t * const error);
+static int storage_request_write (storage_request_t * const self, storage_t * const storage, std_error_t * const error);
+
+int storage_request_init (storage_request_t * const self, storage_request_type_t type, char const * const file_name,
+                            void const * const data, size_t size, std_error_t * const error)
+{
+    assert(self != NULL);
+
+    const bool is_writing = (type == STORAGE_WRITE_REQUEST) || (type == STORAGE_APPEND_REQUEST);
+
+    assert((is_writing != true) || (data != NULL) || (size == 0U));
+
+    if (size > STORAGE_REQUEST_DATA_SIZE)
+    {
+        std_error_catch_custom(error, STD_FAILURE, SIZE_ERROR_TEXT, __FILE__, __LINE__);
+
+        return STD_FAILURE;
+    }
+
+    self->type      = type;
+    self->size      = size;
+    self->offset    = 0U;
+
+    self->file_name[0]      = '\0';
+    self->new_file_name[0]  = '\0';
+
+    if (type == STORAGE_FLUSH_REQUEST)
+    {
+        return STD_SUCCESS;
+    }
+
+    if (storage_request_copy_name(self->file_name, file_name, error) != STD_SUCCESS)
+    {
+        return STD_FAILURE;
+    }
+
+    if (type == STORAGE_RENAME_REQUEST)
+    {
+        return storage_request_copy_name(self->new_file_name, (char const*)(data), error);
+    }
+
+    if (is_writing == true)
+    {
+        memcpy((void*)(self->data), data, size);
+    }
+
+    return STD_SUCCESS;
+}
+
+int storage_request_execute (storage_request_t * const self, storage_t * const storage, std_error_t * const error)
+{
+    assert(self     != NULL);
+    assert(storage  != NULL);
+
+    switch (self->type)
+    {
+        case STORAGE_READ_REQUEST:
+            return storage_request_read(self, storage, error);
+
+        case STORAGE_WRITE_REQUEST:
+        case STORAGE_APPEND_REQUEST:
+            return storage_request_write(self, storage, error);
+
+        case STORAGE_DELETE_REQUEST:
+            return storage_remove_file(storage, self->file_name, error);
+
+        case STORAGE_RENAME_REQUEST:
+            return storage_rename_file(storage, self->file_name, self->new_file_name, error);
+
+        default:
+            break;
+    }
+
+    return STD_SUCCESS;
+}
+
+
+int storage_request_copy_name (char name[STORAGE_REQUEST_NAME_SIZE], char const * const source_name, std_error_t * const error)
+{
+    assert(source_name != NULL);
+
+    const size_t name_length = strlen(source_name);
+
+    if ((name_length == 0U) || (name_length >= STORAGE_REQUEST_NAME_SIZE))
+    {
+        std_error_catch_custom(error, STD_FAILURE, NAME_ERROR_TEXT, __FILE__, __LINE__);
+
+        return STD_FAILURE;
+    }
+
+    memcpy((void*)(name), (const void*)(source_name), name_length + 1U);
+
+    return STD_SUCCESS;
+}
+
+int storage_request_read (storage_request_t * const self, storage_t * const storage, std_error_t * const error)
+{
+    storage_file_t file;
+
+    if (storage_open_file(storage, &file, self->file_name, error) != STD_SUCCESS)
+    {
+        return STD_FAILURE;
+    }
+
+    int exit_code = storage_seek_file(storage, &file, self->offset, error);
+
+    if (exit_code == STD_SUCCESS)
+    {
+        exit_code = storage_read_file(storage, &file, (char*)(self->data), &self->size, self->size, error);
+    }
+
+    storage_close_file(storage, &file, NULL);
+
+    return exit_code;
+}
+
+int storage_request_write (storage_request_t * const self, storage_t * const storage, std_error_t * const error)
+{
+    storage_file_t file;
+
+    int exit_code;
+
+    if (self->type == STORAGE_APPEND_REQUEST)
+    {
+        exit_code = storage_open_file_to_append(storage, &file, self->file_name, error);
+    }
+    else
+    {
+        exit_code = storage_create_file(storage, &file, self->file_name, error);
+    }
+
+    if (exit_code != STD_SUCCESS)
+    {
+        return STD_FAILURE;
+    }
+
+    if (storage_write_file(storage, &file, (const char*)(self->data), self->size, error) != STD_SUCCESS)
+    {
+        storage_close_file(storage, &file, NULL);
+
+        return STD_FAILURE;
+    }
+
+    return storage_close_file(storage, &file, error);
+}
@@ -0,0 +1,56 @@
+/************************************************************
+ *   Author : German Mundinger
+ *   Date   : 2024
+ ************************************************************/
+
+#ifndef STORAGE_REQUEST_H
+#define STORAGE_REQUEST_H
+
+#define STORAGE_REQUEST_NAME_SIZE   64U     // With the terminator, as the storage API takes the names
+#define STORAGE_REQUEST_DATA_SIZE   256U    // A group of the sensor log, a W25Q page
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef struct storage storage_t;
+typedef struct std_error std_error_t;
+
+typedef enum storage_request_type
+{
+    STORAGE_READ_REQUEST = 0,   // Up to size bytes from offset, size is set to what was read
+    STORAGE_WRITE_REQUEST,      // The file is created or truncated
+    STORAGE_APPEND_REQUEST,     // The file is created if missing
+    STORAGE_DELETE_REQUEST,
+    STORAGE_RENAME_REQUEST,     // To new_file_name, replacing it
+    STORAGE_FLUSH_REQUEST       // Nothing to do, done once everything queued before it is
+
+} storage_request_type_t;
+
+// Owns a copy of the name and the data, the caller may drop its own buffers right after queueing it
+typedef struct storage_request
+{
+    storage_request_type_t type;
+    char file_name[STORAGE_REQUEST_NAME_SIZE];
+    char new_file_name[STORAGE_REQUEST_NAME_SIZE];
+    uint8_t data[STORAGE_REQUEST_DATA_SIZE];
+    size_t size;
+    size_t offset;
+
+} storage_request_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// data - to write or append, the new name of a rename (NULL otherwise), size - to read, write or append
+int storage_request_init (storage_request_t * const self, storage_request_type_t type, char const * const file_name,
+                            void const * const data, size_t size, std_error_t * const error);
+
+// On the mounted storage, in the calling task
+int storage_request_execute (storage_request_t * const self, storage_t * const storage, std_error_t * const error);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // STORAGE_REQUEST_H
@@ -0,0 +1,361 @@
+/************************************************************
+ *   Author : German Mundinger
+ *   Date   : 2024
+ ************************************************************/
+
+#include "storage_service.h"
+
+#include <stdbool.h>
+#include <string.h>
+#include <assert.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
+
+#include "storage.h"
+
+#include "logger.h"
+#include "std_error/std_error.h"
+
+
+#define RTOS_TASK_STACK_SIZE    1024U       // 1024*4=4096 bytes, littlefs and a file buffer
+#define RTOS_TASK_PRIORITY      1U          // 0 - lowest, 4 - highest
+#define RTOS_TASK_NAME          "storage"   // 16 - max length
+
+#define REQUEST_BUFFER_SIZE     8U          // A sensor log flush (SENSOR_LOG_REQUEST_BURST) and the waited ones
+
+#define DEFAULT_ERROR_TEXT  "Storage service error"
+#define QUEUE_ERROR_TEXT    "Storage service queue error"
+#define TIMEOUT_ERROR_TEXT  "Storage service timeout error"
+#define MALLOC_ERROR_TEXT   "Storage service memory allocation error"
+
+#define UNUSED(x) (void)(x)
+
+
+typedef struct storage_service_slot
+{
+    storage_request_t request;
+    storage_service_complete_callback_t complete_callback;
+    void *context;
+
+    SemaphoreHandle_t complete_semaphore;
+    int exit_code;
+    bool is_waited;     // Cleared by a caller that gives up, the task frees the slot then
+    bool is_complete;
+
+} storage_service_slot_t;
+
+
+static TaskHandle_t task;
+static QueueHandle_t high_request_queue;
+static QueueHandle_t low_request_queue;
+static QueueHandle_t free_request_queue;
+
+static storage_service_config_t config;
+
+static storage_service_slot_t *slot_buffer;
+
+static bool is_pre_erase_woken_up;
+
+
+static int storage_service_malloc (std_error_t * const error);
+static void storage_service_task (void *parameters);
+static int storage_service_queue (storage_service_slot_t * const slot, storage_service_priority_t priority, std_error_t * const error);
+static void storage_service_complete (storage_service_slot_t * const slot, int exit_code);
+static bool storage_service_pre_erase (std_error_t * const error);
+static bool storage_service_wait_pre_erase (uint32_t delay_ms);
+
+int storage_service_init (storage_service_config_t const * const init_config, std_error_t * const error)
+{
+    assert(init_config          != NULL);
+    assert(init_config->storage != NULL);
+
+    config = *init_config;
+
+    return storage_service_malloc(error);
+}
+
+int storage_service_submit (storage_request_t const * const request, storage_service_priority_t priority, uint32_t timeout_ms,
+                            storage_service_complete_callback_t complete_callback, void *context, std_error_t * const error)
+{
+    assert(request != NULL);
+
+    storage_service_slot_t *slot;
+
+    if (xQueueReceive(free_request_queue, (void*)&slot, pdMS_TO_TICKS(timeout_ms)) != pdPASS)
+    {
+        std_error_catch_custom(error, STD_FAILURE, QUEUE_ERROR_TEXT, __FILE__, __LINE__);
+
+        return STD_FAILURE;
+    }
+
+    slot->request           = *request;
+    slot->complete_callback = complete_callback;
+    slot->context           = context;
+    slot->is_waited         = false;
+    slot->is_complete       = false;
+
+    return storage_service_queue(slot, priority, error);
+}
+
+int storage_service_execute (storage_request_t * const request, storage_service_priority_t priority, uint32_t timeout_ms, std_error_t * const error)
+{
+    assert(request != NULL);
+
+    const TickType_t start_tick_count = xTaskGetTickCount();
+
+    storage_service_slot_t *slot;
+
+    if (xQueueReceive(free_request_queue, (void*)&slot, pdMS_TO_TICKS(timeout_ms)) != pdPASS)
+    {
+        std_error_catch_custom(error, STD_FAILURE, TIMEOUT_ERROR_TEXT, __FILE__, __LINE__);
+
+        return STD_FAILURE;
+    }
+
+    slot->request           = *request;
+    slot->complete_callback = NULL;
+    slot->context           = NULL;
+    slot->is_waited         = true;
+    slot->is_complete       = false;
+
+    if (storage_service_queue(slot, priority, error) != STD_SUCCESS)
+    {
+        return STD_FAILURE;
+    }
+
+    const TickType_t elapsed_ticks  = xTaskGetTickCount() - start_tick_count;
+    const TickType_t timeout_ticks  = pdMS_TO_TICKS(timeout_ms);
+    const TickType_t ticks_to_wait  = (elapsed_ticks < timeout_ticks) ? (timeout_ticks - elapsed_ticks) : 0U;
+
+    if (xSemaphoreTake(slot->complete_semaphore, ticks_to_wait) != pdPASS)
+    {
+        taskENTER_CRITICAL();
+
+        const bool is_complete = slot->is_complete;
+        slot->is_waited = is_complete;
+
+        taskEXIT_CRITICAL();
+
+        if (is_complete != true)
+        {
+            std_error_catch_custom(error, STD_FAILURE, TIMEOUT_ERROR_TEXT, __FILE__, __LINE__);
+
+            return STD_FAILURE;
+        }
+
+        // Done in between, the semaphore is given right away
+        xSemaphoreTake(slot->complete_semaphore, portMAX_DELAY);
+    }
+
+    const int exit_code = slot->exit_code;
+
+    *request = slot->request;
+
+    xQueueSend(free_request_queue, (const void*)&slot, 0U);
+
+    if (exit_code != STD_SUCCESS)
+    {
+        std_error_catch_custom(error, exit_code, DEFAULT_ERROR_TEXT, __FILE__, __LINE__);
+
+        return STD_FAILURE;
+    }
+
+    return STD_SUCCESS;
+}
+
+int storage_service_flush (uint32_t timeout_ms, std_error_t * const error)
+{
+    storage_request_t request;
+    storage_request_init(&request, STORAGE_FLUSH_REQUEST, NULL, NULL, 0U, NULL);
+
+    // Behind every low one, and the high ones go first anyway
+    return storage_service_execute(&request, STORAGE_SERVICE_LOW_PRIORITY, timeout_ms, error);
+}
+
+
+void storage_service_task (void *parameters)
+{
+    UNUSED(parameters);
+
+    std_error_t error;
+    std_error_init(&error);
+
+    const bool is_pre_erase_enabled     = (config.pre_erase_period_ms != 0U);
+    const TickType_t pre_erase_ticks    = pdMS_TO_TICKS(config.pre_erase_period_ms);
+
+    bool is_free_space_erased = (is_pre_erase_enabled != true);
+
+    while (true)
+    {
+        const TickType_t ticks_to_wait = (is_free_space_erased == true) ? portMAX_DELAY : pre_erase_ticks;
+
+        // One notification per queued request
+        if (ulTaskNotifyTake(pdFALSE, ticks_to_wait) == 0U)
+        {
+            is_free_space_erased = storage_service_pre_erase(&error);
+
+            // Took the notification of a request, the erase goes on until littlefs suspends it for that request
+            if (is_pre_erase_woken_up != true)
+            {
+                continue;
+            }
+        }
+
+        // Anything may have freed space, a sensor log rotation above all
+        is_free_space_erased = (is_pre_erase_enabled != true);
+
+        storage_service_slot_t *slot;
+
+        if (xQueueReceive(high_request_queue, (void*)&slot, 0U) != pdPASS)
+        {
+            if (xQueueReceive(low_request_queue, (void*)&slot, 0U) != pdPASS)
+            {
+                continue;
+            }
+        }
+
+        const int exit_code = storage_request_execute(&slot->request, config.storage, &error);
+
+        if (exit_code != STD_SUCCESS)
+        {
+            LOG("Storage service : %s = %s\r\n", slot->request.file_name, error.text);
+        }
+
+        storage_service_complete(slot, exit_code);
+    }
+
+    return;
+}
+
+int storage_service_queue (storage_service_slot_t * const slot, storage_service_priority_t priority, std_error_t * const error)
+{
+    const QueueHandle_t request_queue = (priority == STORAGE_SERVICE_HIGH_PRIORITY) ? high_request_queue : low_request_queue;
+
+    // Both queues hold every slot, never full
+    if (xQueueSend(request_queue, (const void*)&slot, 0U) != pdPASS)
+    {
+        xQueueSend(free_request_queue, (const void*)&slot, 0U);
+
+        std_error_catch_custom(error, STD_FAILURE, QUEUE_ERROR_TEXT, __FILE__, __LINE__);
+
+        return STD_FAILURE;
+    }
+
+    xTaskNotifyGive(task);
+
+    return STD_SUCCESS;
+}
+
+void storage_service_complete (storage_service_slot_t * const slot, int exit_code)
+{
+    if (slot->complete_callback != NULL)
+    {
+        slot->complete_callback(&slot->request, exit_code, slot->context);
+    }
+
+    slot->exit_code = exit_code;
+
+    taskENTER_CRITICAL();
+
+    const bool is_waited = slot->is_waited;
+    slot->is_complete = true;
+
+    taskEXIT_CRITICAL();
+
+    if (is_waited == true)
+    {
+        xSemaphoreGive(slot->complete_semaphore);
+    }
+    else
+    {
+        xQueueSend(free_request_queue, (const void*)&slot, 0U);
+    }
+
+    return;
+}
+
+bool storage_service_pre_erase (std_error_t * const error)
+{
+    is_pre_erase_woken_up = false;
+
+    size_t erase_count;
+
+    // A block per idle period, the lock is not held for long
+    if (storage_pre_erase(config.storage, 1U, storage_service_wait_pre_erase, &erase_count, error) != STD_SUCCESS)
+    {
+        LOG("Storage service : pre-erase = %s\r\n", error->text);
+
+        // Tried again after the next request
+        return true;
+    }
+
+    return (erase_count == 0U) && (is_pre_erase_woken_up != true);
+}
+
+bool storage_service_wait_pre_erase (uint32_t delay_ms)
+{
+    // A request queued meanwhile is carried out right away rather than after the erase
+    is_pre_erase_woken_up = (ulTaskNotifyTake(pdFALSE, pdMS_TO_TICKS(delay_ms)) != 0U);
+
+    return is_pre_erase_woken_up;
+}
+
+
+int storage_service_malloc (std_error_t * const error)
+{
+    slot_buffer = (storage_service_slot_t*)pvPortMalloc(REQUEST_BUFFER_SIZE * sizeof(storage_service_slot_t));
+
+    const bool are_buffers_allocated = (slot_buffer != NULL);
+
+    high_request_queue  = xQueueCreate(REQUEST_BUFFER_SIZE, sizeof(storage_service_slot_t*));
+    low_request_queue   = xQueueCreate(REQUEST_BUFFER_SIZE, sizeof(storage_service_slot_t*));
+    free_request_queue  = xQueueCreate(REQUEST_BUFFER_SIZE, sizeof(storage_service_slot_t*));
+
+    const bool are_queues_allocated = (high_request_queue != NULL) && (low_request_queue != NULL) && (free_request_queue != NULL);
+
+    bool are_semaphores_allocated = are_buffers_allocated;
+
+    for (size_t i = 0U; (are_buffers_allocated == true) && (i < REQUEST_BUFFER_SIZE); ++i)
+    {
+        slot_buffer[i].complete_semaphore = xSemaphoreCreateBinary();
+
+        are_semaphores_allocated = are_semaphores_allocated && (slot_buffer[i].complete_semaphore != NULL);
+    }
+
+    if ((are_buffers_allocated != true) || (are_queues_allocated != true) || (are_semaphores_allocated != true))
+    {
+        for (size_t i = 0U; (are_buffers_allocated == true) && (i < REQUEST_BUFFER_SIZE); ++i)
+        {
+            vSemaphoreDelete(slot_buffer[i].complete_semaphore);
+        }
+        vPortFree((void*)slot_buffer);
+        vQueueDelete(high_request_queue);
+        vQueueDelete(low_request_queue);
+        vQueueDelete(free_request_queue);
+
+        std_error_catch_custom(error, STD_FAILURE, MALLOC_ERROR_TEXT, __FILE__, __LINE__);
+
+        return STD_FAILURE;
+    }
+
+    // Free before the task runs, the callers may queue right after the init
+    for (size_t i = 0U; i < REQUEST_BUFFER_SIZE; ++i)
+    {
+        storage_service_slot_t *free_slot = &slot_buffer[i];
+
+        xQueueSend(free_request_queue, (const void*)&free_slot, 0U);
+    }
+
+    BaseType_t exit_code = xTaskCreate(storage_service_task, RTOS_TASK_NAME, RTOS_TASK_STACK_SIZE, NULL, RTOS_TASK_PRIORITY, &task);
+
+    if (exit_code != pdPASS)
+    {
+        std_error_catch_custom(error, (int)exit_code, MALLOC_ERROR_TEXT, __FILE__, __LINE__);
+
+        return STD_FAILURE;
+    }
+    return STD_SUCCESS;
+}
@@ -0,0 +1,59 @@
+/************************************************************
+ *   Author : German Mundinger
+ *   Date   : 2024
+ ************************************************************/
+
+#ifndef STORAGE_SERVICE_H
+#define STORAGE_SERVICE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "storage_request.h"
+
+typedef struct storage storage_t;
+typedef struct std_error std_error_t;
+
+typedef enum storage_service_priority
+{
+    STORAGE_SERVICE_LOW_PRIORITY = 0,   // Background writes, the sensor log
+    STORAGE_SERVICE_HIGH_PRIORITY       // Someone waits for it, goes before every low one
+
+} storage_service_priority_t;
+
+// Runs in the storage task, request holds the data of a read
+typedef void (*storage_service_complete_callback_t) (storage_request_t const * const request, int exit_code, void *context);
+
+typedef struct storage_service_config
+{
+    storage_t *storage;             // Mounted while anything is queued
+    uint32_t pre_erase_period_ms;   // Of the idle block erases of the free space (0 - never)
+
+} storage_service_config_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Owns a task of its own, the W25Q erases and programs stall nobody else.
+// Once idle it erases ahead the free space a block at a time, a request queued meanwhile wakes the task up
+// and suspends such an erase rather than waits for it.
+int storage_service_init (storage_service_config_t const * const init_config, std_error_t * const error);
+
+// Fire and forget: returns once the request is queued, waits up to timeout_ms for a free slot (0 - never blocks).
+// complete_callback - NULL if of no interest
+int storage_service_submit (storage_request_t const * const request, storage_service_priority_t priority, uint32_t timeout_ms,
+                            storage_service_complete_callback_t complete_callback, void *context, std_error_t * const error);
+
+// Waits up to timeout_ms for the result, a read comes back in request.
+// A request that times out is still carried out, its result is dropped.
+int storage_service_execute (storage_request_t * const request, storage_service_priority_t priority, uint32_t timeout_ms, std_error_t * const error);
+
+// Waits until everything queued so far is done
+int storage_service_flush (uint32_t timeout_ms, std_error_t * const error);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // STORAGE_SERVICE_H
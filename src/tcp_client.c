@@ -17,6 +17,8 @@
 
 #include "socket.h"
 
+#include "latency.h"
+
 #include "logger.h"
 #include "std_error/std_error.h"
 
@@ -30,7 +32,8 @@
 #define SEND_MESSAGE_NOTIFICATION       (1 << 2)
 #define STOP_NOTIFICATION               (1 << 3)
 
-#define RECONNECTION_TIMEOUT_S 10U
+#define RECONNECTION_TIMEOUT_S  10U
+#define POLL_TIMEOUT_S          30U
 
 #define W5500_SOCKET_NUMBER 0U
 
@@ -79,6 +82,8 @@ int tcp_client_init (tcp_client_config_t const * const init_config, tcp_client_e
 {
     assert(init_config                          != NULL);
     assert(init_config->process_msg_callback    != NULL);
+    assert(init_config->connect_callback        != NULL);
+    assert(init_config->poll_callback           != NULL);
     assert(init_config->spi_lock_callback       != NULL);
     assert(init_config->spi_unlock_callback     != NULL);
     assert(init_config->spi_select_callback     != NULL);
@@ -109,9 +114,13 @@ void tcp_client_send_message (tcp_msg_t const * const send_msg)
 
     xSemaphoreTake(send_mutex, portMAX_DELAY);
 
-    strncpy(send_msg_buffer->data, send_msg->data, send_msg->size);
+    memcpy((void*)(send_msg_buffer->data), (const void*)(send_msg->data), send_msg->size);
     send_msg_buffer->size = send_msg->size;
 
+#ifdef LATENCY_TRACE
+    send_msg_buffer->trace = send_msg->trace;
+#endif // LATENCY_TRACE
+
     xSemaphoreGive(send_mutex);
 
     xTaskNotify(task, SEND_MESSAGE_NOTIFICATION, eSetBits);
@@ -125,6 +134,8 @@ void tcp_client_task (void *parameters)
 
     send_msg_buffer->size = 0U;
     recv_msg_buffer->size = 0U;
+
+    LATENCY_CLEAR(&send_msg_buffer->trace);
     
     std_error_t error;
     std_error_init(&error);
@@ -137,7 +148,7 @@ void tcp_client_task (void *parameters)
     while (true)
     {
         uint32_t notification;
-        xTaskNotifyWait(0U, ULONG_MAX, &notification, 30U * 1000U);
+        xTaskNotifyWait(0U, ULONG_MAX, &notification, pdMS_TO_TICKS(POLL_TIMEOUT_S * 1000U));
 
         if ((notification & SEND_MESSAGE_NOTIFICATION) != 0U)
         {
@@ -148,6 +159,10 @@ void tcp_client_task (void *parameters)
             const int32_t exit_code = send(W5500_SOCKET_NUMBER, (uint8_t*)send_msg_buffer->data, (uint16_t)send_msg_buffer->size);
             send_msg_buffer->size = 0U;
 
+            LATENCY_STAMP(&send_msg_buffer->trace, TCP_SEND_HOP);
+            LATENCY_RECORD(&send_msg_buffer->trace);
+            LATENCY_CLEAR(&send_msg_buffer->trace);
+
             xSemaphoreGive(send_mutex);
 
             if (exit_code < SOCK_OK)
@@ -178,6 +193,9 @@ void tcp_client_task (void *parameters)
                 {
                     recv_msg.size = (size_t)msg_size;
 
+                    LATENCY_CLEAR(&recv_msg.trace);
+                    LATENCY_STAMP(&recv_msg.trace, TCP_RECV_HOP);
+
                     if (config.process_msg_callback(&recv_msg, &error) != STD_SUCCESS)
                     {
                         LOG("TCP-Client : %s\r\n", error.text);
@@ -258,10 +276,16 @@ void tcp_client_task (void *parameters)
 
                         is_connected = true;
 
+                        config.connect_callback();
+
                         break;
                     }
                 }
             }
+            else
+            {
+                config.poll_callback();
+            }
         }
     }
 
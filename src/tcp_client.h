@@ -15,6 +15,8 @@ typedef void (*tcp_client_spi_lock_callback_t) ();
 typedef void (*tcp_client_spi_select_callback_t) ();
 typedef int (*tcp_client_spi_tx_rx_callback_t) (uint8_t *data, uint16_t size, uint32_t timeout_ms, std_error_t * const error);
 typedef int (*tcp_client_process_msg_callback_t) (tcp_msg_t const * const recv_msg, std_error_t * const error);
+typedef void (*tcp_client_connect_callback_t) ();
+typedef void (*tcp_client_poll_callback_t) ();
 
 typedef struct tcp_client_endpoint
 {
@@ -30,6 +32,8 @@ typedef struct tcp_client_config
     uint8_t netmask[4];
 
     tcp_client_process_msg_callback_t process_msg_callback;
+    tcp_client_connect_callback_t connect_callback;
+    tcp_client_poll_callback_t poll_callback;   // Every wakeup while connected, 30 s apart at most
 
     tcp_client_spi_lock_callback_t spi_lock_callback;
     tcp_client_spi_lock_callback_t spi_unlock_callback;
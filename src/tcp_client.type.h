@@ -8,11 +8,19 @@
 
 #include <stddef.h>
 
+#ifdef LATENCY_TRACE
+#include "latency.h"
+#endif // LATENCY_TRACE
+
 typedef struct tcp_msg
 {
     char data[128];
     size_t size;
 
+#ifdef LATENCY_TRACE
+    latency_trace_t trace;
+#endif // LATENCY_TRACE
+
 } tcp_msg_t;
 
 #endif // TCP_CLIENT_TYPE_H
@@ -0,0 +1,557 @@
+/************************************************************
+ *   Author : German Mundinger
+ *   Date   : 2024
+ ************************************************************/
+
+#include <gmock/gmock.h>
+
+#include <algorithm>
+#include <map>
+#include <vector>
+
+#include "bootloader/boot.h"
+#include "bootloader/flasher.h"
+#include "std_error/std_error.h"
+
+
+constexpr uint32_t flash_base_address   = 0x08000000U;
+constexpr uint32_t flash_size           = 256U * 1024U;
+constexpr uint32_t application_address  = 0x08010000U;
+constexpr size_t firmware_chunk_size    = 4096U;
+
+
+// Internal flash behind the flasher, littlefs files of the W25Q as plain images
+struct BootDevices
+{
+    static BootDevices *instance;
+
+    std::vector<uint8_t> internal_flash = std::vector<uint8_t>(flash_size, 0xFFU);
+    std::map<boot_image_t, std::vector<uint8_t>> external_flash;
+    uint32_t backup_register = BOOT_CONFIRMED_STATE;
+    uint32_t pending_register = BOOT_NO_PENDING_FLAG;
+
+    // Every image callback needs littlefs mounted
+    size_t storage_access_count = 0U;
+
+    // Every step that changes something spends one, a power loss cuts the rest off
+    size_t power_budget = SIZE_MAX;
+
+    // A corrupt stream of the staged image fails halfway through the install, a dead W25Q fails everything
+    bool is_staged_image_broken = false;
+    bool is_storage_broken = false;
+
+    bool spend_power ()
+    {
+        if (power_budget == 0U)
+        {
+            return false;
+        }
+        --power_budget;
+
+        return true;
+    }
+
+    static uint32_t read_state ()
+    {
+        return instance->backup_register;
+    }
+
+    static void write_state (uint32_t state)
+    {
+        if (instance->spend_power() == true)
+        {
+            instance->backup_register = state;
+        }
+    }
+
+    static uint32_t read_pending ()
+    {
+        return instance->pending_register;
+    }
+
+    static void write_pending (uint32_t pending)
+    {
+        if (instance->spend_power() == true)
+        {
+            instance->pending_register = pending;
+        }
+    }
+
+    static int is_image_present (boot_image_t image, bool * const is_present, std_error_t * const error)
+    {
+        (void)error;
+
+        ++instance->storage_access_count;
+
+        *is_present = false;
+
+        if (instance->is_storage_broken == true)
+        {
+            return STD_FAILURE;
+        }
+
+        *is_present = (instance->external_flash.count(image) != 0U);
+
+        return STD_SUCCESS;
+    }
+
+    static int install_image (boot_image_t image, std_error_t * const error)
+    {
+        ++instance->storage_access_count;
+
+        if (instance->spend_power() != true)
+        {
+            return STD_FAILURE;
+        }
+
+        std::vector<uint8_t> const &data = instance->external_flash.at(image);
+
+        flasher_config_t config;
+        config.erase_sector_callback    = erase_sector;
+        config.program_word_callback    = program_word;
+        config.start_address            = application_address;
+        config.end_address              = flash_base_address + flash_size;
+
+        flasher_t flasher;
+        flasher_init(&flasher, &config);
+
+        if (flasher_erase(&flasher, data.size(), error) != STD_SUCCESS)
+        {
+            return STD_FAILURE;
+        }
+
+        for (size_t i = 0U; i < data.size(); i += firmware_chunk_size)
+        {
+            if ((image == STAGED_IMAGE) && (instance->is_staged_image_broken == true) && (i >= (data.size() / 2U)))
+            {
+                return STD_FAILURE;
+            }
+
+            if (flasher_program(&flasher, &data[i], std::min(firmware_chunk_size, data.size() - i), error) != STD_SUCCESS)
+            {
+                return STD_FAILURE;
+            }
+        }
+        return STD_SUCCESS;
+    }
+
+    static int move_image (boot_image_t from_image, boot_image_t to_image, std_error_t * const error)
+    {
+        (void)error;
+
+        ++instance->storage_access_count;
+
+        if (instance->spend_power() != true)
+        {
+            return STD_FAILURE;
+        }
+
+        // littlefs renames atomically and replaces the target
+        instance->external_flash[to_image] = instance->external_flash.at(from_image);
+        instance->external_flash.erase(from_image);
+
+        return STD_SUCCESS;
+    }
+
+    static int erase_sector (uint32_t sector_number, std_error_t * const error)
+    {
+        (void)error;
+
+        flasher_sector_t const *table;
+        size_t table_size;
+        flasher_get_sector_table(&table, &table_size);
+
+        std::fill_n(instance->internal_flash.begin() + (std::ptrdiff_t)(table[sector_number].address - flash_base_address), table[sector_number].size, 0xFFU);
+
+        return STD_SUCCESS;
+    }
+
+    static int program_word (uint32_t address, uint32_t word, std_error_t * const error)
+    {
+        (void)error;
+
+        for (size_t i = 0U; i < FLASHER_WORD_SIZE; ++i)
+        {
+            instance->internal_flash[(address - flash_base_address) + i] &= (uint8_t)(word >> (8U * i));
+        }
+        return STD_SUCCESS;
+    }
+};
+
+BootDevices *BootDevices::instance = nullptr;
+
+
+class BootTestFixture : public testing::Test
+{
+    protected:
+
+        BootDevices devices;
+        boot_config_t config;
+        std_error_t error;
+
+        std::vector<uint8_t> good_image;
+        std::vector<uint8_t> bad_image;
+
+        virtual void SetUp() override
+        {
+            BootDevices::instance = &devices;
+
+            std_error_init(&error);
+
+            config.read_state_callback          = BootDevices::read_state;
+            config.write_state_callback         = BootDevices::write_state;
+            config.read_pending_callback        = BootDevices::read_pending;
+            config.write_pending_callback       = BootDevices::write_pending;
+            config.is_image_present_callback    = BootDevices::is_image_present;
+            config.install_image_callback       = BootDevices::install_image;
+            config.move_image_callback          = BootDevices::move_image;
+            config.max_attempts                 = BOOT_MAX_ATTEMPTS;
+
+            good_image.resize(70U * 1024U + 5U);
+            bad_image.resize(90U * 1024U + 2U);
+
+            for (size_t i = 0U; i < good_image.size(); ++i)
+            {
+                good_image[i] = (uint8_t)((i * 3U) + 1U);
+            }
+            for (size_t i = 0U; i < bad_image.size(); ++i)
+            {
+                bad_image[i] = (uint8_t)((i * 5U) + 2U);
+            }
+
+            // The good image runs and is confirmed, the bad one is downloaded
+            std::copy(good_image.begin(), good_image.end(), application());
+            devices.external_flash[ACTIVE_IMAGE] = good_image;
+            devices.external_flash[STAGED_IMAGE] = bad_image;
+            devices.pending_register = BOOT_PENDING_FLAG;
+        }
+
+        std::vector<uint8_t>::iterator application ()
+        {
+            return devices.internal_flash.begin() + (std::ptrdiff_t)(application_address - flash_base_address);
+        }
+
+        bool is_running (std::vector<uint8_t> const &image)
+        {
+            return std::equal(image.begin(), image.end(), application());
+        }
+
+        boot_action_t boot ()
+        {
+            boot_action_t action;
+            EXPECT_EQ(boot_prepare(&config, &action, &error), STD_SUCCESS);
+
+            return action;
+        }
+};
+
+
+TEST_F(BootTestFixture, ConfirmedImageJumpsRightAway)
+{
+    // Arrange: create and set up a system under test
+    devices.external_flash.erase(STAGED_IMAGE);
+
+    // Act: poke the system under test
+    const boot_action_t action = boot();
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(action,                   JUMP_BOOT_ACTION);
+    EXPECT_EQ(devices.backup_register,  BOOT_CONFIRMED_STATE);
+    EXPECT_TRUE(is_running(good_image));
+}
+
+TEST_F(BootTestFixture, PlainResetSkipsStorage)
+{
+    // Arrange: create and set up a system under test
+    devices.external_flash.erase(STAGED_IMAGE);
+    devices.pending_register = BOOT_NO_PENDING_FLAG;
+
+    // Act: poke the system under test
+    const boot_action_t action = boot();
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(action,                       JUMP_BOOT_ACTION);
+    EXPECT_EQ(devices.storage_access_count, 0U);
+}
+
+TEST_F(BootTestFixture, StagedImageWaitsForFlag)
+{
+    // Arrange: create and set up a system under test
+    devices.pending_register = BOOT_NO_PENDING_FLAG;
+
+    // Act: poke the system under test
+    const boot_action_t action = boot();
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(action,                       JUMP_BOOT_ACTION);
+    EXPECT_EQ(devices.storage_access_count, 0U);
+    EXPECT_TRUE(is_running(good_image));
+}
+
+TEST_F(BootTestFixture, TrialBootSkipsStorage)
+{
+    // Arrange: create and set up a system under test
+    ASSERT_EQ(boot(), INSTALL_BOOT_ACTION);
+
+    devices.storage_access_count = 0U;
+
+    // Act: poke the system under test
+    const boot_action_t action = boot();
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(action,                       JUMP_BOOT_ACTION);
+    EXPECT_EQ(devices.backup_register,      BOOT_TRIAL_STATE | 2U);
+    EXPECT_EQ(devices.storage_access_count, 0U);
+}
+
+TEST_F(BootTestFixture, FlagWithoutImageIsCleared)
+{
+    // Arrange: create and set up a system under test
+    devices.external_flash.erase(STAGED_IMAGE);
+
+    // Act: poke the system under test
+    const boot_action_t action = boot();
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(action,                   JUMP_BOOT_ACTION);
+    EXPECT_EQ(devices.pending_register, BOOT_NO_PENDING_FLAG);
+    EXPECT_TRUE(is_running(good_image));
+}
+
+TEST_F(BootTestFixture, InstallKeepsFallback)
+{
+    // Arrange: create and set up a system under test
+
+    // Act: poke the system under test
+    const boot_action_t action = boot();
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(action,                   INSTALL_BOOT_ACTION);
+    EXPECT_EQ(devices.backup_register,  BOOT_TRIAL_STATE | 1U);
+    EXPECT_EQ(devices.pending_register, BOOT_NO_PENDING_FLAG);
+    EXPECT_TRUE(is_running(bad_image));
+    EXPECT_EQ(devices.external_flash.count(STAGED_IMAGE),   0U);
+    EXPECT_EQ(devices.external_flash.at(ACTIVE_IMAGE),      bad_image);
+    EXPECT_EQ(devices.external_flash.at(FALLBACK_IMAGE),    good_image);
+}
+
+TEST_F(BootTestFixture, CrashingImageRollsBack)
+{
+    // Arrange: create and set up a system under test
+    ASSERT_EQ(boot(), INSTALL_BOOT_ACTION);
+
+    // Act: poke the system under test
+    std::vector<boot_action_t> actions;
+
+    // The bad image never confirms itself, the watchdog resets it over and over
+    for (size_t i = 0U; i < (BOOT_MAX_ATTEMPTS + 2U); ++i)
+    {
+        actions.push_back(boot());
+    }
+
+    // Assert: make unit test pass or fail
+    std::vector<boot_action_t> expected(BOOT_MAX_ATTEMPTS - 1U, JUMP_BOOT_ACTION);
+    expected.push_back(RESTORE_BOOT_ACTION);
+    expected.push_back(JUMP_BOOT_ACTION);
+    expected.push_back(JUMP_BOOT_ACTION);
+
+    EXPECT_EQ(actions,                  expected);
+    EXPECT_EQ(devices.backup_register,  BOOT_CONFIRMED_STATE);
+    EXPECT_TRUE(is_running(good_image));
+    EXPECT_EQ(devices.external_flash.at(ACTIVE_IMAGE),      good_image);
+    EXPECT_EQ(devices.external_flash.count(FALLBACK_IMAGE), 0U);
+}
+
+TEST_F(BootTestFixture, ConfirmedImageStays)
+{
+    // Arrange: create and set up a system under test
+    ASSERT_EQ(boot(), INSTALL_BOOT_ACTION);
+
+    // Act: poke the system under test
+    ASSERT_EQ(boot(), JUMP_BOOT_ACTION);
+
+    // The application reached the server
+    devices.backup_register = BOOT_CONFIRMED_STATE;
+
+    for (size_t i = 0U; i < (BOOT_MAX_ATTEMPTS + 2U); ++i)
+    {
+        ASSERT_EQ(boot(), JUMP_BOOT_ACTION);
+    }
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(devices.backup_register,  BOOT_CONFIRMED_STATE);
+    EXPECT_TRUE(is_running(bad_image));
+    EXPECT_EQ(devices.external_flash.at(FALLBACK_IMAGE),    good_image);
+}
+
+TEST_F(BootTestFixture, UnconfirmedImageIsNotFallback)
+{
+    // Arrange: create and set up a system under test
+    ASSERT_EQ(boot(), INSTALL_BOOT_ACTION);
+
+    std::vector<uint8_t> next_image(good_image.rbegin(), good_image.rend());
+    devices.external_flash[STAGED_IMAGE] = next_image;
+    devices.pending_register = BOOT_PENDING_FLAG;
+
+    // Act: poke the system under test
+    const boot_action_t action = boot();
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(action, INSTALL_BOOT_ACTION);
+    EXPECT_TRUE(is_running(next_image));
+    EXPECT_EQ(devices.external_flash.at(ACTIVE_IMAGE),      next_image);
+    EXPECT_EQ(devices.external_flash.at(FALLBACK_IMAGE),    good_image);
+}
+
+TEST_F(BootTestFixture, NoFallbackStopsCounting)
+{
+    // Arrange: create and set up a system under test
+    devices.external_flash.erase(STAGED_IMAGE);
+    devices.backup_register = BOOT_TRIAL_STATE | BOOT_MAX_ATTEMPTS;
+
+    // Act: poke the system under test
+    const boot_action_t action = boot();
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(action,                   JUMP_BOOT_ACTION);
+    EXPECT_EQ(devices.backup_register,  BOOT_CONFIRMED_STATE);
+    EXPECT_TRUE(is_running(good_image));
+}
+
+TEST_F(BootTestFixture, BrokenStagedImageRestoresFallback)
+{
+    // Arrange: create and set up a system under test
+    devices.is_staged_image_broken = true;
+
+    // Act: poke the system under test
+    const boot_action_t action = boot();
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(action,                   RESTORE_BOOT_ACTION);
+    EXPECT_EQ(devices.backup_register,  BOOT_CONFIRMED_STATE);
+    EXPECT_EQ(devices.pending_register, BOOT_NO_PENDING_FLAG);
+    EXPECT_TRUE(is_running(good_image));
+    EXPECT_EQ(devices.external_flash.at(ACTIVE_IMAGE),      good_image);
+    EXPECT_EQ(devices.external_flash.count(FALLBACK_IMAGE), 0U);
+}
+
+TEST_F(BootTestFixture, StorageFailureClearsFlag)
+{
+    // Arrange: create and set up a system under test
+    devices.is_storage_broken = true;
+
+    // Act: poke the system under test
+    boot_action_t action;
+    const int exit_code = boot_prepare(&config, &action, &error);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(exit_code,                STD_FAILURE);
+    EXPECT_EQ(devices.pending_register, BOOT_NO_PENDING_FLAG);
+    EXPECT_TRUE(is_running(good_image));
+}
+
+TEST_F(BootTestFixture, FailedTrialImageRestoresFallback)
+{
+    // Arrange: create and set up a system under test
+    ASSERT_EQ(boot(), INSTALL_BOOT_ACTION);
+
+    // A worn flash bit, the check before the jump fails
+    *application() ^= 0x01U;
+
+    // Act: poke the system under test
+    boot_action_t action;
+    const int exit_code = boot_repair(&config, &action, &error);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(exit_code,                STD_SUCCESS);
+    EXPECT_EQ(action,                   RESTORE_BOOT_ACTION);
+    EXPECT_EQ(devices.backup_register,  BOOT_CONFIRMED_STATE);
+    EXPECT_TRUE(is_running(good_image));
+    EXPECT_EQ(devices.external_flash.at(ACTIVE_IMAGE), good_image);
+}
+
+TEST_F(BootTestFixture, FailedConfirmedImageIsReinstalled)
+{
+    // Arrange: create and set up a system under test
+    devices.external_flash.erase(STAGED_IMAGE);
+
+    *application() ^= 0x01U;
+
+    // Act: poke the system under test
+    boot_action_t action;
+    const int exit_code = boot_repair(&config, &action, &error);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(exit_code,                STD_SUCCESS);
+    EXPECT_EQ(action,                   REPAIR_BOOT_ACTION);
+    EXPECT_EQ(devices.backup_register,  BOOT_CONFIRMED_STATE);
+    EXPECT_TRUE(is_running(good_image));
+}
+
+
+class BootParameterizedPowerLoss : public BootTestFixture,
+                                    public testing::WithParamInterface<size_t>
+{
+};
+
+TEST_P(BootParameterizedPowerLoss, InstallSurvivesPowerLoss)
+{
+    // Arrange: create and set up a system under test
+    devices.power_budget = GetParam();
+
+    boot_action_t action;
+    boot_prepare(&config, &action, &error);
+
+    // Act: poke the system under test
+    devices.power_budget = SIZE_MAX;
+
+    boot();
+
+    // Assert: make unit test pass or fail
+    EXPECT_FALSE(boot_is_confirmed(devices.backup_register));
+    EXPECT_FALSE(boot_is_pending(devices.pending_register));
+    EXPECT_TRUE(is_running(bad_image));
+    EXPECT_EQ(devices.external_flash.count(STAGED_IMAGE),   0U);
+    EXPECT_EQ(devices.external_flash.at(ACTIVE_IMAGE),      bad_image);
+    EXPECT_EQ(devices.external_flash.at(FALLBACK_IMAGE),    good_image);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    BootPowerLoss,
+    BootParameterizedPowerLoss,
+    testing::Values(0U, 1U, 2U, 3U, 4U)
+);
+
+
+class BootParameterizedRestorePowerLoss : public BootTestFixture,
+                                            public testing::WithParamInterface<size_t>
+{
+};
+
+TEST_P(BootParameterizedRestorePowerLoss, RestoreSurvivesPowerLoss)
+{
+    // Arrange: create and set up a system under test
+    ASSERT_EQ(boot(), INSTALL_BOOT_ACTION);
+
+    devices.backup_register = BOOT_TRIAL_STATE | BOOT_MAX_ATTEMPTS;
+    devices.power_budget    = GetParam();
+
+    boot_action_t action;
+    boot_prepare(&config, &action, &error);
+
+    // Act: poke the system under test
+    devices.power_budget = SIZE_MAX;
+
+    boot();
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(devices.backup_register,  BOOT_CONFIRMED_STATE);
+    EXPECT_TRUE(is_running(good_image));
+    EXPECT_EQ(devices.external_flash.at(ACTIVE_IMAGE),      good_image);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    BootRestorePowerLoss,
+    BootParameterizedRestorePowerLoss,
+    testing::Values(0U, 1U, 2U)
+);
@@ -0,0 +1,392 @@
+/************************************************************
+ *   Author : German Mundinger
+ *   Date   : 2024
+ ************************************************************/
+
+#include <gmock/gmock.h>
+
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "bootloader/decompressor.h"
+#include "firmware_update.h"
+#include "std_error/std_error.h"
+
+
+// Greedy encoder of the 'heatshrink -e -w <window> -l <lookahead>' stream format
+static std::vector<uint8_t> compress (std::vector<uint8_t> const &data, uint8_t window_bits, uint8_t lookahead_bits)
+{
+    std::vector<uint8_t> stream =
+    {
+        DECOMPRESSOR_MAGIC_0, DECOMPRESSOR_MAGIC_1, window_bits, lookahead_bits,
+        (uint8_t)(data.size()), (uint8_t)(data.size() >> 8U), (uint8_t)(data.size() >> 16U), (uint8_t)(data.size() >> 24U)
+    };
+
+    uint32_t bits       = 0U;
+    uint32_t bit_count  = 0U;
+
+    auto put_bits = [&](uint32_t value, uint32_t count)
+    {
+        for (uint32_t i = count; i > 0U; --i)
+        {
+            bits = (bits << 1U) | ((value >> (i - 1U)) & 1U);
+            ++bit_count;
+
+            if (bit_count == 8U)
+            {
+                stream.push_back((uint8_t)(bits));
+                bits        = 0U;
+                bit_count   = 0U;
+            }
+        }
+    };
+
+    const size_t window_size    = (size_t)(1U) << window_bits;
+    const size_t max_count      = (size_t)(1U) << lookahead_bits;
+    const size_t break_even     = (1U + window_bits + lookahead_bits) / 9U;
+
+    std::map<uint32_t, std::vector<size_t>> positions;
+
+    auto key = [&](size_t i) { return (uint32_t)(data[i]) | ((uint32_t)(data[i + 1U]) << 8U); };
+
+    for (size_t i = 0U; i < data.size();)
+    {
+        size_t best_count   = 0U;
+        size_t best_offset  = 0U;
+
+        if ((i + 1U) < data.size())
+        {
+            auto const &candidates = positions[key(i)];
+
+            size_t checked = 0U;
+
+            for (auto it = candidates.rbegin(); (it != candidates.rend()) && ((i - *it) <= window_size) && (checked < 64U); ++it, ++checked)
+            {
+                size_t count = 0U;
+
+                while ((count < max_count) && ((i + count) < data.size()) && (data[*it + count] == data[i + count]))
+                {
+                    ++count;
+                }
+
+                if (count > best_count)
+                {
+                    best_count  = count;
+                    best_offset = i - *it;
+                }
+            }
+        }
+
+        const size_t step = (best_count > break_even) ? best_count : 1U;
+
+        if (step == 1U)
+        {
+            put_bits(1U, 1U);
+            put_bits(data[i], 8U);
+        }
+        else
+        {
+            put_bits(0U, 1U);
+            put_bits((uint32_t)(best_offset - 1U), window_bits);
+            put_bits((uint32_t)(best_count - 1U), lookahead_bits);
+        }
+
+        for (size_t j = i; (j < (i + step)) && ((j + 1U) < data.size()); ++j)
+        {
+            positions[key(j)].push_back(j);
+        }
+        i += step;
+    }
+
+    if (bit_count != 0U)
+    {
+        put_bits(0U, 8U - bit_count);
+    }
+
+    return stream;
+}
+
+// Thumb-2 looking code: a few hundred functions built from a small set of frequent instructions, literal pools and padding
+static std::vector<uint8_t> make_firmware (size_t size)
+{
+    std::mt19937 random(2024U);
+
+    std::vector<uint16_t> instructions(96U);
+
+    for (auto &instruction : instructions)
+    {
+        instruction = (uint16_t)(random());
+    }
+
+    std::vector<std::vector<uint8_t>> snippets(400U);
+
+    for (auto &snippet : snippets)
+    {
+        const size_t length = 4U + (random() % 24U);
+
+        for (size_t i = 0U; i < length; ++i)
+        {
+            // Low indices are much more frequent, like push/pop/ldr/str/bl
+            const uint16_t instruction = instructions[(random() % 12U) * (random() % 8U)];
+            snippet.push_back((uint8_t)(instruction));
+            snippet.push_back((uint8_t)(instruction >> 8U));
+        }
+    }
+
+    std::vector<uint8_t> firmware;
+
+    while (firmware.size() < size)
+    {
+        const uint32_t kind = random() % 16U;
+
+        if (kind < 11U)
+        {
+            auto const &snippet = snippets[(random() % 20U) * (random() % 20U)];
+            firmware.insert(firmware.end(), snippet.begin(), snippet.end());
+        }
+        else if (kind < 15U)
+        {
+            // Literal pool: addresses in flash and peripherals
+            const uint32_t address = ((random() % 2U) == 0U) ? (0x08010000U + (random() % 0x30000U)) : (0x40000000U + ((random() % 64U) * 0x400U));
+
+            for (size_t i = 0U; i < 4U; ++i)
+            {
+                firmware.push_back((uint8_t)(address >> (8U * i)));
+            }
+        }
+        else
+        {
+            firmware.insert(firmware.end(), 4U * (1U + (random() % 4U)), 0x00U);
+        }
+    }
+    firmware.resize(size);
+
+    return firmware;
+}
+
+
+class DecompressorTestFixture : public testing::Test
+{
+    protected:
+
+        static DecompressorTestFixture *instance;
+
+        decompressor_t decompressor;
+        std_error_t error;
+
+        std::vector<uint8_t> output;
+        std::vector<size_t> write_sizes;
+
+        virtual void SetUp() override
+        {
+            instance = this;
+
+            std_error_init(&error);
+        }
+
+        static int write (uint8_t const * const data, size_t size, std_error_t * const error)
+        {
+            (void)error;
+
+            instance->output.insert(instance->output.end(), data, data + size);
+            instance->write_sizes.push_back(size);
+
+            return STD_SUCCESS;
+        }
+
+        int init (std::vector<uint8_t> const &stream)
+        {
+            decompressor_header_t header;
+
+            if (decompressor_parse_header(stream.data(), &header) != true)
+            {
+                return STD_FAILURE;
+            }
+
+            decompressor_config_t config;
+            config.write_callback = write;
+
+            return decompressor_init(&decompressor, &config, &header, &error);
+        }
+
+        int decompress (std::vector<uint8_t> const &stream, size_t chunk_size)
+        {
+            if (init(stream) != STD_SUCCESS)
+            {
+                return STD_FAILURE;
+            }
+
+            for (size_t i = DECOMPRESSOR_HEADER_SIZE; i < stream.size(); i += chunk_size)
+            {
+                if (decompressor_process(&decompressor, &stream[i], std::min(chunk_size, stream.size() - i), &error) != STD_SUCCESS)
+                {
+                    return STD_FAILURE;
+                }
+            }
+            return decompressor_finish(&decompressor, &error);
+        }
+};
+
+DecompressorTestFixture *DecompressorTestFixture::instance = nullptr;
+
+
+TEST_F(DecompressorTestFixture, RawImageIsNotCompressed)
+{
+    // Arrange: create and set up a system under test
+    const uint8_t raw_image[DECOMPRESSOR_HEADER_SIZE] = { 0x00U, 0x00U, 0x01U, 0x20U, 0x99U, 0x02U, 0x01U, 0x08U };
+
+    // Act: poke the system under test
+    decompressor_header_t header;
+    const bool is_compressed = decompressor_parse_header(raw_image, &header);
+
+    // Assert: make unit test pass or fail
+    EXPECT_FALSE(is_compressed);
+}
+
+TEST_F(DecompressorTestFixture, IncompressibleData)
+{
+    // Arrange: create and set up a system under test
+    std::mt19937 random(7U);
+
+    std::vector<uint8_t> data(10000U);
+
+    for (auto &byte : data)
+    {
+        byte = (uint8_t)(random());
+    }
+
+    const std::vector<uint8_t> stream = compress(data, 10U, 4U);
+
+    // Act: poke the system under test
+    const int exit_code = decompress(stream, 4096U);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(exit_code,    STD_SUCCESS);
+    EXPECT_EQ(output,       data);
+}
+
+TEST_F(DecompressorTestFixture, OutputChunksAreWordMultiples)
+{
+    // Arrange: create and set up a system under test
+    const std::vector<uint8_t> data     = make_firmware((10U * DECOMPRESSOR_OUTPUT_SIZE) + 3U);
+    const std::vector<uint8_t> stream   = compress(data, 10U, 4U);
+
+    // Act: poke the system under test
+    const int exit_code = decompress(stream, 333U);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(exit_code,    STD_SUCCESS);
+    EXPECT_EQ(output,       data);
+    ASSERT_EQ(write_sizes.size(), 11U);
+    EXPECT_EQ(std::count(write_sizes.begin(), write_sizes.end(), DECOMPRESSOR_OUTPUT_SIZE), 10);
+    EXPECT_EQ(write_sizes.back(), 3U);
+}
+
+TEST_F(DecompressorTestFixture, RejectTruncatedStream)
+{
+    // Arrange: create and set up a system under test
+    const std::vector<uint8_t> data = make_firmware(5000U);
+    std::vector<uint8_t> stream     = compress(data, 10U, 4U);
+
+    stream.resize(stream.size() - 10U);
+
+    // Act: poke the system under test
+    const int exit_code = decompress(stream, 4096U);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(exit_code, STD_FAILURE);
+}
+
+TEST_F(DecompressorTestFixture, RejectOverlongStream)
+{
+    // Arrange: create and set up a system under test
+    const std::vector<uint8_t> data = make_firmware(5000U);
+    std::vector<uint8_t> stream     = compress(data, 10U, 4U);
+
+    // The header promises less than the stream holds
+    stream[4] = (uint8_t)(stream[4] - 1U);
+
+    // Act: poke the system under test
+    const int exit_code = decompress(stream, 4096U);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(exit_code, STD_FAILURE);
+}
+
+TEST_F(DecompressorTestFixture, RejectOversizedWindow)
+{
+    // Arrange: create and set up a system under test
+    std::vector<uint8_t> stream = compress(make_firmware(100U), 10U, 4U);
+
+    stream[2] = DECOMPRESSOR_MAX_WINDOW_BITS + 1U;
+
+    // Act: poke the system under test
+    const int exit_code = init(stream);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(exit_code, STD_FAILURE);
+}
+
+TEST_F(DecompressorTestFixture, CompressedTransfer)
+{
+    // Arrange: create and set up a system under test
+    const std::vector<uint8_t> data     = make_firmware(300U * 1024U);
+    const std::vector<uint8_t> stream   = compress(data, 10U, 4U);
+
+    // Act: poke the system under test
+    const int exit_code = decompress(stream, 4096U);
+
+    const size_t raw_frames         = (data.size() + FIRMWARE_UPDATE_CHUNK_SIZE - 1U) / FIRMWARE_UPDATE_CHUNK_SIZE;
+    const size_t compressed_frames  = (stream.size() + FIRMWARE_UPDATE_CHUNK_SIZE - 1U) / FIRMWARE_UPDATE_CHUNK_SIZE;
+    const double ratio              = (double)(stream.size()) / (double)(data.size());
+
+    std::cout << "[ BENCHMARK] raw image        : " << data.size() << " bytes, " << raw_frames << " frames" << std::endl;
+    std::cout << "[ BENCHMARK] compressed image : " << stream.size() << " bytes, " << compressed_frames << " frames, ratio " << ratio << std::endl;
+    RecordProperty("raw_size",          std::to_string(data.size()));
+    RecordProperty("compressed_size",   std::to_string(stream.size()));
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(exit_code,    STD_SUCCESS);
+    EXPECT_EQ(output,       data);
+    EXPECT_LT(ratio,        0.6);
+}
+
+
+class DecompressorParameterizedRoundTrip : public DecompressorTestFixture,
+                                            public testing::WithParamInterface<std::tuple<uint8_t, uint8_t, size_t, size_t>>
+{
+};
+
+TEST_P(DecompressorParameterizedRoundTrip, RoundTrip)
+{
+    // Arrange: create and set up a system under test
+    const auto [window_bits, lookahead_bits, image_size, chunk_size] = GetParam();
+
+    const std::vector<uint8_t> data     = make_firmware(image_size);
+    const std::vector<uint8_t> stream   = compress(data, window_bits, lookahead_bits);
+
+    // Act: poke the system under test
+    const int exit_code = decompress(stream, chunk_size);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(exit_code,    STD_SUCCESS);
+    EXPECT_EQ(output,       data);
+    EXPECT_LT(stream.size(), data.size());
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    DecompressorRoundTrip,
+    DecompressorParameterizedRoundTrip,
+    testing::Values(
+        std::make_tuple(10U,    4U,     64U * 1024U,    4096U),
+        std::make_tuple(10U,    4U,     64U * 1024U,    1U),
+        std::make_tuple(10U,    9U,     20U * 1024U,    7U),
+        std::make_tuple(8U,     4U,     20U * 1024U,    256U),
+        std::make_tuple(4U,     3U,     4U * 1024U,     3U)
+    )
+);
@@ -0,0 +1,256 @@
+/************************************************************
+ *   Author : German Mundinger
+ *   Date   : 2024
+ ************************************************************/
+
+#include <gmock/gmock.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "bootloader/flasher.h"
+#include "std_error/std_error.h"
+
+
+// STM32F4 internal flash, typical timings for x32 parallelism
+constexpr uint32_t flash_base_address   = 0x08000000U;
+constexpr uint32_t silver_flash_size    = 256U * 1024U;
+constexpr uint32_t gold_flash_size      = 512U * 1024U;
+constexpr uint32_t application_address  = 0x08010000U;
+constexpr double program_time_ms        = 0.016;
+
+constexpr size_t firmware_size          = 150U * 1024U + 3U;
+constexpr size_t firmware_chunk_size    = 4096U;
+
+
+struct InternalFlashModel
+{
+    static InternalFlashModel *instance;
+
+    std::vector<uint8_t> data = std::vector<uint8_t>(gold_flash_size, 0x00U);
+    std::vector<uint32_t> erased_sectors;
+
+    size_t program_count    = 0U;
+    size_t overwrite_count  = 0U;
+    double erase_time_ms    = 0.0;
+
+    static int erase_sector (uint32_t sector_number, std_error_t * const error)
+    {
+        (void)error;
+
+        flasher_sector_t const *table;
+        size_t table_size;
+        flasher_get_sector_table(&table, &table_size);
+
+        const flasher_sector_t sector = table[sector_number];
+
+        std::memset(&instance->data[sector.address - flash_base_address], 0xFF, sector.size);
+        instance->erased_sectors.push_back(sector_number);
+
+        // 16 kB - 250 ms, 64 kB - 550 ms, 128 kB - 1000 ms
+        instance->erase_time_ms += (sector.size <= (16U * 1024U)) ? 250.0 : ((sector.size <= (64U * 1024U)) ? 550.0 : 1000.0);
+
+        return STD_SUCCESS;
+    }
+
+    static int program_word (uint32_t address, uint32_t word, std_error_t * const error)
+    {
+        (void)error;
+
+        EXPECT_EQ(address % FLASHER_WORD_SIZE, 0U);
+
+        uint8_t *bytes = &instance->data[address - flash_base_address];
+
+        for (size_t i = 0U; i < FLASHER_WORD_SIZE; ++i)
+        {
+            if (bytes[i] != 0xFFU)
+            {
+                ++instance->overwrite_count;
+            }
+            bytes[i] &= (uint8_t)(word >> (8U * i));
+        }
+        ++instance->program_count;
+
+        return STD_SUCCESS;
+    }
+
+    double get_flash_time_ms () const
+    {
+        return ((double)(program_count) * program_time_ms) + erase_time_ms;
+    }
+};
+
+InternalFlashModel *InternalFlashModel::instance = nullptr;
+
+
+class FlasherTestFixture : public testing::Test
+{
+    protected:
+
+        InternalFlashModel flash;
+        flasher_t flasher;
+        std_error_t error;
+
+        std::vector<uint8_t> firmware;
+
+        virtual void SetUp() override
+        {
+            InternalFlashModel::instance = &flash;
+
+            std_error_init(&error);
+
+            firmware.resize(firmware_size);
+
+            for (size_t i = 0U; i < firmware.size(); ++i)
+            {
+                firmware[i] = (uint8_t)((i * 11U) + (i >> 10U));
+            }
+        }
+
+        void init (uint32_t flash_size)
+        {
+            flasher_config_t config;
+            config.erase_sector_callback    = InternalFlashModel::erase_sector;
+            config.program_word_callback    = InternalFlashModel::program_word;
+            config.start_address            = application_address;
+            config.end_address              = flash_base_address + flash_size;
+
+            flasher_init(&flasher, &config);
+        }
+
+        int program (size_t chunk_size)
+        {
+            for (size_t i = 0U; i < firmware.size(); i += chunk_size)
+            {
+                if (flasher_program(&flasher, &firmware[i], std::min(chunk_size, firmware.size() - i), &error) != STD_SUCCESS)
+                {
+                    return STD_FAILURE;
+                }
+            }
+            return STD_SUCCESS;
+        }
+
+        std::vector<uint8_t> read_back (size_t size)
+        {
+            auto begin = flash.data.begin() + (std::ptrdiff_t)(application_address - flash_base_address);
+
+            return std::vector<uint8_t>(begin, begin + (std::ptrdiff_t)(size));
+        }
+};
+
+
+TEST_F(FlasherTestFixture, ProgramWordWise)
+{
+    // Arrange: create and set up a system under test
+    init(silver_flash_size);
+
+    ASSERT_EQ(flasher_erase(&flasher, firmware.size(), &error), STD_SUCCESS);
+
+    // Act: poke the system under test
+    const int exit_code = program(firmware_chunk_size);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(exit_code,                STD_SUCCESS);
+    EXPECT_EQ(read_back(firmware.size()), firmware);
+    EXPECT_EQ(flash.program_count,      (firmware.size() + FLASHER_WORD_SIZE - 1U) / FLASHER_WORD_SIZE);
+    EXPECT_EQ(flash.overwrite_count,    0U);
+
+    // The padding of the tail word leaves the flash erased
+    EXPECT_EQ(read_back(firmware.size() + 1U).back(), 0xFFU);
+}
+
+TEST_F(FlasherTestFixture, RejectChunkAfterUnalignedTail)
+{
+    // Arrange: create and set up a system under test
+    init(silver_flash_size);
+
+    ASSERT_EQ(flasher_erase(&flasher, 16U, &error), STD_SUCCESS);
+    ASSERT_EQ(flasher_program(&flasher, firmware.data(), 6U, &error), STD_SUCCESS);
+
+    // Act: poke the system under test
+    const int exit_code = flasher_program(&flasher, firmware.data(), 4U, &error);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(exit_code, STD_FAILURE);
+}
+
+TEST_F(FlasherTestFixture, RejectOversizedImage)
+{
+    // Arrange: create and set up a system under test
+    init(silver_flash_size);
+
+    // Act: poke the system under test
+    const int exit_code = flasher_erase(&flasher, (silver_flash_size - (64U * 1024U)) + 1U, &error);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(exit_code, STD_FAILURE);
+    EXPECT_TRUE(flash.erased_sectors.empty());
+}
+
+TEST_F(FlasherTestFixture, ByteVersusWordCopy)
+{
+    // Arrange: create and set up a system under test
+    init(silver_flash_size);
+
+    // Former copy: sectors 4 and 5 always, one program operation per byte from 128-byte reads
+    constexpr size_t former_chunk_size = 128U;
+
+    const size_t former_program_count   = firmware.size();
+    const size_t former_read_count      = (firmware.size() + former_chunk_size - 1U) / former_chunk_size;
+    const double former_time_ms         = 550.0 + 1000.0 + ((double)(former_program_count) * program_time_ms);
+
+    // Act: poke the system under test
+    ASSERT_EQ(flasher_erase(&flasher, firmware.size(), &error), STD_SUCCESS);
+    ASSERT_EQ(program(firmware_chunk_size), STD_SUCCESS);
+
+    const size_t read_count = (firmware.size() + firmware_chunk_size - 1U) / firmware_chunk_size;
+
+    std::cout << "[ BENCHMARK] byte copy : " << former_program_count << " programs, " << former_read_count << " reads, " << former_time_ms << " ms" << std::endl;
+    std::cout << "[ BENCHMARK] word copy : " << flash.program_count << " programs, " << read_count << " reads, " << flash.get_flash_time_ms() << " ms" << std::endl;
+    RecordProperty("byte_program_count",    std::to_string(former_program_count));
+    RecordProperty("word_program_count",    std::to_string(flash.program_count));
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(read_back(firmware.size()), firmware);
+    EXPECT_LE(flash.program_count * 4U,     former_program_count + FLASHER_WORD_SIZE);
+    EXPECT_LE(read_count * 16U,             former_read_count);
+    EXPECT_LE(flash.get_flash_time_ms(),    former_time_ms);
+}
+
+
+class FlasherParameterizedErase : public FlasherTestFixture,
+                                    public testing::WithParamInterface<std::tuple<uint32_t, size_t, std::vector<uint32_t>>>
+{
+};
+
+TEST_P(FlasherParameterizedErase, EraseOnlyNeededSectors)
+{
+    // Arrange: create and set up a system under test
+    const auto [flash_size, image_size, expected_sectors] = GetParam();
+
+    init(flash_size);
+
+    // Act: poke the system under test
+    const int exit_code = flasher_erase(&flasher, image_size, &error);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(exit_code,            STD_SUCCESS);
+    EXPECT_EQ(flash.erased_sectors, expected_sectors);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    FlasherEraseSectors,
+    FlasherParameterizedErase,
+    testing::Values(
+        std::make_tuple(silver_flash_size,  1U,                     std::vector<uint32_t>{ 4U }),
+        std::make_tuple(silver_flash_size,  64U * 1024U,            std::vector<uint32_t>{ 4U }),
+        std::make_tuple(silver_flash_size,  (64U * 1024U) + 1U,     std::vector<uint32_t>{ 4U, 5U }),
+        std::make_tuple(silver_flash_size,  192U * 1024U,           std::vector<uint32_t>{ 4U, 5U }),
+        std::make_tuple(gold_flash_size,    (192U * 1024U) + 1U,    std::vector<uint32_t>{ 4U, 5U, 6U }),
+        std::make_tuple(gold_flash_size,    448U * 1024U,           std::vector<uint32_t>{ 4U, 5U, 6U, 7U })
+    )
+);
@@ -0,0 +1,351 @@
+/************************************************************
+ *   Author : German Mundinger
+ *   Date   : 2024
+ ************************************************************/
+
+#include <gmock/gmock.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "bootloader/image.h"
+#include "crc32.h"
+#include "std_error/std_error.h"
+
+
+// Gold application area and a typical firmware, the STM32 CRC unit takes 4 AHB cycles per word at 84 MHz
+constexpr uint32_t gold_application_size    = 448U * 1024U;
+constexpr uint32_t firmware_size            = 150U * 1024U;
+constexpr double crc_unit_word_time_us      = 4.0 / 84.0;
+
+
+class ImageTestFixture : public testing::Test
+{
+    protected:
+
+        std::vector<uint32_t> flash;
+        image_config_t config;
+        image_info_t info;
+        std_error_t error;
+
+        virtual void SetUp() override
+        {
+            std_error_init(&error);
+
+            // What the linker and tools/image_trailer.c leave in the application area
+            flash.assign(gold_application_size / sizeof(uint32_t), 0xFFFFFFFFU);
+
+            for (uint32_t i = 0U; i < (firmware_size / sizeof(uint32_t)); ++i)
+            {
+                flash[i] = (i * 2654435761U) ^ (i >> 3U);
+            }
+            flash[(IMAGE_INFO_OFFSET / sizeof(uint32_t)) + 0U] = IMAGE_INFO_MAGIC;
+            flash[(IMAGE_INFO_OFFSET / sizeof(uint32_t)) + 1U] = firmware_size;
+
+            flash[(firmware_size / sizeof(uint32_t)) + 0U] = firmware_size;
+            flash[(firmware_size / sizeof(uint32_t)) + 1U] = crc32_calculate_words(flash.data(), firmware_size / sizeof(uint32_t));
+
+            config.crc_callback = crc32_calculate_words;
+            config.image        = flash.data();
+            config.max_size     = gold_application_size;
+        }
+};
+
+
+TEST_F(ImageTestFixture, VerifyImage)
+{
+    // Arrange: create and set up a system under test
+
+    // Act: poke the system under test
+    const auto start = std::chrono::steady_clock::now();
+
+    const int exit_code = image_verify(&config, &info, &error);
+
+    const auto stop = std::chrono::steady_clock::now();
+
+    const double host_time_us   = std::chrono::duration<double, std::micro>(stop - start).count();
+    const double target_time_ms = ((double)(firmware_size / sizeof(uint32_t)) * crc_unit_word_time_us) / 1000.0;
+
+    std::cout << "[ BENCHMARK] image        : " << firmware_size << " bytes" << std::endl;
+    std::cout << "[ BENCHMARK] software crc : " << host_time_us << " us on the host" << std::endl;
+    std::cout << "[ BENCHMARK] crc unit     : " << target_time_ms << " ms at 84 MHz" << std::endl;
+    RecordProperty("crc_unit_time_us", std::to_string((int)(target_time_ms * 1000.0)));
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(exit_code,    STD_SUCCESS);
+    EXPECT_EQ(info.size,    firmware_size);
+    EXPECT_EQ(info.crc32,   flash[(firmware_size / sizeof(uint32_t)) + 1U]);
+    EXPECT_LT(target_time_ms, 5.0);
+}
+
+TEST_F(ImageTestFixture, RejectFlippedBit)
+{
+    // Arrange: create and set up a system under test
+    flash[12345U] ^= 0x00010000U;
+
+    // Act: poke the system under test
+    const int exit_code = image_verify(&config, &info, &error);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(exit_code, STD_FAILURE);
+}
+
+TEST_F(ImageTestFixture, RejectCorruptedTrailer)
+{
+    // Arrange: create and set up a system under test
+    flash[(firmware_size / sizeof(uint32_t)) + 1U] ^= 0x01U;
+
+    // Act: poke the system under test
+    const int exit_code = image_verify(&config, &info, &error);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(exit_code, STD_FAILURE);
+}
+
+TEST_F(ImageTestFixture, RejectHalfProgrammedImage)
+{
+    // Arrange: create and set up a system under test
+    std::fill(flash.begin() + (64U * 1024U / sizeof(uint32_t)), flash.end(), 0xFFFFFFFFU);
+
+    // Act: poke the system under test
+    const int exit_code = image_verify(&config, &info, &error);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(exit_code, STD_FAILURE);
+}
+
+TEST_F(ImageTestFixture, RejectErasedFlash)
+{
+    // Arrange: create and set up a system under test
+    std::fill(flash.begin(), flash.end(), 0xFFFFFFFFU);
+
+    // Act: poke the system under test
+    const int exit_code = image_verify(&config, &info, &error);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(exit_code, STD_FAILURE);
+    EXPECT_EQ(info.size, 0U);
+}
+
+TEST_F(ImageTestFixture, RejectImageWithoutTrailer)
+{
+    // Arrange: create and set up a system under test
+    flash[(firmware_size / sizeof(uint32_t)) + 0U] = 0xFFFFFFFFU;
+    flash[(firmware_size / sizeof(uint32_t)) + 1U] = 0xFFFFFFFFU;
+
+    // Act: poke the system under test
+    const int exit_code = image_verify(&config, &info, &error);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(exit_code, STD_FAILURE);
+}
+
+
+TEST_F(ImageTestFixture, CheckFileInChunks)
+{
+    // Arrange: create and set up a system under test
+    const uint8_t *file = (const uint8_t*)(flash.data());
+    const size_t file_size = firmware_size + IMAGE_TRAILER_SIZE;
+
+    image_checker_t checker;
+    image_checker_init(&checker, crc32_update, gold_application_size);
+
+    // Act: poke the system under test
+    for (size_t offset = 0U; offset < file_size; offset += 7U)
+    {
+        image_checker_process(&checker, &file[offset], std::min((size_t)(7U), file_size - offset));
+    }
+    const int exit_code = image_checker_finish(&checker, &info, &error);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(exit_code,    STD_SUCCESS);
+    EXPECT_EQ(info.size,    firmware_size);
+    EXPECT_EQ(info.crc32,   flash[(firmware_size / sizeof(uint32_t)) + 1U]);
+}
+
+TEST_F(ImageTestFixture, CheckerRejectsFlippedBit)
+{
+    // Arrange: create and set up a system under test
+    flash[12345U] ^= 0x00010000U;
+
+    image_checker_t checker;
+    image_checker_init(&checker, crc32_update, gold_application_size);
+
+    // Act: poke the system under test
+    image_checker_process(&checker, (const uint8_t*)(flash.data()), firmware_size + IMAGE_TRAILER_SIZE);
+    const int exit_code = image_checker_finish(&checker, &info, &error);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(exit_code, STD_FAILURE);
+}
+
+TEST_F(ImageTestFixture, CheckerRejectsFileSize)
+{
+    // Arrange: create and set up a system under test
+    image_checker_t truncated_checker;
+    image_checker_t tailed_checker;
+    image_checker_init(&truncated_checker, crc32_update, gold_application_size);
+    image_checker_init(&tailed_checker, crc32_update, gold_application_size);
+
+    // Act: poke the system under test
+    image_checker_process(&truncated_checker, (const uint8_t*)(flash.data()), firmware_size + IMAGE_TRAILER_SIZE - 1U);
+    image_checker_process(&tailed_checker, (const uint8_t*)(flash.data()), firmware_size + IMAGE_TRAILER_SIZE + 4U);
+
+    const int truncated_exit_code   = image_checker_finish(&truncated_checker, &info, &error);
+    const int tailed_exit_code      = image_checker_finish(&tailed_checker, &info, &error);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(truncated_exit_code,  STD_FAILURE);
+    EXPECT_EQ(tailed_exit_code,     STD_FAILURE);
+}
+
+TEST_F(ImageTestFixture, CheckerRejectsRawFile)
+{
+    // Arrange: create and set up a system under test
+    flash[(IMAGE_INFO_OFFSET / sizeof(uint32_t)) + 0U] = 0xFFFFFFFFU;
+
+    image_checker_t checker;
+    image_checker_init(&checker, crc32_update, gold_application_size);
+
+    // Act: poke the system under test
+    image_checker_process(&checker, (const uint8_t*)(flash.data()), firmware_size + IMAGE_TRAILER_SIZE);
+    const int exit_code = image_checker_finish(&checker, &info, &error);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(exit_code, STD_FAILURE);
+    EXPECT_EQ(info.size, 0U);
+}
+
+
+class ImageParameterizedSize : public ImageTestFixture,
+                                public testing::WithParamInterface<uint32_t>
+{
+};
+
+TEST_P(ImageParameterizedSize, RejectSizeOutOfArea)
+{
+    // Arrange: create and set up a system under test
+    flash[(IMAGE_INFO_OFFSET / sizeof(uint32_t)) + 1U] = GetParam();
+
+    // Act: poke the system under test
+    const int exit_code = image_verify(&config, &info, &error);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(exit_code, STD_FAILURE);
+    EXPECT_EQ(info.size, 0U);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    ImageSize,
+    ImageParameterizedSize,
+    testing::Values(0U, IMAGE_INFO_OFFSET, firmware_size + 2U, gold_application_size - 4U, 0xFFFFFFFCU)
+);
+
+
+TEST(ImageStackPointer, AcceptStackTop)
+{
+    // Arrange: create and set up a system under test
+    const uint32_t ram_base = 0x20000000U;
+    const uint32_t ram_size = 64U * 1024U;
+
+    // Act: poke the system under test
+    const bool is_below_noinit_valid    = image_is_stack_pointer_valid(ram_base + ram_size - 256U, ram_base, ram_size);
+    const bool is_end_valid             = image_is_stack_pointer_valid(ram_base + ram_size, ram_base, ram_size);
+
+    // Assert: make unit test pass or fail
+    EXPECT_TRUE(is_below_noinit_valid);
+    EXPECT_TRUE(is_end_valid);
+}
+
+TEST(ImageStackPointer, RejectStackTop)
+{
+    // Arrange: create and set up a system under test
+    const uint32_t ram_base = 0x20000000U;
+    const uint32_t ram_size = 64U * 1024U;
+
+    // Act: poke the system under test
+    const bool is_erased_valid      = image_is_stack_pointer_valid(0xFFFFFFFFU, ram_base, ram_size);
+    const bool is_past_end_valid    = image_is_stack_pointer_valid(ram_base + ram_size + 8U, ram_base, ram_size);
+    const bool is_base_valid        = image_is_stack_pointer_valid(ram_base, ram_base, ram_size);
+    const bool is_unaligned_valid   = image_is_stack_pointer_valid(ram_base + ram_size - 4U, ram_base, ram_size);
+
+    // Assert: make unit test pass or fail
+    EXPECT_FALSE(is_erased_valid);
+    EXPECT_FALSE(is_past_end_valid);
+    EXPECT_FALSE(is_base_valid);
+    EXPECT_FALSE(is_unaligned_valid);
+}
+
+
+struct ImageBoard
+{
+    std::string linker_script;
+    std::string config_header;
+};
+
+class ImageParameterizedBoard : public testing::TestWithParam<ImageBoard>
+{
+    protected:
+
+        static std::string read_file (std::string const &path)
+        {
+            std::ifstream file(std::string(SOURCE_DIR) + "/" + path);
+            std::stringstream stream;
+            stream << file.rdbuf();
+
+            return stream.str();
+        }
+
+        // "128K - 256" -> 130816
+        static uint32_t parse_length (std::string const &length)
+        {
+            std::smatch match;
+            std::regex_match(length, match, std::regex(R"((\d+)K(?:\s*-\s*(\d+))?)"));
+
+            const uint32_t size = (uint32_t)(std::stoul(match[1].str())) * 1024U;
+
+            return (match[2].matched == true) ? (size - (uint32_t)(std::stoul(match[2].str()))) : size;
+        }
+};
+
+TEST_P(ImageParameterizedBoard, BootloaderAcceptsApplicationStack)
+{
+    // Arrange: create and set up a system under test
+    const std::string linker_script = read_file(GetParam().linker_script);
+    const std::string config_header = read_file(GetParam().config_header);
+
+    std::smatch estack_match;
+    std::smatch ram_match;
+    std::smatch sram_size_match;
+
+    ASSERT_TRUE(std::regex_search(linker_script, estack_match, std::regex(R"(_estack\s*=\s*ORIGIN\(RAM\)\s*\+\s*LENGTH\(RAM\);)")));
+    ASSERT_TRUE(std::regex_search(linker_script, ram_match, std::regex(R"(RAM \(xrw\)\s*:\s*ORIGIN\s*=\s*0x([0-9A-Fa-f]+),\s*LENGTH\s*=\s*([0-9K -]+?)\s*[\r\n])")));
+    ASSERT_TRUE(std::regex_search(config_header, sram_size_match, std::regex(R"(#define SRAM_SIZE\s+\((\d+) \* 1024\))")));
+
+    // What the linker puts into the first vector word and what the bootloader compares it against
+    const uint32_t estack       = (uint32_t)(std::stoul(ram_match[1].str(), nullptr, 16)) + parse_length(ram_match[2].str());
+    const uint32_t sram_base    = 0x20000000U;
+    const uint32_t sram_size    = (uint32_t)(std::stoul(sram_size_match[1].str())) * 1024U;
+
+    // Act: poke the system under test
+    const bool is_valid = image_is_stack_pointer_valid(estack, sram_base, sram_size);
+
+    // Assert: make unit test pass or fail
+    EXPECT_TRUE(is_valid);
+    EXPECT_EQ(estack, sram_base + sram_size - 256U);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    ImageBoard,
+    ImageParameterizedBoard,
+    testing::Values(
+        ImageBoard{ "src/gold/STM32F411CEUx_FLASH_APPLICATION.ld", "src/gold/board.config.h" },
+        ImageBoard{ "src/silver/STM32F401CCUx_FLASH_APPLICATION.ld", "src/silver/board.config.h" }
+    )
+);
@@ -0,0 +1,69 @@
+/************************************************************
+ *   Author : German Mundinger
+ *   Date   : 2024
+ ************************************************************/
+
+#include <gmock/gmock.h>
+
+#include <string>
+#include <vector>
+
+#include "crc32.h"
+
+
+TEST(Crc32Test, CheckValue)
+{
+    // Arrange: create and set up a system under test
+    const std::string data = "123456789";
+
+    // Act & Assert: poke the system under test and check the result
+    EXPECT_EQ(crc32_calculate((const uint8_t*)(data.data()), data.size()), 0x0376E6E7U);
+    EXPECT_EQ(crc32_calculate(nullptr, 0U), CRC32_INITIAL_VALUE);
+}
+
+TEST(Crc32Test, Incremental)
+{
+    // Arrange: create and set up a system under test
+    std::vector<uint8_t> data(1000U);
+
+    for (size_t i = 0U; i < data.size(); ++i)
+    {
+        data[i] = (uint8_t)((i * 31U) + 7U);
+    }
+
+    // Act: poke the system under test
+    uint32_t crc = CRC32_INITIAL_VALUE;
+
+    for (size_t i = 0U; i < data.size(); i += 77U)
+    {
+        crc = crc32_update(crc, &data[i], std::min<size_t>(77U, data.size() - i));
+    }
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(crc, crc32_calculate(data.data(), data.size()));
+}
+
+TEST(Crc32Test, Words)
+{
+    // Arrange: create and set up a system under test
+    const std::vector<uint32_t> words = { 0x12345678U, 0xDEADBEEFU, 0x00000000U, 0xFFFFFFFFU };
+
+    std::vector<uint8_t> bytes;
+
+    for (const uint32_t word : words)
+    {
+        bytes.push_back((uint8_t)(word >> 24U));
+        bytes.push_back((uint8_t)(word >> 16U));
+        bytes.push_back((uint8_t)(word >> 8U));
+        bytes.push_back((uint8_t)(word));
+    }
+
+    // Act: poke the system under test
+    const uint32_t crc = crc32_calculate_words(words.data(), words.size());
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(crc, crc32_calculate(bytes.data(), bytes.size()));
+
+    // Reference value of the STM32 CRC unit for a single 0x12345678 word
+    EXPECT_EQ(crc32_calculate_words(words.data(), 1U), 0xDF8A8A2BU);
+}
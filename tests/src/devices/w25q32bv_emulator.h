@@ -0,0 +1,697 @@
+/************************************************************
+ *   Author : German Mundinger
+ *   Date   : 2024
+ ************************************************************/
+
+#ifndef W25Q32BV_EMULATOR_H
+#define W25Q32BV_EMULATOR_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+#include "std_error/std_error.h"
+
+
+// The W25Q32BV on SPI1 of an 84 MHz core: the commands of the driver, NOR semantics, datasheet timings and wear.
+// Time is virtual, it goes on with the SPI bytes, the sleeps and the yields of the driver.
+// A larger W25Q is a set_part() away, its SFDP tables and 4 byte addressing come along.
+struct W25q32bvEmulator
+{
+    static constexpr uint32_t page_size     = 256U;
+    static constexpr uint32_t sector_size   = 4096U;
+    static constexpr uint32_t block_size    = 65536U;
+    static constexpr uint32_t cycles_per_us = 84U;
+
+    struct Part
+    {
+        const char *name;
+        uint32_t jedec_id;
+        uint32_t flash_size;
+        uint32_t sfdp_table_size;   // DWORDs of the basic table: 9 - JESD216, 16 - JESD216B, 0 - no SFDP
+        bool is_half_block_erase;
+    };
+
+    static constexpr Part w25q32bv              = { "W25Q32BV",             0xEF4016U,  4U * 1024U * 1024U,     9U,     true };
+    static constexpr Part w25q32bv_without_sfdp = { "W25Q32BV, no SFDP",    0xEF4016U,  4U * 1024U * 1024U,     0U,     true };
+    static constexpr Part w25q64jv              = { "W25Q64JV",             0xEF4017U,  8U * 1024U * 1024U,     16U,    true };
+    static constexpr Part w25q128jv             = { "W25Q128JV",            0xEF4018U,  16U * 1024U * 1024U,    16U,    true };
+    static constexpr Part w25q256jv             = { "W25Q256JV",            0xEF4019U,  32U * 1024U * 1024U,    16U,    true };
+    static constexpr Part uniform_64k           = { "64 KB erases only",    0xEF4017U,  8U * 1024U * 1024U,     16U,    false };
+
+    static constexpr uint32_t sfdp_table_address = 0x80U;
+
+    static constexpr uint8_t BUSY_BIT   = 0x01U;
+    static constexpr uint8_t WEL_BIT    = 0x02U;
+    static constexpr uint8_t SUS_BIT    = 0x80U;    // Of the status register 2
+
+    struct Timing
+    {
+        double page_program_us;
+        double sector_erase_us;
+        double half_block_erase_us;
+        double block_erase_us;
+        double chip_erase_us;
+        double release_power_down_us;
+    };
+
+    // Datasheet, the sector erase as on the boards
+    static constexpr Timing typical_timing  = { 700.0,  45000.0,    120000.0,   150000.0,   10000000.0, 3.0 };
+    static constexpr Timing maximum_timing  = { 3000.0, 200000.0,   800000.0,   1000000.0,  50000000.0, 3.0 };
+
+    static constexpr double spi_byte_time_us        = 8.0 / 42.0;
+    static constexpr double spi_transfer_time_us    = 2.0;
+    static constexpr double yield_time_us           = 1.0;
+    static constexpr double tick_time_us            = 1000.0;
+    static constexpr double suspend_time_us         = 20.0;     // tSUS, the datasheet max
+
+    struct Operation
+    {
+        uint8_t command;
+        double start_us;
+        double duration_us;
+        double ready_us;    // The first poll that saw it done
+    };
+
+    inline static W25q32bvEmulator *instance = nullptr;
+
+    Timing timing = typical_timing;
+
+    Part part               = w25q32bv;
+    uint32_t flash_size     = part.flash_size;
+    uint32_t sector_count   = flash_size / sector_size;
+
+    std::vector<uint8_t> memory = std::vector<uint8_t>(flash_size, 0xFFU);
+    std::vector<uint32_t> sector_erase_count = std::vector<uint32_t>(sector_count, 0U);
+    std::vector<uint8_t> sfdp = get_sfdp(part);
+    std::vector<Operation> operation_array;
+
+    double now_us           = 0.0;
+    double busy_until_us    = 0.0;
+    bool is_stuck           = false;
+    bool is_write_enabled   = false;
+    bool is_powered_down    = false;
+    bool is_selected        = false;
+    bool is_4_byte_address  = false;
+
+    // The erase that may be suspended, its sectors are not to be read or programmed meanwhile
+    uint32_t erase_address      = 0U;
+    uint32_t erase_size         = 0U;
+    double erase_remaining_us   = 0.0;
+    bool is_suspended           = false;
+
+    // Runs after every sleep of the driver, other tasks get the bus there
+    std::function<void ()> sleep_hook;
+
+    std::vector<uint8_t> command;
+    std::array<uint8_t, page_size> page_latch;
+
+    size_t lock_count           = 0U;
+    size_t spi_byte_count       = 0U;
+    size_t transfer_count       = 0U;
+    size_t status_poll_count    = 0U;
+    size_t read_count           = 0U;
+    size_t program_count        = 0U;
+    size_t erase_count          = 0U;
+    size_t sleep_count          = 0U;
+    size_t yield_count          = 0U;
+    size_t suspend_count        = 0U;
+    size_t violation_count      = 0U;   // Anything a real part would drop: no select, busy, powered down, no write enable
+    size_t max_transfer_size    = 0U;
+    uintptr_t stack_low_address = UINTPTR_MAX;  // Of the deepest SPI transfer, the stack grows down on the host too
+
+    W25q32bvEmulator ()
+    {
+        instance = this;
+    }
+
+    ~W25q32bvEmulator ()
+    {
+        if (instance == this)
+        {
+            instance = nullptr;
+        }
+    }
+
+    // A blank part of another size, before the driver sees it
+    void set_part (Part const &new_part)
+    {
+        part                = new_part;
+        flash_size          = part.flash_size;
+        sector_count        = flash_size / sector_size;
+        is_4_byte_address   = false;
+
+        memory.assign(flash_size, 0xFFU);
+        sector_erase_count.assign(sector_count, 0U);
+        sfdp = get_sfdp(part);
+    }
+
+    void reset_counters ()
+    {
+        lock_count          = 0U;
+        spi_byte_count      = 0U;
+        transfer_count      = 0U;
+        status_poll_count   = 0U;
+        read_count          = 0U;
+        program_count       = 0U;
+        erase_count         = 0U;
+        sleep_count         = 0U;
+        yield_count         = 0U;
+        suspend_count       = 0U;
+        violation_count     = 0U;
+        max_transfer_size   = 0U;
+        stack_low_address   = UINTPTR_MAX;
+
+        operation_array.clear();
+        std::fill(sector_erase_count.begin(), sector_erase_count.end(), 0U);
+    }
+
+    bool is_busy () const
+    {
+        return (is_stuck == true) || (now_us < busy_until_us);
+    }
+
+    uint8_t get_status () const
+    {
+        return (uint8_t)(((is_busy() == true) ? BUSY_BIT : 0U) | ((is_write_enabled == true) ? WEL_BIT : 0U));
+    }
+
+    uint8_t get_status_2 () const
+    {
+        return (is_suspended == true) ? SUS_BIT : 0U;
+    }
+
+    uint32_t get_max_sector_erase_count () const
+    {
+        return *std::max_element(sector_erase_count.begin(), sector_erase_count.end());
+    }
+
+    double get_busy_time_us () const
+    {
+        double time_us = 0.0;
+
+        for (Operation const &operation : operation_array)
+        {
+            time_us += operation.duration_us;
+        }
+        return time_us;
+    }
+
+
+    // SPI1 and its chip select
+    void select ()
+    {
+        if (is_selected == true)
+        {
+            ++violation_count;
+        }
+        is_selected = true;
+
+        command.clear();
+        page_latch.fill(0xFFU);
+    }
+
+    void unselect ()
+    {
+        is_selected = false;
+
+        if (command.empty() == true)
+        {
+            return;
+        }
+
+        const uint8_t opcode = command[0];
+
+        if (opcode == 0xABU)
+        {
+            if (is_powered_down == true)
+            {
+                is_powered_down = false;
+                now_us          += timing.release_power_down_us;
+            }
+            return;
+        }
+
+        // The status, the suspend and the resume are taken while busy
+        const bool is_busy_allowed = (opcode == 0x05U) || (opcode == 0x35U) || (opcode == 0x75U) || (opcode == 0x7AU);
+
+        if ((is_powered_down == true) || ((is_busy_allowed != true) && (is_busy() == true)))
+        {
+            ++violation_count;
+
+            return;
+        }
+
+        const bool is_erase = (opcode == 0x20U) || (opcode == 0x52U) || (opcode == 0xD8U) || (opcode == 0xC7U) || (opcode == 0x60U);
+
+        if ((is_suspended == true) && (is_erase == true))
+        {
+            ++violation_count;
+
+            return;
+        }
+
+        switch (opcode)
+        {
+            case 0x06U:
+                is_write_enabled = true;
+                break;
+
+            case 0x04U:
+                is_write_enabled = false;
+                break;
+
+            case 0xB9U:
+                is_powered_down = true;
+                break;
+
+            // The parts past 16 MB only, the others ignore them
+            case 0xB7U:
+                is_4_byte_address = (flash_size > (16U * 1024U * 1024U));
+                break;
+
+            case 0xE9U:
+                is_4_byte_address = false;
+                break;
+
+            case 0x75U:
+                suspend();
+                break;
+
+            case 0x7AU:
+                resume();
+                break;
+
+            case 0x02U:
+                if (command.size() > get_data_index())
+                {
+                    program();
+                }
+                break;
+
+            case 0x20U:
+                if (command.size() == get_data_index())
+                {
+                    erase(get_address() - (get_address() % sector_size), sector_size, timing.sector_erase_us);
+                }
+                break;
+
+            case 0x52U:
+                if (command.size() == get_data_index())
+                {
+                    erase(get_address() - (get_address() % (block_size / 2U)), block_size / 2U, timing.half_block_erase_us);
+                }
+                break;
+
+            case 0xD8U:
+                if (command.size() == get_data_index())
+                {
+                    erase(get_address() - (get_address() % block_size), block_size, timing.block_erase_us);
+                }
+                break;
+
+            case 0xC7U:
+            case 0x60U:
+                erase(0U, flash_size, timing.chip_erase_us);
+                break;
+
+            default:
+                break;
+        }
+        return;
+    }
+
+    void transfer (uint8_t const * const tx_data, uint8_t * const rx_data, uint16_t size)
+    {
+        if (is_selected != true)
+        {
+            ++violation_count;
+        }
+
+        now_us              += spi_transfer_time_us + ((double)(size) * spi_byte_time_us);
+        spi_byte_count      += size;
+        max_transfer_size   = std::max(max_transfer_size, (size_t)(size));
+        ++transfer_count;
+
+        const bool is_ready = (is_busy() != true);
+
+        for (uint16_t i = 0U; i < size; ++i)
+        {
+            const uint8_t rx_byte = exchange((tx_data != nullptr) ? tx_data[i] : 0xFFU);
+
+            if (rx_data != nullptr)
+            {
+                rx_data[i] = rx_byte;
+            }
+        }
+
+        if ((command[0] == 0x05U) && (command.size() > 1U))
+        {
+            ++status_poll_count;
+
+            if ((is_ready == true) && (is_suspended != true) && (operation_array.empty() != true) && (operation_array.back().ready_us == 0.0))
+            {
+                operation_array.back().ready_us = now_us;
+            }
+        }
+    }
+
+
+    // The RTOS around the driver
+    void delay (uint32_t delay_ms)
+    {
+        // vTaskDelay() wakes up on a tick boundary
+        now_us = (std::floor(now_us / tick_time_us) + (double)(delay_ms)) * tick_time_us;
+
+        ++sleep_count;
+
+        if (sleep_hook)
+        {
+            // Not again from within, the hook itself may sleep
+            std::function<void ()> hook;
+            std::swap(hook, sleep_hook);
+
+            hook();
+
+            std::swap(hook, sleep_hook);
+        }
+    }
+
+    void yield ()
+    {
+        now_us += yield_time_us;
+
+        ++yield_count;
+    }
+
+    uint32_t get_cycles () const
+    {
+        return (uint32_t)((uint64_t)(now_us * (double)(cycles_per_us)));
+    }
+
+
+    // Config callbacks of the driver and of storage, bound to the last emulator created
+    // A single task on the host, nothing to serialize
+    static void storage_lock ()
+    {
+        return;
+    }
+
+    static void storage_unlock ()
+    {
+        return;
+    }
+
+    static void spi_lock ()
+    {
+        ++instance->lock_count;
+
+        return;
+    }
+
+    static void spi_unlock ()
+    {
+        return;
+    }
+
+    static void spi_select ()
+    {
+        instance->select();
+
+        return;
+    }
+
+    static void spi_unselect ()
+    {
+        instance->unselect();
+
+        return;
+    }
+
+    static int spi_tx_rx (uint8_t *tx_data, uint8_t *rx_data, uint16_t size, uint32_t timeout_ms, std_error_t * const error)
+    {
+        (void)timeout_ms;
+        (void)error;
+
+        instance->stack_low_address = std::min(instance->stack_low_address, (uintptr_t)(__builtin_frame_address(0)));
+
+        instance->transfer(tx_data, rx_data, size);
+
+        return STD_SUCCESS;
+    }
+
+    static void delay_callback (uint32_t delay_ms)
+    {
+        instance->delay(delay_ms);
+
+        return;
+    }
+
+    static void yield_callback ()
+    {
+        instance->yield();
+
+        return;
+    }
+
+    static uint32_t get_cycles_callback ()
+    {
+        return instance->get_cycles();
+    }
+
+
+    private:
+
+        // JESD216: the header, a parameter header, the basic table
+        static std::vector<uint8_t> get_sfdp (Part const &sfdp_part)
+        {
+            if (sfdp_part.sfdp_table_size == 0U)
+            {
+                return {};
+            }
+
+            const uint8_t minor_revision = (sfdp_part.sfdp_table_size > 9U) ? 0x06U : 0x00U;
+
+            std::vector<uint8_t> data(sfdp_table_address + (sfdp_part.sfdp_table_size * 4U), 0xFFU);
+
+            const uint8_t header[16] = { 'S', 'F', 'D', 'P', minor_revision, 0x01U, 0x00U, 0xFFU,
+                                            0x00U, minor_revision, 0x01U, (uint8_t)(sfdp_part.sfdp_table_size),
+                                            (uint8_t)(sfdp_table_address), 0x00U, 0x00U, 0xFFU };
+            std::memcpy(data.data(), header, sizeof(header));
+
+            const bool is_4_byte_address_part = (sfdp_part.flash_size > (16U * 1024U * 1024U));
+
+            std::vector<uint32_t> table(sfdp_part.sfdp_table_size, 0xFFFFFFFFU);
+            table[0] = 0xFFF120E5U | ((is_4_byte_address_part == true) ? (1U << 17U) : 0U);    // 4 KB erases, 3 or 4 byte addresses
+            table[1] = (sfdp_part.flash_size * 8U) - 1U;                                        // Bits
+            table[7] = (sfdp_part.is_half_block_erase == true) ? 0x520F200CU : 0xFF00200CU;     // 4 KB 0x20, 32 KB 0x52
+            table[8] = 0xFF00D810U;                                                             // 64 KB 0xD8
+
+            if (sfdp_part.sfdp_table_size > 10U)
+            {
+                table[10] = 0x00000081U;    // 256 byte pages
+            }
+
+            for (size_t i = 0U; i < table.size(); ++i)
+            {
+                for (size_t j = 0U; j < 4U; ++j)
+                {
+                    data[sfdp_table_address + (i * 4U) + j] = (uint8_t)(table[i] >> (8U * j));
+                }
+            }
+            return data;
+        }
+
+        // SFDP reads take 3 bytes in any mode
+        size_t get_address_size () const
+        {
+            return ((is_4_byte_address == true) && (command[0] != 0x5AU)) ? 4U : 3U;
+        }
+
+        size_t get_data_index () const
+        {
+            return 1U + get_address_size();
+        }
+
+        uint32_t get_address () const
+        {
+            uint32_t address = 0U;
+
+            for (size_t i = 1U; i <= get_address_size(); ++i)
+            {
+                address = (address << 8U) | (uint32_t)(command[i]);
+            }
+            return address;
+        }
+
+        uint8_t exchange (uint8_t tx_byte)
+        {
+            command.push_back(tx_byte);
+
+            const size_t index  = command.size() - 1U;
+            const uint8_t opcode = command[0];
+
+            if (is_powered_down == true)
+            {
+                return 0xFFU;
+            }
+
+            // The status register is sent over and over for as long as the chip is selected
+            if (opcode == 0x05U)
+            {
+                return (index > 0U) ? get_status() : 0xFFU;
+            }
+            if (opcode == 0x35U)
+            {
+                return (index > 0U) ? get_status_2() : 0xFFU;
+            }
+
+            if (is_busy() == true)
+            {
+                return 0xFFU;
+            }
+
+            if ((opcode == 0x9FU) && (index > 0U) && (index < 4U))
+            {
+                return (uint8_t)(part.jedec_id >> (8U * (3U - index)));
+            }
+            if ((opcode == 0xABU) && (index >= 4U))
+            {
+                return (uint8_t)((part.jedec_id & 0xFFU) - 1U);
+            }
+            if ((opcode == 0x5AU) && (index >= 5U))
+            {
+                const size_t sfdp_address = get_address() + (index - 5U);
+
+                return (sfdp_address < sfdp.size()) ? sfdp[sfdp_address] : 0xFFU;
+            }
+            if ((opcode == 0x03U) && (index >= get_data_index()))
+            {
+                return read(index - get_data_index());
+            }
+            if ((opcode == 0x0BU) && (index >= (get_data_index() + 1U)))
+            {
+                return read(index - get_data_index() - 1U);
+            }
+            if ((opcode == 0x02U) && (index >= get_data_index()))
+            {
+                // Past the end of the page the latch wraps and the last bytes win
+                page_latch[((get_address() % page_size) + (uint32_t)(index - get_data_index())) % page_size] = tx_byte;
+            }
+            return 0xFFU;
+        }
+
+        uint8_t read (size_t offset)
+        {
+            if (offset == 0U)
+            {
+                ++read_count;
+
+                if (is_erasing(get_address()) == true)
+                {
+                    ++violation_count;
+                }
+            }
+            return memory[(get_address() + (uint32_t)(offset)) % flash_size];
+        }
+
+        void program ()
+        {
+            if (is_write_enabled != true)
+            {
+                ++violation_count;
+
+                return;
+            }
+
+            const uint32_t page = get_address() - (get_address() % page_size);
+
+            if (is_erasing(page) == true)
+            {
+                ++violation_count;
+
+                return;
+            }
+
+            for (uint32_t i = 0U; i < page_size; ++i)
+            {
+                // NOR flash can only clear bits
+                memory[page + i] &= page_latch[i];
+            }
+
+            ++program_count;
+            start(0x02U, timing.page_program_us);
+        }
+
+        void erase (uint32_t address, uint32_t size, double duration_us)
+        {
+            if (is_write_enabled != true)
+            {
+                ++violation_count;
+
+                return;
+            }
+
+            std::memset(&memory[address], 0xFF, size);
+
+            erase_address   = address;
+            erase_size      = size;
+
+            for (uint32_t sector = address / sector_size; sector < ((address + size) / sector_size); ++sector)
+            {
+                ++sector_erase_count[sector];
+            }
+
+            ++erase_count;
+            start(command[0], duration_us);
+        }
+
+        bool is_erasing (uint32_t address) const
+        {
+            return (is_suspended == true) && (address >= erase_address) && (address < (erase_address + erase_size));
+        }
+
+        void suspend ()
+        {
+            const bool is_erase_running = (is_busy() == true) && (is_suspended != true) && (operation_array.empty() != true) &&
+                                            ((operation_array.back().command == 0x20U) || (operation_array.back().command == 0x52U) ||
+                                            (operation_array.back().command == 0xD8U));
+
+            // Ignored otherwise, a chip erase goes on
+            if ((is_erase_running != true) || (is_stuck == true))
+            {
+                return;
+            }
+
+            erase_remaining_us  = busy_until_us - now_us;
+            busy_until_us       = now_us + suspend_time_us;
+            is_suspended        = true;
+
+            ++suspend_count;
+        }
+
+        void resume ()
+        {
+            if (is_suspended != true)
+            {
+                return;
+            }
+
+            busy_until_us   = std::max(busy_until_us, now_us) + erase_remaining_us;
+            is_suspended    = false;
+        }
+
+        void start (uint8_t opcode, double duration_us)
+        {
+            is_write_enabled    = false;
+            busy_until_us       = now_us + duration_us;
+
+            operation_array.push_back({ opcode, now_us, duration_us, 0.0 });
+        }
+};
+
+#endif // W25Q32BV_EMULATOR_H
@@ -0,0 +1,778 @@
+/************************************************************
+ *   Author : German Mundinger
+ *   Date   : 2024
+ ************************************************************/
+
+#include <gmock/gmock.h>
+
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "devices/w25q32bv_flash.h"
+#include "storage.h"
+#include "std_error/std_error.h"
+
+#include "w25q32bv_emulator.h"
+
+
+constexpr size_t firmware_size  = 64U * 1024U;
+constexpr size_t tcp_chunk_size = 128U;
+
+
+// The same run with the former wait: a status poll, then a whole tick sleep while busy
+static double get_tick_polling_time_us (W25q32bvEmulator const &emulator)
+{
+    const double poll_time_us = W25q32bvEmulator::spi_transfer_time_us + (2.0 * W25q32bvEmulator::spi_byte_time_us);
+
+    double shift_us = 0.0;
+
+    for (W25q32bvEmulator::Operation const &operation : emulator.operation_array)
+    {
+        const double start_us = operation.start_us + shift_us;
+
+        double ready_us = start_us + poll_time_us;
+
+        while (ready_us < (start_us + operation.duration_us))
+        {
+            ready_us = ((std::floor(ready_us / W25q32bvEmulator::tick_time_us) + 1.0) * W25q32bvEmulator::tick_time_us) + poll_time_us;
+        }
+        shift_us += (ready_us - start_us) - (operation.ready_us - operation.start_us);
+    }
+    return emulator.now_us + shift_us;
+}
+
+// From the frame of the caller down to the deepest SPI transfer, a frame of its own keeps the test body out of it
+__attribute__((noinline)) static size_t get_read_stack_usage (w25q32bv_flash_t const * const flash, W25q32bvEmulator &emulator,
+                                                                std::vector<uint8_t> &data, std_error_t * const error)
+{
+    emulator.stack_low_address = UINTPTR_MAX;
+
+    const uintptr_t stack_address = (uintptr_t)(__builtin_frame_address(0));
+
+    if (w25q32bv_flash_read_data_fast(flash, data.data(), (uint32_t)(data.size()), 0U, 0U, error) != STD_SUCCESS)
+    {
+        return SIZE_MAX;
+    }
+    return (size_t)(stack_address - emulator.stack_low_address);
+}
+
+static int append_chunk (uint8_t const * const data, uint32_t size, void *context, std_error_t * const error)
+{
+    (void)error;
+
+    std::vector<uint8_t> *result = (std::vector<uint8_t>*)(context);
+
+    // The bus is free for the others meanwhile
+    if (W25q32bvEmulator::instance->is_selected == true)
+    {
+        return STD_FAILURE;
+    }
+
+    result->insert(result->end(), data, data + size);
+
+    return STD_SUCCESS;
+}
+
+static double get_wait_time_us (W25q32bvEmulator const &emulator)
+{
+    double time_us = 0.0;
+
+    for (W25q32bvEmulator::Operation const &operation : emulator.operation_array)
+    {
+        time_us += operation.ready_us - operation.start_us;
+    }
+    return time_us;
+}
+
+
+class W25q32bvFlashTestFixture : public testing::Test
+{
+    protected:
+
+        W25q32bvEmulator emulator;
+        w25q32bv_flash_t flash;
+        std_error_t error;
+
+        virtual void SetUp() override
+        {
+            std_error_init(&error);
+
+            w25q32bv_flash_config_t config;
+            config.spi_lock_callback        = W25q32bvEmulator::spi_lock;
+            config.spi_unlock_callback      = W25q32bvEmulator::spi_unlock;
+            config.spi_select_callback      = W25q32bvEmulator::spi_select;
+            config.spi_unselect_callback    = W25q32bvEmulator::spi_unselect;
+            config.spi_tx_rx_callback       = W25q32bvEmulator::spi_tx_rx;
+            config.spi_timeout_ms           = 10U;
+            config.delay_callback           = W25q32bvEmulator::delay_callback;
+            config.yield_callback           = W25q32bvEmulator::yield_callback;
+            config.get_cycles_callback      = W25q32bvEmulator::get_cycles_callback;
+            config.cycles_per_us            = W25q32bvEmulator::cycles_per_us;
+
+            w25q32bv_flash_init(&flash, &config);
+        }
+
+        virtual void TearDown() override
+        {
+            EXPECT_EQ(emulator.violation_count, 0U);
+        }
+
+        storage_config_t get_storage_config () const
+        {
+            storage_config_t config;
+            config.lock_callback            = W25q32bvEmulator::storage_lock;
+            config.unlock_callback          = W25q32bvEmulator::storage_unlock;
+            config.spi_lock_callback        = W25q32bvEmulator::spi_lock;
+            config.spi_unlock_callback      = W25q32bvEmulator::spi_unlock;
+            config.spi_select_callback      = W25q32bvEmulator::spi_select;
+            config.spi_unselect_callback    = W25q32bvEmulator::spi_unselect;
+            config.spi_tx_rx_callback       = W25q32bvEmulator::spi_tx_rx;
+            config.spi_timeout_ms           = 10U;
+            config.delay_callback           = W25q32bvEmulator::delay_callback;
+            config.yield_callback           = W25q32bvEmulator::yield_callback;
+            config.get_cycles_callback      = W25q32bvEmulator::get_cycles_callback;
+            config.cycles_per_us            = W25q32bvEmulator::cycles_per_us;
+            config.geometry                 = { 16U, 256U, 256U, 128U, 500 };
+
+            return config;
+        }
+
+        int program (uint8_t *data, uint32_t size, uint32_t page_number, uint32_t page_offset)
+        {
+            if (w25q32bv_flash_enable_erasing_or_writing(&flash, &error) != STD_SUCCESS)
+            {
+                return STD_FAILURE;
+            }
+            if (w25q32bv_flash_write_page(&flash, data, size, page_number, page_offset, &error) != STD_SUCCESS)
+            {
+                return STD_FAILURE;
+            }
+            return w25q32bv_flash_wait_erasing_or_writing(&flash, PAGE_PROGRAM_W25Q32BV_OPERATION, &error);
+        }
+};
+
+
+TEST_F(W25q32bvFlashTestFixture, ProgramPageWithoutSleep)
+{
+    // Arrange: create and set up a system under test
+    uint8_t data[128];
+
+    for (size_t i = 0U; i < sizeof(data); ++i)
+    {
+        data[i] = (uint8_t)(i * 3U);
+    }
+
+    // Act: poke the system under test
+    const int exit_code = program(data, sizeof(data), 10U, 64U);
+
+    // Assert: make unit test pass or fail
+    const double wait_time_us = get_wait_time_us(emulator);
+
+    EXPECT_EQ(exit_code,                STD_SUCCESS);
+    EXPECT_EQ(emulator.sleep_count,     0U);
+    EXPECT_GE(wait_time_us,             W25q32bvEmulator::typical_timing.page_program_us);
+    EXPECT_LT(wait_time_us,             W25q32bvEmulator::typical_timing.page_program_us + 10.0);
+    EXPECT_EQ(std::memcmp(&emulator.memory[(10U * W25q32bvEmulator::page_size) + 64U], data, sizeof(data)), 0);
+}
+
+TEST_F(W25q32bvFlashTestFixture, EraseSectorWithSleep)
+{
+    // Arrange: create and set up a system under test
+    ASSERT_EQ(w25q32bv_flash_enable_erasing_or_writing(&flash, &error), STD_SUCCESS);
+    ASSERT_EQ(w25q32bv_flash_erase_sector(&flash, 7U, &error), STD_SUCCESS);
+
+    const size_t lock_count = emulator.lock_count;
+
+    // Act: poke the system under test
+    const int exit_code = w25q32bv_flash_wait_erasing_or_writing(&flash, SECTOR_ERASE_W25Q32BV_OPERATION, &error);
+
+    // Assert: make unit test pass or fail
+    const double wait_time_us       = get_wait_time_us(emulator);
+    const double sector_erase_us    = W25q32bvEmulator::typical_timing.sector_erase_us;
+
+    EXPECT_EQ(exit_code,                STD_SUCCESS);
+    EXPECT_EQ(emulator.yield_count,     0U);
+    EXPECT_LE(emulator.sleep_count,     (size_t)(sector_erase_us / W25q32bvEmulator::tick_time_us) + 1U);
+    EXPECT_GE(wait_time_us,             sector_erase_us);
+    EXPECT_LT(wait_time_us,             sector_erase_us + W25q32bvEmulator::tick_time_us + 10.0);
+
+    // The bus is free between the polls
+    EXPECT_EQ(emulator.lock_count - lock_count, emulator.status_poll_count);
+}
+
+TEST_F(W25q32bvFlashTestFixture, SpinYieldThenSleep)
+{
+    // Arrange: create and set up a system under test
+    emulator.busy_until_us = emulator.now_us + 3500.0;
+
+    // Act: poke the system under test
+    const int exit_code = w25q32bv_flash_wait_erasing_or_writing(&flash, PAGE_PROGRAM_W25Q32BV_OPERATION, &error);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(exit_code,                STD_SUCCESS);
+    EXPECT_GT(emulator.yield_count,     0U);
+    EXPECT_GT(emulator.sleep_count,     0U);
+    EXPECT_LE(emulator.sleep_count,     2U);
+}
+
+TEST_F(W25q32bvFlashTestFixture, ReadBack)
+{
+    // Arrange: create and set up a system under test
+    std::vector<uint8_t> data(W25q32bvEmulator::page_size);
+
+    for (size_t i = 0U; i < data.size(); ++i)
+    {
+        data[i] = (uint8_t)((i * 5U) + 1U);
+    }
+    ASSERT_EQ(program(data.data(), (uint32_t)(data.size()), 33U, 0U), STD_SUCCESS);
+
+    std::vector<uint8_t> read_data(100U);
+    std::vector<uint8_t> fast_read_data(100U);
+
+    // Act: poke the system under test
+    const int read_exit_code        = w25q32bv_flash_read_data(&flash, read_data.data(), 100U, 2U, 0x100U + 20U, &error);
+    const int fast_read_exit_code   = w25q32bv_flash_read_data_fast(&flash, fast_read_data.data(), 100U, 2U, 0x100U + 20U, &error);
+
+    // Assert: make unit test pass or fail
+    const std::vector<uint8_t> expected(data.begin() + 20U, data.begin() + 120U);
+
+    EXPECT_EQ(read_exit_code,       STD_SUCCESS);
+    EXPECT_EQ(fast_read_exit_code,  STD_SUCCESS);
+    EXPECT_EQ(read_data,            expected);
+    EXPECT_EQ(fast_read_data,       expected);
+}
+
+TEST_F(W25q32bvFlashTestFixture, ReadStackUsage)
+{
+    // Arrange: create and set up a system under test
+    for (size_t i = 0U; i < W25q32bvEmulator::sector_size; ++i)
+    {
+        emulator.memory[i] = (uint8_t)((i * 3U) + (i >> 8U));
+    }
+
+    std::vector<uint8_t> data(W25q32bvEmulator::sector_size);
+
+    // Act: poke the system under test
+    const size_t stack_usage = get_read_stack_usage(&flash, emulator, data, &error);
+
+    // Assert: make unit test pass or fail
+    const std::vector<uint8_t> expected(emulator.memory.begin(), emulator.memory.begin() + W25q32bvEmulator::sector_size);
+
+    // Nothing sized by the read, a dummy buffer of it alone would take 4 KB
+    EXPECT_LT(stack_usage,                  1024U);
+    EXPECT_EQ(data,                         expected);
+    EXPECT_EQ(emulator.spi_byte_count,      5U + W25q32bvEmulator::sector_size);
+}
+
+TEST_F(W25q32bvFlashTestFixture, LargeReadInChunks)
+{
+    // Arrange: create and set up a system under test
+    constexpr uint32_t size = (100U * 1024U) + 7U;
+
+    for (size_t i = 0U; i < size + 16U; ++i)
+    {
+        emulator.memory[i] = (uint8_t)((i * 7U) + (i >> 8U));
+    }
+
+    std::vector<uint8_t> read_data(size);
+    std::vector<uint8_t> fast_read_data(size);
+
+    // Act: poke the system under test
+    const int read_exit_code        = w25q32bv_flash_read_data(&flash, read_data.data(), size, 0U, 3U, &error);
+    const int fast_read_exit_code   = w25q32bv_flash_read_data_fast(&flash, fast_read_data.data(), size, 0U, 3U, &error);
+
+    // Assert: make unit test pass or fail
+    const std::vector<uint8_t> expected(emulator.memory.begin() + 3U, emulator.memory.begin() + 3U + size);
+
+    // Past the 16 bit size of an SPI transfer, one command each
+    EXPECT_EQ(read_exit_code,               STD_SUCCESS);
+    EXPECT_EQ(fast_read_exit_code,          STD_SUCCESS);
+    EXPECT_EQ(read_data,                    expected);
+    EXPECT_EQ(fast_read_data,               expected);
+    EXPECT_EQ(emulator.read_count,          2U);
+    EXPECT_LE(emulator.max_transfer_size,   W25q32bvEmulator::sector_size);
+}
+
+TEST_F(W25q32bvFlashTestFixture, ReadStream)
+{
+    // Arrange: create and set up a system under test
+    constexpr uint32_t size = (20U * 1024U) + 100U;
+
+    for (size_t i = 0U; i < size; ++i)
+    {
+        emulator.memory[(2U * W25q32bvEmulator::sector_size) + i] = (uint8_t)((i * 5U) + (i >> 8U));
+    }
+
+    uint8_t buffer[1024];
+    std::vector<uint8_t> result;
+
+    // Act: poke the system under test
+    const int exit_code = w25q32bv_flash_read_data_stream(&flash, buffer, sizeof(buffer), size, 2U, 0U, append_chunk, &result, &error);
+
+    // Assert: make unit test pass or fail
+    const auto begin = emulator.memory.begin() + (2U * W25q32bvEmulator::sector_size);
+    const std::vector<uint8_t> expected(begin, begin + size);
+
+    EXPECT_EQ(exit_code,            STD_SUCCESS);
+    EXPECT_EQ(result,               expected);
+    EXPECT_EQ(emulator.read_count,  (size + sizeof(buffer) - 1U) / sizeof(buffer));
+}
+
+TEST_F(W25q32bvFlashTestFixture, ReadStreamStopsOnCallback)
+{
+    // Arrange: create and set up a system under test
+    uint8_t buffer[256];
+    size_t chunk_count = 0U;
+
+    const w25q32bv_flash_read_callback_t fail_second = [] (uint8_t const * const, uint32_t, void *context, std_error_t * const error) -> int
+    {
+        size_t *count = (size_t*)(context);
+
+        if (++(*count) < 2U)
+        {
+            return STD_SUCCESS;
+        }
+        std_error_catch_custom(error, STD_FAILURE, "Full", __FILE__, __LINE__);
+
+        return STD_FAILURE;
+    };
+
+    // Act: poke the system under test
+    const int exit_code = w25q32bv_flash_read_data_stream(&flash, buffer, sizeof(buffer), 4096U, 0U, 0U, fail_second, &chunk_count, &error);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(exit_code,            STD_FAILURE);
+    EXPECT_EQ(error.code,           STD_FAILURE);
+    EXPECT_EQ(chunk_count,          2U);
+    EXPECT_EQ(emulator.read_count,  2U);
+}
+
+TEST_F(W25q32bvFlashTestFixture, ProgramClearsBitsOnly)
+{
+    // Arrange: create and set up a system under test
+    uint8_t first_data[2]   = { 0xF0U, 0x0FU };
+    uint8_t second_data[2]  = { 0x3CU, 0xFFU };
+
+    ASSERT_EQ(program(first_data, 2U, 0U, 0U), STD_SUCCESS);
+
+    // Act: poke the system under test
+    const int exit_code = program(second_data, 2U, 0U, 0U);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(exit_code,            STD_SUCCESS);
+    EXPECT_EQ(emulator.memory[0],   0x30U);
+    EXPECT_EQ(emulator.memory[1],   0x0FU);
+    EXPECT_EQ(emulator.memory[2],   0xFFU);
+}
+
+TEST_F(W25q32bvFlashTestFixture, ProgramWrapsInsidePage)
+{
+    // Arrange: create and set up a system under test
+    uint8_t tx_data[4 + 8] = { 0x02U, 0x00U, 0x01U, 0xFCU };
+
+    for (size_t i = 4U; i < sizeof(tx_data); ++i)
+    {
+        tx_data[i] = (uint8_t)(i);
+    }
+
+    emulator.is_write_enabled = true;
+
+    // Act: poke the system under test
+    emulator.select();
+    emulator.transfer(tx_data, nullptr, sizeof(tx_data));
+    emulator.unselect();
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(emulator.memory[0x1FCU],  4U);
+    EXPECT_EQ(emulator.memory[0x1FFU],  7U);
+    EXPECT_EQ(emulator.memory[0x100U],  8U);
+    EXPECT_EQ(emulator.memory[0x103U],  11U);
+    EXPECT_EQ(emulator.memory[0x200U],  0xFFU);
+}
+
+TEST_F(W25q32bvFlashTestFixture, EraseWear)
+{
+    // Arrange: create and set up a system under test
+    uint8_t data[1] = { 0x00U };
+
+    ASSERT_EQ(program(data, 1U, 16U * 5U, 0U), STD_SUCCESS);
+
+    // Act: poke the system under test
+    ASSERT_EQ(w25q32bv_flash_enable_erasing_or_writing(&flash, &error), STD_SUCCESS);
+    ASSERT_EQ(w25q32bv_flash_erase_sector(&flash, 5U, &error), STD_SUCCESS);
+    ASSERT_EQ(w25q32bv_flash_wait_erasing_or_writing(&flash, SECTOR_ERASE_W25Q32BV_OPERATION, &error), STD_SUCCESS);
+
+    ASSERT_EQ(w25q32bv_flash_enable_erasing_or_writing(&flash, &error), STD_SUCCESS);
+    ASSERT_EQ(w25q32bv_flash_erase_block(&flash, 0U, &error), STD_SUCCESS);
+    ASSERT_EQ(w25q32bv_flash_wait_erasing_or_writing(&flash, BLOCK_ERASE_W25Q32BV_OPERATION, &error), STD_SUCCESS);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(emulator.memory[5U * W25q32bvEmulator::sector_size],  0xFFU);
+    EXPECT_EQ(emulator.sector_erase_count[5],                       2U);
+    EXPECT_EQ(emulator.sector_erase_count[15],                      1U);
+    EXPECT_EQ(emulator.sector_erase_count[16],                      0U);
+    EXPECT_EQ(emulator.get_max_sector_erase_count(),                2U);
+    EXPECT_EQ(emulator.erase_count,                                 2U);
+}
+
+TEST_F(W25q32bvFlashTestFixture, HalfBlockErase)
+{
+    // Arrange: create and set up a system under test
+    uint8_t data[1] = { 0x00U };
+
+    ASSERT_EQ(program(data, 1U, 16U * 7U, 0U), STD_SUCCESS);
+    ASSERT_EQ(program(data, 1U, 16U * 8U, 0U), STD_SUCCESS);
+    ASSERT_EQ(program(data, 1U, 16U * 15U, 0U), STD_SUCCESS);
+
+    // Act: poke the system under test
+    ASSERT_EQ(w25q32bv_flash_enable_erasing_or_writing(&flash, &error), STD_SUCCESS);
+    ASSERT_EQ(w25q32bv_flash_erase_half_block(&flash, 1U, &error), STD_SUCCESS);
+    ASSERT_EQ(w25q32bv_flash_wait_erasing_or_writing(&flash, HALF_BLOCK_ERASE_W25Q32BV_OPERATION, &error), STD_SUCCESS);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(emulator.memory[7U * W25q32bvEmulator::sector_size],  0x00U);
+    EXPECT_EQ(emulator.memory[8U * W25q32bvEmulator::sector_size],  0xFFU);
+    EXPECT_EQ(emulator.memory[15U * W25q32bvEmulator::sector_size], 0xFFU);
+    EXPECT_EQ(emulator.sector_erase_count[7],                       0U);
+    EXPECT_EQ(emulator.sector_erase_count[8],                       1U);
+    EXPECT_EQ(emulator.sector_erase_count[15],                      1U);
+    EXPECT_EQ(emulator.sector_erase_count[16],                      0U);
+    EXPECT_EQ(emulator.operation_array.back().duration_us,          W25q32bvEmulator::typical_timing.half_block_erase_us);
+}
+
+TEST_F(W25q32bvFlashTestFixture, EraseSuspendResume)
+{
+    // Arrange: create and set up a system under test
+    uint8_t data[4] = { 1U, 2U, 3U, 4U };
+
+    ASSERT_EQ(program(data, sizeof(data), 16U * 20U, 0U), STD_SUCCESS);
+
+    ASSERT_EQ(w25q32bv_flash_enable_erasing_or_writing(&flash, &error), STD_SUCCESS);
+    ASSERT_EQ(w25q32bv_flash_erase_block(&flash, 0U, &error), STD_SUCCESS);
+
+    const double erase_start_us = emulator.now_us;
+
+    emulator.delay(50U);
+
+    // Act: poke the system under test
+    const double suspend_start_us = emulator.now_us;
+
+    bool is_suspended;
+    const int suspend_exit_code = w25q32bv_flash_suspend_erasing(&flash, &is_suspended, &error);
+
+    const double suspend_latency_us = emulator.now_us - suspend_start_us;
+
+    // Anywhere but block 0
+    uint8_t result[4];
+    ASSERT_EQ(w25q32bv_flash_read_data_fast(&flash, result, sizeof(result), 20U, 0U, &error), STD_SUCCESS);
+    ASSERT_EQ(program(data, sizeof(data), 16U * 21U, 0U), STD_SUCCESS);
+
+    const double suspended_time_us = emulator.now_us - suspend_start_us;
+
+    ASSERT_EQ(w25q32bv_flash_resume_erasing(&flash, &error), STD_SUCCESS);
+    const int wait_exit_code = w25q32bv_flash_wait_erasing_or_writing(&flash, BLOCK_ERASE_W25Q32BV_OPERATION, &error);
+
+    // Assert: make unit test pass or fail
+    const double block_erase_us = W25q32bvEmulator::typical_timing.block_erase_us;
+
+    std::cout << "[ BENCHMARK] suspend  : " << suspend_latency_us << " us to readable, " << suspended_time_us << " us suspended" << std::endl;
+    RecordProperty("suspend_latency_us", std::to_string((int)(suspend_latency_us)));
+
+    EXPECT_EQ(suspend_exit_code,    STD_SUCCESS);
+    EXPECT_EQ(wait_exit_code,       STD_SUCCESS);
+    EXPECT_TRUE(is_suspended);
+    EXPECT_EQ(emulator.suspend_count, 1U);
+    EXPECT_LT(suspend_latency_us,   W25q32bvEmulator::suspend_time_us + 20.0);
+    EXPECT_EQ(std::memcmp(result, data, sizeof(data)),                  0);
+    EXPECT_EQ(emulator.memory[21U * W25q32bvEmulator::sector_size],     1U);
+    EXPECT_EQ(emulator.memory[0U],                                      0xFFU);
+
+    // Resumed, not started over
+    EXPECT_GE(emulator.now_us - erase_start_us, block_erase_us + suspended_time_us);
+    EXPECT_LT(emulator.now_us - erase_start_us, block_erase_us + suspended_time_us + (20.0 * W25q32bvEmulator::tick_time_us));
+}
+
+TEST_F(W25q32bvFlashTestFixture, SuspendOnlyErases)
+{
+    // Arrange: create and set up a system under test
+    bool is_idle_suspended;
+    bool is_chip_erase_suspended = false;
+
+    // Act: poke the system under test
+    const int idle_exit_code = w25q32bv_flash_suspend_erasing(&flash, &is_idle_suspended, &error);
+
+    ASSERT_EQ(w25q32bv_flash_enable_erasing_or_writing(&flash, &error), STD_SUCCESS);
+    ASSERT_EQ(w25q32bv_flash_erase_chip(&flash, &error), STD_SUCCESS);
+
+    const double suspend_start_us = emulator.now_us;
+
+    const int chip_erase_exit_code = w25q32bv_flash_suspend_erasing(&flash, &is_chip_erase_suspended, &error);
+
+    const double suspend_time_us = emulator.now_us - suspend_start_us;
+
+    ASSERT_EQ(w25q32bv_flash_wait_erasing_or_writing(&flash, CHIP_ERASE_W25Q32BV_OPERATION, &error), STD_SUCCESS);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(idle_exit_code,           STD_SUCCESS);
+    EXPECT_FALSE(is_idle_suspended);
+    EXPECT_EQ(chip_erase_exit_code,     STD_FAILURE);
+    EXPECT_FALSE(is_chip_erase_suspended);
+    EXPECT_LT(suspend_time_us,          1100.0);
+    EXPECT_EQ(emulator.suspend_count,   0U);
+}
+
+TEST_F(W25q32bvFlashTestFixture, PowerDownDropsCommands)
+{
+    // Arrange: create and set up a system under test
+    ASSERT_EQ(w25q32bv_flash_power_down(&flash, &error), STD_SUCCESS);
+
+    w25q32bv_flash_info_t info;
+
+    // Act: poke the system under test
+    ASSERT_EQ(w25q32bv_flash_read_info(&flash, &info, &error), STD_SUCCESS);
+
+    const uint32_t powered_down_jedec_id = info.jedec_id;
+    emulator.violation_count = 0U;
+
+    ASSERT_EQ(w25q32bv_flash_release_power_down(&flash, &error), STD_SUCCESS);
+    ASSERT_EQ(w25q32bv_flash_read_info(&flash, &info, &error), STD_SUCCESS);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(powered_down_jedec_id,    0xFFFFFFU);
+    EXPECT_EQ(info.jedec_id,            0xEF4016U);
+    EXPECT_EQ(info.capacity_KByte,      4096U);
+}
+
+TEST_F(W25q32bvFlashTestFixture, WorstCaseTimingWithinTimeout)
+{
+    // Arrange: create and set up a system under test
+    emulator.timing = W25q32bvEmulator::maximum_timing;
+
+    uint8_t data[W25q32bvEmulator::page_size] = {};
+
+    // Act: poke the system under test
+    const int program_exit_code = program(data, sizeof(data), 0U, 0U);
+
+    ASSERT_EQ(w25q32bv_flash_enable_erasing_or_writing(&flash, &error), STD_SUCCESS);
+    ASSERT_EQ(w25q32bv_flash_erase_chip(&flash, &error), STD_SUCCESS);
+
+    const int erase_exit_code = w25q32bv_flash_wait_erasing_or_writing(&flash, CHIP_ERASE_W25Q32BV_OPERATION, &error);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(program_exit_code,        STD_SUCCESS);
+    EXPECT_EQ(erase_exit_code,          STD_SUCCESS);
+    EXPECT_EQ(emulator.memory[0],       0xFFU);
+    EXPECT_EQ(emulator.sector_erase_count[emulator.sector_count - 1U], 1U);
+}
+
+
+struct WaitTimeoutParameter
+{
+    w25q32bv_flash_operation_t operation;
+    double timeout_us;
+};
+
+class W25q32bvFlashParameterizedTimeout : public W25q32bvFlashTestFixture,
+                                            public testing::WithParamInterface<WaitTimeoutParameter>
+{
+};
+
+TEST_P(W25q32bvFlashParameterizedTimeout, StuckBusy)
+{
+    // Arrange: create and set up a system under test
+    const WaitTimeoutParameter parameter = GetParam();
+
+    emulator.is_stuck = true;
+
+    // Act: poke the system under test
+    const int exit_code = w25q32bv_flash_wait_erasing_or_writing(&flash, parameter.operation, &error);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(exit_code,    STD_FAILURE);
+    EXPECT_EQ(error.code,   STD_FAILURE);
+    EXPECT_GT(emulator.now_us, parameter.timeout_us * 0.9);
+    EXPECT_LT(emulator.now_us, parameter.timeout_us * 1.1);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    W25q32bvFlashTimeout,
+    W25q32bvFlashParameterizedTimeout,
+    testing::Values(
+        WaitTimeoutParameter { PAGE_PROGRAM_W25Q32BV_OPERATION,     10000.0 },
+        WaitTimeoutParameter { SECTOR_ERASE_W25Q32BV_OPERATION,     400000.0 },
+        WaitTimeoutParameter { HALF_BLOCK_ERASE_W25Q32BV_OPERATION, 1600000.0 },
+        WaitTimeoutParameter { BLOCK_ERASE_W25Q32BV_OPERATION,      2000000.0 },
+        WaitTimeoutParameter { CHIP_ERASE_W25Q32BV_OPERATION,       100000000.0 },
+        WaitTimeoutParameter { ERASE_SUSPEND_W25Q32BV_OPERATION,    1000.0 }
+    )
+);
+
+
+class W25q32bvFlashParameterizedPart : public W25q32bvFlashTestFixture,
+                                        public testing::WithParamInterface<W25q32bvEmulator::Part>
+{
+    protected:
+
+        virtual void SetUp() override
+        {
+            W25q32bvFlashTestFixture::SetUp();
+
+            emulator.set_part(GetParam());
+        }
+};
+
+TEST_P(W25q32bvFlashParameterizedPart, Detect)
+{
+    // Arrange: create and set up a system under test
+    const W25q32bvEmulator::Part part = GetParam();
+
+    // Act: poke the system under test
+    const int exit_code = w25q32bv_flash_detect(&flash, &error);
+
+    w25q32bv_flash_array_t array;
+    w25q32bv_flash_get_array(&flash, &array);
+
+    w25q32bv_flash_info_t info;
+    ASSERT_EQ(w25q32bv_flash_read_info(&flash, &info, &error), STD_SUCCESS);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(exit_code,                    STD_SUCCESS);
+    EXPECT_EQ(info.jedec_id,                part.jedec_id);
+    EXPECT_EQ(info.capacity_KByte,          part.flash_size / 1024U);
+    EXPECT_EQ(array.page_size,              W25q32bvEmulator::page_size);
+    EXPECT_EQ(array.page_count,             part.flash_size / W25q32bvEmulator::page_size);
+    EXPECT_EQ(array.sector_size,            W25q32bvEmulator::sector_size);
+    EXPECT_EQ(array.sector_count,           part.flash_size / W25q32bvEmulator::sector_size);
+    EXPECT_EQ(array.block_size,             W25q32bvEmulator::block_size);
+    EXPECT_EQ(array.block_count,            part.flash_size / W25q32bvEmulator::block_size);
+    EXPECT_EQ(emulator.is_4_byte_address,   part.flash_size > (16U * 1024U * 1024U));
+}
+
+TEST_P(W25q32bvFlashParameterizedPart, LastSector)
+{
+    // Arrange: create and set up a system under test
+    ASSERT_EQ(w25q32bv_flash_detect(&flash, &error), STD_SUCCESS);
+
+    w25q32bv_flash_array_t array;
+    w25q32bv_flash_get_array(&flash, &array);
+
+    uint8_t data[W25q32bvEmulator::page_size];
+
+    for (size_t i = 0U; i < sizeof(data); ++i)
+    {
+        data[i] = (uint8_t)(i * 3U);
+    }
+
+    const uint32_t last_sector  = array.sector_count - 1U;
+    const uint32_t last_page    = array.page_count - 1U;
+
+    emulator.memory[emulator.flash_size - 1U] = 0x00U;
+
+    // Act: poke the system under test
+    ASSERT_EQ(w25q32bv_flash_enable_erasing_or_writing(&flash, &error), STD_SUCCESS);
+    ASSERT_EQ(w25q32bv_flash_erase_sector(&flash, last_sector, &error), STD_SUCCESS);
+    ASSERT_EQ(w25q32bv_flash_wait_erasing_or_writing(&flash, SECTOR_ERASE_W25Q32BV_OPERATION, &error), STD_SUCCESS);
+    ASSERT_EQ(program(data, sizeof(data), last_page, 0U), STD_SUCCESS);
+
+    uint8_t read_data[W25q32bvEmulator::page_size];
+    uint8_t fast_read_data[W25q32bvEmulator::page_size];
+
+    const uint32_t sector_offset = W25q32bvEmulator::sector_size - W25q32bvEmulator::page_size;
+
+    ASSERT_EQ(w25q32bv_flash_read_data(&flash, read_data, sizeof(read_data), last_sector, sector_offset, &error), STD_SUCCESS);
+    ASSERT_EQ(w25q32bv_flash_read_data_fast(&flash, fast_read_data, sizeof(fast_read_data), last_sector, sector_offset, &error), STD_SUCCESS);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(std::memcmp(read_data,        data, sizeof(data)), 0);
+    EXPECT_EQ(std::memcmp(fast_read_data,   data, sizeof(data)), 0);
+    EXPECT_EQ(std::memcmp(&emulator.memory[emulator.flash_size - sizeof(data)], data, sizeof(data)), 0);
+    EXPECT_EQ(emulator.sector_erase_count[last_sector], 1U);
+    EXPECT_EQ(emulator.get_max_sector_erase_count(),    1U);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    W25q32bvFlashPart,
+    W25q32bvFlashParameterizedPart,
+    testing::Values(
+        W25q32bvEmulator::w25q32bv,
+        W25q32bvEmulator::w25q32bv_without_sfdp,
+        W25q32bvEmulator::w25q64jv,
+        W25q32bvEmulator::w25q128jv,
+        W25q32bvEmulator::w25q256jv
+    )
+);
+
+TEST_F(W25q32bvFlashTestFixture, DetectRefusesOtherErases)
+{
+    // Arrange: create and set up a system under test
+    emulator.set_part(W25q32bvEmulator::uniform_64k);
+
+    // Act: poke the system under test
+    const int exit_code = w25q32bv_flash_detect(&flash, &error);
+
+    w25q32bv_flash_array_t array;
+    w25q32bv_flash_get_array(&flash, &array);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(exit_code,            STD_FAILURE);
+    EXPECT_EQ(error.code,           STD_FAILURE);
+    EXPECT_EQ(array.sector_count,   1024U);
+}
+
+
+TEST_F(W25q32bvFlashTestFixture, LittlefsWriteThroughput)
+{
+    // Arrange: create and set up a system under test
+    std::vector<uint8_t> firmware(firmware_size);
+
+    for (size_t i = 0U; i < firmware.size(); ++i)
+    {
+        firmware[i] = (uint8_t)((i * 7U) + (i >> 8U));
+    }
+
+    const storage_config_t config = get_storage_config();
+    const char file_name[64] = "firmware\0";
+
+    storage_t storage;
+    ASSERT_EQ(storage_init(&storage, &config, &error), STD_SUCCESS);
+    ASSERT_EQ(storage_enable_power(&storage, &error), STD_SUCCESS);
+    ASSERT_EQ(storage_mount_filesystem(&storage, &error), STD_SUCCESS);
+
+    emulator.operation_array.clear();
+
+    const double start_us = emulator.now_us;
+
+    // Act: poke the system under test
+    storage_stream_t stream;
+    ASSERT_EQ(storage_create_stream(&storage, &stream, file_name, STORAGE_STREAM_CHECKPOINT_SIZE, &error), STD_SUCCESS);
+
+    for (size_t i = 0U; i < firmware.size(); i += tcp_chunk_size)
+    {
+        ASSERT_EQ(storage_write_stream(&storage, &stream, &firmware[i], tcp_chunk_size, &error), STD_SUCCESS);
+    }
+
+    size_t stream_size;
+    const int exit_code = storage_close_stream(&storage, &stream, &stream_size, &error);
+
+    // Assert: make unit test pass or fail
+    const double time_us                = emulator.now_us - start_us;
+    const double tick_polling_time_us   = get_tick_polling_time_us(emulator) - start_us;
+
+    const double throughput_KBps                = ((double)(firmware_size) / 1024.0) / (time_us / 1000000.0);
+    const double tick_polling_throughput_KBps   = ((double)(firmware_size) / 1024.0) / (tick_polling_time_us / 1000000.0);
+
+    std::cout << "[ BENCHMARK] tick polling     : " << tick_polling_time_us / 1000.0 << " ms, " << tick_polling_throughput_KBps << " KB/s" << std::endl;
+    std::cout << "[ BENCHMARK] adaptive polling : " << time_us / 1000.0 << " ms, " << throughput_KBps << " KB/s, "
+                << emulator.operation_array.size() << " programs and erases" << std::endl;
+    RecordProperty("tick_polling_throughput_KBps",  std::to_string(tick_polling_throughput_KBps));
+    RecordProperty("throughput_KBps",               std::to_string(throughput_KBps));
+
+    EXPECT_EQ(exit_code,    STD_SUCCESS);
+    EXPECT_EQ(stream_size,  firmware.size());
+    EXPECT_LT(time_us,      tick_polling_time_us);
+
+    storage_unmount_filesystem(&storage, &error);
+}
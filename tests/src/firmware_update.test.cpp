@@ -0,0 +1,462 @@
+/************************************************************
+ *   Author : German Mundinger
+ *   Date   : 2024
+ ************************************************************/
+
+#include <gmock/gmock.h>
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <vector>
+
+#include "firmware_update.h"
+#include "crc32.h"
+#include "std_error/std_error.h"
+
+
+constexpr size_t firmware_size  = 100U * 1024U + 77U;
+constexpr size_t tcp_recv_size  = 128U;
+
+
+// Answers every RESUME with the header and the chunks from the asked offset, like the admin server does
+struct ScriptedServer
+{
+    std::vector<uint8_t> image;
+    firmware_update_header_t header;
+
+    std::deque<uint8_t> stream;
+    std::vector<uint32_t> resume_offsets;
+    std::vector<uint8_t> results;
+
+    size_t sent_size = 0U;
+    size_t lost_resume_count = 0U;  // What the single send buffer of tcp_client drops
+
+    std::deque<size_t> frame_sizes;
+    size_t frame_tail_size = 0U;   // Bytes of the front frame already sent
+
+    void receive (uint8_t const *frame, size_t size)
+    {
+        ASSERT_GE(size, (size_t)(FIRMWARE_UPDATE_FRAME_HEAD_SIZE + FIRMWARE_UPDATE_FRAME_CRC_SIZE));
+
+        const uint32_t offset = (uint32_t)(frame[4]) | ((uint32_t)(frame[5]) << 8U) | ((uint32_t)(frame[6]) << 16U) | ((uint32_t)(frame[7]) << 24U);
+
+        if ((frame[2] == RESUME_FRAME) && (lost_resume_count != 0U))
+        {
+            --lost_resume_count;
+        }
+        else if (frame[2] == RESUME_FRAME)
+        {
+            resume_offsets.push_back(offset);
+            restart(offset);
+        }
+        else if (frame[2] == RESULT_FRAME)
+        {
+            results.push_back(frame[FIRMWARE_UPDATE_FRAME_HEAD_SIZE]);
+        }
+    }
+
+    void restart (uint32_t offset)
+    {
+        // A frame already started on the wire goes out whole
+        if (frame_tail_size != 0U)
+        {
+            const size_t frame_left = frame_sizes.front() - frame_tail_size;
+
+            stream.erase(stream.begin() + (std::ptrdiff_t)(frame_left), stream.end());
+            frame_sizes.erase(frame_sizes.begin() + 1, frame_sizes.end());
+        }
+        else
+        {
+            disconnect();
+        }
+
+        uint8_t payload[FIRMWARE_UPDATE_HEADER_SIZE];
+        firmware_update_pack_header(&header, payload);
+        push_frame(IMAGE_HEADER_FRAME, 0U, payload, sizeof(payload));
+
+        for (size_t i = offset; i < image.size(); i += FIRMWARE_UPDATE_CHUNK_SIZE)
+        {
+            push_frame(IMAGE_CHUNK_FRAME, (uint32_t)(i), &image[i], std::min((size_t)(FIRMWARE_UPDATE_CHUNK_SIZE), image.size() - i));
+        }
+    }
+
+    void push_frame (firmware_update_frame_type_t type, uint32_t offset, uint8_t const *payload, size_t size)
+    {
+        uint8_t frame[FIRMWARE_UPDATE_FRAME_MAX_SIZE];
+        const size_t frame_size = firmware_update_pack_frame(type, offset, payload, size, frame);
+
+        stream.insert(stream.end(), frame, frame + frame_size);
+        frame_sizes.push_back(frame_size);
+    }
+
+    void disconnect ()
+    {
+        stream.clear();
+        frame_sizes.clear();
+        frame_tail_size = 0U;
+    }
+
+    // Pops up to size bytes, what a single recv() would return
+    std::vector<uint8_t> pop (size_t size)
+    {
+        size = std::min(size, stream.size());
+
+        std::vector<uint8_t> segment(stream.begin(), stream.begin() + (std::ptrdiff_t)(size));
+        stream.erase(stream.begin(), stream.begin() + (std::ptrdiff_t)(size));
+
+        sent_size += size;
+
+        while ((size != 0U) && (frame_sizes.empty() != true))
+        {
+            const size_t frame_left = frame_sizes.front() - frame_tail_size;
+
+            if (size >= frame_left)
+            {
+                size -= frame_left;
+                frame_sizes.pop_front();
+                frame_tail_size = 0U;
+            }
+            else
+            {
+                frame_tail_size += size;
+                size = 0U;
+            }
+        }
+
+        return segment;
+    }
+};
+
+
+class FirmwareUpdateTestFixture : public testing::Test
+{
+    protected:
+
+        static FirmwareUpdateTestFixture *instance;
+
+        firmware_update_t firmware_update;
+        std_error_t error;
+
+        ScriptedServer server;
+        std::vector<uint8_t> written;
+        size_t start_count      = 0U;
+        size_t commit_count     = 0U;
+        size_t discard_count    = 0U;
+        uint32_t time_ms        = 0U;
+
+        virtual void SetUp() override
+        {
+            instance = this;
+
+            std_error_init(&error);
+
+            server.image.resize(firmware_size);
+
+            for (size_t i = 0U; i < server.image.size(); ++i)
+            {
+                server.image[i] = (uint8_t)((i * 13U) + (i >> 9U));
+            }
+
+            server.header.image_size    = (uint32_t)(server.image.size());
+            server.header.image_crc32   = crc32_calculate(server.image.data(), server.image.size());
+            server.header.version_major = 1U;
+            server.header.version_minor = 2U;
+            server.header.version_patch = 3U;
+            server.header.image_type    = FULL_IMAGE_TYPE;
+
+            firmware_update_config_t config;
+            config.start_callback   = start;
+            config.write_callback   = write;
+            config.commit_callback  = commit;
+            config.discard_callback = discard;
+            config.send_callback    = send;
+            config.time_callback    = get_time;
+            config.max_image_size   = 192U * 1024U;
+
+            firmware_update_init(&firmware_update, &config);
+        }
+
+        // Feeds the node with recv() sized segments until the server has nothing to say or the budget ends
+        void transfer (size_t budget = SIZE_MAX, size_t segment_size = tcp_recv_size)
+        {
+            while ((server.stream.empty() != true) && (budget != 0U))
+            {
+                const std::vector<uint8_t> segment = server.pop(std::min(segment_size, budget));
+                budget -= segment.size();
+
+                firmware_update_process(&firmware_update, segment.data(), segment.size(), &error);
+            }
+        }
+
+        firmware_update_state_t get_state ()
+        {
+            firmware_update_state_t state;
+            firmware_update_get_state(&firmware_update, &state);
+
+            return state;
+        }
+
+        static int start (firmware_update_header_t const * const header, std_error_t * const error)
+        {
+            (void)header;
+            (void)error;
+
+            instance->written.clear();
+            ++instance->start_count;
+
+            return STD_SUCCESS;
+        }
+
+        static int write (uint8_t const * const data, size_t size, std_error_t * const error)
+        {
+            (void)error;
+
+            instance->written.insert(instance->written.end(), data, data + size);
+
+            return STD_SUCCESS;
+        }
+
+        static int commit (firmware_update_header_t const * const header, std_error_t * const error)
+        {
+            (void)header;
+            (void)error;
+
+            ++instance->commit_count;
+
+            return STD_SUCCESS;
+        }
+
+        static void discard ()
+        {
+            instance->written.clear();
+            ++instance->discard_count;
+
+            return;
+        }
+
+        static void send (uint8_t const * const frame, size_t size)
+        {
+            instance->server.receive(frame, size);
+
+            return;
+        }
+
+        static uint32_t get_time ()
+        {
+            return instance->time_ms;
+        }
+};
+
+FirmwareUpdateTestFixture *FirmwareUpdateTestFixture::instance = nullptr;
+
+
+TEST_F(FirmwareUpdateTestFixture, FullTransfer)
+{
+    // Arrange: create and set up a system under test
+    firmware_update_resume(&firmware_update);
+
+    // Act: poke the system under test
+    transfer();
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(get_state(),          COMPLETE_STATE);
+    EXPECT_EQ(server.results,       std::vector<uint8_t>{ IMAGE_ACCEPTED });
+    EXPECT_EQ(written,              server.image);
+    EXPECT_EQ(start_count,          1U);
+    EXPECT_EQ(commit_count,         1U);
+    EXPECT_EQ(discard_count,        0U);
+}
+
+TEST_F(FirmwareUpdateTestFixture, ShortSegmentsAreNotEndOfFile)
+{
+    // Arrange: create and set up a system under test
+    firmware_update_resume(&firmware_update);
+
+    // Act: poke the system under test
+    size_t segment_size = 1U;
+
+    while (server.stream.empty() != true)
+    {
+        const std::vector<uint8_t> segment = server.pop(segment_size);
+        firmware_update_process(&firmware_update, segment.data(), segment.size(), &error);
+
+        segment_size = (segment_size % 300U) + 1U;
+
+        if (server.stream.empty() != true)
+        {
+            EXPECT_NE(get_state(), COMPLETE_STATE);
+        }
+    }
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(get_state(),      COMPLETE_STATE);
+    EXPECT_EQ(written,          server.image);
+    EXPECT_EQ(commit_count,     1U);
+}
+
+TEST_F(FirmwareUpdateTestFixture, ResumeAfterDisconnect)
+{
+    // Arrange: create and set up a system under test
+    firmware_update_resume(&firmware_update);
+
+    // Act: poke the system under test
+    for (size_t budget : { 30000U, 12345U, 7U, 50001U })
+    {
+        // The link drops in the middle of a frame
+        transfer(budget);
+        server.disconnect();
+
+        firmware_update_resume(&firmware_update);
+    }
+    transfer();
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(get_state(),      COMPLETE_STATE);
+    EXPECT_EQ(written,          server.image);
+    EXPECT_EQ(start_count,      1U);
+    EXPECT_EQ(commit_count,     1U);
+    EXPECT_EQ(server.resume_offsets.size(), 5U);
+
+    // Every resume starts near where the link dropped, nothing is sent twice but the cut chunks
+    const size_t frame_overhead = FIRMWARE_UPDATE_FRAME_HEAD_SIZE + FIRMWARE_UPDATE_FRAME_CRC_SIZE;
+    const size_t restart_size   = (FIRMWARE_UPDATE_HEADER_SIZE + frame_overhead) + FIRMWARE_UPDATE_FRAME_MAX_SIZE;
+    const size_t chunk_count    = (firmware_size + FIRMWARE_UPDATE_CHUNK_SIZE - 1U) / FIRMWARE_UPDATE_CHUNK_SIZE;
+
+    EXPECT_LE(server.sent_size, firmware_size + (chunk_count * frame_overhead) + (server.resume_offsets.size() * restart_size));
+}
+
+TEST_F(FirmwareUpdateTestFixture, CorruptedChunkIsRequestedAgain)
+{
+    // Arrange: create and set up a system under test
+    firmware_update_resume(&firmware_update);
+
+    transfer(20000U);
+
+    // Act: poke the system under test
+    server.stream[1000U] ^= 0x10U;
+
+    transfer();
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(get_state(),      COMPLETE_STATE);
+    EXPECT_EQ(written,          server.image);
+    EXPECT_EQ(commit_count,     1U);
+    EXPECT_EQ(server.resume_offsets.size(), 2U);
+}
+
+TEST_F(FirmwareUpdateTestFixture, LostResumeIsSentAgainOnPoll)
+{
+    // Arrange: create and set up a system under test
+    firmware_update_resume(&firmware_update);
+
+    transfer(20000U);
+
+    server.stream[1000U] ^= 0x10U;
+    server.lost_resume_count = 1U;
+
+    // Act: poke the system under test
+    transfer();
+
+    firmware_update_poll(&firmware_update);
+    const size_t early_resume_count = server.resume_offsets.size();
+
+    time_ms += FIRMWARE_UPDATE_RESUME_TIMEOUT_MS;
+    firmware_update_poll(&firmware_update);
+
+    transfer();
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(early_resume_count, 1U);
+    EXPECT_EQ(get_state(),      COMPLETE_STATE);
+    EXPECT_EQ(written,          server.image);
+    EXPECT_EQ(commit_count,     1U);
+    EXPECT_EQ(server.resume_offsets.size(), 2U);
+}
+
+TEST_F(FirmwareUpdateTestFixture, LostResumeIsSentAgainOnGap)
+{
+    // Arrange: create and set up a system under test
+    firmware_update_resume(&firmware_update);
+
+    transfer(20000U);
+
+    server.stream[1000U] ^= 0x10U;
+    server.lost_resume_count = 1U;
+
+    // Act: poke the system under test
+    transfer(10000U);
+
+    time_ms += FIRMWARE_UPDATE_RESUME_TIMEOUT_MS;
+
+    transfer();
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(get_state(),      COMPLETE_STATE);
+    EXPECT_EQ(written,          server.image);
+    EXPECT_EQ(commit_count,     1U);
+    EXPECT_EQ(server.resume_offsets.size(), 2U);
+}
+
+TEST_F(FirmwareUpdateTestFixture, ImageCrcMismatchIsNotCommitted)
+{
+    // Arrange: create and set up a system under test
+    server.header.image_crc32 ^= 1U;
+
+    firmware_update_resume(&firmware_update);
+
+    // Act: poke the system under test
+    transfer();
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(get_state(),      WAITING_HEADER_STATE);
+    EXPECT_EQ(server.results,   std::vector<uint8_t>{ IMAGE_CRC_MISMATCH });
+    EXPECT_EQ(commit_count,     0U);
+    EXPECT_EQ(discard_count,    1U);
+    EXPECT_TRUE(written.empty());
+}
+
+TEST_F(FirmwareUpdateTestFixture, NewImageRestartsFromZero)
+{
+    // Arrange: create and set up a system under test
+    firmware_update_resume(&firmware_update);
+
+    transfer(40000U);
+    server.disconnect();
+
+    // Act: poke the system under test
+    for (size_t i = 0U; i < server.image.size(); ++i)
+    {
+        server.image[i] = (uint8_t)(~server.image[i]);
+    }
+    server.header.image_crc32   = crc32_calculate(server.image.data(), server.image.size());
+    server.header.version_patch = 4U;
+
+    firmware_update_resume(&firmware_update);
+    transfer();
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(get_state(),      COMPLETE_STATE);
+    EXPECT_EQ(written,          server.image);
+    EXPECT_EQ(start_count,      2U);
+    EXPECT_EQ(discard_count,    1U);
+    EXPECT_EQ(server.resume_offsets.back(), 0U);
+}
+
+TEST_F(FirmwareUpdateTestFixture, OversizedImageIsRejected)
+{
+    // Arrange: create and set up a system under test
+    server.image.resize(200U * 1024U);
+    server.header.image_size = (uint32_t)(server.image.size());
+
+    firmware_update_resume(&firmware_update);
+
+    // Act: poke the system under test
+    transfer();
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(get_state(),      WAITING_HEADER_STATE);
+    EXPECT_EQ(server.results,   std::vector<uint8_t>{ IMAGE_STORAGE_ERROR });
+    EXPECT_EQ(start_count,      0U);
+    EXPECT_TRUE(written.empty());
+}
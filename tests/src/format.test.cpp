@@ -0,0 +1,240 @@
+/************************************************************
+ *   Author : German Mundinger
+ *   Date   : 2024
+ ************************************************************/
+
+#include <gmock/gmock.h>
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+#include "format.h"
+
+
+TEST(FormatTest, Integer)
+{
+    // Arrange: create and set up a system under test
+    char buffer[FORMAT_NUMBER_SIZE];
+
+    // Act & Assert: poke the system under test and check the result
+    EXPECT_EQ(format_int(buffer, 0), 1U);
+    EXPECT_STREQ(buffer, "0");
+
+    EXPECT_EQ(format_int(buffer, -42), 3U);
+    EXPECT_STREQ(buffer, "-42");
+
+    EXPECT_EQ(format_int(buffer, INT32_MAX), 10U);
+    EXPECT_STREQ(buffer, "2147483647");
+
+    EXPECT_EQ(format_int(buffer, INT32_MIN), 11U);
+    EXPECT_STREQ(buffer, "-2147483648");
+
+    EXPECT_EQ(format_uint(buffer, UINT32_MAX), 10U);
+    EXPECT_STREQ(buffer, "4294967295");
+}
+
+TEST(FormatTest, Hex)
+{
+    // Arrange: create and set up a system under test
+    char buffer[FORMAT_NUMBER_SIZE];
+
+    // Act & Assert: poke the system under test and check the result
+    EXPECT_EQ(format_hex(buffer, 0x5U, 2U, false), 2U);
+    EXPECT_STREQ(buffer, "05");
+
+    EXPECT_EQ(format_hex(buffer, 0xBEEFU, 1U, false), 4U);
+    EXPECT_STREQ(buffer, "beef");
+
+    EXPECT_EQ(format_hex(buffer, 0xDEADBEEFU, 1U, true), 8U);
+    EXPECT_STREQ(buffer, "DEADBEEF");
+}
+
+TEST(FormatTest, Fixed)
+{
+    // Arrange: create and set up a system under test
+    char buffer[FORMAT_NUMBER_SIZE];
+
+    // Act & Assert: poke the system under test and check the result
+    EXPECT_EQ(format_fixed(buffer, 235, FORMAT_DECI, false), 4U);
+    EXPECT_STREQ(buffer, "23.5");
+
+    EXPECT_EQ(format_fixed(buffer, -5, FORMAT_CENTI, false), 5U);
+    EXPECT_STREQ(buffer, "-0.05");
+
+    EXPECT_EQ(format_fixed(buffer, 0, FORMAT_DECI, true), 4U);
+    EXPECT_STREQ(buffer, "+0.0");
+
+    EXPECT_EQ(format_fixed(buffer, INT32_MIN, FORMAT_CENTI, false), 12U);
+    EXPECT_STREQ(buffer, "-21474836.48");
+}
+
+TEST(FormatTest, FloatToFixed)
+{
+    // Act & Assert: poke the system under test and check the result
+    EXPECT_EQ(format_float_to_fixed(23.45F, FORMAT_DECI),   235);
+    EXPECT_EQ(format_float_to_fixed(-23.45F, FORMAT_DECI),  (-235));
+    EXPECT_EQ(format_float_to_fixed(0.004F, FORMAT_CENTI),  0);
+    EXPECT_EQ(format_float_to_fixed(1.0e12F, FORMAT_DECI),  INT32_MAX);
+    EXPECT_EQ(format_float_to_fixed(-1.0e12F, FORMAT_DECI), (-INT32_MAX));
+    EXPECT_EQ(format_float_to_fixed(NAN, FORMAT_DECI),      0);
+}
+
+TEST(FormatTest, FloatKeepsSignOfSmallNegative)
+{
+    // Arrange: create and set up a system under test
+    char buffer[FORMAT_NUMBER_SIZE];
+
+    // Act & Assert: poke the system under test and check the result
+    EXPECT_EQ(format_float(buffer, -0.004F, FORMAT_CENTI, false), 5U);
+    EXPECT_STREQ(buffer, "-0.00");
+
+    EXPECT_EQ(format_float(buffer, -0.04F, FORMAT_DECI, true), 4U);
+    EXPECT_STREQ(buffer, "-0.0");
+
+    EXPECT_EQ(format_float(buffer, -0.4F, 0U, false), 2U);
+    EXPECT_STREQ(buffer, "-0");
+
+    EXPECT_EQ(format_float(buffer, -0.0F, FORMAT_DECI, false), 4U);
+    EXPECT_STREQ(buffer, "-0.0");
+
+    EXPECT_EQ(format_float(buffer, 0.004F, FORMAT_CENTI, true), 5U);
+    EXPECT_STREQ(buffer, "+0.00");
+}
+
+TEST(FormatTest, FloatLongFraction)
+{
+    // Arrange: create and set up a system under test
+    char buffer[FORMAT_NUMBER_SIZE];
+
+    // Act & Assert: poke the system under test and check the result
+    EXPECT_EQ(format_float(buffer, 100000.0F, 6U, false), 13U);
+    EXPECT_STREQ(buffer, "100000.000000");
+
+    EXPECT_EQ(format_float(buffer, -0.0000004F, 6U, false), 9U);
+    EXPECT_STREQ(buffer, "-0.000000");
+
+    EXPECT_EQ(format_float(buffer, 0.9999999F, 3U, false), 5U);
+    EXPECT_STREQ(buffer, "1.000");
+
+    EXPECT_EQ(format_float(buffer, -1.0e12F, FORMAT_FRACTION_DIGITS_MAX, false), 21U);
+    EXPECT_STREQ(buffer, "-4294967040.000000000");
+}
+
+class FormatFloatTestFixture : public testing::TestWithParam<float>
+{
+};
+
+TEST_P(FormatFloatTestFixture, FloatMatchesPrintf)
+{
+    // Arrange: create and set up a system under test
+    const float value = GetParam();
+
+    char expected_deci[32];
+    char expected_centi[32];
+    char expected_signed[32];
+    char expected_micro[32];
+    std::snprintf(expected_deci, sizeof(expected_deci), "%.1f", value);
+    std::snprintf(expected_centi, sizeof(expected_centi), "%.2f", value);
+    std::snprintf(expected_signed, sizeof(expected_signed), "%+.1f", value);
+    std::snprintf(expected_micro, sizeof(expected_micro), "%.6f", value);
+
+    // Act: poke the system under test
+    char result_deci[FORMAT_NUMBER_SIZE];
+    char result_centi[FORMAT_NUMBER_SIZE];
+    char result_signed[FORMAT_NUMBER_SIZE];
+    char result_micro[FORMAT_NUMBER_SIZE];
+    format_float(result_deci, value, FORMAT_DECI, false);
+    format_float(result_centi, value, FORMAT_CENTI, false);
+    format_float(result_signed, value, FORMAT_DECI, true);
+    format_float(result_micro, value, 6U, false);
+
+    // Assert: make unit test pass or fail
+    EXPECT_STREQ(result_deci,   expected_deci);
+    EXPECT_STREQ(result_centi,  expected_centi);
+    EXPECT_STREQ(result_signed, expected_signed);
+    EXPECT_STREQ(result_micro,  expected_micro);
+}
+
+INSTANTIATE_TEST_SUITE_P(FormatFloat, FormatFloatTestFixture,
+    testing::Values(0.0F, 1.0F, -1.0F, 21.3F, -7.8F, 99.9F, 1013.2F, 760.1F, 45.67F, -12.34F, 0.5F, 100000.0F, -0.004F, -0.04F)
+);
+
+TEST(FormatBenchmark, FloatVersusPrintf)
+{
+    // Arrange: create and set up a system under test
+    constexpr size_t iteration_count = 1000000U;
+
+    char buffer[32];
+    size_t format_size = 0U;
+    size_t printf_size = 0U;
+
+    // Act: poke the system under test
+    auto start_time = std::chrono::steady_clock::now();
+
+    for (size_t i = 0U; i < iteration_count; ++i)
+    {
+        format_size += format_float(buffer, (float)(i % 1000U) * 0.37F - 150.0F, FORMAT_DECI, false);
+    }
+
+    const auto format_duration = std::chrono::steady_clock::now() - start_time;
+
+    start_time = std::chrono::steady_clock::now();
+
+    for (size_t i = 0U; i < iteration_count; ++i)
+    {
+        printf_size += (size_t)std::snprintf(buffer, sizeof(buffer), "%.1f", (float)(i % 1000U) * 0.37F - 150.0F);
+    }
+
+    const auto printf_duration = std::chrono::steady_clock::now() - start_time;
+
+    const double format_ns = std::chrono::duration<double, std::nano>(format_duration).count() / (double)(iteration_count);
+    const double printf_ns = std::chrono::duration<double, std::nano>(printf_duration).count() / (double)(iteration_count);
+
+    std::cout << "[ BENCHMARK] format_float = " << format_ns << " ns, snprintf = " << printf_ns << " ns" << std::endl;
+    RecordProperty("format_float_ns", std::to_string(format_ns));
+    RecordProperty("snprintf_ns", std::to_string(printf_ns));
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(format_size, printf_size);
+}
+
+TEST(FormatBenchmark, IntegerVersusPrintf)
+{
+    // Arrange: create and set up a system under test
+    constexpr size_t iteration_count = 1000000U;
+
+    char buffer[32];
+    size_t format_size = 0U;
+    size_t printf_size = 0U;
+
+    // Act: poke the system under test
+    auto start_time = std::chrono::steady_clock::now();
+
+    for (size_t i = 0U; i < iteration_count; ++i)
+    {
+        format_size += format_int(buffer, (int32_t)(i * 7919U) - 500000);
+    }
+
+    const auto format_duration = std::chrono::steady_clock::now() - start_time;
+
+    start_time = std::chrono::steady_clock::now();
+
+    for (size_t i = 0U; i < iteration_count; ++i)
+    {
+        printf_size += (size_t)std::snprintf(buffer, sizeof(buffer), "%d", (int32_t)(i * 7919U) - 500000);
+    }
+
+    const auto printf_duration = std::chrono::steady_clock::now() - start_time;
+
+    const double format_ns = std::chrono::duration<double, std::nano>(format_duration).count() / (double)(iteration_count);
+    const double printf_ns = std::chrono::duration<double, std::nano>(printf_duration).count() / (double)(iteration_count);
+
+    std::cout << "[ BENCHMARK] format_int = " << format_ns << " ns, snprintf = " << printf_ns << " ns" << std::endl;
+    RecordProperty("format_int_ns", std::to_string(format_ns));
+    RecordProperty("snprintf_ns", std::to_string(printf_ns));
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(format_size, printf_size);
+}
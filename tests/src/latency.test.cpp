@@ -0,0 +1,156 @@
+/************************************************************
+ *   Author : German Mundinger
+ *   Date   : 2024
+ ************************************************************/
+
+#include <gmock/gmock.h>
+
+#include "latency.h"
+
+
+static uint32_t current_cycles;
+
+static uint32_t latency_get_test_cycles ()
+{
+    return current_cycles;
+}
+
+static void latency_test_lock ()
+{
+}
+
+static void latency_test_unlock ()
+{
+}
+
+class LatencyTestFixture : public testing::Test
+{
+    protected:
+
+        static constexpr uint32_t cycles_per_us = 84U;
+
+        latency_trace_t trace;
+
+        virtual void SetUp() override
+        {
+            latency_config_t config;
+            config.get_cycles_callback  = latency_get_test_cycles;
+            config.lock_callback        = latency_test_lock;
+            config.unlock_callback      = latency_test_unlock;
+            config.cycles_per_us        = cycles_per_us;
+
+            latency_init(&config);
+            latency_clear_trace(&trace);
+
+            current_cycles = 0U;
+        }
+
+        void stamp_after (latency_hop_t hop, uint32_t time_us)
+        {
+            current_cycles += time_us * cycles_per_us;
+
+            latency_stamp(&trace, hop);
+        }
+};
+
+
+TEST_F(LatencyTestFixture, InitZero)
+{
+    // Act: poke the system under test
+    uint16_t histogram[LATENCY_BUCKET_COUNT];
+    latency_get_histogram(NODE_TASK_HOP, histogram);
+
+    // Assert: make unit test pass or fail
+    EXPECT_THAT(histogram, testing::Each(0U));
+}
+
+TEST_F(LatencyTestFixture, RecordOutboundPath)
+{
+    // Arrange: create and set up a system under test
+    latency_stamp_cycles(&trace, ISR_HOP, 0U);
+    stamp_after(BOARD_TASK_HOP, 1U);    // Bucket 0
+    stamp_after(NODE_SEND_HOP, 5U);     // Bucket 2
+    stamp_after(NODE_TASK_HOP, 300U);   // Bucket 8
+    stamp_after(TCP_SEND_HOP, 100000U); // Last bucket
+
+    // Act: poke the system under test
+    latency_record(&trace);
+
+    // Assert: make unit test pass or fail
+    uint16_t histogram[LATENCY_BUCKET_COUNT];
+
+    latency_get_histogram(ISR_HOP, histogram);
+    EXPECT_THAT(histogram, testing::Each(0U));
+
+    latency_get_histogram(BOARD_TASK_HOP, histogram);
+    EXPECT_EQ(histogram[0], 1U);
+
+    latency_get_histogram(NODE_SEND_HOP, histogram);
+    EXPECT_EQ(histogram[2], 1U);
+
+    latency_get_histogram(NODE_TASK_HOP, histogram);
+    EXPECT_EQ(histogram[8], 1U);
+
+    latency_get_histogram(TCP_SEND_HOP, histogram);
+    EXPECT_EQ(histogram[LATENCY_BUCKET_COUNT - 1U], 1U);
+}
+
+TEST_F(LatencyTestFixture, RecordCounterWrap)
+{
+    // Arrange: create and set up a system under test
+    current_cycles = UINT32_MAX - (10U * cycles_per_us);
+
+    latency_stamp(&trace, TCP_RECV_HOP);
+    stamp_after(NODE_RECV_HOP, 20U);    // Bucket 4
+
+    // Act: poke the system under test
+    latency_record(&trace);
+
+    // Assert: make unit test pass or fail
+    uint16_t histogram[LATENCY_BUCKET_COUNT];
+    latency_get_histogram(NODE_RECV_HOP, histogram);
+
+    EXPECT_EQ(histogram[4], 1U);
+}
+
+TEST_F(LatencyTestFixture, RecordHalving)
+{
+    // Arrange: create and set up a system under test
+    latency_stamp(&trace, NODE_RECV_HOP);
+    stamp_after(BOARD_PROCESS_HOP, 3U); // Bucket 1
+
+    latency_trace_t slow_trace;
+    latency_clear_trace(&slow_trace);
+    latency_stamp_cycles(&slow_trace, NODE_RECV_HOP, 0U);
+    latency_stamp_cycles(&slow_trace, BOARD_PROCESS_HOP, 1000U * cycles_per_us); // Bucket 9
+
+    // Act: poke the system under test
+    for (size_t i = 0U; i < 10U; ++i)
+    {
+        latency_record(&slow_trace);
+    }
+
+    for (size_t i = 0U; i < LATENCY_COUNT_MAX; ++i)
+    {
+        latency_record(&trace);
+    }
+
+    // Assert: make unit test pass or fail
+    uint16_t histogram[LATENCY_BUCKET_COUNT];
+    latency_get_histogram(BOARD_PROCESS_HOP, histogram);
+
+    EXPECT_EQ(histogram[1], (LATENCY_COUNT_MAX / 2U));
+    EXPECT_EQ(histogram[9], 5U);
+}
+
+TEST_F(LatencyTestFixture, StampOverflow)
+{
+    // Act: poke the system under test
+    for (size_t i = 0U; i < (2U * LATENCY_HOP_SIZE); ++i)
+    {
+        stamp_after(NODE_TASK_HOP, 1U);
+    }
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(trace.size, (size_t)(LATENCY_HOP_SIZE));
+}
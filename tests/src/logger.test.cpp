@@ -0,0 +1,84 @@
+/************************************************************
+ *   Author : German Mundinger
+ *   Date   : 2024
+ ************************************************************/
+
+#include <gmock/gmock.h>
+
+#include <cstdio>
+#include <string>
+
+#include "logger.h"
+
+
+static std::string logger_output;
+
+static void logger_write_array (const uint8_t *data, uint16_t data_size)
+{
+    logger_output.append((const char*)(data), data_size);
+}
+
+class LoggerTestFixture : public testing::Test
+{
+    protected:
+
+        virtual void SetUp() override
+        {
+            logger_config_t config;
+            config.write_array_callback = logger_write_array;
+
+            logger_init(&config);
+
+            logger_output.clear();
+        }
+};
+
+
+TEST_F(LoggerTestFixture, PrintMatchesPrintf)
+{
+    // Arrange: create and set up a system under test
+    const char *text = "firmware";
+    const long code = (-7L);
+    const unsigned long size = 4096UL;
+
+    char expected[256];
+    std::snprintf(expected, sizeof(expected), "Node [%s] : code = %ld, size = %lu, id = %d/%i/%u, mac = %02x:%02x, addr = 0x%lX, %c%%\r\n",
+                    text, code, size, 3, -4, 5U, 0xAU, 0xBCU, 0xDEADUL, 'Z');
+
+    // Act: poke the system under test
+    logger_print("Node [%s] : code = %ld, size = %lu, id = %d/%i/%u, mac = %02x:%02x, addr = 0x%lX, %c%%\r\n",
+                    text, code, size, 3, -4, 5U, 0xAU, 0xBCU, 0xDEADUL, 'Z');
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(logger_output, std::string(expected));
+}
+
+TEST_F(LoggerTestFixture, PrintFloat)
+{
+    // Act: poke the system under test
+    logger_print("t = %.2f C, p = %.1f hPa, v = %+.1f, z = %f\r\n", 21.456F, 1013.25F, -3.04F, 1.5F);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(logger_output, std::string("t = 21.46 C, p = 1013.3 hPa, v = -3.0, z = 1.500000\r\n"));
+}
+
+TEST_F(LoggerTestFixture, PrintFloatPrecision)
+{
+    // Act: poke the system under test
+    logger_print("a = %.4f, b = %.1f, c = %.12f, d = %d\r\n", 3.14159F, -0.02F, 1.0F, 7);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(logger_output, std::string("a = 3.1416, b = -0.0, c = %.12f, d = 7\r\n"));
+}
+
+TEST_F(LoggerTestFixture, PrintLongText)
+{
+    // Arrange: create and set up a system under test
+    const std::string text(300U, 'x');
+
+    // Act: poke the system under test
+    logger_print("[%s]%5d|%03d\r\n", text.c_str(), 42, -7);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(logger_output, "[" + text + "]   42|-07\r\n");
+}
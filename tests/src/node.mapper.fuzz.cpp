@@ -0,0 +1,35 @@
+/************************************************************
+ *   Author : German Mundinger
+ *   Date   : 2024
+ ************************************************************/
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdlib>
+
+#include "node.mapper.h"
+#include "node.type.h"
+#include "std_error/std_error.h"
+
+
+extern "C" int LLVMFuzzerTestOneInput (const uint8_t *data, size_t size)
+{
+    node_msg_t msg;
+    std_error_t error;
+
+    std_error_init(&error);
+
+    const int exit_code = node_mapper_deserialize_message((const char*)(data), size, &msg, &error);
+
+    if (msg.header.dest_array_size > NODE_LIST_SIZE)
+    {
+        std::abort();
+    }
+
+    if ((exit_code != STD_SUCCESS) && (msg.header.dest_array_size != 0U))
+    {
+        std::abort();
+    }
+
+    return 0;
+}
@@ -0,0 +1,429 @@
+/************************************************************
+ *   Author : German Mundinger
+ *   Date   : 2024
+ ************************************************************/
+
+#include <gmock/gmock.h>
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "node.mapper.h"
+#include "node.type.h"
+#include "version.h"
+#include "std_error/std_error.h"
+
+
+class NodeMapperTestFixture : public testing::Test
+{
+    protected:
+
+        node_msg_t msg;
+        std_error_t error;
+
+        virtual void SetUp() override
+        {
+            std::memset(&msg, 0xA5, sizeof(msg));
+            std_error_init(&error);
+        }
+
+        int deserialize (std::string const &raw_data)
+        {
+            return node_mapper_deserialize_message(raw_data.data(), raw_data.size(), &msg, &error);
+        }
+};
+
+
+TEST_F(NodeMapperTestFixture, DeserializeFullMessage)
+{
+    // Arrange: create and set up a system under test
+    const std::string raw_data = "{\"src_id\":0,\"dst_id\":[1,2],\"cmd_id\":" + std::to_string(SET_LIGHT) + ",\"data\":{\"value_id\":1}}\n";
+
+    // Act: poke the system under test
+    const int exit_code = deserialize(raw_data);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(exit_code,                    STD_SUCCESS);
+    EXPECT_EQ(msg.header.source,            NODE_B01);
+    EXPECT_EQ(msg.header.dest_array_size,   2U);
+    EXPECT_EQ(msg.header.dest_array[0],     NODE_T01);
+    EXPECT_EQ(msg.header.dest_array[1],     NODE_B02);
+    EXPECT_EQ(msg.cmd_id,                   SET_LIGHT);
+    EXPECT_EQ(msg.value_0,                  1);
+}
+
+TEST_F(NodeMapperTestFixture, DeserializeAnyKeyOrder)
+{
+    // Arrange: create and set up a system under test
+    const std::string raw_data = " { \"data\" : { \"unknown\" : [ 1, { \"a\" : null } ], \"value_id\" : -2 } , \"cmd_id\" : " + std::to_string(SET_MODE) + " , \"dst_id\" : [ 2 ] , \"src_id\" : 1 }\r\n";
+
+    // Act: poke the system under test
+    const int exit_code = deserialize(raw_data);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(exit_code,                    STD_SUCCESS);
+    EXPECT_EQ(msg.header.source,            NODE_T01);
+    EXPECT_EQ(msg.header.dest_array_size,   1U);
+    EXPECT_EQ(msg.header.dest_array[0],     NODE_B02);
+    EXPECT_EQ(msg.cmd_id,                   SET_MODE);
+    EXPECT_EQ(msg.value_0,                  (-2));
+}
+
+TEST_F(NodeMapperTestFixture, DeserializeUnknownFields)
+{
+    // Arrange: create and set up a system under test
+    const std::string raw_data = "{\"src_id\":0,\"name\":\"a\\\"b\\\\\",\"flags\":[true,false,null],\"rate\":-1.5e+3,\"dst_id\":[1],\"cmd_id\":" + std::to_string(REQUEST_VERSION) + "}";
+
+    // Act: poke the system under test
+    const int exit_code = deserialize(raw_data);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(exit_code,                    STD_SUCCESS);
+    EXPECT_EQ(msg.header.dest_array_size,   1U);
+    EXPECT_EQ(msg.cmd_id,                   REQUEST_VERSION);
+}
+
+TEST_F(NodeMapperTestFixture, DeserializeMissingCommand)
+{
+    // Arrange: create and set up a system under test
+    const std::string raw_data = "{\"src_id\":0,\"dst_id\":[1],\"cmd_id\":1.5}";
+
+    // Act: poke the system under test
+    const int exit_code = deserialize(raw_data);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(exit_code,    STD_SUCCESS);
+    EXPECT_EQ(msg.cmd_id,   DO_NOTHING);
+    EXPECT_EQ(msg.value_0,  0);
+}
+
+TEST_F(NodeMapperTestFixture, DeserializeDuplicateDestinations)
+{
+    // Arrange: create and set up a system under test
+    std::string raw_data = "{\"src_id\":0,\"dst_id\":[1";
+
+    for (size_t i = 0U; i < 1000U; ++i)
+    {
+        raw_data += ",2,1";
+    }
+    raw_data += "],\"cmd_id\":0}";
+
+    // Act: poke the system under test
+    const int exit_code = deserialize(raw_data);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(exit_code,                    STD_SUCCESS);
+    EXPECT_EQ(msg.header.dest_array_size,   2U);
+    EXPECT_EQ(msg.header.dest_array[0],     NODE_T01);
+    EXPECT_EQ(msg.header.dest_array[1],     NODE_B02);
+}
+
+TEST_F(NodeMapperTestFixture, DeserializeDestinationOverflow)
+{
+    // Arrange: create and set up a system under test
+    std::string raw_data = "{\"src_id\":0,\"dst_id\":[0";
+
+    for (size_t i = 1U; i <= NODE_LIST_SIZE; ++i)
+    {
+        raw_data += "," + std::to_string(i);
+    }
+    raw_data += "],\"cmd_id\":0}";
+
+    // Act: poke the system under test
+    const int exit_code = deserialize(raw_data);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(exit_code,                    STD_FAILURE);
+    EXPECT_EQ(msg.header.dest_array_size,   0U);
+}
+
+TEST_F(NodeMapperTestFixture, DeserializeBoundedSize)
+{
+    // Arrange: create and set up a system under test
+    const std::string raw_data = "{\"src_id\":0,\"dst_id\":[1],\"cmd_id\":0}";
+
+    // Act: poke the system under test
+    const int cut_exit_code = node_mapper_deserialize_message(raw_data.data(), raw_data.size() - 1U, &msg, &error);
+    const int full_exit_code = node_mapper_deserialize_message(raw_data.data(), raw_data.size(), &msg, &error);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(cut_exit_code,    STD_FAILURE);
+    EXPECT_EQ(full_exit_code,   STD_SUCCESS);
+}
+
+TEST_F(NodeMapperTestFixture, SerializeHumidity)
+{
+    // Arrange: create and set up a system under test
+    msg.header.source           = NODE_T01;
+    msg.header.dest_array[0]    = NODE_B01;
+    msg.header.dest_array[1]    = NODE_B02;
+    msg.header.dest_array_size  = 2U;
+    msg.cmd_id                  = UPDATE_HUMIDITY;
+    msg.value_0                 = 1013;
+    msg.value_1                 = 45;
+    msg.value_2                 = -3.04F;
+
+    const std::string expected_data = "{\"src_id\":1,\"dst_id\":[0,2],\"cmd_id\":" + std::to_string(UPDATE_HUMIDITY) + ",\"data\":{\"pres_hpa\":1013,\"hum_pct\":45,\"temp_c\":-3.0}}\n";
+
+    // Act: poke the system under test
+    char raw_data[128];
+    size_t raw_data_size;
+    node_mapper_serialize_message(&msg, raw_data, &raw_data_size);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(std::string(raw_data, raw_data_size), expected_data);
+}
+
+TEST_F(NodeMapperTestFixture, SerializeVersion)
+{
+    // Arrange: create and set up a system under test
+    msg.header.source           = NODE_T01;
+    msg.header.dest_array[0]    = NODE_ADMIN;
+    msg.header.dest_array_size  = 1U;
+    msg.cmd_id                  = RESPONSE_VERSION;
+
+    const std::string expected_data = "{\"src_id\":1,\"dst_id\":[" + std::to_string(NODE_ADMIN) + "],\"cmd_id\":" + std::to_string(RESPONSE_VERSION) + ",\"data\":{\"major\":" VERSION_MAJOR ",\"minor\":" VERSION_MINOR ",\"patch\":" VERSION_PATCH "}}\n";
+
+    // Act: poke the system under test
+    char raw_data[128];
+    size_t raw_data_size;
+    node_mapper_serialize_message(&msg, raw_data, &raw_data_size);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(std::string(raw_data, raw_data_size), expected_data);
+}
+
+TEST_F(NodeMapperTestFixture, SerializeRoundTrip)
+{
+    // Arrange: create and set up a system under test
+    node_msg_t send_msg;
+    send_msg.header.source          = NODE_B02;
+    send_msg.header.dest_array[0]   = NODE_T01;
+    send_msg.header.dest_array_size = 1U;
+    send_msg.cmd_id                 = SET_INTRUSION;
+    send_msg.value_0                = INTRUSION_ON;
+
+    // Act: poke the system under test
+    char raw_data[128];
+    size_t raw_data_size;
+    node_mapper_serialize_message(&send_msg, raw_data, &raw_data_size);
+
+    const int exit_code = node_mapper_deserialize_message(raw_data, raw_data_size, &msg, &error);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(exit_code,                    STD_SUCCESS);
+    EXPECT_EQ(msg.header.source,            send_msg.header.source);
+    EXPECT_EQ(msg.header.dest_array_size,   send_msg.header.dest_array_size);
+    EXPECT_EQ(msg.header.dest_array[0],     send_msg.header.dest_array[0]);
+    EXPECT_EQ(msg.cmd_id,                   send_msg.cmd_id);
+    EXPECT_EQ(msg.value_0,                  send_msg.value_0);
+}
+
+TEST_F(NodeMapperTestFixture, SerializeLatency)
+{
+    // Arrange: create and set up a system under test
+    msg.header.source           = NODE_B02;
+    msg.header.dest_array[0]    = NODE_ADMIN;
+    msg.header.dest_array_size  = 1U;
+    msg.cmd_id                  = RESPONSE_LATENCY;
+    msg.value_0                 = 7;
+
+    const uint16_t histogram[14] = { 999, 998, 997, 996, 995, 994, 993, 992, 991, 990, 989, 988, 987, 986 };
+
+    const std::string expected_data = "{\"src_id\":2,\"dst_id\":[" + std::to_string(NODE_ADMIN) + "],\"cmd_id\":101,\"data\":{\"hop\":7,\"hist\":[999,998,997,996,995,994,993,992,991,990,989,988,987,986]}}\n";
+
+    // Act: poke the system under test
+    char raw_data[128];
+    size_t raw_data_size;
+    node_mapper_serialize_latency(&msg, histogram, 14U, raw_data, &raw_data_size);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(std::string(raw_data, raw_data_size), expected_data);
+    EXPECT_LT(raw_data_size, sizeof(raw_data));
+}
+
+TEST_F(NodeMapperTestFixture, SerializeState)
+{
+    // Arrange: create and set up a system under test
+    msg.header.source           = NODE_T01;
+    msg.header.dest_array[0]    = NODE_B01;
+    msg.header.dest_array_size  = 1U;
+    msg.cmd_id                  = RESPONSE_STATE;
+    msg.value_0                 = (int32_t)((uint32_t)(GUARD_MODE) | NODE_STATE_DOOR_OPEN_FLAG | NODE_STATE_SENSOR_VALID_FLAG | (45U << NODE_STATE_HUMIDITY_SHIFT));
+    msg.value_1                 = 1013;
+    msg.value_2                 = -4.5F;
+
+    const std::string expected_data = "{\"src_id\":1,\"dst_id\":[0],\"cmd_id\":103,\"data\":{\"mode\":1,\"flags\":" +
+                                        std::to_string(NODE_STATE_DOOR_OPEN_FLAG | NODE_STATE_SENSOR_VALID_FLAG) +
+                                        ",\"pres_hpa\":1013,\"hum_pct\":45,\"temp_c\":-4.5}}\n";
+
+    // Act: poke the system under test
+    char raw_data[128];
+    size_t raw_data_size;
+    node_mapper_serialize_message(&msg, raw_data, &raw_data_size);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(std::string(raw_data, raw_data_size), expected_data);
+    EXPECT_LT(raw_data_size, sizeof(raw_data));
+}
+
+TEST_F(NodeMapperTestFixture, SerializeFirmwareCheck)
+{
+    // Arrange: create and set up a system under test
+    msg.header.source           = NODE_B02;
+    msg.header.dest_array[0]    = NODE_ADMIN;
+    msg.header.dest_array_size  = 1U;
+    msg.cmd_id                  = RESPONSE_FIRMWARE_CHECK;
+    msg.value_0                 = 1;
+    msg.value_1                 = 153604;
+
+    const std::string expected_data = "{\"src_id\":" + std::to_string(NODE_B02) + ",\"dst_id\":[" + std::to_string(NODE_ADMIN) +
+                                        "],\"cmd_id\":105,\"data\":{\"valid\":1,\"size\":153604}}\n";
+
+    // Act: poke the system under test
+    char raw_data[128];
+    size_t raw_data_size;
+    node_mapper_serialize_message(&msg, raw_data, &raw_data_size);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(std::string(raw_data, raw_data_size), expected_data);
+    EXPECT_LT(raw_data_size, sizeof(raw_data));
+}
+
+TEST_F(NodeMapperTestFixture, DeserializeHistoryRequest)
+{
+    // Arrange: create and set up a system under test
+    const std::string raw_data = "{\"src_id\":" + std::to_string(NODE_ADMIN) + ",\"dst_id\":[" + std::to_string(NODE_T01) +
+                                    "],\"cmd_id\":106,\"data\":{\"from_s\":86400,\"to_s\":172800}}\n";
+
+    // Act: poke the system under test
+    const int exit_code = deserialize(raw_data);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(exit_code,    STD_SUCCESS);
+    EXPECT_EQ(msg.cmd_id,   REQUEST_HISTORY);
+    EXPECT_EQ(msg.value_0,  86400);
+    EXPECT_EQ(msg.value_1,  172800);
+}
+
+TEST_F(NodeMapperTestFixture, SerializeHistory)
+{
+    // Arrange: create and set up a system under test
+    msg.header.source           = NODE_T01;
+    msg.header.dest_array[0]    = NODE_ADMIN;
+    msg.header.dest_array_size  = 1U;
+    msg.cmd_id                  = RESPONSE_HISTORY;
+    msg.value_0                 = 90061;
+    msg.value_1                 = (int32_t)(NODE_HISTORY_TEMPERATURE_SENSOR);
+    msg.value_2                 = -3.5F;
+
+    const std::string expected_data = "{\"src_id\":" + std::to_string(NODE_T01) + ",\"dst_id\":[" + std::to_string(NODE_ADMIN) +
+                                        "],\"cmd_id\":107,\"data\":{\"time_s\":90061,\"sensor\":1,\"value\":-3.5}}\n";
+
+    // Act: poke the system under test
+    char raw_data[128];
+    size_t raw_data_size;
+    node_mapper_serialize_message(&msg, raw_data, &raw_data_size);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(std::string(raw_data, raw_data_size), expected_data);
+    EXPECT_LT(raw_data_size, sizeof(raw_data));
+}
+
+TEST_F(NodeMapperTestFixture, SerializeHistoryEnd)
+{
+    // Arrange: create and set up a system under test
+    msg.header.source           = NODE_T01;
+    msg.header.dest_array[0]    = NODE_ADMIN;
+    msg.header.dest_array_size  = 1U;
+    msg.cmd_id                  = RESPONSE_HISTORY_END;
+    msg.value_0                 = 172800;
+    msg.value_1                 = 256;
+
+    const std::string expected_data = "{\"src_id\":" + std::to_string(NODE_T01) + ",\"dst_id\":[" + std::to_string(NODE_ADMIN) +
+                                        "],\"cmd_id\":108,\"data\":{\"time_s\":172800,\"count\":256}}\n";
+
+    // Act: poke the system under test
+    char raw_data[128];
+    size_t raw_data_size;
+    node_mapper_serialize_message(&msg, raw_data, &raw_data_size);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(std::string(raw_data, raw_data_size), expected_data);
+    EXPECT_LT(raw_data_size, sizeof(raw_data));
+}
+
+class NodeMapperInvalidTestFixture : public NodeMapperTestFixture, public testing::WithParamInterface<std::string>
+{
+};
+
+TEST_P(NodeMapperInvalidTestFixture, DeserializeInvalidMessage)
+{
+    // Arrange: create and set up a system under test
+    const std::string raw_data = GetParam();
+
+    // Act: poke the system under test
+    const int exit_code = deserialize(raw_data);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(exit_code,                    STD_FAILURE);
+    EXPECT_EQ(error.code,                   STD_FAILURE);
+    EXPECT_EQ(msg.header.dest_array_size,   0U);
+}
+
+INSTANTIATE_TEST_SUITE_P(NodeMapperInvalid, NodeMapperInvalidTestFixture,
+    testing::Values(
+        "",
+        "   ",
+        "[]",
+        "{",
+        "{\"src_id\"}",
+        "{\"src_id\":}",
+        "{\"src_id\":0,}",
+        "{\"src_id\":0 \"cmd_id\":0}",
+        "{\"src_id\":-}",
+        "{\"src_id\":1.}",
+        "{\"src_id\":1e}",
+        "{\"dst_id\":[1,]}",
+        "{\"dst_id\":[\"1\"]}",
+        "{\"data\":{\"value_id\":tru}}",
+        "{\"name\":\"abc}",
+        "{\"name\":\"a\nb\"}",
+        "{\"deep\":[[[[[[[[[[1]]]]]]]]]]}",
+        "{\"src_id\":0}x"
+    )
+);
+
+TEST(NodeMapperBenchmark, ParseRate)
+{
+    // Arrange: create and set up a system under test
+    const std::string raw_data = "{\"src_id\":0,\"dst_id\":[1,2],\"cmd_id\":" + std::to_string(SET_LIGHT) + ",\"data\":{\"value_id\":1}}\n";
+    constexpr size_t iteration_count = 100000U;
+
+    node_msg_t msg;
+    size_t parsed_count = 0U;
+
+    // Act: poke the system under test
+    const auto start_time = std::chrono::steady_clock::now();
+
+    for (size_t i = 0U; i < iteration_count; ++i)
+    {
+        if (node_mapper_deserialize_message(raw_data.data(), raw_data.size(), &msg, NULL) == STD_SUCCESS)
+        {
+            ++parsed_count;
+        }
+    }
+
+    const auto stop_time = std::chrono::steady_clock::now();
+    const double duration_s = std::chrono::duration<double>(stop_time - start_time).count();
+    const double msg_per_s = (double)(iteration_count) / duration_s;
+    const double mbyte_per_s = (msg_per_s * (double)(raw_data.size())) / (1024.0 * 1024.0);
+
+    std::cout << "[ BENCHMARK] " << msg_per_s << " msg/s, " << mbyte_per_s << " MB/s" << std::endl;
+    RecordProperty("msg_per_s", std::to_string((size_t)(msg_per_s)));
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(parsed_count, iteration_count);
+}
@@ -1728,3 +1728,175 @@ INSTANTIATE_TEST_SUITE_P(NodeB02TestFixture, NodeB02ParameterizedVerandaPirComma
                             .is_veranda_light_on = true, .is_front_light_on = true, .is_buzzer_on = false, .is_msg_to_send = true })
     )
 );
+
+
+class NodeB02ParameterizedMsgState : public NodeB02TestFixture, public testing::WithParamInterface
+    <std::tuple<
+        node_msg_t,
+        node_B02_luminosity_t,
+        node_B02_temperature_t,
+        uint32_t
+    >>
+{};
+
+TEST_P(NodeB02ParameterizedMsgState, ProcessMsgState)
+{
+    // Arrange: create and set up a system under test
+    node_msg_t mode_msg                 = std::get<0>(GetParam());
+    node_B02_luminosity_t luminosity    = std::get<1>(GetParam());
+    node_B02_temperature_t temperature  = std::get<2>(GetParam());
+
+    uint32_t next_time_ms;
+    node_B02_process_luminosity(&node, &luminosity, &next_time_ms);
+    node_B02_process_temperature(&node, &temperature, &next_time_ms);
+    node_B02_process_msg(&node, &mode_msg, (NODE_B02_LIGHT_DURATION_MS * 2U));
+
+    // Drop the periodic updates
+    node_msg_t msg;
+    bool is_msg_valid = true;
+
+    while (is_msg_valid == true)
+    {
+        node_B02_get_msg(&node, &msg, &is_msg_valid);
+    }
+
+    node_msg_t request_msg { .header { .source = NODE_B01, .dest_array { [0] = NODE_B02 }, .dest_array_size = 1U },
+                                .cmd_id = REQUEST_STATE };
+
+    const uint32_t expected_state = std::get<3>(GetParam());
+
+    // Act: poke the system under test
+    node_B02_process_msg(&node, &request_msg, ((NODE_B02_LIGHT_DURATION_MS * 2U) + 1U));
+
+    node_B02_get_msg(&node, &msg, &is_msg_valid);
+
+    // Assert: make unit test pass or fail
+    ASSERT_EQ(is_msg_valid, true);
+    EXPECT_EQ(msg.cmd_id,                   RESPONSE_STATE);
+    EXPECT_EQ(msg.header.source,            NODE_B02);
+    EXPECT_EQ(msg.header.dest_array_size,   1U);
+    EXPECT_EQ(msg.header.dest_array[0],     NODE_B01);
+    EXPECT_EQ((uint32_t)(msg.value_0),      expected_state);
+
+    if (temperature.is_valid == true)
+    {
+        EXPECT_EQ(msg.value_1,          (int32_t)(temperature.pressure_hPa));
+        EXPECT_FLOAT_EQ(msg.value_2,    temperature.temperature_C);
+    }
+    else
+    {
+        EXPECT_EQ(msg.value_1,          0);
+        EXPECT_FLOAT_EQ(msg.value_2,    0.0F);
+    }
+
+    node_B02_get_msg(&node, &msg, &is_msg_valid);
+    EXPECT_EQ(is_msg_valid, false);
+}
+
+INSTANTIATE_TEST_SUITE_P(NodeB02TestFixture, NodeB02ParameterizedMsgState,
+    testing::Values
+    (
+        std::make_tuple(node_msg_t { .header { .dest_array { [0] = NODE_B02 }, .dest_array_size = 1U },
+                            .cmd_id = SET_MODE, .value_0 = (int32_t)(SILENCE_MODE) },
+                        node_B02_luminosity_t { .lux = (NODE_B02_DARKNESS_LEVEL_LUX), .is_valid = true },
+                        node_B02_temperature_t { .is_valid = false },
+                        (uint32_t)(SILENCE_MODE)),
+
+        std::make_tuple(node_msg_t { .header { .dest_array { [0] = NODE_B02 }, .dest_array_size = 1U },
+                            .cmd_id = SET_MODE, .value_0 = (int32_t)(SILENCE_MODE) },
+                        node_B02_luminosity_t { .lux = (NODE_B02_DARKNESS_LEVEL_LUX - 1.0F), .is_valid = true },
+                        node_B02_temperature_t { .pressure_hPa = 1002.0F, .temperature_C = 18.5F, .is_valid = true },
+                        (uint32_t)(SILENCE_MODE) | NODE_STATE_DARK_FLAG | NODE_STATE_SENSOR_VALID_FLAG),
+
+        std::make_tuple(node_msg_t { .header { .dest_array { [0] = NODE_B02 }, .dest_array_size = 1U },
+                            .cmd_id = SET_LIGHT, .value_0 = (int32_t)(LIGHT_ON) },
+                        node_B02_luminosity_t { .lux = (NODE_B02_DARKNESS_LEVEL_LUX - 1.0F), .is_valid = true },
+                        node_B02_temperature_t { .is_valid = false },
+                        (uint32_t)(SILENCE_MODE) | NODE_STATE_LIGHT_FLAG | NODE_STATE_DARK_FLAG),
+
+        std::make_tuple(node_msg_t { .header { .dest_array { [0] = NODE_B02 }, .dest_array_size = 1U },
+                            .cmd_id = SET_MODE, .value_0 = (int32_t)(ALARM_MODE) },
+                        node_B02_luminosity_t { .lux = (NODE_B02_DARKNESS_LEVEL_LUX), .is_valid = true },
+                        node_B02_temperature_t { .is_valid = false },
+                        (uint32_t)(ALARM_MODE) | NODE_STATE_INTRUSION_FLAG)
+    )
+);
+
+
+class NodeB02ParameterizedWarmRestart : public NodeB02TestFixture, public testing::WithParamInterface
+    <std::tuple<
+        node_msg_t
+    >>
+{};
+
+TEST_P(NodeB02ParameterizedWarmRestart, RestoreSnapshot)
+{
+    // Arrange: create and set up a system under test
+    node_msg_t rcv_msg = std::get<0>(GetParam());
+
+    const uint32_t movement_time_ms = 100U * 1000U;
+    const uint32_t snapshot_time_ms = movement_time_ms + (10U * 1000U);
+
+    uint32_t next_time_ms;
+
+    node_B02_luminosity_t luminosity { .lux = (NODE_B02_DARKNESS_LEVEL_LUX - 1.0F), .is_valid = true };
+    node_B02_temperature_t temperature { .pressure_hPa = 1013.0F, .temperature_C = 21.5F, .is_valid = true };
+
+    node_B02_process_luminosity(&node, &luminosity, &next_time_ms);
+    node_B02_process_temperature(&node, &temperature, &next_time_ms);
+    node_B02_process_msg(&node, &rcv_msg, movement_time_ms / 2U);
+    node_B02_process_door_movement(&node, movement_time_ms);
+
+    node_B02_snapshot_t snapshot;
+    node_B02_get_snapshot(&node, &snapshot, snapshot_time_ms);
+
+    // Act: poke the system under test
+    node_B02_t restored_node;
+    node_B02_init(&restored_node);
+    node_B02_restore(&restored_node, &snapshot);
+
+    // Assert: make unit test pass or fail
+    const uint32_t time_array[] = { snapshot_time_ms, (movement_time_ms + NODE_B02_BUZZER_DURATION_MS + 1U),
+                                    (movement_time_ms + NODE_B02_LIGHT_DURATION_MS), (movement_time_ms + NODE_B02_LIGHT_DURATION_MS + 1U),
+                                    (movement_time_ms + (NODE_B02_LIGHT_DURATION_MS * 2U)) };
+
+    for (const uint32_t time_ms : time_array)
+    {
+        node_B02_state_t expected_state;
+        node_B02_get_state(&node, &expected_state, time_ms);
+
+        node_B02_state_t result_state;
+        node_B02_get_state(&restored_node, &result_state, time_ms);
+
+        EXPECT_EQ(result_state.status_led_color,                expected_state.status_led_color) << time_ms;
+        EXPECT_EQ(result_state.is_display_on,                   expected_state.is_display_on) << time_ms;
+        EXPECT_EQ(result_state.is_front_pir_on,                 expected_state.is_front_pir_on) << time_ms;
+        EXPECT_EQ(result_state.light_strip.is_white_on,         expected_state.light_strip.is_white_on) << time_ms;
+        EXPECT_EQ(result_state.light_strip.is_blue_green_on,    expected_state.light_strip.is_blue_green_on) << time_ms;
+        EXPECT_EQ(result_state.light_strip.is_red_on,           expected_state.light_strip.is_red_on) << time_ms;
+        EXPECT_EQ(result_state.is_veranda_light_on,             expected_state.is_veranda_light_on) << time_ms;
+        EXPECT_EQ(result_state.is_front_light_on,               expected_state.is_front_light_on) << time_ms;
+        EXPECT_EQ(result_state.is_buzzer_on,                    expected_state.is_buzzer_on) << time_ms;
+    }
+
+    node_B02_temperature_t result_temperature;
+    uint32_t disable_time_ms;
+    node_B02_get_display_data(&restored_node, &result_temperature, &disable_time_ms);
+
+    EXPECT_EQ(result_temperature.temperature_C, temperature.temperature_C);
+    EXPECT_EQ(result_temperature.is_valid,      temperature.is_valid);
+}
+
+INSTANTIATE_TEST_SUITE_P(NodeB02TestFixture, NodeB02ParameterizedWarmRestart,
+    testing::Values
+    (
+        std::make_tuple(node_msg_t { .header { .dest_array { [0] = NODE_B02 }, .dest_array_size = 1U },
+                            .cmd_id = SET_MODE, .value_0 = (int32_t)(SILENCE_MODE) }),
+
+        std::make_tuple(node_msg_t { .header { .dest_array { [0] = NODE_B02 }, .dest_array_size = 1U },
+                            .cmd_id = SET_MODE, .value_0 = (int32_t)(GUARD_MODE) }),
+
+        std::make_tuple(node_msg_t { .header { .dest_array { [0] = NODE_B02 }, .dest_array_size = 1U },
+                            .cmd_id = SET_MODE, .value_0 = (int32_t)(ALARM_MODE) })
+    )
+);
@@ -1334,3 +1334,177 @@ INSTANTIATE_TEST_SUITE_P(NodeT01TestFixture, NodeT01ParameterizedFrontPirCommand
                             .is_display_on = false, .is_warning_led_on = false, .is_msg_to_send = true })
     )
 );
+
+
+class NodeT01ParameterizedMsgState : public NodeT01TestFixture, public testing::WithParamInterface
+    <std::tuple<
+        node_msg_t,
+        bool,
+        node_T01_humidity_t,
+        uint32_t
+    >>
+{};
+
+TEST_P(NodeT01ParameterizedMsgState, ProcessMsgState)
+{
+    // Arrange: create and set up a system under test
+    node_msg_t mode_msg             = std::get<0>(GetParam());
+    bool is_door_open               = std::get<1>(GetParam());
+    node_T01_humidity_t humidity    = std::get<2>(GetParam());
+
+    uint32_t next_time_ms;
+    node_T01_process_msg(&node, &mode_msg, (NODE_T01_LIGHT_DURATION_MS * 2U));
+    node_T01_process_door_state(&node, is_door_open, &next_time_ms);
+    node_T01_process_humidity(&node, &humidity, &next_time_ms);
+
+    // Drop the periodic updates
+    node_msg_t msg;
+    bool is_msg_valid = true;
+
+    while (is_msg_valid == true)
+    {
+        node_T01_get_msg(&node, &msg, &is_msg_valid);
+    }
+
+    node_msg_t request_msg { .header { .source = NODE_B01, .dest_array { [0] = NODE_T01 }, .dest_array_size = 1U },
+                                .cmd_id = REQUEST_STATE };
+
+    const uint32_t expected_state = std::get<3>(GetParam());
+
+    // Act: poke the system under test
+    node_T01_process_msg(&node, &request_msg, ((NODE_T01_LIGHT_DURATION_MS * 2U) + 1U));
+
+    node_T01_get_msg(&node, &msg, &is_msg_valid);
+
+    // Assert: make unit test pass or fail
+    ASSERT_EQ(is_msg_valid, true);
+    EXPECT_EQ(msg.cmd_id,                   RESPONSE_STATE);
+    EXPECT_EQ(msg.header.source,            NODE_T01);
+    EXPECT_EQ(msg.header.dest_array_size,   1U);
+    EXPECT_EQ(msg.header.dest_array[0],     NODE_B01);
+    EXPECT_EQ((uint32_t)(msg.value_0),      expected_state);
+
+    if (humidity.is_valid == true)
+    {
+        EXPECT_EQ(msg.value_1,          (int32_t)(humidity.pressure_hPa));
+        EXPECT_FLOAT_EQ(msg.value_2,    humidity.temperature_C);
+    }
+    else
+    {
+        EXPECT_EQ(msg.value_1,          0);
+        EXPECT_FLOAT_EQ(msg.value_2,    0.0F);
+    }
+
+    node_T01_get_msg(&node, &msg, &is_msg_valid);
+    EXPECT_EQ(is_msg_valid, false);
+}
+
+INSTANTIATE_TEST_SUITE_P(NodeT01TestFixture, NodeT01ParameterizedMsgState,
+    testing::Values
+    (
+        std::make_tuple(node_msg_t { .header { .dest_array { [0] = NODE_T01 }, .dest_array_size = 1U },
+                            .cmd_id = SET_MODE, .value_0 = (int32_t)(SILENCE_MODE) },
+                        false, node_T01_humidity_t { .is_valid = false },
+                        (uint32_t)(SILENCE_MODE) | NODE_STATE_WARNING_FLAG),
+
+        std::make_tuple(node_msg_t { .header { .dest_array { [0] = NODE_T01 }, .dest_array_size = 1U },
+                            .cmd_id = SET_MODE, .value_0 = (int32_t)(SILENCE_MODE) },
+                        true, node_T01_humidity_t { .pressure_hPa = 1013.0F, .temperature_C = 21.5F, .humidity_pct = 45.0F, .is_valid = true },
+                        (uint32_t)(SILENCE_MODE) | NODE_STATE_DOOR_OPEN_FLAG | NODE_STATE_WARNING_FLAG | NODE_STATE_SENSOR_VALID_FLAG |
+                            (45U << NODE_STATE_HUMIDITY_SHIFT)),
+
+        std::make_tuple(node_msg_t { .header { .dest_array { [0] = NODE_T01 }, .dest_array_size = 1U },
+                            .cmd_id = SET_WARNING, .value_0 = (int32_t)(WARNING_OFF) },
+                        false, node_T01_humidity_t { .pressure_hPa = 990.0F, .temperature_C = -4.5F, .humidity_pct = 80.0F, .is_valid = true },
+                        (uint32_t)(SILENCE_MODE) | NODE_STATE_SENSOR_VALID_FLAG | (80U << NODE_STATE_HUMIDITY_SHIFT)),
+
+        std::make_tuple(node_msg_t { .header { .dest_array { [0] = NODE_T01 }, .dest_array_size = 1U },
+                            .cmd_id = SET_MODE, .value_0 = (int32_t)(GUARD_MODE) },
+                        false, node_T01_humidity_t { .is_valid = false },
+                        (uint32_t)(GUARD_MODE) | NODE_STATE_WARNING_FLAG),
+
+        std::make_tuple(node_msg_t { .header { .dest_array { [0] = NODE_T01 }, .dest_array_size = 1U },
+                            .cmd_id = SET_MODE, .value_0 = (int32_t)(ALARM_MODE) },
+                        true, node_T01_humidity_t { .is_valid = false },
+                        (uint32_t)(ALARM_MODE) | NODE_STATE_DOOR_OPEN_FLAG | NODE_STATE_INTRUSION_FLAG | NODE_STATE_WARNING_FLAG)
+    )
+);
+
+
+class NodeT01ParameterizedWarmRestart : public NodeT01TestFixture, public testing::WithParamInterface
+    <std::tuple<
+        node_msg_t,
+        bool
+    >>
+{};
+
+TEST_P(NodeT01ParameterizedWarmRestart, RestoreSnapshot)
+{
+    // Arrange: create and set up a system under test
+    node_msg_t rcv_msg  = std::get<0>(GetParam());
+    bool is_door_open   = std::get<1>(GetParam());
+
+    const uint32_t movement_time_ms = 100U * 1000U;
+    const uint32_t snapshot_time_ms = movement_time_ms + (10U * 1000U);
+
+    uint32_t next_time_ms;
+
+    node_T01_luminosity_t luminosity { .lux = (NODE_T01_DARKNESS_LEVEL_LUX - 1.0F), .is_valid = true };
+    node_T01_humidity_t humidity { .pressure_hPa = 1013.0F, .temperature_C = (NODE_T01_LOW_TEMPERATURE_C - 1.0F), .humidity_pct = 45.0F, .is_valid = true };
+
+    node_T01_process_luminosity(&node, &luminosity, &next_time_ms);
+    node_T01_process_humidity(&node, &humidity, &next_time_ms);
+    node_T01_process_door_state(&node, is_door_open, &next_time_ms);
+    node_T01_process_msg(&node, &rcv_msg, movement_time_ms / 2U);
+    node_T01_process_movement(&node, movement_time_ms);
+
+    node_T01_snapshot_t snapshot;
+    node_T01_get_snapshot(&node, &snapshot, snapshot_time_ms);
+
+    // Act: poke the system under test
+    node_T01_t restored_node;
+    node_T01_init(&restored_node);
+    node_T01_restore(&restored_node, &snapshot);
+
+    // Assert: make unit test pass or fail
+    const uint32_t time_array[] = { snapshot_time_ms, (movement_time_ms + NODE_T01_LIGHT_DURATION_MS),
+                                    (movement_time_ms + NODE_T01_LIGHT_DURATION_MS + 1U), (movement_time_ms + (NODE_T01_LIGHT_DURATION_MS * 2U)) };
+
+    for (const uint32_t time_ms : time_array)
+    {
+        node_T01_state_t expected_state;
+        node_T01_get_state(&node, &expected_state, time_ms);
+
+        node_T01_state_t result_state;
+        node_T01_get_state(&restored_node, &result_state, time_ms);
+
+        EXPECT_EQ(result_state.status_led_color,    expected_state.status_led_color) << time_ms;
+        EXPECT_EQ(result_state.is_light_on,         expected_state.is_light_on) << time_ms;
+        EXPECT_EQ(result_state.is_display_on,       expected_state.is_display_on) << time_ms;
+        EXPECT_EQ(result_state.is_warning_led_on,   expected_state.is_warning_led_on) << time_ms;
+    }
+
+    node_T01_humidity_t result_humidity;
+    uint32_t disable_time_ms;
+    node_T01_get_display_data(&restored_node, &result_humidity, &disable_time_ms);
+
+    EXPECT_EQ(result_humidity.temperature_C,    humidity.temperature_C);
+    EXPECT_EQ(result_humidity.is_valid,         humidity.is_valid);
+}
+
+INSTANTIATE_TEST_SUITE_P(NodeT01TestFixture, NodeT01ParameterizedWarmRestart,
+    testing::Values
+    (
+        std::make_tuple(node_msg_t { .header { .dest_array { [0] = NODE_T01 }, .dest_array_size = 1U },
+                            .cmd_id = SET_MODE, .value_0 = (int32_t)(SILENCE_MODE) }, true),
+
+        std::make_tuple(node_msg_t { .header { .dest_array { [0] = NODE_T01 }, .dest_array_size = 1U },
+                            .cmd_id = SET_WARNING, .value_0 = (int32_t)(WARNING_OFF) }, true),
+
+        std::make_tuple(node_msg_t { .header { .dest_array { [0] = NODE_T01 }, .dest_array_size = 1U },
+                            .cmd_id = SET_MODE, .value_0 = (int32_t)(GUARD_MODE) }, false),
+
+        std::make_tuple(node_msg_t { .header { .dest_array { [0] = NODE_T01 }, .dest_array_size = 1U },
+                            .cmd_id = SET_MODE, .value_0 = (int32_t)(ALARM_MODE) }, false)
+    )
+);
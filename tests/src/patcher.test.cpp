@@ -0,0 +1,301 @@
+/************************************************************
+ *   Author : German Mundinger
+ *   Date   : 2024
+ ************************************************************/
+
+#include <gmock/gmock.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "patcher.h"
+#include "crc32.h"
+#include "firmware_update.h"
+#include "std_error/std_error.h"
+
+
+constexpr size_t old_image_size = 120U * 1024U + 6U;
+
+
+// What the server side differ emits
+struct PatchBuilder
+{
+    std::vector<uint8_t> patch;
+
+    void put_u32 (uint32_t value)
+    {
+        for (size_t i = 0U; i < 4U; ++i)
+        {
+            patch.push_back((uint8_t)(value >> (8U * i)));
+        }
+    }
+
+    void header (std::vector<uint8_t> const &old_image, std::vector<uint8_t> const &new_image)
+    {
+        patch = { PATCHER_MAGIC_0, PATCHER_MAGIC_1, 0U, 0U };
+        put_u32((uint32_t)(old_image.size()));
+        put_u32(crc32_calculate(old_image.data(), old_image.size()));
+        put_u32((uint32_t)(new_image.size()));
+        put_u32(crc32_calculate(new_image.data(), new_image.size()));
+    }
+
+    void copy (uint32_t old_offset, uint32_t size)
+    {
+        patch.push_back(COPY_PATCHER_OPERATION);
+        put_u32(old_offset);
+        put_u32(size);
+    }
+
+    void add (std::vector<uint8_t> const &old_image, std::vector<uint8_t> const &new_image, uint32_t old_offset, uint32_t new_offset, uint32_t size)
+    {
+        patch.push_back(ADD_PATCHER_OPERATION);
+        put_u32(old_offset);
+        put_u32(size);
+
+        for (uint32_t i = 0U; i < size; ++i)
+        {
+            patch.push_back((uint8_t)(new_image[new_offset + i] - old_image[old_offset + i]));
+        }
+    }
+
+    void insert (uint8_t const * const data, uint32_t size)
+    {
+        patch.push_back(INSERT_PATCHER_OPERATION);
+        put_u32(size);
+        patch.insert(patch.end(), data, data + size);
+    }
+};
+
+
+class PatcherTestFixture : public testing::Test
+{
+    protected:
+
+        static PatcherTestFixture *instance;
+
+        patcher_t patcher;
+        std_error_t error;
+
+        std::vector<uint8_t> old_image;
+        std::vector<uint8_t> new_image;
+        std::vector<uint8_t> output;
+        PatchBuilder builder;
+
+        virtual void SetUp() override
+        {
+            instance = this;
+
+            std_error_init(&error);
+
+            old_image.resize(old_image_size);
+
+            for (size_t i = 0U; i < old_image.size(); ++i)
+            {
+                old_image[i] = (uint8_t)((i * 7U) + (i >> 8U));
+            }
+
+            // A release: 2 kB of new code at 40 kB, everything after it moves and its literal pool words change
+            const size_t insert_offset  = 40U * 1024U;
+            const size_t insert_size    = 2U * 1024U;
+
+            new_image.assign(old_image.begin(), old_image.begin() + insert_offset);
+
+            for (size_t i = 0U; i < insert_size; ++i)
+            {
+                new_image.push_back((uint8_t)(i * 29U));
+            }
+            new_image.insert(new_image.end(), old_image.begin() + insert_offset, old_image.end());
+
+            for (size_t i = insert_offset + insert_size; (i + 4U) <= new_image.size(); i += 64U)
+            {
+                new_image[i] = (uint8_t)(new_image[i] + 0x08U);
+            }
+
+            builder.header(old_image, new_image);
+            builder.copy(0U, (uint32_t)(insert_offset));
+            builder.insert(&new_image[insert_offset], (uint32_t)(insert_size));
+            builder.add(old_image, new_image, (uint32_t)(insert_offset), (uint32_t)(insert_offset + insert_size), (uint32_t)(old_image.size() - insert_offset));
+
+            patcher_config_t config;
+            config.read_callback    = read;
+            config.write_callback   = write;
+            config.max_old_size     = 448U * 1024U;
+            config.max_new_size     = 448U * 1024U;
+
+            patcher_init(&patcher, &config);
+        }
+
+        static int read (uint32_t offset, uint8_t * const data, size_t size, std_error_t * const error)
+        {
+            (void)error;
+
+            EXPECT_LE(offset + size, instance->old_image.size());
+
+            std::memcpy(data, &instance->old_image[offset], size);
+
+            return STD_SUCCESS;
+        }
+
+        static int write (uint8_t const * const data, size_t size, std_error_t * const error)
+        {
+            (void)error;
+
+            instance->output.insert(instance->output.end(), data, data + size);
+
+            return STD_SUCCESS;
+        }
+
+        int apply (std::vector<uint8_t> const &patch, size_t chunk_size)
+        {
+            for (size_t i = 0U; i < patch.size(); i += chunk_size)
+            {
+                if (patcher_process(&patcher, &patch[i], std::min(chunk_size, patch.size() - i), &error) != STD_SUCCESS)
+                {
+                    return STD_FAILURE;
+                }
+            }
+            return patcher_finish(&patcher, &error);
+        }
+};
+
+PatcherTestFixture *PatcherTestFixture::instance = nullptr;
+
+
+TEST_F(PatcherTestFixture, RejectOtherOldImage)
+{
+    // Arrange: create and set up a system under test
+    old_image[1000U] ^= 0x01U;
+
+    // Act: poke the system under test
+    const int exit_code = apply(builder.patch, 4096U);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(exit_code, STD_FAILURE);
+    EXPECT_TRUE(output.empty());
+}
+
+TEST_F(PatcherTestFixture, RejectCopyPastOldImage)
+{
+    // Arrange: create and set up a system under test
+    builder.header(old_image, new_image);
+    builder.copy((uint32_t)(old_image.size() - 10U), 11U);
+
+    // Act: poke the system under test
+    const int exit_code = apply(builder.patch, 4096U);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(exit_code, STD_FAILURE);
+    EXPECT_TRUE(output.empty());
+}
+
+TEST_F(PatcherTestFixture, RejectCorruptedPatch)
+{
+    // Arrange: create and set up a system under test
+    builder.patch[builder.patch.size() - 100U] ^= 0x10U;
+
+    // Act: poke the system under test
+    const int exit_code = apply(builder.patch, 4096U);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(exit_code,        STD_FAILURE);
+    EXPECT_EQ(output.size(),    new_image.size());
+}
+
+TEST_F(PatcherTestFixture, RejectTruncatedPatch)
+{
+    // Arrange: create and set up a system under test
+    builder.patch.resize(builder.patch.size() - 1U);
+
+    // Act: poke the system under test
+    const int exit_code = apply(builder.patch, 4096U);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(exit_code, STD_FAILURE);
+}
+
+TEST_F(PatcherTestFixture, RejectOverlongPatch)
+{
+    // Arrange: create and set up a system under test
+    builder.copy(0U, 1U);
+
+    // Act: poke the system under test
+    const int exit_code = apply(builder.patch, 4096U);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(exit_code, STD_FAILURE);
+}
+
+TEST_F(PatcherTestFixture, RejectUnknownOperation)
+{
+    // Arrange: create and set up a system under test
+    builder.header(old_image, new_image);
+    builder.patch.push_back(0x7FU);
+
+    // Act: poke the system under test
+    const int exit_code = apply(builder.patch, 4096U);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(exit_code, STD_FAILURE);
+}
+
+TEST_F(PatcherTestFixture, PatchTransfer)
+{
+    // Arrange: create and set up a system under test
+    PatchBuilder small_builder;
+
+    // A small fix in place: a couple of instructions, nothing moves
+    std::vector<uint8_t> fixed_image = old_image;
+    fixed_image[70000U] = 0x00U;
+    fixed_image[70001U] = 0xBFU;
+
+    small_builder.header(old_image, fixed_image);
+    small_builder.copy(0U, 70000U);
+    small_builder.insert(&fixed_image[70000U], 2U);
+    small_builder.copy(70002U, (uint32_t)(old_image.size() - 70002U));
+
+    new_image = fixed_image;
+
+    // Act: poke the system under test
+    const int exit_code = apply(small_builder.patch, 4096U);
+
+    const size_t image_frames = (new_image.size() + FIRMWARE_UPDATE_CHUNK_SIZE - 1U) / FIRMWARE_UPDATE_CHUNK_SIZE;
+    const size_t patch_frames = (small_builder.patch.size() + FIRMWARE_UPDATE_CHUNK_SIZE - 1U) / FIRMWARE_UPDATE_CHUNK_SIZE;
+
+    std::cout << "[ BENCHMARK] full image : " << new_image.size() << " bytes, " << image_frames << " frames" << std::endl;
+    std::cout << "[ BENCHMARK] patch      : " << small_builder.patch.size() << " bytes, " << patch_frames << " frames" << std::endl;
+    RecordProperty("image_frames", std::to_string(image_frames));
+    RecordProperty("patch_frames", std::to_string(patch_frames));
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(exit_code,    STD_SUCCESS);
+    EXPECT_EQ(output,       new_image);
+    EXPECT_EQ(patch_frames, 1U);
+}
+
+
+class PatcherParameterizedApply : public PatcherTestFixture,
+                                    public testing::WithParamInterface<size_t>
+{
+};
+
+TEST_P(PatcherParameterizedApply, ApplyPatch)
+{
+    // Arrange: create and set up a system under test
+    const size_t chunk_size = GetParam();
+
+    // Act: poke the system under test
+    const int exit_code = apply(builder.patch, chunk_size);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(exit_code,    STD_SUCCESS);
+    EXPECT_EQ(output,       new_image);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    PatcherApply,
+    PatcherParameterizedApply,
+    testing::Values(1U, 13U, FIRMWARE_UPDATE_CHUNK_SIZE, 4096U)
+);
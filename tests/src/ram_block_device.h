@@ -0,0 +1,144 @@
+/************************************************************
+ *   Author : German Mundinger
+ *   Date   : 2024
+ ************************************************************/
+
+#ifndef RAM_BLOCK_DEVICE_H
+#define RAM_BLOCK_DEVICE_H
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "storage.h"
+
+
+// W25Q32BV geometry and typical timings
+constexpr uint32_t ram_block_size       = 4096U;
+constexpr uint32_t ram_block_count      = 1024U;
+constexpr double page_program_time_ms   = 0.7;
+constexpr double sector_erase_time_ms   = 45.0;
+
+
+// littlefs straight on RAM with NOR semantics, counting the flash operations
+struct RamBlockDevice
+{
+    std::vector<uint8_t> data = std::vector<uint8_t>(ram_block_size * ram_block_count, 0xFFU);
+
+    size_t prog_count   = 0U;
+    size_t erase_count  = 0U;
+    size_t lock_count   = 0U;
+
+    // Those of storage_config_t, nothing to take by default
+    storage_lock_callback_t lock_callback   = nullptr;
+    storage_lock_callback_t unlock_callback = nullptr;
+
+    static int read (const struct lfs_config *config, lfs_block_t block, lfs_off_t offset, void *buffer, lfs_size_t size)
+    {
+        RamBlockDevice *device = (RamBlockDevice*)config->context;
+
+        std::memcpy(buffer, &device->data[(block * ram_block_size) + offset], size);
+
+        return LFS_ERR_OK;
+    }
+
+    static int prog (const struct lfs_config *config, lfs_block_t block, lfs_off_t offset, const void *buffer, lfs_size_t size)
+    {
+        RamBlockDevice *device = (RamBlockDevice*)config->context;
+
+        const uint8_t *bytes = (const uint8_t*)buffer;
+
+        for (lfs_size_t i = 0U; i < size; ++i)
+        {
+            // NOR flash can only clear bits
+            device->data[(block * ram_block_size) + offset + i] &= bytes[i];
+        }
+        ++device->prog_count;
+
+        return LFS_ERR_OK;
+    }
+
+    static int erase (const struct lfs_config *config, lfs_block_t block)
+    {
+        RamBlockDevice *device = (RamBlockDevice*)config->context;
+
+        std::memset(&device->data[block * ram_block_size], 0xFF, ram_block_size);
+        ++device->erase_count;
+
+        return LFS_ERR_OK;
+    }
+
+    static int sync (const struct lfs_config *config)
+    {
+        (void)config;
+
+        return LFS_ERR_OK;
+    }
+
+    static int lock (const struct lfs_config *config)
+    {
+        RamBlockDevice *device = (RamBlockDevice*)config->context;
+
+        if (device->lock_callback != nullptr)
+        {
+            device->lock_callback();
+        }
+        ++device->lock_count;
+
+        return LFS_ERR_OK;
+    }
+
+    static int unlock (const struct lfs_config *config)
+    {
+        RamBlockDevice *device = (RamBlockDevice*)config->context;
+
+        if (device->unlock_callback != nullptr)
+        {
+            device->unlock_callback();
+        }
+
+        return LFS_ERR_OK;
+    }
+
+    void reset_counters ()
+    {
+        prog_count  = 0U;
+        erase_count = 0U;
+        lock_count  = 0U;
+    }
+
+    double get_flash_time_ms () const
+    {
+        return ((double)(prog_count) * page_program_time_ms) + ((double)(erase_count) * sector_erase_time_ms);
+    }
+
+    // Binds storage to the device, lfs_format() or lfs_mount() it then
+    struct lfs_config* configure (storage_t &storage, storage_geometry_t const &geometry)
+    {
+        storage.lfs_config = {};
+
+        storage.lfs_config.context  = (void*)(this);
+        storage.lfs_config.read     = RamBlockDevice::read;
+        storage.lfs_config.prog     = RamBlockDevice::prog;
+        storage.lfs_config.erase    = RamBlockDevice::erase;
+        storage.lfs_config.sync     = RamBlockDevice::sync;
+        storage.lfs_config.lock     = RamBlockDevice::lock;
+        storage.lfs_config.unlock   = RamBlockDevice::unlock;
+
+        storage.lfs_config.read_size        = geometry.read_size;
+        storage.lfs_config.prog_size        = geometry.prog_size;
+        storage.lfs_config.block_size       = ram_block_size;
+        storage.lfs_config.block_count      = ram_block_count;
+        storage.lfs_config.cache_size       = geometry.cache_size;
+        storage.lfs_config.lookahead_size   = geometry.lookahead_size;
+        storage.lfs_config.block_cycles     = geometry.block_cycles;
+
+        storage.lfs_config.read_buffer      = storage.lfs_read_buffer;
+        storage.lfs_config.prog_buffer      = storage.lfs_prog_buffer;
+        storage.lfs_config.lookahead_buffer = storage.lfs_lookahead_buffer;
+
+        return &storage.lfs_config;
+    }
+};
+
+#endif // RAM_BLOCK_DEVICE_H
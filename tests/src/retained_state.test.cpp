@@ -0,0 +1,137 @@
+/************************************************************
+ *   Author : German Mundinger
+ *   Date   : 2024
+ ************************************************************/
+
+#include <gmock/gmock.h>
+
+#include <array>
+#include <cstring>
+#include <random>
+
+#include "retained_state.h"
+
+
+struct RetainedSnapshot
+{
+    uint32_t mode;
+    uint32_t start_time_ms;
+    float temperature_C;
+    bool is_dark;
+};
+
+static constexpr uint32_t retained_type = 7U;
+
+class RetainedStateTestFixture : public testing::Test
+{
+    protected:
+
+        retained_state_t state;
+        RetainedSnapshot snapshot;
+
+        virtual void SetUp() override
+        {
+            // What the RAM holds after a power-on
+            std::mt19937 generator(1U);
+            uint8_t * const bytes = (uint8_t*)(&state);
+
+            for (size_t i = 0U; i < sizeof(retained_state_t); ++i)
+            {
+                bytes[i] = (uint8_t)(generator());
+            }
+
+            std::memset(&snapshot, 0, sizeof(RetainedSnapshot));
+            snapshot.mode           = 2U;
+            snapshot.start_time_ms  = 123456U;
+            snapshot.temperature_C  = 21.5F;
+            snapshot.is_dark        = true;
+        }
+};
+
+
+TEST_F(RetainedStateTestFixture, ColdBoot)
+{
+    // Arrange: create and set up a system under test
+    RetainedSnapshot result;
+    std::memset(&result, 0, sizeof(RetainedSnapshot));
+
+    // Act & Assert: poke the system under test and check the result
+    EXPECT_FALSE(retained_state_load(&state, retained_type, &result, sizeof(RetainedSnapshot)));
+    EXPECT_EQ(result.start_time_ms, 0U);
+
+    retained_state_clear(&state);
+
+    EXPECT_FALSE(retained_state_load(&state, retained_type, &result, sizeof(RetainedSnapshot)));
+}
+
+TEST_F(RetainedStateTestFixture, WarmBoot)
+{
+    // Arrange: create and set up a system under test
+    retained_state_save(&state, retained_type, &snapshot, sizeof(RetainedSnapshot));
+
+    // Act: poke the system under test
+    RetainedSnapshot result;
+    std::memset(&result, 0, sizeof(RetainedSnapshot));
+
+    const bool is_loaded = retained_state_load(&state, retained_type, &result, sizeof(RetainedSnapshot));
+
+    // Assert: make unit test pass or fail
+    EXPECT_TRUE(is_loaded);
+    EXPECT_EQ(result.mode,          snapshot.mode);
+    EXPECT_EQ(result.start_time_ms, snapshot.start_time_ms);
+    EXPECT_EQ(result.temperature_C, snapshot.temperature_C);
+    EXPECT_EQ(result.is_dark,       snapshot.is_dark);
+}
+
+TEST_F(RetainedStateTestFixture, LatestSaveWins)
+{
+    // Arrange: create and set up a system under test
+    retained_state_save(&state, retained_type, &snapshot, sizeof(RetainedSnapshot));
+
+    snapshot.mode = 0U;
+    retained_state_save(&state, retained_type, &snapshot, sizeof(RetainedSnapshot));
+
+    // Act: poke the system under test
+    RetainedSnapshot result;
+    const bool is_loaded = retained_state_load(&state, retained_type, &result, sizeof(RetainedSnapshot));
+
+    // Assert: make unit test pass or fail
+    EXPECT_TRUE(is_loaded);
+    EXPECT_EQ(result.mode, 0U);
+}
+
+TEST_F(RetainedStateTestFixture, OtherTypeOrSize)
+{
+    // Arrange: create and set up a system under test
+    retained_state_save(&state, retained_type, &snapshot, sizeof(RetainedSnapshot));
+
+    // Act & Assert: poke the system under test and check the result
+    std::array<uint8_t, RETAINED_STATE_DATA_SIZE> result;
+
+    EXPECT_FALSE(retained_state_load(&state, retained_type + 1U, result.data(), sizeof(RetainedSnapshot)));
+    EXPECT_FALSE(retained_state_load(&state, retained_type, result.data(), sizeof(RetainedSnapshot) - 4U));
+    EXPECT_FALSE(retained_state_load(&state, retained_type, result.data(), RETAINED_STATE_DATA_SIZE));
+    EXPECT_TRUE(retained_state_load(&state, retained_type, result.data(), sizeof(RetainedSnapshot)));
+}
+
+TEST_F(RetainedStateTestFixture, AnyBitFlip)
+{
+    // Arrange: create and set up a system under test
+    retained_state_save(&state, retained_type, &snapshot, sizeof(RetainedSnapshot));
+
+    const retained_state_t saved_state = state;
+
+    // Act & Assert: poke the system under test and check the result
+    for (size_t i = 0U; i < sizeof(retained_state_t); ++i)
+    {
+        for (uint8_t bit = 0U; bit < 8U; ++bit)
+        {
+            state = saved_state;
+            ((uint8_t*)(&state))[i] ^= (uint8_t)(1U << bit);
+
+            RetainedSnapshot result;
+
+            EXPECT_FALSE(retained_state_load(&state, retained_type, &result, sizeof(RetainedSnapshot))) << "byte " << i << ", bit " << (int)(bit);
+        }
+    }
+}
@@ -0,0 +1,621 @@
+/************************************************************
+ *   Author : German Mundinger
+ *   Date   : 2024
+ ************************************************************/
+
+#include <gmock/gmock.h>
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "sensor_log.h"
+#include "storage.h"
+#include "storage_request.h"
+#include "std_error/std_error.h"
+
+#include "ram_block_device.h"
+
+
+constexpr storage_geometry_t test_geometry = { 16U, 256U, 256U, 128U, 500 };
+
+// The queue of the storage task
+static std::vector<storage_request_t> queued_request_array;
+static size_t queue_size = SIZE_MAX;
+
+static int queue_request (storage_request_t const * const request, std_error_t * const error)
+{
+    if (queued_request_array.size() == queue_size)
+    {
+        std_error_catch_custom(error, STD_FAILURE, "Queue full", __FILE__, __LINE__);
+
+        return STD_FAILURE;
+    }
+
+    queued_request_array.push_back(*request);
+
+    return STD_SUCCESS;
+}
+
+
+class SensorLogTestFixture : public testing::Test
+{
+    protected:
+
+        RamBlockDevice device;
+        storage_t storage;
+        sensor_log_t log;
+        std_error_t error;
+
+        sensor_log_request_callback_t request_callback = nullptr;
+
+        virtual void SetUp() override
+        {
+            std_error_init(&error);
+
+            queued_request_array.clear();
+            queue_size = SIZE_MAX;
+
+            ASSERT_EQ(lfs_format(&storage.lfs, device.configure(storage, test_geometry)), LFS_ERR_OK);
+            ASSERT_EQ(storage_mount_filesystem(&storage, &error), STD_SUCCESS);
+            ASSERT_EQ(init(log), STD_SUCCESS);
+
+            device.reset_counters();
+        }
+
+        virtual void TearDown() override
+        {
+            lfs_unmount(&storage.lfs);
+        }
+
+        int init (sensor_log_t &self)
+        {
+            sensor_log_config_t config;
+            config.storage          = &storage;
+            config.request_callback = request_callback;
+
+            return sensor_log_init(&self, &config, &error);
+        }
+
+        // Three sensors a second, as the T01 logs a BME280 reading
+        int append (size_t count, size_t first_index = 0U)
+        {
+            for (size_t i = first_index; i < (first_index + count); ++i)
+            {
+                if (sensor_log_append(&log, get_time_s(i), get_sensor_id(i), get_value(i), &error) != STD_SUCCESS)
+                {
+                    return STD_FAILURE;
+                }
+            }
+            return STD_SUCCESS;
+        }
+
+        std::vector<sensor_log_record_t> query (sensor_log_t &self, uint32_t from_s, uint32_t to_s)
+        {
+            std::vector<sensor_log_record_t> result;
+
+            sensor_log_cursor_t cursor;
+
+            if (sensor_log_find(&self, &cursor, from_s, to_s, &error) != STD_SUCCESS)
+            {
+                return result;
+            }
+
+            while (true)
+            {
+                sensor_log_record_t record;
+                bool is_record_valid;
+
+                if ((sensor_log_read_next(&self, &cursor, &record, &is_record_valid, &error) != STD_SUCCESS) || (is_record_valid != true))
+                {
+                    break;
+                }
+                result.push_back(record);
+            }
+            return result;
+        }
+
+        static uint32_t get_time_s (size_t index)
+        {
+            return 1000U + (uint32_t)(index / 3U);
+        }
+
+        static uint8_t get_sensor_id (size_t index)
+        {
+            return (uint8_t)((index % 3U) + 1U);
+        }
+
+        static float get_value (size_t index)
+        {
+            return (float)(index % 500U) / 10.0F;
+        }
+
+        // Index of the first record of the second
+        static size_t get_index (uint32_t time_s)
+        {
+            return (size_t)(time_s - 1000U) * 3U;
+        }
+
+        static void expect_records (std::vector<sensor_log_record_t> const &records, size_t first_index, size_t count)
+        {
+            ASSERT_EQ(records.size(), count);
+
+            for (size_t i = 0U; i < count; ++i)
+            {
+                const size_t index = first_index + i;
+
+                ASSERT_EQ(records[i].time_s,    get_time_s(index)) << "record " << i;
+                ASSERT_EQ(records[i].sensor_id, get_sensor_id(index)) << "record " << i;
+                ASSERT_FLOAT_EQ(sensor_log_get_value(&records[i]), get_value(index)) << "record " << i;
+            }
+        }
+};
+
+
+TEST_F(SensorLogTestFixture, RecordSize)
+{
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(sizeof(sensor_log_record_t), SENSOR_LOG_RECORD_SIZE);
+}
+
+TEST_F(SensorLogTestFixture, AppendIsBuffered)
+{
+    // Act: poke the system under test
+    const int exit_code = append(SENSOR_LOG_BUFFER_SIZE - 1U);
+
+    const size_t buffered_prog_count = device.prog_count;
+
+    append(1U, SENSOR_LOG_BUFFER_SIZE - 1U);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(exit_code,            STD_SUCCESS);
+    EXPECT_EQ(buffered_prog_count,  0U);
+    EXPECT_EQ(device.erase_count,   0U);
+    EXPECT_GT(device.prog_count,    0U);
+}
+
+TEST_F(SensorLogTestFixture, ValueScaling)
+{
+    // Arrange: create and set up a system under test
+    ASSERT_EQ(sensor_log_append(&log, 1U, 1U, 23.45F,    &error), STD_SUCCESS);
+    ASSERT_EQ(sensor_log_append(&log, 2U, 1U, -5.04F,    &error), STD_SUCCESS);
+    ASSERT_EQ(sensor_log_append(&log, 3U, 3U, 1013.25F,  &error), STD_SUCCESS);
+    ASSERT_EQ(sensor_log_append(&log, 4U, 3U, 5000.0F,   &error), STD_SUCCESS);
+
+    // Act: poke the system under test
+    const std::vector<sensor_log_record_t> records = query(log, 0U, UINT32_MAX);
+
+    // Assert: make unit test pass or fail
+    ASSERT_EQ(records.size(), 4U);
+    EXPECT_EQ(records[0].value, 235);
+    EXPECT_EQ(records[1].value, -50);
+    EXPECT_EQ(records[2].value, 10133);
+    EXPECT_EQ(records[3].value, INT16_MAX);
+}
+
+TEST_F(SensorLogTestFixture, QueryRange)
+{
+    // Arrange: create and set up a system under test
+    ASSERT_EQ(append(3000U), STD_SUCCESS);
+
+    // Act: poke the system under test
+    const std::vector<sensor_log_record_t> records = query(log, 1200U, 1300U);
+
+    // Assert: make unit test pass or fail
+    expect_records(records, get_index(1200U), 101U * 3U);
+}
+
+TEST_F(SensorLogTestFixture, QuerySecondSplitBySegments)
+{
+    // Arrange: create and set up a system under test
+    ASSERT_EQ(append(3U * SENSOR_LOG_SEGMENT_SIZE), STD_SUCCESS);
+
+    // The second of the last record of the first segment goes on in the next one
+    const uint32_t time_s = get_time_s(SENSOR_LOG_SEGMENT_SIZE - 1U);
+
+    // Act: poke the system under test
+    const std::vector<sensor_log_record_t> records = query(log, time_s, time_s);
+
+    // Assert: make unit test pass or fail
+    EXPECT_NE(get_time_s(SENSOR_LOG_SEGMENT_SIZE - 1U), get_time_s(SENSOR_LOG_SEGMENT_SIZE - 3U));
+    expect_records(records, get_index(time_s), 3U);
+}
+
+TEST_F(SensorLogTestFixture, QueryOutOfRange)
+{
+    // Arrange: create and set up a system under test
+    ASSERT_EQ(append(300U), STD_SUCCESS);
+
+    // Act: poke the system under test
+    const std::vector<sensor_log_record_t> before_records   = query(log, 0U, 999U);
+    const std::vector<sensor_log_record_t> after_records    = query(log, 1100U, 2000U);
+    const std::vector<sensor_log_record_t> reversed_records = query(log, 1050U, 1040U);
+    const std::vector<sensor_log_record_t> all_records      = query(log, 0U, UINT32_MAX);
+
+    // Assert: make unit test pass or fail
+    EXPECT_TRUE(before_records.empty());
+    EXPECT_TRUE(after_records.empty());
+    EXPECT_TRUE(reversed_records.empty());
+    expect_records(all_records, 0U, 300U);
+}
+
+TEST_F(SensorLogTestFixture, QuerySeesBufferedRecords)
+{
+    // Arrange: create and set up a system under test
+    ASSERT_EQ(append(5U), STD_SUCCESS);
+
+    // Act: poke the system under test
+    const std::vector<sensor_log_record_t> records = query(log, 0U, UINT32_MAX);
+
+    // Assert: make unit test pass or fail
+    expect_records(records, 0U, 5U);
+}
+
+TEST_F(SensorLogTestFixture, RotationDropsOldestSegment)
+{
+    // Arrange: create and set up a system under test
+    constexpr size_t record_count = (SENSOR_LOG_SEGMENT_COUNT + 2U) * SENSOR_LOG_SEGMENT_SIZE;
+
+    // Act: poke the system under test
+    const int exit_code = append(record_count);
+
+    const std::vector<sensor_log_record_t> records = query(log, 0U, UINT32_MAX);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(exit_code, STD_SUCCESS);
+    expect_records(records, 2U * SENSOR_LOG_SEGMENT_SIZE, SENSOR_LOG_SEGMENT_COUNT * SENSOR_LOG_SEGMENT_SIZE);
+}
+
+TEST_F(SensorLogTestFixture, ReopenGoesOn)
+{
+    // Arrange: create and set up a system under test
+    ASSERT_EQ(append(1000U), STD_SUCCESS);
+    ASSERT_EQ(sensor_log_flush(&log, &error), STD_SUCCESS);
+
+    // Act: poke the system under test
+    sensor_log_t reopened_log;
+    const int exit_code = init(reopened_log);
+
+    uint32_t last_time_s;
+    const bool is_last_time_valid = sensor_log_get_last_time(&reopened_log, &last_time_s);
+
+    for (size_t i = 1000U; i < 1500U; ++i)
+    {
+        ASSERT_EQ(sensor_log_append(&reopened_log, get_time_s(i), get_sensor_id(i), get_value(i), &error), STD_SUCCESS);
+    }
+
+    const std::vector<sensor_log_record_t> records = query(reopened_log, 0U, UINT32_MAX);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(exit_code, STD_SUCCESS);
+    EXPECT_TRUE(is_last_time_valid);
+    EXPECT_EQ(last_time_s, get_time_s(999U));
+    expect_records(records, 0U, 1500U);
+}
+
+TEST_F(SensorLogTestFixture, PowerLossCostsBufferOnly)
+{
+    // Arrange: create and set up a system under test
+    ASSERT_EQ(append(SENSOR_LOG_BUFFER_SIZE + 10U), STD_SUCCESS);
+
+    // Act: poke the system under test
+    sensor_log_t rebooted_log;
+    const int exit_code = init(rebooted_log);
+
+    const std::vector<sensor_log_record_t> records = query(rebooted_log, 0U, UINT32_MAX);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(exit_code, STD_SUCCESS);
+    expect_records(records, 0U, SENSOR_LOG_BUFFER_SIZE);
+}
+
+TEST_F(SensorLogTestFixture, QueuedWrites)
+{
+    // Arrange: create and set up a system under test
+    constexpr size_t record_count = (SENSOR_LOG_SEGMENT_COUNT + 2U) * SENSOR_LOG_SEGMENT_SIZE;
+
+    queued_request_array.clear();
+
+    request_callback = queue_request;
+
+    sensor_log_t queued_log;
+    ASSERT_EQ(init(queued_log), STD_SUCCESS);
+
+    device.reset_counters();
+
+    // Act: poke the system under test
+    for (size_t i = 0U; i < record_count; ++i)
+    {
+        ASSERT_EQ(sensor_log_append(&queued_log, get_time_s(i), get_sensor_id(i), get_value(i), &error), STD_SUCCESS);
+    }
+
+    const size_t queued_prog_count = device.prog_count;
+
+    for (storage_request_t &request : queued_request_array)
+    {
+        ASSERT_EQ(storage_request_execute(&request, &storage, &error), STD_SUCCESS);
+    }
+
+    const std::vector<sensor_log_record_t> records = query(queued_log, 0U, UINT32_MAX);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(queued_prog_count, 0U);
+    EXPECT_GT(device.prog_count, 0U);
+    expect_records(records, 2U * SENSOR_LOG_SEGMENT_SIZE, SENSOR_LOG_SEGMENT_COUNT * SENSOR_LOG_SEGMENT_SIZE);
+}
+
+TEST_F(SensorLogTestFixture, QueueOfRequestBurst)
+{
+    // Arrange: create and set up a system under test
+    constexpr size_t record_count = (SENSOR_LOG_SEGMENT_COUNT + 2U) * SENSOR_LOG_SEGMENT_SIZE;
+    constexpr size_t flush_period = 20U;    // Not a divisor of the segment size, the flushes cross the segment ends
+
+    request_callback    = queue_request;
+    queue_size          = SENSOR_LOG_REQUEST_BURST;
+
+    sensor_log_t queued_log;
+    ASSERT_EQ(init(queued_log), STD_SUCCESS);
+
+    size_t max_queued_count = 0U;
+
+    // Act: poke the system under test
+    for (size_t i = 0U; i < record_count; ++i)
+    {
+        ASSERT_EQ(sensor_log_append(&queued_log, get_time_s(i), get_sensor_id(i), get_value(i), &error), STD_SUCCESS) << "record " << i;
+
+        if ((i % flush_period) == (flush_period - 1U))
+        {
+            ASSERT_EQ(sensor_log_flush(&queued_log, &error), STD_SUCCESS) << "record " << i;
+        }
+
+        max_queued_count = std::max(max_queued_count, queued_request_array.size());
+
+        // The storage task catches up between two flushes
+        for (storage_request_t &request : queued_request_array)
+        {
+            ASSERT_EQ(storage_request_execute(&request, &storage, &error), STD_SUCCESS);
+        }
+        queued_request_array.clear();
+    }
+
+    ASSERT_EQ(sensor_log_flush(&queued_log, &error), STD_SUCCESS);
+
+    for (storage_request_t &request : queued_request_array)
+    {
+        ASSERT_EQ(storage_request_execute(&request, &storage, &error), STD_SUCCESS);
+    }
+
+    const std::vector<sensor_log_record_t> records = query(queued_log, 0U, UINT32_MAX);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(max_queued_count, SENSOR_LOG_REQUEST_BURST);
+    expect_records(records, 2U * SENSOR_LOG_SEGMENT_SIZE, SENSOR_LOG_SEGMENT_COUNT * SENSOR_LOG_SEGMENT_SIZE);
+}
+
+class SensorLogParameterizedQueueSize : public SensorLogTestFixture,
+                                        public testing::WithParamInterface<size_t>
+{
+};
+
+TEST_P(SensorLogParameterizedQueueSize, FullQueueUndoesRotation)
+{
+    // Arrange: create and set up a system under test
+    constexpr size_t record_count = SENSOR_LOG_SEGMENT_COUNT * SENSOR_LOG_SEGMENT_SIZE;
+
+    request_callback = queue_request;
+
+    sensor_log_t queued_log;
+    ASSERT_EQ(init(queued_log), STD_SUCCESS);
+
+    for (size_t i = 0U; i < record_count; ++i)
+    {
+        ASSERT_EQ(sensor_log_append(&queued_log, get_time_s(i), get_sensor_id(i), get_value(i), &error), STD_SUCCESS);
+    }
+
+    for (storage_request_t &request : queued_request_array)
+    {
+        ASSERT_EQ(storage_request_execute(&request, &storage, &error), STD_SUCCESS);
+    }
+    queued_request_array.clear();
+
+    // Room for none, the delete or the delete and the index write of the rotation
+    queue_size = GetParam();
+
+    // Act: poke the system under test
+    int exit_code = STD_SUCCESS;
+
+    for (size_t i = record_count; (i < (record_count + SENSOR_LOG_BUFFER_SIZE)) && (exit_code == STD_SUCCESS); ++i)
+    {
+        exit_code = sensor_log_append(&queued_log, get_time_s(i), get_sensor_id(i), get_value(i), &error);
+    }
+
+    const size_t segment_array_size     = queued_log.segment_array_size;
+    const size_t segment_record_count   = queued_log.record_count;
+
+    for (storage_request_t &request : queued_request_array)
+    {
+        ASSERT_EQ(storage_request_execute(&request, &storage, &error), STD_SUCCESS);
+    }
+    queued_request_array.clear();
+
+    queue_size = SIZE_MAX;
+
+    sensor_log_t reopened_log;
+    ASSERT_EQ(init(reopened_log), STD_SUCCESS);
+
+    const std::vector<sensor_log_record_t> records          = query(queued_log, 0U, UINT32_MAX);
+    const std::vector<sensor_log_record_t> reopened_records = query(reopened_log, 0U, UINT32_MAX);
+
+    // The next flush rotates again
+    const size_t next_index = record_count + SENSOR_LOG_BUFFER_SIZE;
+
+    for (size_t i = next_index; i < (next_index + SENSOR_LOG_BUFFER_SIZE); ++i)
+    {
+        ASSERT_EQ(sensor_log_append(&queued_log, get_time_s(i), get_sensor_id(i), get_value(i), &error), STD_SUCCESS);
+    }
+
+    // The delete of the oldest segment fails if the undone rotation got it queued already
+    for (storage_request_t &request : queued_request_array)
+    {
+        storage_request_execute(&request, &storage, NULL);
+    }
+
+    const std::vector<sensor_log_record_t> next_records = query(queued_log, get_time_s(next_index), UINT32_MAX);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(exit_code, STD_FAILURE);
+    EXPECT_EQ(segment_array_size, SENSOR_LOG_SEGMENT_COUNT);
+    EXPECT_EQ(segment_record_count, SENSOR_LOG_SEGMENT_SIZE);
+    EXPECT_EQ(reopened_log.segment_array_size, SENSOR_LOG_SEGMENT_COUNT);
+
+    // The RAM index is the W25Q one, the oldest segment reads as empty once its delete was queued
+    const size_t lost_count = (GetParam() == 0U) ? 0U : SENSOR_LOG_SEGMENT_SIZE;
+
+    expect_records(records, lost_count, record_count - lost_count);
+    expect_records(reopened_records, lost_count, record_count - lost_count);
+    expect_records(next_records, next_index, SENSOR_LOG_BUFFER_SIZE);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    SensorLogQueueSize,
+    SensorLogParameterizedQueueSize,
+    testing::Values(0U, 1U, 2U)
+);
+
+TEST_F(SensorLogTestFixture, TimeGoesBack)
+{
+    // Arrange: create and set up a system under test
+    ASSERT_EQ(sensor_log_append(&log, 100U, 1U, 1.0F, &error), STD_SUCCESS);
+
+    // Act: poke the system under test
+    const int same_time_exit_code   = sensor_log_append(&log, 100U, 2U, 1.0F, &error);
+    const int past_time_exit_code   = sensor_log_append(&log, 99U,  1U, 1.0F, &error);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(same_time_exit_code,  STD_SUCCESS);
+    EXPECT_EQ(past_time_exit_code,  STD_FAILURE);
+    EXPECT_EQ(query(log, 0U, UINT32_MAX).size(), 2U);
+}
+
+TEST_F(SensorLogTestFixture, AppendVersusFileWrite)
+{
+    // Arrange: create and set up a system under test
+    constexpr size_t record_count = 1024U;
+
+    // Act: poke the system under test
+    ASSERT_EQ(append(record_count), STD_SUCCESS);
+
+    const size_t log_prog_count     = device.prog_count;
+    const size_t log_erase_count    = device.erase_count;
+    const double log_time_ms        = device.get_flash_time_ms();
+
+    // The same records, a synced write each
+    device.reset_counters();
+
+    storage_file_t file;
+    const char file_name[64] = "readings\0";
+    ASSERT_EQ(storage_create_file(&storage, &file, file_name, &error), STD_SUCCESS);
+
+    for (size_t i = 0U; i < record_count; ++i)
+    {
+        const sensor_log_record_t record = { get_time_s(i), get_sensor_id(i), 0U, (int16_t)(i) };
+
+        ASSERT_EQ(storage_write_file(&storage, &file, (const char*)(&record), sizeof(record), &error), STD_SUCCESS);
+    }
+    ASSERT_EQ(storage_close_file(&storage, &file, &error), STD_SUCCESS);
+
+    const size_t sync_prog_count    = device.prog_count;
+    const size_t sync_erase_count   = device.erase_count;
+    const double sync_time_ms       = device.get_flash_time_ms();
+
+    std::cout << "[ BENCHMARK] " << record_count << " records, log    : " << log_prog_count << " progs, "
+                << log_erase_count << " erases, " << log_time_ms << " ms" << std::endl;
+    std::cout << "[ BENCHMARK] " << record_count << " records, synced : " << sync_prog_count << " progs, "
+                << sync_erase_count << " erases, " << sync_time_ms << " ms" << std::endl;
+    RecordProperty("log_prog_count",    std::to_string(log_prog_count));
+    RecordProperty("sync_prog_count",   std::to_string(sync_prog_count));
+
+    // Assert: make unit test pass or fail
+    EXPECT_LT(log_prog_count * 4U,  sync_prog_count);
+    EXPECT_LE(log_erase_count,      sync_erase_count);
+}
+
+TEST_F(SensorLogTestFixture, LoopLatencyDuringDownload)
+{
+    // Arrange: create and set up a system under test
+    constexpr size_t loop_count     = 1024U;
+    constexpr size_t chunk_size     = 256U;
+    constexpr size_t reading_count  = 3U;   // Of a BME280 measurement
+
+    // The worst stall of a loop logging its readings while the TCP client task streams an image:
+    // a loop that touches the flash waits for the chunk in flight and then for its own writes.
+    const auto get_worst_loop_time_ms = [this](sensor_log_request_callback_t callback) -> double
+    {
+        lfs_unmount(&storage.lfs);
+
+        EXPECT_EQ(lfs_format(&storage.lfs, &storage.lfs_config), LFS_ERR_OK);
+        EXPECT_EQ(storage_mount_filesystem(&storage, &error), STD_SUCCESS);
+
+        queued_request_array.clear();
+
+        request_callback = callback;
+
+        sensor_log_t loop_log;
+        EXPECT_EQ(init(loop_log), STD_SUCCESS);
+
+        storage_stream_t stream;
+        const char file_name[64] = "firmware.part\0";
+        EXPECT_EQ(storage_create_stream(&storage, &stream, file_name, STORAGE_STREAM_CHECKPOINT_SIZE, &error), STD_SUCCESS);
+
+        const std::vector<uint8_t> chunk(chunk_size, 0x5AU);
+
+        double worst_time_ms = 0.0;
+
+        for (size_t i = 0U; i < loop_count; ++i)
+        {
+            const double stream_start_ms = device.get_flash_time_ms();
+
+            EXPECT_EQ(storage_write_stream(&storage, &stream, chunk.data(), chunk.size(), &error), STD_SUCCESS);
+
+            const double loop_start_ms = device.get_flash_time_ms();
+
+            for (size_t j = (i * reading_count); j < ((i + 1U) * reading_count); ++j)
+            {
+                EXPECT_EQ(sensor_log_append(&loop_log, get_time_s(j), get_sensor_id(j), get_value(j), &error), STD_SUCCESS);
+            }
+
+            const double loop_time_ms = device.get_flash_time_ms() - loop_start_ms;
+
+            if (loop_time_ms > 0.0)
+            {
+                worst_time_ms = std::max(worst_time_ms, (loop_start_ms - stream_start_ms) + loop_time_ms);
+            }
+
+            // The storage task, behind the stream as it has the lowest priority
+            for (storage_request_t &request : queued_request_array)
+            {
+                EXPECT_EQ(storage_request_execute(&request, &storage, &error), STD_SUCCESS);
+            }
+            queued_request_array.clear();
+        }
+
+        size_t stream_size;
+        EXPECT_EQ(storage_close_stream(&storage, &stream, &stream_size, &error), STD_SUCCESS);
+
+        return worst_time_ms;
+    };
+
+    // Act: poke the system under test
+    const double in_place_time_ms   = get_worst_loop_time_ms(nullptr);
+    const double queued_time_ms     = get_worst_loop_time_ms(queue_request);
+
+    std::cout << "[ BENCHMARK] " << loop_count << " loops, in place : worst " << in_place_time_ms << " ms" << std::endl;
+    std::cout << "[ BENCHMARK] " << loop_count << " loops, queued   : worst " << queued_time_ms << " ms" << std::endl;
+    RecordProperty("in_place_time_ms",  std::to_string(in_place_time_ms));
+    RecordProperty("queued_time_ms",    std::to_string(queued_time_ms));
+
+    // Assert: make unit test pass or fail
+    EXPECT_GT(in_place_time_ms, 0.0);
+    EXPECT_EQ(queued_time_ms,   0.0);
+}
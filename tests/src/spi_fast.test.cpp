@@ -0,0 +1,294 @@
+/************************************************************
+ *   Author : German Mundinger
+ *   Date   : 2024
+ ************************************************************/
+
+#include <gmock/gmock.h>
+
+#include <cstdint>
+#include <deque>
+#include <iostream>
+#include <string>
+#include <vector>
+
+
+// SPI1 at the /2 prescaler: a byte is 16 CPU cycles on the wire, an APB2 register access about 2
+constexpr size_t byte_time_polls        = 4U;
+constexpr double register_access_cycles = 2.0;
+constexpr double byte_wire_cycles       = 16.0;
+
+
+// STM32F4 SPI register model: one byte in the shift register, RXNE/TXE/BSY advance with every status read
+struct SpiModel
+{
+    static SpiModel *instance;
+
+    uint32_t cr1 = 0U;
+
+    bool is_tx_empty    = true;
+    bool is_rx_full     = false;
+    bool is_overrun     = false;
+    size_t shift_left   = 0U;       // Status reads until the byte in the shift register is out
+    uint8_t shift_byte  = 0U;
+    uint8_t rx_byte     = 0U;
+    bool is_stuck       = false;
+
+    std::deque<uint8_t> miso;       // What the slave answers
+    std::vector<std::string> trace;
+
+    size_t status_reads = 0U;
+    size_t data_reads   = 0U;
+    size_t data_writes  = 0U;
+
+    void tick ()
+    {
+        if ((shift_left == 0U) || (is_stuck == true))
+        {
+            return;
+        }
+
+        if (--shift_left == 0U)
+        {
+            if (is_rx_full == true)
+            {
+                is_overrun = true;
+            }
+            rx_byte     = miso.empty() ? 0x00U : miso.front();
+            is_rx_full  = true;
+
+            if (miso.empty() != true)
+            {
+                miso.pop_front();
+            }
+            trace.push_back("MISO " + std::to_string(rx_byte));
+        }
+    }
+
+    uint32_t read_status ()
+    {
+        ++status_reads;
+        tick();
+
+        uint32_t status = 0U;
+
+        status |= is_rx_full ? (1U << 0U) : 0U;
+        status |= is_tx_empty ? (1U << 1U) : 0U;
+        status |= is_overrun ? (1U << 6U) : 0U;
+        status |= (shift_left != 0U) ? (1U << 7U) : 0U;
+
+        return status;
+    }
+
+    void write_data (uint32_t value)
+    {
+        ++data_writes;
+
+        EXPECT_TRUE(is_tx_empty);
+        EXPECT_EQ(cr1 & (1U << 6U), (1U << 6U));
+
+        // The model keeps it simple: the byte goes straight into the shift register
+        EXPECT_EQ(shift_left, 0U);
+
+        shift_byte  = (uint8_t)(value);
+        shift_left  = byte_time_polls;
+        trace.push_back("MOSI " + std::to_string(shift_byte));
+    }
+
+    uint32_t read_data ()
+    {
+        ++data_reads;
+
+        is_rx_full = false;
+
+        return rx_byte;
+    }
+};
+
+SpiModel *SpiModel::instance = nullptr;
+
+struct CrRegister
+{
+    operator uint32_t () const { return SpiModel::instance->cr1; }
+    CrRegister & operator|= (uint32_t value) { SpiModel::instance->cr1 |= value; return *this; }
+};
+
+struct SrRegister
+{
+    operator uint32_t () const { return SpiModel::instance->read_status(); }
+};
+
+struct DrRegister
+{
+    operator uint32_t () const { return SpiModel::instance->read_data(); }
+    DrRegister & operator= (uint32_t value) { SpiModel::instance->write_data(value); return *this; }
+};
+
+struct SPI_TypeDef
+{
+    CrRegister CR1;
+    SrRegister SR;
+    DrRegister DR;
+};
+
+#define SPI_CR1_SPE     (1U << 6U)
+#define SPI_SR_RXNE     (1U << 0U)
+#define SPI_SR_TXE      (1U << 1U)
+#define SPI_SR_OVR      (1U << 6U)
+#define SPI_SR_BSY      (1U << 7U)
+
+#include "spi_fast.h"
+
+
+class SpiFastTestFixture : public testing::Test
+{
+    protected:
+
+        SpiModel model;
+        SPI_TypeDef spi;
+
+        virtual void SetUp() override
+        {
+            SpiModel::instance = &model;
+        }
+
+        std::vector<std::string> expected_trace (std::vector<uint8_t> const &mosi, std::vector<uint8_t> const &miso)
+        {
+            std::vector<std::string> trace;
+
+            for (size_t i = 0U; i < mosi.size(); ++i)
+            {
+                trace.push_back("MOSI " + std::to_string(mosi[i]));
+                trace.push_back("MISO " + std::to_string(miso[i]));
+            }
+            return trace;
+        }
+};
+
+
+TEST_F(SpiFastTestFixture, ReadW5500Register)
+{
+    // Arrange: create and set up a system under test
+
+    // VERSIONR (0x0039) of the common block: address, control byte (read, variable length), then the data phase
+    std::vector<uint8_t> header = { 0x00U, 0x39U, 0x00U };
+    uint8_t version = 0U;
+
+    model.miso = { 0x00U, 0x01U, 0x02U, 0x04U };
+
+    // Act: poke the system under test
+    const bool is_header_sent   = spi_fast_read_write(&spi, header.data(), NULL, (uint16_t)(header.size()));
+    const bool is_data_read     = spi_fast_read_write(&spi, NULL, &version, 1U);
+
+    // Assert: make unit test pass or fail
+    EXPECT_TRUE(is_header_sent);
+    EXPECT_TRUE(is_data_read);
+    EXPECT_EQ(version, 0x04U);
+    EXPECT_EQ(model.trace, expected_trace({ 0x00U, 0x39U, 0x00U, SPI_FAST_DUMMY_BYTE }, { 0x00U, 0x01U, 0x02U, 0x04U }));
+    EXPECT_FALSE(model.is_overrun);
+    EXPECT_EQ(model.shift_left, 0U);
+}
+
+TEST_F(SpiFastTestFixture, ReadW25QStatus)
+{
+    // Arrange: create and set up a system under test
+    uint8_t tx_data[2] = { 0x05U, 0x00U };  // READ_STATUS_REGISTER_1
+    uint8_t rx_data[2] = { 0U, 0U };
+
+    model.miso = { 0xFFU, 0x03U };
+
+    // Act: poke the system under test
+    const bool is_done = spi_fast_read_write(&spi, tx_data, rx_data, 2U);
+
+    // Assert: make unit test pass or fail
+    EXPECT_TRUE(is_done);
+    EXPECT_EQ(rx_data[1], 0x03U);
+    EXPECT_EQ(model.trace, expected_trace({ 0x05U, 0x00U }, { 0xFFU, 0x03U }));
+}
+
+TEST_F(SpiFastTestFixture, DropStaleByte)
+{
+    // Arrange: create and set up a system under test
+
+    // Left by a HAL transmit only transfer
+    model.cr1           = SPI_CR1_SPE;
+    model.is_rx_full    = true;
+    model.rx_byte       = 0xAAU;
+    model.miso          = { 0x11U };
+
+    uint8_t byte = 0x22U;
+
+    // Act: poke the system under test
+    const bool is_done = spi_fast_read_write(&spi, &byte, &byte, 1U);
+
+    // Assert: make unit test pass or fail
+    EXPECT_TRUE(is_done);
+    EXPECT_EQ(byte, 0x11U);
+    EXPECT_FALSE(model.is_overrun);
+}
+
+TEST_F(SpiFastTestFixture, GiveUpOnStuckFlag)
+{
+    // Arrange: create and set up a system under test
+    uint8_t tx_data[4] = { 1U, 2U, 3U, 4U };
+
+    model.is_stuck = true;
+
+    // Act: poke the system under test
+    const bool is_done = spi_fast_read_write(&spi, tx_data, NULL, 4U);
+
+    // Assert: make unit test pass or fail
+    EXPECT_FALSE(is_done);
+    EXPECT_LE(model.status_reads, (size_t)(SPI_FAST_SPIN_LIMIT + 2U));
+}
+
+
+class SpiFastParameterizedSize : public SpiFastTestFixture,
+                                    public testing::WithParamInterface<uint16_t>
+{
+};
+
+TEST_P(SpiFastParameterizedSize, CountRegisterAccesses)
+{
+    // Arrange: create and set up a system under test
+    const uint16_t size = GetParam();
+
+    std::vector<uint8_t> tx_data(size);
+    std::vector<uint8_t> rx_data(size, 0U);
+
+    for (uint16_t i = 0U; i < size; ++i)
+    {
+        tx_data[i] = (uint8_t)(i + 1U);
+        model.miso.push_back((uint8_t)(0x80U + i));
+    }
+
+    // Act: poke the system under test
+    const bool is_done = spi_fast_read_write(&spi, tx_data.data(), rx_data.data(), size);
+
+    const size_t accesses       = model.status_reads + model.data_reads + model.data_writes;
+    const double cpu_cycles     = (double)(accesses) * register_access_cycles;
+    const double wire_cycles    = (double)(size) * byte_wire_cycles;
+
+    std::cout << "[ BENCHMARK] " << size << " bytes : " << accesses << " register accesses, ~" << cpu_cycles
+                << " cycles, " << wire_cycles << " cycles on the wire" << std::endl;
+    RecordProperty("register_accesses_" + std::to_string(size), std::to_string(accesses));
+
+    // Assert: make unit test pass or fail
+    EXPECT_TRUE(is_done);
+    EXPECT_EQ(model.data_writes,    size);
+    EXPECT_EQ(model.data_reads,     size);
+    EXPECT_FALSE(model.is_overrun);
+
+    for (uint16_t i = 0U; i < size; ++i)
+    {
+        EXPECT_EQ(rx_data[i], (uint8_t)(0x80U + i));
+    }
+
+    // Everything but the polling is a handful of accesses per byte, the rest is waiting for the wire
+    EXPECT_LE(model.status_reads, (size_t)(size) * (byte_time_polls + 2U) + 2U);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    SpiFastSize,
+    SpiFastParameterizedSize,
+    testing::Values(1U, 3U, 4U, 5U, 31U)
+);
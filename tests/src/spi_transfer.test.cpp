@@ -0,0 +1,387 @@
+/************************************************************
+ *   Author : German Mundinger
+ *   Date   : 2024
+ ************************************************************/
+
+#include <gmock/gmock.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <semaphore>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "spi_transfer.h"
+#include "std_error/std_error.h"
+
+
+constexpr uint32_t timeout_ms = 1000U;
+
+
+// The bus and the DMA engine: a W25Q-like device answers every byte with its complement
+struct FakeDmaEngine
+{
+    static FakeDmaEngine *instance;
+
+    struct Job
+    {
+        uint8_t *tx_data;
+        uint8_t *rx_data;
+        uint16_t size;
+        size_t id;
+    };
+
+    spi_transfer_t *transfer = nullptr;
+
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::deque<Job> jobs;
+    bool is_running     = true;
+    bool is_gate_open   = true;
+    std::atomic<bool> is_failing{false};
+    std::atomic<bool> is_stalled{false};
+
+    std::binary_semaphore completion{0};
+    std::thread thread;
+
+    // What went over the bus, in order: transfer id, 'P' - polled, 'D' - DMA
+    std::vector<std::pair<size_t, char>> bus_log;
+    size_t next_id          = 0U;
+    bool is_dma_in_flight   = false;
+    size_t overlap_count    = 0U;
+    size_t abort_count      = 0U;
+
+    FakeDmaEngine ()
+    {
+        thread = std::thread([this] () { run(); });
+    }
+
+    ~FakeDmaEngine ()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            is_running = false;
+        }
+        condition.notify_all();
+        thread.join();
+    }
+
+    static void exchange (uint8_t *tx_data, uint8_t *rx_data, uint16_t size)
+    {
+        for (uint16_t i = 0U; i < size; ++i)
+        {
+            const uint8_t byte = (tx_data != NULL) ? tx_data[i] : 0xFFU;
+
+            if (rx_data != NULL)
+            {
+                rx_data[i] = (uint8_t)(~byte);
+            }
+        }
+    }
+
+    void run ()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        while (true)
+        {
+            condition.wait(lock, [this] () { return (is_running != true) || ((jobs.empty() != true) && (is_gate_open == true)); });
+
+            if (is_running != true)
+            {
+                return;
+            }
+
+            const Job job = jobs.front();
+            jobs.pop_front();
+
+            if (is_stalled == true)
+            {
+                continue;
+            }
+
+            exchange(job.tx_data, job.rx_data, job.size);
+            bus_log.emplace_back(job.id, 'D');
+            is_dma_in_flight = false;
+
+            const bool is_success = (is_failing != true);
+
+            lock.unlock();
+            spi_transfer_complete_ISR(transfer, is_success);
+            lock.lock();
+        }
+    }
+
+    void open_gate (bool is_open)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            is_gate_open = is_open;
+        }
+        condition.notify_all();
+    }
+
+    static int poll (uint8_t *tx_data, uint8_t *rx_data, uint16_t size, uint32_t timeout_ms, std_error_t * const error)
+    {
+        (void)timeout_ms;
+        (void)error;
+
+        std::lock_guard<std::mutex> lock(instance->mutex);
+
+        if (instance->is_dma_in_flight == true)
+        {
+            ++instance->overlap_count;
+        }
+
+        exchange(tx_data, rx_data, size);
+        instance->bus_log.emplace_back(instance->next_id++, 'P');
+
+        return STD_SUCCESS;
+    }
+
+    static int start (uint8_t *tx_data, uint8_t *rx_data, uint16_t size, std_error_t * const error)
+    {
+        (void)error;
+
+        {
+            std::lock_guard<std::mutex> lock(instance->mutex);
+
+            if (instance->is_dma_in_flight == true)
+            {
+                ++instance->overlap_count;
+            }
+            instance->is_dma_in_flight = true;
+            instance->jobs.push_back({ tx_data, rx_data, size, instance->next_id++ });
+        }
+        instance->condition.notify_all();
+
+        return STD_SUCCESS;
+    }
+
+    static bool wait (uint32_t timeout_ms)
+    {
+        return instance->completion.try_acquire_for(std::chrono::milliseconds(timeout_ms));
+    }
+
+    static void notify_ISR ()
+    {
+        instance->completion.release();
+    }
+
+    static void abort ()
+    {
+        std::lock_guard<std::mutex> lock(instance->mutex);
+
+        instance->jobs.clear();
+        instance->is_dma_in_flight = false;
+        ++instance->abort_count;
+
+        (void)instance->completion.try_acquire();
+    }
+
+    bool is_done ()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        return (is_dma_in_flight != true);
+    }
+};
+
+FakeDmaEngine *FakeDmaEngine::instance = nullptr;
+
+
+class SpiTransferTestFixture : public testing::Test
+{
+    protected:
+
+        FakeDmaEngine engine;
+        spi_transfer_t transfer;
+        std_error_t error;
+
+        virtual void SetUp() override
+        {
+            FakeDmaEngine::instance = &engine;
+            engine.transfer         = &transfer;
+
+            std_error_init(&error);
+
+            spi_transfer_config_t config;
+            config.poll_callback        = FakeDmaEngine::poll;
+            config.start_callback       = FakeDmaEngine::start;
+            config.wait_callback        = FakeDmaEngine::wait;
+            config.notify_ISR_callback  = FakeDmaEngine::notify_ISR;
+            config.abort_callback       = FakeDmaEngine::abort;
+            config.dma_threshold        = SPI_TRANSFER_DMA_THRESHOLD;
+
+            spi_transfer_init(&transfer, &config);
+        }
+
+        static std::vector<uint8_t> make_data (size_t size)
+        {
+            std::vector<uint8_t> data(size);
+
+            for (size_t i = 0U; i < size; ++i)
+            {
+                data[i] = (uint8_t)((i * 13U) + 5U);
+            }
+            return data;
+        }
+
+        static std::vector<uint8_t> complement (std::vector<uint8_t> const &data)
+        {
+            std::vector<uint8_t> result(data.size());
+
+            for (size_t i = 0U; i < data.size(); ++i)
+            {
+                result[i] = (uint8_t)(~data[i]);
+            }
+            return result;
+        }
+};
+
+
+TEST_F(SpiTransferTestFixture, SubmitReturnsBeforeCompletion)
+{
+    // Arrange: create and set up a system under test
+    std::vector<uint8_t> tx_data = make_data(256U);
+    std::vector<uint8_t> rx_data(tx_data.size(), 0x00U);
+
+    engine.open_gate(false);
+
+    // Act: poke the system under test
+    const int submit_code = spi_transfer_submit(&transfer, tx_data.data(), rx_data.data(), (uint16_t)(tx_data.size()), timeout_ms, &error);
+
+    const bool is_done_after_submit = engine.is_done();
+
+    engine.open_gate(true);
+
+    const int wait_code = spi_transfer_wait(&transfer, timeout_ms, &error);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(submit_code,          STD_SUCCESS);
+    EXPECT_FALSE(is_done_after_submit);
+    EXPECT_EQ(wait_code,            STD_SUCCESS);
+    EXPECT_EQ(rx_data,              complement(tx_data));
+    ASSERT_EQ(engine.bus_log.size(), 1U);
+    EXPECT_EQ(engine.bus_log[0].second, 'D');
+}
+
+TEST_F(SpiTransferTestFixture, KeepSubmissionOrder)
+{
+    // Arrange: create and set up a system under test
+    std::vector<uint8_t> page_0     = make_data(256U);
+    std::vector<uint8_t> command    = make_data(4U);
+    std::vector<uint8_t> page_1     = make_data(256U);
+    std::vector<uint8_t> status     = make_data(1U);
+
+    engine.open_gate(false);
+
+    // Act: poke the system under test
+    int exit_code = spi_transfer_submit(&transfer, page_0.data(), NULL, (uint16_t)(page_0.size()), timeout_ms, &error);
+
+    // The engine is held, the short one behind the bulk one has to wait for it
+    std::thread release([this] ()
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        engine.open_gate(true);
+    });
+
+    exit_code |= spi_transfer_submit(&transfer, command.data(), NULL, (uint16_t)(command.size()), timeout_ms, &error);
+    exit_code |= spi_transfer_submit(&transfer, page_1.data(), NULL, (uint16_t)(page_1.size()), timeout_ms, &error);
+    exit_code |= spi_transfer_submit(&transfer, status.data(), NULL, (uint16_t)(status.size()), timeout_ms, &error);
+    exit_code |= spi_transfer_wait(&transfer, timeout_ms, &error);
+
+    release.join();
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(exit_code,            STD_SUCCESS);
+    EXPECT_EQ(engine.overlap_count, 0U);
+    ASSERT_EQ(engine.bus_log.size(), 4U);
+    EXPECT_EQ(engine.bus_log[0],    std::make_pair((size_t)(0U), 'D'));
+    EXPECT_EQ(engine.bus_log[1],    std::make_pair((size_t)(1U), 'P'));
+    EXPECT_EQ(engine.bus_log[2],    std::make_pair((size_t)(2U), 'D'));
+    EXPECT_EQ(engine.bus_log[3],    std::make_pair((size_t)(3U), 'P'));
+}
+
+TEST_F(SpiTransferTestFixture, ReportDmaError)
+{
+    // Arrange: create and set up a system under test
+    std::vector<uint8_t> tx_data = make_data(512U);
+
+    engine.is_failing = true;
+
+    // Act: poke the system under test
+    const int exit_code = spi_transfer_read_write(&transfer, tx_data.data(), NULL, (uint16_t)(tx_data.size()), timeout_ms, &error);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(exit_code, STD_FAILURE);
+}
+
+TEST_F(SpiTransferTestFixture, AbortAfterTimeout)
+{
+    // Arrange: create and set up a system under test
+    std::vector<uint8_t> tx_data = make_data(512U);
+    std::vector<uint8_t> rx_data(tx_data.size(), 0x00U);
+
+    engine.is_stalled = true;
+
+    // Act: poke the system under test
+    const int timeout_code = spi_transfer_read_write(&transfer, tx_data.data(), rx_data.data(), (uint16_t)(tx_data.size()), 20U, &error);
+
+    engine.is_stalled = false;
+
+    const int next_code = spi_transfer_read_write(&transfer, tx_data.data(), rx_data.data(), (uint16_t)(tx_data.size()), timeout_ms, &error);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(timeout_code,         STD_FAILURE);
+    EXPECT_EQ(engine.abort_count,   1U);
+    EXPECT_EQ(next_code,            STD_SUCCESS);
+    EXPECT_EQ(rx_data,              complement(tx_data));
+}
+
+
+class SpiTransferParameterizedSize : public SpiTransferTestFixture,
+                                        public testing::WithParamInterface<uint16_t>
+{
+};
+
+TEST_P(SpiTransferParameterizedSize, ReadWrite)
+{
+    // Arrange: create and set up a system under test
+    const uint16_t size = GetParam();
+
+    std::vector<uint8_t> tx_data = make_data(size);
+    std::vector<uint8_t> rx_data(size, 0x00U);
+    std::vector<uint8_t> read_data(size, 0x00U);
+
+    // Act: poke the system under test
+    const int write_code    = spi_transfer_read_write(&transfer, tx_data.data(), NULL, size, timeout_ms, &error);
+    const int exchange_code = spi_transfer_read_write(&transfer, tx_data.data(), rx_data.data(), size, timeout_ms, &error);
+    const int read_code     = spi_transfer_read_write(&transfer, NULL, read_data.data(), size, timeout_ms, &error);
+
+    const char expected_path = (size < SPI_TRANSFER_DMA_THRESHOLD) ? 'P' : 'D';
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(write_code,       STD_SUCCESS);
+    EXPECT_EQ(exchange_code,    STD_SUCCESS);
+    EXPECT_EQ(read_code,        STD_SUCCESS);
+    EXPECT_EQ(rx_data,          complement(tx_data));
+    EXPECT_EQ(read_data,        std::vector<uint8_t>(size, 0x00U));
+    ASSERT_EQ(engine.bus_log.size(), 3U);
+
+    for (auto const &entry : engine.bus_log)
+    {
+        EXPECT_EQ(entry.second, expected_path);
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    SpiTransferSize,
+    SpiTransferParameterizedSize,
+    testing::Values(1U, 3U, SPI_TRANSFER_DMA_THRESHOLD - 1U, SPI_TRANSFER_DMA_THRESHOLD, 256U, 4096U)
+);
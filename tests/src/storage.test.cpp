@@ -0,0 +1,1103 @@
+/************************************************************
+ *   Author : German Mundinger
+ *   Date   : 2024
+ ************************************************************/
+
+#include <gmock/gmock.h>
+
+#include <atomic>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "storage.h"
+#include "std_error/std_error.h"
+
+#include "devices/w25q32bv_emulator.h"
+#include "ram_block_device.h"
+
+
+constexpr size_t firmware_size  = 200U * 1024U;
+constexpr size_t tcp_chunk_size = 128U;
+
+// As in board.config.h
+constexpr storage_geometry_t board_geometry = { 16U, 256U, 256U, 128U, 500 };
+
+
+class StorageTestFixture : public testing::Test
+{
+    protected:
+
+        RamBlockDevice device;
+        storage_t storage;
+        std_error_t error;
+
+        std::vector<uint8_t> firmware;
+
+        const char file_name[64] = "firmware\0";
+
+        virtual void SetUp() override
+        {
+            std_error_init(&error);
+
+            firmware.resize(firmware_size);
+
+            for (size_t i = 0U; i < firmware.size(); ++i)
+            {
+                firmware[i] = (uint8_t)((i * 7U) + (i >> 8U));
+            }
+
+            ASSERT_EQ(lfs_format(&storage.lfs, configure(storage)), LFS_ERR_OK);
+            ASSERT_EQ(storage_mount_filesystem(&storage, &error), STD_SUCCESS);
+
+            device.reset_counters();
+        }
+
+        virtual void TearDown() override
+        {
+            lfs_unmount(&storage.lfs);
+        }
+
+        struct lfs_config* configure (storage_t &self)
+        {
+            return device.configure(self, board_geometry);
+        }
+
+        std::vector<uint8_t> read_back (storage_t &self)
+        {
+            std::vector<uint8_t> result;
+
+            storage_file_t file;
+
+            if (storage_open_file(&self, &file, file_name, &error) != STD_SUCCESS)
+            {
+                return result;
+            }
+
+            while (true)
+            {
+                char chunk[512];
+                size_t size;
+
+                if ((storage_read_file(&self, &file, chunk, &size, sizeof(chunk), &error) != STD_SUCCESS) || (size == 0U))
+                {
+                    break;
+                }
+                result.insert(result.end(), chunk, chunk + size);
+            }
+
+            storage_close_file(&self, &file, &error);
+
+            return result;
+        }
+};
+
+
+TEST_F(StorageTestFixture, StreamRoundTrip)
+{
+    // Arrange: create and set up a system under test
+    storage_stream_t stream;
+    ASSERT_EQ(storage_create_stream(&storage, &stream, file_name, STORAGE_STREAM_CHECKPOINT_SIZE, &error), STD_SUCCESS);
+
+    // Act: poke the system under test
+    for (size_t i = 0U; i < firmware.size(); i += tcp_chunk_size)
+    {
+        ASSERT_EQ(storage_write_stream(&storage, &stream, &firmware[i], std::min(tcp_chunk_size, firmware.size() - i), &error), STD_SUCCESS);
+    }
+
+    size_t stream_size;
+    const int exit_code = storage_close_stream(&storage, &stream, &stream_size, &error);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(exit_code,    STD_SUCCESS);
+    EXPECT_EQ(stream_size,  firmware.size());
+    EXPECT_EQ(read_back(storage), firmware);
+}
+
+TEST_F(StorageTestFixture, StreamUnalignedChunks)
+{
+    // Arrange: create and set up a system under test
+    storage_stream_t stream;
+    ASSERT_EQ(storage_create_stream(&storage, &stream, file_name, 1000U, &error), STD_SUCCESS);
+
+    // Act: poke the system under test
+    size_t offset = 0U;
+
+    for (size_t chunk_size = 1U; offset < firmware.size(); chunk_size = (chunk_size % 300U) + 1U)
+    {
+        const size_t size = std::min(chunk_size, firmware.size() - offset);
+
+        ASSERT_EQ(storage_write_stream(&storage, &stream, &firmware[offset], size, &error), STD_SUCCESS);
+        offset += size;
+    }
+
+    size_t stream_size;
+    const int exit_code = storage_close_stream(&storage, &stream, &stream_size, &error);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(exit_code,    STD_SUCCESS);
+    EXPECT_EQ(stream_size,  firmware.size());
+    EXPECT_EQ(read_back(storage), firmware);
+}
+
+TEST_F(StorageTestFixture, StreamSurvivesPowerLossAtCheckpoint)
+{
+    // Arrange: create and set up a system under test
+    constexpr size_t checkpoint_size = 16U * 1024U;
+
+    storage_stream_t stream;
+    ASSERT_EQ(storage_create_stream(&storage, &stream, file_name, checkpoint_size, &error), STD_SUCCESS);
+
+    const size_t written_size = (3U * checkpoint_size) + 1000U;
+
+    for (size_t i = 0U; i < written_size; i += tcp_chunk_size)
+    {
+        ASSERT_EQ(storage_write_stream(&storage, &stream, &firmware[i], std::min(tcp_chunk_size, written_size - i), &error), STD_SUCCESS);
+    }
+
+    // Act: poke the system under test
+    storage_t rebooted_storage;
+    ASSERT_EQ(lfs_mount(&rebooted_storage.lfs, configure(rebooted_storage)), LFS_ERR_OK);
+
+    const std::vector<uint8_t> result = read_back(rebooted_storage);
+
+    lfs_unmount(&rebooted_storage.lfs);
+
+    // Assert: make unit test pass or fail
+    const std::vector<uint8_t> expected(firmware.begin(), firmware.begin() + (3U * checkpoint_size));
+
+    EXPECT_EQ(result, expected);
+}
+
+TEST_F(StorageTestFixture, StreamVersusPerChunkSync)
+{
+    // Arrange: create and set up a system under test
+    storage_file_t file;
+    ASSERT_EQ(storage_create_file(&storage, &file, file_name, &error), STD_SUCCESS);
+
+    // Act: poke the system under test
+    for (size_t i = 0U; i < firmware.size(); i += tcp_chunk_size)
+    {
+        ASSERT_EQ(storage_write_file(&storage, &file, (const char*)(&firmware[i]), tcp_chunk_size, &error), STD_SUCCESS);
+    }
+    ASSERT_EQ(storage_close_file(&storage, &file, &error), STD_SUCCESS);
+
+    const size_t sync_prog_count    = device.prog_count;
+    const size_t sync_erase_count   = device.erase_count;
+    const double sync_time_ms       = device.get_flash_time_ms();
+
+    ASSERT_EQ(storage_remove_file(&storage, file_name, &error), STD_SUCCESS);
+    device.reset_counters();
+
+    storage_stream_t stream;
+    ASSERT_EQ(storage_create_stream(&storage, &stream, file_name, STORAGE_STREAM_CHECKPOINT_SIZE, &error), STD_SUCCESS);
+
+    for (size_t i = 0U; i < firmware.size(); i += tcp_chunk_size)
+    {
+        ASSERT_EQ(storage_write_stream(&storage, &stream, &firmware[i], tcp_chunk_size, &error), STD_SUCCESS);
+    }
+
+    size_t stream_size;
+    ASSERT_EQ(storage_close_stream(&storage, &stream, &stream_size, &error), STD_SUCCESS);
+
+    const size_t stream_prog_count  = device.prog_count;
+    const size_t stream_erase_count = device.erase_count;
+    const double stream_time_ms     = device.get_flash_time_ms();
+
+    std::cout << "[ BENCHMARK] per-chunk sync : " << sync_prog_count << " progs, " << sync_erase_count << " erases, " << sync_time_ms << " ms" << std::endl;
+    std::cout << "[ BENCHMARK] stream         : " << stream_prog_count << " progs, " << stream_erase_count << " erases, " << stream_time_ms << " ms" << std::endl;
+    RecordProperty("sync_erase_count",      std::to_string(sync_erase_count));
+    RecordProperty("stream_erase_count",    std::to_string(stream_erase_count));
+    RecordProperty("sync_time_ms",          std::to_string(sync_time_ms));
+    RecordProperty("stream_time_ms",        std::to_string(stream_time_ms));
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(read_back(storage), firmware);
+    EXPECT_LT(stream_prog_count,    sync_prog_count);
+    EXPECT_LT(stream_erase_count,   sync_erase_count);
+    EXPECT_LT(stream_time_ms,       sync_time_ms);
+}
+
+
+// The recursive storage mutex of the board, the host threads stand for its tasks
+static std::recursive_mutex storage_mutex;
+static std::atomic<std::thread::id> storage_owner;
+static std::atomic<size_t> storage_switch_count;
+
+static void storage_lock ()
+{
+    storage_mutex.lock();
+
+    if (storage_owner.exchange(std::this_thread::get_id()) != std::this_thread::get_id())
+    {
+        ++storage_switch_count;
+    }
+    return;
+}
+
+static void storage_unlock ()
+{
+    storage_mutex.unlock();
+
+    // Let the other tasks in between the calls as the scheduler would
+    std::this_thread::yield();
+
+    return;
+}
+
+// Any block device access overlapping another one is a race littlefs does not survive
+static std::atomic<size_t> device_access_count;
+static std::atomic<size_t> device_overlap_count;
+
+template <auto operation, typename... Args>
+static int serialized_access (Args... args)
+{
+    if (++device_access_count != 1U)
+    {
+        ++device_overlap_count;
+    }
+    const int result = operation(args...);
+    --device_access_count;
+
+    return result;
+}
+
+TEST_F(StorageTestFixture, ConcurrentTasks)
+{
+    // Arrange: create and set up a system under test
+    constexpr size_t config_writer_count    = 2U;
+    constexpr size_t config_rewrite_count   = 50U;
+    constexpr size_t log_record_count       = 400U;
+    constexpr size_t log_record_size        = 8U;
+
+    storage_switch_count    = 0U;
+    device_overlap_count    = 0U;
+
+    device.lock_callback    = storage_lock;
+    device.unlock_callback  = storage_unlock;
+
+    storage.lfs_config.read     = serialized_access<RamBlockDevice::read, const struct lfs_config*, lfs_block_t, lfs_off_t, void*, lfs_size_t>;
+    storage.lfs_config.prog     = serialized_access<RamBlockDevice::prog, const struct lfs_config*, lfs_block_t, lfs_off_t, const void*, lfs_size_t>;
+    storage.lfs_config.erase    = serialized_access<RamBlockDevice::erase, const struct lfs_config*, lfs_block_t>;
+
+    std::atomic<size_t> failure_count { 0U };
+
+    // Act: poke the system under test
+    std::vector<std::thread> task_array;
+
+    // The firmware download of the TCP client task
+    task_array.emplace_back([&]()
+    {
+        std_error_t task_error;
+        std_error_init(&task_error);
+
+        storage_stream_t stream;
+
+        if (storage_create_stream(&storage, &stream, file_name, STORAGE_STREAM_CHECKPOINT_SIZE, &task_error) != STD_SUCCESS)
+        {
+            ++failure_count;
+
+            return;
+        }
+
+        for (size_t i = 0U; i < firmware.size(); i += tcp_chunk_size)
+        {
+            if (storage_write_stream(&storage, &stream, &firmware[i], std::min(tcp_chunk_size, firmware.size() - i), &task_error) != STD_SUCCESS)
+            {
+                ++failure_count;
+            }
+        }
+
+        size_t stream_size;
+
+        if ((storage_close_stream(&storage, &stream, &stream_size, &task_error) != STD_SUCCESS) || (stream_size != firmware.size()))
+        {
+            ++failure_count;
+        }
+    });
+
+    // Config files rewritten and read back by other tasks
+    for (size_t writer = 0U; writer < config_writer_count; ++writer)
+    {
+        task_array.emplace_back([&, writer]()
+        {
+            std_error_t task_error;
+            std_error_init(&task_error);
+
+            char config_name[64];
+            char temporary_name[64];
+            std::snprintf(config_name, sizeof(config_name), "config.%zu", writer);
+            std::snprintf(temporary_name, sizeof(temporary_name), "config.%zu.tmp", writer);
+
+            for (size_t i = 0U; i < config_rewrite_count; ++i)
+            {
+                char config[64];
+                std::memset(config, (int)((writer * config_rewrite_count) + i), sizeof(config));
+
+                storage_file_t file;
+
+                if ((storage_create_file(&storage, &file, temporary_name, &task_error) != STD_SUCCESS) ||
+                    (storage_write_file(&storage, &file, config, sizeof(config), &task_error) != STD_SUCCESS) ||
+                    (storage_close_file(&storage, &file, &task_error) != STD_SUCCESS) ||
+                    (storage_rename_file(&storage, temporary_name, config_name, &task_error) != STD_SUCCESS))
+                {
+                    ++failure_count;
+
+                    continue;
+                }
+
+                char result[sizeof(config) + 1U];
+                size_t size = 0U;
+
+                if ((storage_open_file(&storage, &file, config_name, &task_error) != STD_SUCCESS) ||
+                    (storage_read_file(&storage, &file, result, &size, sizeof(result), &task_error) != STD_SUCCESS) ||
+                    (storage_close_file(&storage, &file, &task_error) != STD_SUCCESS) ||
+                    (size != sizeof(config)) || (std::memcmp(result, config, sizeof(config)) != 0))
+                {
+                    ++failure_count;
+                }
+            }
+        });
+    }
+
+    // The sensor log appends of the board task
+    task_array.emplace_back([&]()
+    {
+        std_error_t task_error;
+        std_error_init(&task_error);
+
+        for (uint32_t i = 0U; i < log_record_count; ++i)
+        {
+            char record[log_record_size];
+            std::memset(record, 0, sizeof(record));
+            std::memcpy(record, &i, sizeof(i));
+
+            storage_file_t file;
+
+            if ((storage_open_file_to_append(&storage, &file, "log", &task_error) != STD_SUCCESS) ||
+                (storage_write_file(&storage, &file, record, sizeof(record), &task_error) != STD_SUCCESS) ||
+                (storage_close_file(&storage, &file, &task_error) != STD_SUCCESS))
+            {
+                ++failure_count;
+            }
+        }
+    });
+
+    for (std::thread &task : task_array)
+    {
+        task.join();
+    }
+
+    std::cout << "[ BENCHMARK] " << task_array.size() << " tasks : " << device.lock_count << " littlefs calls, " << storage_switch_count << " task switches" << std::endl;
+    RecordProperty("lock_count",    std::to_string(device.lock_count));
+    RecordProperty("switch_count",  std::to_string(storage_switch_count));
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(failure_count,        0U);
+    EXPECT_EQ(device_overlap_count, 0U);
+    EXPECT_GT(storage_switch_count, 0U);
+
+    EXPECT_EQ(read_back(storage), firmware);
+
+    storage_file_t file;
+    ASSERT_EQ(storage_open_file(&storage, &file, "log", &error), STD_SUCCESS);
+
+    size_t log_size;
+    ASSERT_EQ(storage_get_file_size(&storage, &file, &log_size, &error), STD_SUCCESS);
+    EXPECT_EQ(log_size, log_record_count * log_record_size);
+
+    for (uint32_t i = 0U; i < log_record_count; ++i)
+    {
+        char record[log_record_size];
+        size_t size;
+
+        ASSERT_EQ(storage_read_file(&storage, &file, record, &size, sizeof(record), &error), STD_SUCCESS);
+        ASSERT_EQ(size, sizeof(record));
+
+        uint32_t number;
+        std::memcpy(&number, record, sizeof(number));
+        EXPECT_EQ(number, i);
+    }
+    storage_close_file(&storage, &file, &error);
+}
+
+
+class StorageEmulatorTestFixture : public testing::Test
+{
+    protected:
+
+        W25q32bvEmulator emulator;
+        storage_t storage;
+        std_error_t error;
+
+        W25q32bvEmulator::Part part = W25q32bvEmulator::w25q32bv;
+        storage_geometry_t geometry = board_geometry;
+
+        std::vector<uint8_t> firmware;
+
+        const char file_name[64] = "firmware\0";
+
+        virtual void SetUp() override
+        {
+            std_error_init(&error);
+
+            emulator.set_part(part);
+
+            firmware.resize(firmware_size);
+
+            for (size_t i = 0U; i < firmware.size(); ++i)
+            {
+                firmware[i] = (uint8_t)((i * 7U) + (i >> 8U));
+            }
+
+            storage_config_t config;
+            config.lock_callback            = W25q32bvEmulator::storage_lock;
+            config.unlock_callback          = W25q32bvEmulator::storage_unlock;
+            config.spi_lock_callback        = W25q32bvEmulator::spi_lock;
+            config.spi_unlock_callback      = W25q32bvEmulator::spi_unlock;
+            config.spi_select_callback      = W25q32bvEmulator::spi_select;
+            config.spi_unselect_callback    = W25q32bvEmulator::spi_unselect;
+            config.spi_tx_rx_callback       = W25q32bvEmulator::spi_tx_rx;
+            config.spi_timeout_ms           = 10U;
+            config.delay_callback           = W25q32bvEmulator::delay_callback;
+            config.yield_callback           = W25q32bvEmulator::yield_callback;
+            config.get_cycles_callback      = W25q32bvEmulator::get_cycles_callback;
+            config.cycles_per_us            = W25q32bvEmulator::cycles_per_us;
+            config.geometry                 = geometry;
+
+            // A blank part, formatted on the way
+            ASSERT_EQ(storage_init(&storage, &config, &error), STD_SUCCESS);
+            ASSERT_EQ(storage_enable_power(&storage, &error), STD_SUCCESS);
+            ASSERT_EQ(storage_mount_filesystem(&storage, &error), STD_SUCCESS);
+
+            emulator.reset_counters();
+        }
+
+        virtual void TearDown() override
+        {
+            storage_unmount_filesystem(&storage, &error);
+
+            EXPECT_EQ(emulator.violation_count, 0U);
+        }
+
+        std::vector<uint8_t> read_back ()
+        {
+            std::vector<uint8_t> result;
+
+            storage_file_t file;
+
+            if (storage_open_file(&storage, &file, file_name, &error) != STD_SUCCESS)
+            {
+                return result;
+            }
+
+            while (true)
+            {
+                char chunk[512];
+                size_t size;
+
+                if ((storage_read_file(&storage, &file, chunk, &size, sizeof(chunk), &error) != STD_SUCCESS) || (size == 0U))
+                {
+                    break;
+                }
+                result.insert(result.end(), chunk, chunk + size);
+            }
+
+            storage_close_file(&storage, &file, &error);
+
+            return result;
+        }
+};
+
+
+TEST_F(StorageEmulatorTestFixture, FirmwareDownload)
+{
+    // Arrange: create and set up a system under test
+    storage_stream_t stream;
+    ASSERT_EQ(storage_create_stream(&storage, &stream, file_name, STORAGE_STREAM_CHECKPOINT_SIZE, &error), STD_SUCCESS);
+
+    const double start_us = emulator.now_us;
+
+    // Act: poke the system under test
+    for (size_t i = 0U; i < firmware.size(); i += tcp_chunk_size)
+    {
+        ASSERT_EQ(storage_write_stream(&storage, &stream, &firmware[i], std::min(tcp_chunk_size, firmware.size() - i), &error), STD_SUCCESS);
+    }
+
+    size_t stream_size;
+    const int exit_code = storage_close_stream(&storage, &stream, &stream_size, &error);
+
+    const double time_ms            = (emulator.now_us - start_us) / 1000.0;
+    const double busy_time_ms       = emulator.get_busy_time_us() / 1000.0;
+    const double throughput_KBps    = ((double)(firmware_size) / 1024.0) / (time_ms / 1000.0);
+
+    std::cout << "[ BENCHMARK] download : " << time_ms << " ms (" << busy_time_ms << " ms busy), " << throughput_KBps << " KB/s" << std::endl;
+    std::cout << "[ BENCHMARK] flash    : " << emulator.spi_byte_count << " SPI bytes, " << emulator.program_count << " programs, "
+                << emulator.erase_count << " erases, " << emulator.get_max_sector_erase_count() << " erases of a sector at most" << std::endl;
+    RecordProperty("download_time_ms",      std::to_string((int)(time_ms)));
+    RecordProperty("download_spi_bytes",    std::to_string(emulator.spi_byte_count));
+    RecordProperty("download_erase_count",  std::to_string(emulator.erase_count));
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(exit_code,    STD_SUCCESS);
+    EXPECT_EQ(stream_size,  firmware.size());
+    EXPECT_EQ(read_back(),  firmware);
+
+    // Every sector of the image is erased once, a few more go to the metadata
+    EXPECT_LE(emulator.erase_count,                     (firmware_size / W25q32bvEmulator::sector_size) + 8U);
+    EXPECT_LE(emulator.get_max_sector_erase_count(),    3U);
+    EXPECT_GT(throughput_KBps,                          40.0);
+}
+
+TEST_F(StorageEmulatorTestFixture, RemountAfterPowerDown)
+{
+    // Arrange: create and set up a system under test
+    storage_file_t file;
+    ASSERT_EQ(storage_create_file(&storage, &file, file_name, &error), STD_SUCCESS);
+    ASSERT_EQ(storage_write_file(&storage, &file, (const char*)(firmware.data()), 1000U, &error), STD_SUCCESS);
+    ASSERT_EQ(storage_close_file(&storage, &file, &error), STD_SUCCESS);
+
+    // Act: poke the system under test
+    ASSERT_EQ(storage_unmount_filesystem(&storage, &error), STD_SUCCESS);
+    ASSERT_EQ(storage_disable_power(&storage, &error), STD_SUCCESS);
+
+    const bool is_powered_down = emulator.is_powered_down;
+
+    ASSERT_EQ(storage_enable_power(&storage, &error), STD_SUCCESS);
+    const int exit_code = storage_mount_filesystem(&storage, &error);
+
+    // Assert: make unit test pass or fail
+    const std::vector<uint8_t> expected(firmware.begin(), firmware.begin() + 1000U);
+
+    EXPECT_TRUE(is_powered_down);
+    EXPECT_EQ(exit_code,    STD_SUCCESS);
+    EXPECT_EQ(read_back(),  expected);
+}
+
+TEST_F(StorageEmulatorTestFixture, PreEraseOfDeletedImage)
+{
+    // Arrange: create and set up a system under test
+    constexpr size_t image_size = 1024U * 1024U;
+
+    std::vector<uint8_t> image(image_size);
+
+    for (size_t i = 0U; i < image.size(); ++i)
+    {
+        image[i] = firmware[i % firmware.size()] ^ (uint8_t)(i >> 16U);
+    }
+
+    auto download = [&] ()
+    {
+        storage_stream_t stream;
+        EXPECT_EQ(storage_create_stream(&storage, &stream, file_name, STORAGE_STREAM_CHECKPOINT_SIZE, &error), STD_SUCCESS);
+
+        for (size_t i = 0U; i < image.size(); i += tcp_chunk_size)
+        {
+            EXPECT_EQ(storage_write_stream(&storage, &stream, &image[i], tcp_chunk_size, &error), STD_SUCCESS);
+        }
+
+        size_t stream_size;
+        EXPECT_EQ(storage_close_stream(&storage, &stream, &stream_size, &error), STD_SUCCESS);
+    };
+
+    auto get_erase_time_us = [&] (uint32_t * const erase_size)
+    {
+        double time_us  = 0.0;
+        *erase_size     = 0U;
+
+        for (W25q32bvEmulator::Operation const &operation : emulator.operation_array)
+        {
+            if (operation.command == 0x20U)
+            {
+                *erase_size += W25q32bvEmulator::sector_size;
+            }
+            else if (operation.command == 0x52U)
+            {
+                *erase_size += W25q32bvEmulator::block_size / 2U;
+            }
+            else if (operation.command == 0xD8U)
+            {
+                *erase_size += W25q32bvEmulator::block_size;
+            }
+            else
+            {
+                continue;
+            }
+            time_us += operation.duration_us;
+        }
+        return time_us;
+    };
+
+    const double first_start_us = emulator.now_us;
+
+    download();
+
+    uint32_t sector_erase_size;
+    const double sector_erase_time_us   = get_erase_time_us(&sector_erase_size);
+    const double first_download_us      = emulator.now_us - first_start_us;
+
+    ASSERT_EQ(storage_remove_file(&storage, file_name, &error), STD_SUCCESS);
+
+    // Act: poke the system under test
+    emulator.reset_counters();
+
+    size_t erase_count;
+    const int exit_code = storage_pre_erase(&storage, 0U, NULL, &erase_count, &error);
+
+    uint32_t block_erase_size;
+    const double block_erase_time_us = get_erase_time_us(&block_erase_size);
+
+    size_t repeated_erase_count;
+    ASSERT_EQ(storage_pre_erase(&storage, 0U, NULL, &repeated_erase_count, &error), STD_SUCCESS);
+
+    emulator.reset_counters();
+
+    const double start_us = emulator.now_us;
+
+    download();
+
+    uint32_t download_erase_size;
+    const double download_erase_time_us = get_erase_time_us(&download_erase_size);
+    const double second_download_us     = emulator.now_us - start_us;
+
+    // Assert: make unit test pass or fail
+    const double MB_size                = 1024.0 * 1024.0;
+    const double sector_erase_ms_per_MB = (sector_erase_time_us / 1000.0) / ((double)(sector_erase_size) / MB_size);
+    const double block_erase_ms_per_MB  = (block_erase_time_us / 1000.0) / ((double)(block_erase_size) / MB_size);
+
+    std::cout << "[ BENCHMARK] erase    : " << sector_erase_ms_per_MB << " ms/MB in sectors, " << block_erase_ms_per_MB << " ms/MB in "
+                << erase_count << " blocks" << std::endl;
+    std::cout << "[ BENCHMARK] download : " << (first_download_us / 1000.0) << " ms (" << (sector_erase_time_us / 1000.0) << " ms erasing), "
+                << (second_download_us / 1000.0) << " ms after a pre-erase (" << (download_erase_time_us / 1000.0) << " ms erasing)" << std::endl;
+    RecordProperty("sector_erase_ms_per_MB",    std::to_string((int)(sector_erase_ms_per_MB)));
+    RecordProperty("block_erase_ms_per_MB",     std::to_string((int)(block_erase_ms_per_MB)));
+    RecordProperty("pre_erased_download_ms",    std::to_string((int)(second_download_us / 1000.0)));
+
+    EXPECT_EQ(exit_code,                STD_SUCCESS);
+    EXPECT_GE(block_erase_size,         (uint32_t)(image_size));
+    EXPECT_EQ(repeated_erase_count,     0U);
+    EXPECT_LT(block_erase_ms_per_MB,    sector_erase_ms_per_MB / 3.0);
+    EXPECT_EQ(read_back(),              image);
+
+    // Only the metadata pairs are erased in place
+    EXPECT_LT(download_erase_time_us,   sector_erase_time_us / 10.0);
+    EXPECT_LT(second_download_us,       first_download_us / 2.0);
+}
+
+TEST_F(StorageEmulatorTestFixture, PreEraseKeepsOpenFiles)
+{
+    // Arrange: create and set up a system under test
+    const char other_file_name[64] = "sensor.log\0";
+
+    storage_file_t file;
+    ASSERT_EQ(storage_create_file(&storage, &file, other_file_name, &error), STD_SUCCESS);
+    ASSERT_EQ(storage_write_file(&storage, &file, (const char*)(firmware.data()), 10000U, &error), STD_SUCCESS);
+    ASSERT_EQ(storage_close_file(&storage, &file, &error), STD_SUCCESS);
+
+    storage_stream_t stream;
+    ASSERT_EQ(storage_create_stream(&storage, &stream, file_name, STORAGE_STREAM_CHECKPOINT_SIZE, &error), STD_SUCCESS);
+
+    const size_t half_size = firmware.size() / 2U;
+
+    // Act: poke the system under test
+    ASSERT_EQ(storage_write_stream(&storage, &stream, firmware.data(), half_size, &error), STD_SUCCESS);
+
+    size_t erase_count;
+    const int exit_code = storage_pre_erase(&storage, 0U, NULL, &erase_count, &error);
+
+    ASSERT_EQ(storage_write_stream(&storage, &stream, &firmware[half_size], firmware.size() - half_size, &error), STD_SUCCESS);
+
+    size_t stream_size;
+    ASSERT_EQ(storage_close_stream(&storage, &stream, &stream_size, &error), STD_SUCCESS);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(exit_code,    STD_SUCCESS);
+    EXPECT_GT(erase_count,  0U);
+    EXPECT_EQ(read_back(),  firmware);
+
+    char data[10000U];
+    size_t size;
+
+    ASSERT_EQ(storage_open_file(&storage, &file, other_file_name, &error), STD_SUCCESS);
+    ASSERT_EQ(storage_read_file(&storage, &file, data, &size, sizeof(data), &error), STD_SUCCESS);
+    storage_close_file(&storage, &file, &error);
+
+    EXPECT_EQ(size, sizeof(data));
+    EXPECT_EQ(std::memcmp(data, firmware.data(), sizeof(data)), 0);
+}
+
+
+TEST_F(StorageEmulatorTestFixture, PreEraseSuspendedByRead)
+{
+    // Arrange: create and set up a system under test
+    constexpr size_t config_size = 4096U;
+
+    storage_file_t file;
+    ASSERT_EQ(storage_create_file(&storage, &file, file_name, &error), STD_SUCCESS);
+    ASSERT_EQ(storage_write_file(&storage, &file, (const char*)(firmware.data()), config_size, &error), STD_SUCCESS);
+    ASSERT_EQ(storage_close_file(&storage, &file, &error), STD_SUCCESS);
+
+    auto read_config = [&] ()
+    {
+        static char data[config_size];
+        size_t size = 0U;
+
+        storage_file_t config_file;
+
+        if (storage_open_file(&storage, &config_file, file_name, &error) == STD_SUCCESS)
+        {
+            storage_read_file(&storage, &config_file, data, &size, sizeof(data), &error);
+            storage_close_file(&storage, &config_file, &error);
+        }
+        return (size == config_size) && (std::memcmp(data, firmware.data(), config_size) == 0);
+    };
+
+    const double idle_start_us = emulator.now_us;
+    ASSERT_TRUE(read_config());
+    const double idle_read_us = emulator.now_us - idle_start_us;
+
+    emulator.reset_counters();
+
+    bool is_read        = false;
+    double read_us      = 0.0;
+
+    // Another task reads the config while the storage task sleeps through its erase
+    emulator.sleep_hook = [&] ()
+    {
+        if ((is_read != true) && (emulator.sleep_count == 5U))
+        {
+            const double start_us = emulator.now_us;
+
+            is_read = read_config();
+            read_us = emulator.now_us - start_us;
+        }
+    };
+
+    // Act: poke the system under test
+    const double erase_start_us = emulator.now_us;
+
+    size_t erase_count;
+    const int exit_code = storage_pre_erase(&storage, 1U, NULL, &erase_count, &error);
+
+    const double erase_time_us = emulator.now_us - erase_start_us;
+
+    emulator.sleep_hook = nullptr;
+
+    // Assert: make unit test pass or fail
+    ASSERT_FALSE(emulator.operation_array.empty());
+
+    const double erase_us = emulator.operation_array.front().duration_us;
+
+    std::cout << "[ BENCHMARK] read     : " << read_us << " us during a pre-erase, " << idle_read_us << " us idle, "
+                << (erase_us / 1000.0) << " ms erase done in " << (erase_time_us / 1000.0) << " ms" << std::endl;
+    RecordProperty("suspended_read_us", std::to_string((int)(read_us)));
+
+    EXPECT_EQ(exit_code,                STD_SUCCESS);
+    EXPECT_EQ(erase_count,              1U);
+    EXPECT_TRUE(is_read);
+    EXPECT_EQ(emulator.suspend_count,   1U);
+
+    // A suspend and a resume on top, not the rest of the erase
+    EXPECT_LT(read_us,          idle_read_us + 100.0);
+    EXPECT_GE(erase_time_us,    erase_us);
+    EXPECT_EQ(read_back(),      std::vector<uint8_t>(firmware.begin(), firmware.begin() + config_size));
+}
+
+TEST_F(StorageEmulatorTestFixture, PreEraseWokenUpByRequest)
+{
+    // Arrange: create and set up a system under test
+    constexpr size_t config_size = 4096U;
+
+    storage_file_t file;
+    ASSERT_EQ(storage_create_file(&storage, &file, file_name, &error), STD_SUCCESS);
+    ASSERT_EQ(storage_write_file(&storage, &file, (const char*)(firmware.data()), config_size, &error), STD_SUCCESS);
+    ASSERT_EQ(storage_close_file(&storage, &file, &error), STD_SUCCESS);
+
+    emulator.reset_counters();
+
+    // A request comes in for the storage task itself on its third poll
+    static size_t wait_count;
+    wait_count = 0U;
+
+    const storage_wait_callback_t wait_callback = [] (uint32_t delay_ms) -> bool
+    {
+        W25q32bvEmulator::delay_callback(delay_ms);
+
+        return (++wait_count == 3U);
+    };
+
+    // Act: poke the system under test
+    const double start_us = emulator.now_us;
+
+    size_t erase_count;
+    const int exit_code = storage_pre_erase(&storage, 1U, wait_callback, &erase_count, &error);
+
+    const double woken_up_us = emulator.now_us - start_us;
+
+    static char data[config_size];
+    size_t size = 0U;
+
+    ASSERT_EQ(storage_open_file(&storage, &file, file_name, &error), STD_SUCCESS);
+    ASSERT_EQ(storage_read_file(&storage, &file, data, &size, sizeof(data), &error), STD_SUCCESS);
+    storage_close_file(&storage, &file, &error);
+
+    const size_t suspend_count = emulator.suspend_count;
+
+    // Waits for the erase left going before anything else
+    size_t next_erase_count;
+    const int next_exit_code = storage_pre_erase(&storage, 1U, NULL, &next_erase_count, &error);
+
+    // Assert: make unit test pass or fail
+    ASSERT_FALSE(emulator.operation_array.empty());
+
+    const double erase_us = emulator.operation_array.front().duration_us;
+
+    EXPECT_EQ(exit_code,                    STD_SUCCESS);
+    EXPECT_EQ(erase_count,                  1U);
+    EXPECT_EQ(wait_count,                   3U);
+    EXPECT_LT(woken_up_us,                  erase_us);
+    EXPECT_EQ(size,                         config_size);
+    EXPECT_EQ(std::memcmp(data, firmware.data(), config_size), 0);
+    EXPECT_EQ(suspend_count,                1U);
+    EXPECT_EQ(next_exit_code,               STD_SUCCESS);
+    EXPECT_EQ(next_erase_count,             1U);
+    EXPECT_EQ(storage.erasing_sector_count, 0U);
+}
+
+struct StorageGeometryParameter
+{
+    const char *name;
+    storage_geometry_t geometry;
+};
+
+// Workloads of a node run against littlefs settings, the boards take the winner in board.config.h
+class StorageParameterizedGeometry : public StorageEmulatorTestFixture,
+                                        public testing::WithParamInterface<StorageGeometryParameter>
+{
+    protected:
+
+        double start_us;
+
+        virtual void SetUp() override
+        {
+            geometry = GetParam().geometry;
+
+            StorageEmulatorTestFixture::SetUp();
+
+            start_us = emulator.now_us;
+        }
+
+        void report (const char *workload)
+        {
+            const double time_ms = (emulator.now_us - start_us) / 1000.0;
+
+            std::cout << "[ BENCHMARK] " << GetParam().name << " : " << workload << " " << time_ms << " ms, "
+                        << emulator.spi_byte_count << " SPI bytes, " << emulator.read_count << " reads, "
+                        << emulator.program_count << " programs, " << emulator.erase_count << " erases" << std::endl;
+
+            const std::string prefix = std::string(workload) + "_";
+            RecordProperty(prefix + "time_ms",      std::to_string((int)(time_ms)));
+            RecordProperty(prefix + "spi_bytes",    std::to_string(emulator.spi_byte_count));
+            RecordProperty(prefix + "programs",     std::to_string(emulator.program_count));
+            RecordProperty(prefix + "erases",       std::to_string(emulator.erase_count));
+        }
+};
+
+TEST_P(StorageParameterizedGeometry, FirmwareDownload)
+{
+    // Arrange: create and set up a system under test
+    storage_stream_t stream;
+    ASSERT_EQ(storage_create_stream(&storage, &stream, file_name, STORAGE_STREAM_CHECKPOINT_SIZE, &error), STD_SUCCESS);
+
+    // Act: poke the system under test
+    for (size_t i = 0U; i < firmware.size(); i += tcp_chunk_size)
+    {
+        ASSERT_EQ(storage_write_stream(&storage, &stream, &firmware[i], std::min(tcp_chunk_size, firmware.size() - i), &error), STD_SUCCESS);
+    }
+
+    size_t stream_size;
+    const int exit_code = storage_close_stream(&storage, &stream, &stream_size, &error);
+
+    report("download");
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(exit_code,    STD_SUCCESS);
+    EXPECT_EQ(read_back(),  firmware);
+}
+
+TEST_P(StorageParameterizedGeometry, ConfigRewrite)
+{
+    // Arrange: create and set up a system under test
+    constexpr size_t config_size    = 200U;
+    constexpr size_t rewrite_count  = 50U;
+
+    const char temporary_file_name[64] = "config.tmp\0";
+
+    // Act: poke the system under test
+    for (size_t i = 0U; i < rewrite_count; ++i)
+    {
+        storage_file_t file;
+        ASSERT_EQ(storage_create_file(&storage, &file, temporary_file_name, &error), STD_SUCCESS);
+        ASSERT_EQ(storage_write_file(&storage, &file, (const char*)(&firmware[i]), config_size, &error), STD_SUCCESS);
+        ASSERT_EQ(storage_close_file(&storage, &file, &error), STD_SUCCESS);
+        ASSERT_EQ(storage_rename_file(&storage, temporary_file_name, file_name, &error), STD_SUCCESS);
+    }
+
+    report("config");
+
+    // Assert: make unit test pass or fail
+    const std::vector<uint8_t> expected(&firmware[rewrite_count - 1U], &firmware[rewrite_count - 1U] + config_size);
+
+    EXPECT_EQ(read_back(), expected);
+}
+
+TEST_P(StorageParameterizedGeometry, LogAppend)
+{
+    // Arrange: create and set up a system under test
+    constexpr size_t record_size    = 32U;
+    constexpr size_t record_count   = 200U;
+
+    storage_file_t file;
+    ASSERT_EQ(storage_create_file(&storage, &file, file_name, &error), STD_SUCCESS);
+
+    // Act: poke the system under test
+    for (size_t i = 0U; i < record_count; ++i)
+    {
+        // Synced every time, a record must survive a power loss right after it
+        ASSERT_EQ(storage_write_file(&storage, &file, (const char*)(&firmware[i * record_size]), record_size, &error), STD_SUCCESS);
+    }
+    ASSERT_EQ(storage_close_file(&storage, &file, &error), STD_SUCCESS);
+
+    report("log");
+
+    // Assert: make unit test pass or fail
+    const std::vector<uint8_t> expected(firmware.begin(), firmware.begin() + (record_count * record_size));
+
+    EXPECT_EQ(read_back(), expected);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    StorageGeometry,
+    StorageParameterizedGeometry,
+    testing::Values(
+        StorageGeometryParameter { "read 128, prog 128, cache 128",     { 128U, 128U, 128U, 128U, 500 } },
+        StorageGeometryParameter { "read 16, prog 128, cache 256",      { 16U,  128U, 256U, 128U, 500 } },
+        StorageGeometryParameter { "read 16, prog 256, cache 256",      { 16U,  256U, 256U, 128U, 500 } },
+        StorageGeometryParameter { "read 256, prog 256, cache 256",     { 256U, 256U, 256U, 128U, 500 } },
+        StorageGeometryParameter { "read 64, prog 64, lookahead 32",    { 64U,  64U,  64U,  32U,  500 } }
+    )
+);
+
+
+// The boards populated with a larger W25Q, littlefs gets the part the driver detected
+class StorageParameterizedPart : public StorageEmulatorTestFixture,
+                                    public testing::WithParamInterface<W25q32bvEmulator::Part>
+{
+    protected:
+
+        virtual void SetUp() override
+        {
+            part = GetParam();
+
+            StorageEmulatorTestFixture::SetUp();
+        }
+};
+
+TEST_P(StorageParameterizedPart, FirmwareDownload)
+{
+    // Arrange: create and set up a system under test
+    storage_stream_t stream;
+    ASSERT_EQ(storage_create_stream(&storage, &stream, file_name, STORAGE_STREAM_CHECKPOINT_SIZE, &error), STD_SUCCESS);
+
+    // Act: poke the system under test
+    for (size_t i = 0U; i < firmware.size(); i += tcp_chunk_size)
+    {
+        ASSERT_EQ(storage_write_stream(&storage, &stream, &firmware[i], std::min(tcp_chunk_size, firmware.size() - i), &error), STD_SUCCESS);
+    }
+
+    size_t stream_size;
+    const int exit_code = storage_close_stream(&storage, &stream, &stream_size, &error);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(exit_code,                        STD_SUCCESS);
+    EXPECT_EQ(storage.lfs_config.block_size,    W25q32bvEmulator::sector_size);
+    EXPECT_EQ(storage.lfs_config.block_count,   GetParam().flash_size / W25q32bvEmulator::sector_size);
+    EXPECT_EQ(read_back(),                      firmware);
+}
+
+TEST_P(StorageParameterizedPart, PreEraseWholePart)
+{
+    // Arrange: create and set up a system under test
+    size_t erase_count;
+
+    // Act: poke the system under test
+    const int exit_code = storage_pre_erase(&storage, 0U, NULL, &erase_count, &error);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(exit_code, STD_SUCCESS);
+    EXPECT_GE(erase_count, (GetParam().flash_size / W25q32bvEmulator::block_size) - 1U);
+    EXPECT_EQ(emulator.sector_erase_count.back(), 1U);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    StorageParts,
+    StorageParameterizedPart,
+    testing::Values(
+        W25q32bvEmulator::w25q32bv,
+        W25q32bvEmulator::w25q32bv_without_sfdp,
+        W25q32bvEmulator::w25q128jv,
+        W25q32bvEmulator::w25q256jv
+    )
+);
+
+
+class StorageParameterizedInvalidGeometry : public testing::TestWithParam<storage_geometry_t>
+{
+};
+
+TEST_P(StorageParameterizedInvalidGeometry, Init)
+{
+    // Arrange: create and set up a system under test
+    W25q32bvEmulator emulator;
+    std_error_t error;
+    std_error_init(&error);
+
+    storage_config_t config;
+    config.lock_callback            = W25q32bvEmulator::storage_lock;
+    config.unlock_callback          = W25q32bvEmulator::storage_unlock;
+    config.spi_lock_callback        = W25q32bvEmulator::spi_lock;
+    config.spi_unlock_callback      = W25q32bvEmulator::spi_unlock;
+    config.spi_select_callback      = W25q32bvEmulator::spi_select;
+    config.spi_unselect_callback    = W25q32bvEmulator::spi_unselect;
+    config.spi_tx_rx_callback       = W25q32bvEmulator::spi_tx_rx;
+    config.spi_timeout_ms           = 10U;
+    config.delay_callback           = W25q32bvEmulator::delay_callback;
+    config.yield_callback           = W25q32bvEmulator::yield_callback;
+    config.get_cycles_callback      = W25q32bvEmulator::get_cycles_callback;
+    config.cycles_per_us            = W25q32bvEmulator::cycles_per_us;
+    config.geometry                 = GetParam();
+
+    storage_t storage;
+
+    // Act: poke the system under test
+    const int exit_code = storage_init(&storage, &config, &error);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(exit_code, STD_FAILURE);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    StorageGeometry,
+    StorageParameterizedInvalidGeometry,
+    testing::Values(
+        storage_geometry_t { 0U,    256U,   256U,   128U,   500 },  // No read size
+        storage_geometry_t { 16U,   256U,   512U,   128U,   500 },  // Cache past the buffers
+        storage_geometry_t { 16U,   256U,   256U,   256U,   500 },  // Lookahead past the buffer
+        storage_geometry_t { 48U,   256U,   256U,   128U,   500 },  // Cache not a multiple of the reads
+        storage_geometry_t { 16U,   96U,    192U,   128U,   500 },  // Prog not a divisor of the page
+        storage_geometry_t { 16U,   256U,   256U,   12U,    500 }   // Lookahead not a multiple of 8
+    )
+);
@@ -0,0 +1,188 @@
+/************************************************************
+ *   Author : German Mundinger
+ *   Date   : 2024
+ ************************************************************/
+
+#include <gmock/gmock.h>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "storage_request.h"
+#include "storage.h"
+#include "std_error/std_error.h"
+
+#include "ram_block_device.h"
+
+
+constexpr storage_geometry_t test_geometry = { 16U, 256U, 256U, 128U, 500 };
+
+
+class StorageRequestTestFixture : public testing::Test
+{
+    protected:
+
+        RamBlockDevice device;
+        storage_t storage;
+        std_error_t error;
+
+        virtual void SetUp() override
+        {
+            std_error_init(&error);
+
+            ASSERT_EQ(lfs_format(&storage.lfs, device.configure(storage, test_geometry)), LFS_ERR_OK);
+            ASSERT_EQ(storage_mount_filesystem(&storage, &error), STD_SUCCESS);
+        }
+
+        virtual void TearDown() override
+        {
+            lfs_unmount(&storage.lfs);
+        }
+
+        int execute (storage_request_type_t type, char const *file_name, std::string const &data)
+        {
+            storage_request_t request;
+
+            if (storage_request_init(&request, type, file_name, data.data(), data.size(), &error) != STD_SUCCESS)
+            {
+                return STD_FAILURE;
+            }
+            return storage_request_execute(&request, &storage, &error);
+        }
+
+        std::string read (char const *file_name, size_t size = STORAGE_REQUEST_DATA_SIZE, size_t offset = 0U)
+        {
+            storage_request_t request;
+
+            if (storage_request_init(&request, STORAGE_READ_REQUEST, file_name, nullptr, size, &error) != STD_SUCCESS)
+            {
+                return "<init failure>";
+            }
+            request.offset = offset;
+
+            if (storage_request_execute(&request, &storage, &error) != STD_SUCCESS)
+            {
+                return "<read failure>";
+            }
+            return std::string((char const*)(request.data), request.size);
+        }
+};
+
+
+TEST_F(StorageRequestTestFixture, WriteReplaces)
+{
+    // Act: poke the system under test
+    const int first_exit_code   = execute(STORAGE_WRITE_REQUEST, "config", "first content");
+    const int second_exit_code  = execute(STORAGE_WRITE_REQUEST, "config", "second");
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(first_exit_code,  STD_SUCCESS);
+    EXPECT_EQ(second_exit_code, STD_SUCCESS);
+    EXPECT_EQ(read("config"),   "second");
+}
+
+TEST_F(StorageRequestTestFixture, AppendCreatesAndGrows)
+{
+    // Act: poke the system under test
+    const int first_exit_code   = execute(STORAGE_APPEND_REQUEST, "log.0", "abc");
+    const int second_exit_code  = execute(STORAGE_APPEND_REQUEST, "log.0", "def");
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(first_exit_code,  STD_SUCCESS);
+    EXPECT_EQ(second_exit_code, STD_SUCCESS);
+    EXPECT_EQ(read("log.0"),    "abcdef");
+}
+
+TEST_F(StorageRequestTestFixture, ReadFromOffset)
+{
+    // Arrange: create and set up a system under test
+    ASSERT_EQ(execute(STORAGE_WRITE_REQUEST, "data", "0123456789"), STD_SUCCESS);
+
+    // Act & Assert: poke the system under test and check the result
+    EXPECT_EQ(read("data", 4U, 3U),     "3456");
+    EXPECT_EQ(read("data", 100U, 8U),   "89");
+    EXPECT_EQ(read("data", 4U, 20U),    "");
+    EXPECT_EQ(read("missing"),          "<read failure>");
+}
+
+TEST_F(StorageRequestTestFixture, RenameAndDelete)
+{
+    // Arrange: create and set up a system under test
+    ASSERT_EQ(execute(STORAGE_WRITE_REQUEST, "log.index", "old"), STD_SUCCESS);
+    ASSERT_EQ(execute(STORAGE_WRITE_REQUEST, "log.index.tmp", "new"), STD_SUCCESS);
+
+    // Act: poke the system under test
+    storage_request_t request;
+    ASSERT_EQ(storage_request_init(&request, STORAGE_RENAME_REQUEST, "log.index.tmp", "log.index", 0U, &error), STD_SUCCESS);
+
+    const int rename_exit_code = storage_request_execute(&request, &storage, &error);
+
+    const std::string renamed_data = read("log.index");
+    const std::string temporary_data = read("log.index.tmp");
+
+    const int delete_exit_code = execute(STORAGE_DELETE_REQUEST, "log.index", "");
+    const int missing_delete_exit_code = execute(STORAGE_DELETE_REQUEST, "log.index", "");
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(rename_exit_code,         STD_SUCCESS);
+    EXPECT_EQ(renamed_data,             "new");
+    EXPECT_EQ(temporary_data,           "<read failure>");
+    EXPECT_EQ(delete_exit_code,         STD_SUCCESS);
+    EXPECT_EQ(missing_delete_exit_code, STD_FAILURE);
+    EXPECT_EQ(read("log.index"),        "<read failure>");
+}
+
+TEST_F(StorageRequestTestFixture, FlushTouchesNothing)
+{
+    // Arrange: create and set up a system under test
+    storage_request_t request;
+    ASSERT_EQ(storage_request_init(&request, STORAGE_FLUSH_REQUEST, nullptr, nullptr, 0U, &error), STD_SUCCESS);
+
+    device.reset_counters();
+
+    // Act: poke the system under test
+    const int exit_code = storage_request_execute(&request, &storage, &error);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(exit_code,            STD_SUCCESS);
+    EXPECT_EQ(device.prog_count,    0U);
+    EXPECT_EQ(device.erase_count,   0U);
+}
+
+TEST_F(StorageRequestTestFixture, OwnsItsCopy)
+{
+    // Arrange: create and set up a system under test
+    char file_name[16] = "log.7";
+    std::vector<uint8_t> data(STORAGE_REQUEST_DATA_SIZE, 0xA5U);
+
+    storage_request_t request;
+    ASSERT_EQ(storage_request_init(&request, STORAGE_APPEND_REQUEST, file_name, data.data(), data.size(), &error), STD_SUCCESS);
+
+    // Act: poke the system under test
+    std::memset(file_name, 0, sizeof(file_name));
+    std::fill(data.begin(), data.end(), 0x00U);
+
+    const int exit_code = storage_request_execute(&request, &storage, &error);
+
+    // Assert: make unit test pass or fail
+    EXPECT_EQ(exit_code,        STD_SUCCESS);
+    EXPECT_EQ(read("log.7"),    std::string(STORAGE_REQUEST_DATA_SIZE, (char)(0xA5U)));
+}
+
+TEST_F(StorageRequestTestFixture, InvalidRequest)
+{
+    // Arrange: create and set up a system under test
+    storage_request_t request;
+
+    const std::string long_name(STORAGE_REQUEST_NAME_SIZE, 'a');
+    const std::vector<uint8_t> data(STORAGE_REQUEST_DATA_SIZE + 1U, 0U);
+
+    // Act & Assert: poke the system under test and check the result
+    EXPECT_EQ(storage_request_init(&request, STORAGE_WRITE_REQUEST, long_name.c_str(), data.data(), 1U, &error), STD_FAILURE);
+    EXPECT_EQ(storage_request_init(&request, STORAGE_WRITE_REQUEST, "", data.data(), 1U, &error), STD_FAILURE);
+    EXPECT_EQ(storage_request_init(&request, STORAGE_WRITE_REQUEST, "data", data.data(), data.size(), &error), STD_FAILURE);
+    EXPECT_EQ(storage_request_init(&request, STORAGE_READ_REQUEST, "data", nullptr, data.size(), &error), STD_FAILURE);
+    EXPECT_EQ(storage_request_init(&request, STORAGE_RENAME_REQUEST, "data", long_name.c_str(), 0U, &error), STD_FAILURE);
+    EXPECT_EQ(storage_request_init(&request, STORAGE_WRITE_REQUEST, long_name.substr(1U).c_str(), data.data(), STORAGE_REQUEST_DATA_SIZE, &error), STD_SUCCESS);
+}
@@ -0,0 +1,175 @@
+/************************************************************
+ *   Author : German Mundinger
+ *   Date   : 2024
+ ************************************************************/
+
+// Appends the image trailer: size (4) | crc32 (4), both little endian.
+// The crc is the one the bootloader checks, crc32_calculate_words() over the image words.
+// Usage: image_trailer <firmware.bin>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "crc32.h"
+#include "bootloader/image.h"
+
+
+#define WORD_SIZE   4U
+
+
+static uint8_t *image_trailer_read (char const * const file_name, size_t * const size);
+static uint32_t image_trailer_get_word (uint8_t const * const data);
+static void image_trailer_set_word (uint8_t * const data, uint32_t word);
+
+int main (int argc, char *argv[])
+{
+    if (argc != 2)
+    {
+        fprintf(stderr, "Usage: %s <firmware.bin>\n", argv[0]);
+
+        return EXIT_FAILURE;
+    }
+
+    char const * const file_name = argv[1];
+
+    size_t image_size;
+    uint8_t * const image = image_trailer_read(file_name, &image_size);
+
+    if (image == NULL)
+    {
+        fprintf(stderr, "%s: can not read\n", file_name);
+
+        return EXIT_FAILURE;
+    }
+
+    // The linker puts the trailer offset into the info block, the binary must end right there
+    if ((image_size < (IMAGE_INFO_OFFSET + 8U)) || (image_trailer_get_word(&image[IMAGE_INFO_OFFSET]) != IMAGE_INFO_MAGIC))
+    {
+        fprintf(stderr, "%s: no image info block\n", file_name);
+        free(image);
+
+        return EXIT_FAILURE;
+    }
+
+    const uint32_t trailer_offset = image_trailer_get_word(&image[IMAGE_INFO_OFFSET + 4U]);
+
+    if (((trailer_offset % WORD_SIZE) != 0U) || (image_size > trailer_offset) || ((image_size + (WORD_SIZE - 1U)) < trailer_offset))
+    {
+        fprintf(stderr, "%s: %lu bytes, the info block says %lu\n", file_name, (unsigned long)(image_size), (unsigned long)(trailer_offset));
+        free(image);
+
+        return EXIT_FAILURE;
+    }
+
+    uint32_t * const words = (uint32_t*)malloc(trailer_offset);
+
+    if (words == NULL)
+    {
+        free(image);
+
+        return EXIT_FAILURE;
+    }
+
+    // Filled with what objcopy would put into an alignment gap, the words as the MCU reads them
+    uint8_t tail[WORD_SIZE] = { 0U };
+
+    for (size_t i = 0U; i < (trailer_offset / WORD_SIZE); ++i)
+    {
+        uint8_t const *data = &image[i * WORD_SIZE];
+
+        if (((i + 1U) * WORD_SIZE) > image_size)
+        {
+            for (size_t j = 0U; j < (image_size - (i * WORD_SIZE)); ++j)
+            {
+                tail[j] = data[j];
+            }
+            data = tail;
+        }
+        words[i] = image_trailer_get_word(data);
+    }
+
+    const uint32_t crc32 = crc32_calculate_words(words, (size_t)(trailer_offset / WORD_SIZE));
+
+    free(words);
+    free(image);
+
+    uint8_t trailer[WORD_SIZE + IMAGE_TRAILER_SIZE] = { 0U };
+    const size_t padding_size = (size_t)(trailer_offset) - image_size;
+
+    image_trailer_set_word(&trailer[padding_size], trailer_offset);
+    image_trailer_set_word(&trailer[padding_size + 4U], crc32);
+
+    FILE *file = fopen(file_name, "ab");
+
+    if (file == NULL)
+    {
+        fprintf(stderr, "%s: can not write\n", file_name);
+
+        return EXIT_FAILURE;
+    }
+
+    const size_t trailer_size   = padding_size + IMAGE_TRAILER_SIZE;
+    const bool is_written       = (fwrite(trailer, 1U, trailer_size, file) == trailer_size);
+
+    if ((fclose(file) != 0) || (is_written != true))
+    {
+        fprintf(stderr, "%s: can not write\n", file_name);
+
+        return EXIT_FAILURE;
+    }
+
+    printf("%s: %lu bytes, crc32 = 0x%08lx\n", file_name, (unsigned long)(trailer_offset), (unsigned long)(crc32));
+
+    return EXIT_SUCCESS;
+}
+
+uint8_t *image_trailer_read (char const * const file_name, size_t * const size)
+{
+    FILE *file = fopen(file_name, "rb");
+
+    if (file == NULL)
+    {
+        return NULL;
+    }
+
+    uint8_t *data = NULL;
+
+    if (fseek(file, 0L, SEEK_END) == 0)
+    {
+        const long file_size = ftell(file);
+
+        if ((file_size > 0L) && (fseek(file, 0L, SEEK_SET) == 0))
+        {
+            data = (uint8_t*)malloc((size_t)(file_size));
+
+            if ((data != NULL) && (fread(data, 1U, (size_t)(file_size), file) != (size_t)(file_size)))
+            {
+                free(data);
+                data = NULL;
+            }
+            *size = (size_t)(file_size);
+        }
+    }
+
+    fclose(file);
+
+    return data;
+}
+
+uint32_t image_trailer_get_word (uint8_t const * const data)
+{
+    return (uint32_t)(data[0]) | ((uint32_t)(data[1]) << 8U) | ((uint32_t)(data[2]) << 16U) | ((uint32_t)(data[3]) << 24U);
+}
+
+void image_trailer_set_word (uint8_t * const data, uint32_t word)
+{
+    data[0] = (uint8_t)(word);
+    data[1] = (uint8_t)(word >> 8U);
+    data[2] = (uint8_t)(word >> 16U);
+    data[3] = (uint8_t)(word >> 24U);
+
+    return;
+}